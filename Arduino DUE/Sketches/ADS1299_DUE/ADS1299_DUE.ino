@@ -7,13 +7,17 @@
  This version modifies to work with the Arduino Due by Joel Murphy (Fall 2013) 
  Includes a 60Hz notch filter, made by Chip Audette
 
+ Now it uses the same ADS1299 library as the Uno (Arduino/Libraries/ADS1299), which picks
+ the DUE's bit-banged SPI on its own (see ADS1299_SPI.h).  Install that library, and the
+ Biquad library, the same way as for the Uno.
+
  Now warranty or promise that this will work for your purposes. Use at your own risk. wysiwyg
  
  */
 typedef long int int32;
 
-#include <ADS1299Managerdue.h>
-ADS1299Managerdue ADSManager; //Uses soft SPI bus and pins to say data is ready.  Uses Pins 13,12,11,10,9,8,4
+#include <ADS1299Manager.h>
+ADS1299Manager ADSManager; //Uses soft SPI bus and pins to say data is ready.  Uses Pins 13,12,11,10,9,8,4
 
 //define how I'd like my channels setup
 #define MAX_N_CHANNELS (8)  //must be less than or equal to length of channelData in ADS1299 object!!
@@ -62,7 +66,7 @@ void setup() {
   pinMode(2,INPUT);  digitalWrite(2,HIGH); //activate pullup...for detecting which version of OpenBCI PCB
   pinMode(3,OUTPUT); digitalWrite(3,LOW);  //act as a ground pin...for detecting which version of OpenBCI PCB
   if (digitalRead(2) == LOW) OpenBCI_version = OPENBCI_V1; //check pins to see if there is a jumper.  if so, it is the older board
-  ADSManager.initialize(OpenBCI_version);  //must do this VERY early in the setup...preferably first
+  ADSManager.initialize(OpenBCI_version,false);  //must do this VERY early in the setup...preferably first.  One board, no daisy chain.
 
   // setup the serial link to the PC
   Serial.begin(115200);
@@ -127,7 +131,6 @@ void loop(){
       switch (outputType) {
         case OUTPUT_NOTHING:
           //don't output anything...the Arduino is still collecting data from the OpenBCI board...just nothing is being done with it
-          //if ((sampleCounter % 250) == 1) { Serial.print(F("Free RAM = ")); Serial.println(freeRam()); }; //print memory status
           break;
         case OUTPUT_BINARY:
           ADSManager.writeChannelDataAsBinary(8,sampleCounter);  //print all channels, whether active or not
@@ -274,6 +277,7 @@ boolean toggleRunState(int OUT_TYPE)
 boolean stopRunning(void) {
   ADSManager.stop();                    // stop the data acquisition
   is_running = false;
+  return is_running;
 }
 
 boolean startRunning(int OUT_TYPE) {
@@ -304,6 +308,7 @@ int changeChannelState_maintainRunningState(int chan, int start)
   if (is_running_when_called == true) {
     startRunning(cur_outputType);
   }
+  return is_running;
 }
 
 int activateAllChannelsToTestCondition(int testInputCode, byte amplitudeCode, byte freqCode)
@@ -326,6 +331,7 @@ int activateAllChannelsToTestCondition(int testInputCode, byte amplitudeCode, by
   if (is_running_when_called == true) {
     startRunning(cur_outputType);
   }
+  return is_running;
 }
 
 long int runningAve[MAX_N_CHANNELS];
@@ -369,10 +375,3 @@ int applyFilters(void) {
   }
   return 0;
 }
-
-int freeRam() 
-{
-  extern int __heap_start, *__brkval; 
-  int v; 
-  return (int) &v - (__brkval == 0 ? (int) &__heap_start : (int) __brkval); 
-}
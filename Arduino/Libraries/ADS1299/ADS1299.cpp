@@ -11,8 +11,9 @@
 #include "pins_arduino.h"
 #include "ADS1299.h"
 
-void ADS1299::initialize(int _DRDY, int _RST, int _CS, int _FREQ, boolean _isDaisy){
-	isDaisy = _isDaisy;
+template <class SPI, int N_BOARDS>
+void ADS1299_Driver<SPI,N_BOARDS>::initialize(int _DRDY, int _RST, int _CS, int _FREQ, boolean _isDaisy){
+	if (_isDaisy) { setNumBoards(2); } else { setNumBoards(1); }
 	DRDY = _DRDY;
 	CS = _CS;
 	int FREQ = _FREQ;
@@ -28,108 +29,71 @@ void ADS1299::initialize(int _DRDY, int _RST, int _CS, int _FREQ, boolean _isDai
 
     // **** ----- SPI Setup ----- **** //
     
-    // Set direction register for SCK and MOSI pin.
-    // MISO pin automatically overrides to INPUT.
-    // When the SS pin is set as OUTPUT, it can be used as
-    // a general purpose output port (it doesn't influence
-    // SPI operations).
-    
-    pinMode(SCK, OUTPUT);
-    pinMode(MOSI, OUTPUT);
-    pinMode(SS, OUTPUT);
-	
-    
-    digitalWrite(SCK, LOW);
-    digitalWrite(MOSI, LOW);
-    digitalWrite(SS, HIGH);
-    
-    // set as master and enable SPI
-    SPCR |= _BV(MSTR);
-    SPCR |= _BV(SPE);
-    //set bit order
-    SPCR &= ~(_BV(DORD)); ////SPI data format is MSB (pg. 25)
-	// set data mode
-    SPCR = (SPCR & ~SPI_MODE_MASK) | SPI_DATA_MODE; //clock polarity = 0; clock phase = 1 (pg. 8)
-    // set clock divider
-	switch (FREQ){
-		case 8:
-			DIVIDER = SPI_CLOCK_DIV_2;
-			break;
-		case 4:
-			DIVIDER = SPI_CLOCK_DIV_4;
-			break;
-		case 1:
-			DIVIDER = SPI_CLOCK_DIV_16;
-			break;
-		default:
-			break;
-	}
-    SPCR = (SPCR & ~SPI_CLOCK_MASK) | (DIVIDER);  // set SCK frequency  
-    SPSR = (SPSR & ~SPI_2XCLOCK_MASK) | (DIVIDER); // by dividing 16MHz system clock
-    
-    
-    
-    
+    // the board's SPI policy sets up the SPI port and the CS and DRDY pins
+    SPI::begin(FREQ);
     
     // **** ----- End of SPI Setup ----- **** //
     
-    // initalize the  data ready chip select and reset pins:
-    pinMode(DRDY, INPUT);
-    pinMode(CS, OUTPUT);
-	
-	digitalWrite(CS,HIGH); 	
 	digitalWrite(RST,HIGH);
 }
 
 //System Commands
-void ADS1299::WAKEUP() {
-    digitalWrite(CS, LOW); 
+template <class SPI, int N_BOARDS>
+void ADS1299_Driver<SPI,N_BOARDS>::WAKEUP() {
+    SPI::select(); 
     transfer(_WAKEUP);
-    digitalWrite(CS, HIGH); 
+    SPI::deselect(); 
     delayMicroseconds(3);  		//must wait 4 tCLK cycles before sending another command (Datasheet, pg. 35)
 }
 
-void ADS1299::STANDBY() {		// only allowed to send WAKEUP after sending STANDBY
-    digitalWrite(CS, LOW);
+template <class SPI, int N_BOARDS>
+void ADS1299_Driver<SPI,N_BOARDS>::STANDBY() {		// only allowed to send WAKEUP after sending STANDBY
+    SPI::select();
     transfer(_STANDBY);
-    digitalWrite(CS, HIGH);
+    SPI::deselect();
 }
 
-void ADS1299::RESET() {			// reset all the registers to default settings
-    digitalWrite(CS, LOW);
+template <class SPI, int N_BOARDS>
+void ADS1299_Driver<SPI,N_BOARDS>::RESET() {			// reset all the registers to default settings
+    SPI::select();
     transfer(_RESET);
     delayMicroseconds(12);   	//must wait 18 tCLK cycles to execute this command (Datasheet, pg. 35)
-    digitalWrite(CS, HIGH);
+    SPI::deselect();
 }
 
-void ADS1299::START() {			//start data conversion 
-    digitalWrite(CS, LOW);
+template <class SPI, int N_BOARDS>
+void ADS1299_Driver<SPI,N_BOARDS>::START() {			//start data conversion 
+    SPI::select();
     transfer(_START);
-    digitalWrite(CS, HIGH);
+    SPI::deselect();
 }
 
-void ADS1299::STOP() {			//stop data conversion
-    digitalWrite(CS, LOW);
+template <class SPI, int N_BOARDS>
+void ADS1299_Driver<SPI,N_BOARDS>::STOP() {			//stop data conversion
+    SPI::select();
     transfer(_STOP);
-    digitalWrite(CS, HIGH);
+    SPI::deselect();
 }
 
-void ADS1299::RDATAC() {
-    digitalWrite(CS, LOW);
+template <class SPI, int N_BOARDS>
+void ADS1299_Driver<SPI,N_BOARDS>::RDATAC() {
+    SPI::select();
     transfer(_RDATAC);
-    digitalWrite(CS, HIGH);
+    SPI::deselect();
 	delayMicroseconds(3);   
 }
-void ADS1299::SDATAC() {
-    digitalWrite(CS, LOW);
+template <class SPI, int N_BOARDS>
+void ADS1299_Driver<SPI,N_BOARDS>::SDATAC() {
+    SPI::select();
     transfer(_SDATAC);
-    digitalWrite(CS, HIGH);
+    SPI::deselect();
 	delayMicroseconds(3);   //must wait 4 tCLK cycles after executing this command (Datasheet, pg. 37)
 }
 
 
 // Register Read/Write Commands
-byte ADS1299::getDeviceID() {			// simple hello world com check
+template <class SPI, int N_BOARDS>
+byte ADS1299_Driver<SPI,N_BOARDS>::getDeviceID() {			// simple hello world com check
 	byte data = RREG(0x00);
 	if(verbose){						// verbose otuput
 		Serial.print(F("Device ID "));
@@ -138,13 +102,14 @@ byte ADS1299::getDeviceID() {			// simple hello world com check
 	return data;
 }
 
-byte ADS1299::RREG(byte _address) {		//  reads ONE register at _address
+template <class SPI, int N_BOARDS>
+byte ADS1299_Driver<SPI,N_BOARDS>::RREG(byte _address) {		//  reads ONE register at _address
     byte opcode1 = _address + 0x20; 	//  RREG expects 001rrrrr where rrrrr = _address
-    digitalWrite(CS, LOW); 				//  open SPI
+    SPI::select(); 				//  open SPI
     transfer(opcode1); 					//  opcode1
     transfer(0x00); 					//  opcode2
     regData[_address] = transfer(0x00);//  update mirror location with returned byte
-    digitalWrite(CS, HIGH); 			//  close SPI	
+    SPI::deselect(); 			//  close SPI	
 	if (verbose){						//  verbose output
 		printRegisterName(_address);
 		printHex(_address);
@@ -162,18 +127,19 @@ byte ADS1299::RREG(byte _address) {		//  reads ONE register at _address
 }
 
 // Read more than one register starting at _address
-void ADS1299::RREGS(byte _address, byte _numRegistersMinusOne) {
+template <class SPI, int N_BOARDS>
+void ADS1299_Driver<SPI,N_BOARDS>::RREGS(byte _address, byte _numRegistersMinusOne) {
 //	for(byte i = 0; i < 0x17; i++){
 //		regData[i] = 0;					//  reset the regData array
 //	}
     byte opcode1 = _address + 0x20; 	//  RREG expects 001rrrrr where rrrrr = _address
-    digitalWrite(CS, LOW); 				//  open SPI
+    SPI::select(); 				//  open SPI
     transfer(opcode1); 					//  opcode1
     transfer(_numRegistersMinusOne);	//  opcode2
     for(int i = 0; i <= _numRegistersMinusOne; i++){
         regData[_address + i] = transfer(0x00); 	//  add register byte to mirror array
 		}
-    digitalWrite(CS, HIGH); 			//  close SPI
+    SPI::deselect(); 			//  close SPI
 	if(verbose){						//  verbose output
 		for(int i = 0; i<= _numRegistersMinusOne; i++){
 			printRegisterName(_address + i);
@@ -191,13 +157,14 @@ void ADS1299::RREGS(byte _address, byte _numRegistersMinusOne) {
     
 }
 
-void ADS1299::WREG(byte _address, byte _value) {	//  Write ONE register at _address
+template <class SPI, int N_BOARDS>
+void ADS1299_Driver<SPI,N_BOARDS>::WREG(byte _address, byte _value) {	//  Write ONE register at _address
     byte opcode1 = _address + 0x40; 	//  WREG expects 010rrrrr where rrrrr = _address
-    digitalWrite(CS, LOW); 				//  open SPI
+    SPI::select(); 				//  open SPI
     transfer(opcode1);					//  Send WREG command & address
     transfer(0x00);						//	Send number of registers to read -1
     transfer(_value);					//  Write the value to the register
-    digitalWrite(CS, HIGH); 			//  close SPI
+    SPI::deselect(); 			//  close SPI
 	regData[_address] = _value;			//  update the mirror array
 	if(verbose){						//  verbose output
 		Serial.print(F("Register "));
@@ -206,15 +173,16 @@ void ADS1299::WREG(byte _address, byte _value) {	//  Write ONE register at _addr
 	}
 }
 
-void ADS1299::WREGS(byte _address, byte _numRegistersMinusOne) {
+template <class SPI, int N_BOARDS>
+void ADS1299_Driver<SPI,N_BOARDS>::WREGS(byte _address, byte _numRegistersMinusOne) {
     byte opcode1 = _address + 0x40;		//  WREG expects 010rrrrr where rrrrr = _address
-    digitalWrite(CS, LOW); 				//  open SPI
+    SPI::select(); 				//  open SPI
     transfer(opcode1);					//  Send WREG command & address
     transfer(_numRegistersMinusOne);	//	Send number of registers to read -1	
 	for (int i=_address; i <=(_address + _numRegistersMinusOne); i++){
 		transfer(regData[i]);			//  Write to the registers
 	}	
-	digitalWrite(CS,HIGH);				//  close SPI
+	SPI::deselect();				//  close SPI
 	if(verbose){
 		Serial.print(F("Registers "));
 		printHex(_address); Serial.print(F(" to "));
@@ -224,107 +192,72 @@ void ADS1299::WREGS(byte _address, byte _numRegistersMinusOne) {
 }
 
 
-void ADS1299::updateChannelData(){
-	byte inByte;
-	int nchan=8;  //assume 8 channel.  If needed, it automatically changes to 16 automatically in a later block.
-	digitalWrite(CS, LOW);				//  open SPI
-	
-	// READ CHANNEL DATA FROM FIRST ADS IN DAISY LINE
-	for(int i=0; i<3; i++){			//  read 3 byte status register from ADS 1 (1100+LOFF_STATP+LOFF_STATN+GPIO[7:4])
-		inByte = transfer(0x00);
-		stat_1 = (stat_1<<8) | inByte;				
-	}
-	
-	for(int i = 0; i<8; i++){
-		for(int j=0; j<3; j++){		//  read 24 bits of channel data from 1st ADS in 8 3 byte chunks
-			inByte = transfer(0x00);
-			channelData[i] = (channelData[i]<<8) | inByte;
-		}
-	}
-	
-	if (isDaisy) {
-		nchan = 16;
-		// READ CHANNEL DATA FROM SECOND ADS IN DAISY LINE
-		for(int i=0; i<3; i++){			//  read 3 byte status register from ADS 2 (1100+LOFF_STATP+LOFF_STATN+GPIO[7:4])
-			inByte = transfer(0x00);
-			stat_2 = (stat_1<<8) | inByte;				
-		}
+template <class SPI, int N_BOARDS>
+void ADS1299_Driver<SPI,N_BOARDS>::updateChannelData(){
+	updateChannelData(channelData);
+}
+
+template <class SPI, int N_BOARDS>
+void ADS1299_Driver<SPI,N_BOARDS>::updateChannelData(long *dataTarget){
+	readFrame(rawFrame);
+	unpackFrame(rawFrame,dataTarget);
+}
+
+template <class SPI, int N_BOARDS>
+int ADS1299_Driver<SPI,N_BOARDS>::getFrameBytes(void){
+	return nBoards*ADS_FRAME_BYTES_PER_BOARD;
+}
+
+template <class SPI, int N_BOARDS>
+void ADS1299_Driver<SPI,N_BOARDS>::setNumBoards(int N){
+	nBoards = constrain(N,1,N_BOARDS);
+	isDaisy = (nBoards > 1);
+}
+
+//Read the whole RDATAC frame (status + 8 channels from each ADS in the daisy line)
+//in one burst.  Nothing is converted here, so this is as short as it can be.
+template <class SPI, int N_BOARDS>
+void ADS1299_Driver<SPI,N_BOARDS>::readFrame(byte *frameTarget){
+	SPI::select();						//  open SPI
+	SPI::readBlock(frameTarget,getFrameBytes());
+	SPI::deselect();					//  close SPI
+}
+
+//Convert a raw frame into the status words and the 32-bit channel values.  The
+//3 byte 2's compliment values are sign extended by putting them in the top of
+//a 32-bit word and shifting back down, so there is no branching.
+template <class SPI, int N_BOARDS>
+void ADS1299_Driver<SPI,N_BOARDS>::unpackFrame(const byte *frame, long *dataTarget){
+	const byte *p = frame;
+	long *out = dataTarget;
+	for (int board=0; board < nBoards; board++) {
+		//  3 byte status register at the start of each ADS (1100+LOFF_STATP+LOFF_STATN+GPIO[7:4])
+		stat[board] = ((long)p[0] << 16) | ((long)p[1] << 8) | (long)p[2];
+		p += ADS_STATUS_BYTES;
 		
-		for(int i = 8; i<16; i++){
-			for(int j=0; j<3; j++){		//  read 24 bits of channel data from 2nd ADS in 8 3 byte chunks
-				inByte = transfer(0x00);
-				channelData[i] = (channelData[i]<<8) | inByte;
-			}
-		}
-	}
-	
-	digitalWrite(CS, HIGH);				//  close SPI
-	
-	//reformat the numbers
-	for(int i=0; i<nchan; i++){			// convert 3 byte 2's compliment to 4 byte 2's compliment	
-		if(bitRead(channelData[i],23) == 1){	
-			channelData[i] |= 0xFF000000;
-		}else{
-			channelData[i] &= 0x00FFFFFF;
+		for (int i=0; i < ADS_CHAN_PER_BOARD; i++) {
+			*out++ = ((int32_t)(((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8))) >> 8;  //32 bits, even where long is longer
+			p += ADS_BYTES_PER_CHAN;
 		}
 	}
 }
 
 	
 //read data
-void ADS1299::RDATA() {				//  use in Stop Read Continuous mode when DRDY goes low
-	byte inByte;
-	stat_1 = 0;							//  clear the status registers
-	stat_2 = 0;	
-	int nchan = 8;	//assume 8 channel.  If needed, it automatically changes to 16 automatically in a later block.
-	digitalWrite(CS, LOW);				//  open SPI
+template <class SPI, int N_BOARDS>
+void ADS1299_Driver<SPI,N_BOARDS>::RDATA() {				//  use in Stop Read Continuous mode when DRDY goes low
+	SPI::select();						//  open SPI
 	transfer(_RDATA);
-	
-	// READ CHANNEL DATA FROM FIRST ADS IN DAISY LINE
-	for(int i=0; i<3; i++){			//  read 3 byte status register (1100+LOFF_STATP+LOFF_STATN+GPIO[7:4])
-		inByte = transfer(0x00);
-		stat_1 = (stat_1<<8) | inByte;				
-	}
-	
-	for(int i = 0; i<8; i++){
-		for(int j=0; j<3; j++){		//  read 24 bits of channel data from 1st ADS in 8 3 byte chunks
-			inByte = transfer(0x00);
-			channelData[i] = (channelData[i]<<8) | inByte;
-		}
-	}
-	
-	if (isDaisy) {
-		nchan = 16;
-		
-		// READ CHANNEL DATA FROM SECOND ADS IN DAISY LINE
-		for(int i=0; i<3; i++){			//  read 3 byte status register (1100+LOFF_STATP+LOFF_STATN+GPIO[7:4])
-			inByte = transfer(0x00);
-			stat_2 = (stat_1<<8) | inByte;				
-		}
-		
-		for(int i = 8; i<16; i++){
-			for(int j=0; j<3; j++){		//  read 24 bits of channel data from 2nd ADS in 8 3 byte chunks
-				inByte = transfer(0x00);
-				channelData[i] = (channelData[i]<<8) | inByte;
-			}
-		}
-	}
-	
-	for(int i=0; i<nchan; i++){			// convert 3 byte 2's compliment to 4 byte 2's compliment	
-		if(bitRead(channelData[i],23) == 1){	
-			channelData[i] |= 0xFF000000;
-		}else{
-			channelData[i] &= 0x00FFFFFF;
-		}
-	}
-	
-    
+	SPI::readBlock(rawFrame,getFrameBytes());	//  same frame as in RDATAC mode
+	SPI::deselect();					//  close SPI
+	unpackFrame(rawFrame,channelData);
 }
 
 
 
 // String-Byte converters for RREG and WREG
-void ADS1299::printRegisterName(byte _address) {
+template <class SPI, int N_BOARDS>
+void ADS1299_Driver<SPI,N_BOARDS>::printRegisterName(byte _address) {
     if(_address == ID){
         Serial.print(F("ID, ")); //the "F" macro loads the string directly from Flash memory, thereby saving RAM
     }
@@ -399,18 +332,9 @@ void ADS1299::printRegisterName(byte _address) {
     }
 }
 
-//SPI communication methods
-byte ADS1299::transfer(byte _data) {
-	cli();
-    SPDR = _data;
-    while (!(SPSR & _BV(SPIF)))
-        ;
-	sei();
-    return SPDR;
-}
-
 // Used for printing HEX in verbose feedback mode
-void ADS1299::printHex(byte _data){
+template <class SPI, int N_BOARDS>
+void ADS1299_Driver<SPI,N_BOARDS>::printHex(byte _data){
 	Serial.print("0x");
     if(_data < 0x10) Serial.print("0");
     Serial.print(_data, HEX);
@@ -420,5 +344,14 @@ void ADS1299::printHex(byte _data){
 //-------------------------------------------------------------------//
 //-------------------------------------------------------------------//
 
+#if defined(__AVR__) && defined(PCINT0_vect)
+// the pin-change interrupt for port B, where DRDY is on the Uno.  The SPI policy says who to call.
+ISR(PCINT0_vect)
+{
+	ADS1299_ISR isr = ADS1299_SPI_Board::drdyISR();
+	if (isr != NULL) isr();
+}
+#endif
 
-
+// build the driver for this board
+template class ADS1299_Driver<ADS1299_SPI_Board,ADS_MAX_N_BOARDS>;
@@ -13,12 +13,35 @@
 #include <Arduino.h>
 #include <avr/pgmspace.h>
 #include "Definitions.h"
+#include "ADS1299_SPI.h"
 
+//size of the frame that the ADS1299 sends for each sample (Datasheet, p38)
+#define ADS_STATUS_BYTES (3)
+#define ADS_BYTES_PER_CHAN (3)
+#define ADS_CHAN_PER_BOARD (8)
+#define ADS_FRAME_BYTES_PER_BOARD (ADS_STATUS_BYTES + ADS_CHAN_PER_BOARD*ADS_BYTES_PER_CHAN)   // 27 bytes
 
-class ADS1299 {
+//The most ADS1299s that can be daisy chained.  This sizes all of the sample
+//buffers and the per-channel bookkeeping, so keep it small on the Uno.  Change it
+//here (or with -D) for a daisy chain.
+#ifndef ADS_MAX_N_BOARDS
+#define ADS_MAX_N_BOARDS (1)
+#endif
+
+
+//The driver is written once and specialized at compile time for the board's
+//SPI policy (see ADS1299_SPI.h) and for the longest daisy chain it must handle.
+template <class SPI, int N_BOARDS>
+class ADS1299_Driver {
 public:
+    enum {
+        MAX_N_BOARDS = N_BOARDS,
+        MAX_N_CHAN = N_BOARDS*ADS_CHAN_PER_BOARD,
+        MAX_FRAME_BYTES = N_BOARDS*ADS_FRAME_BYTES_PER_BOARD
+    };
     
     void initialize(int _DRDY, int _RST, int _CS, int _FREQ, boolean _isDaisy);
+    void setNumBoards(int N);                   //how many ADS1299s are actually in the daisy chain (1 to MAX_N_BOARDS)
     
     //ADS1299 SPI Command Definitions (Datasheet, p35)
     //System Commands
@@ -42,20 +65,32 @@ public:
     void WREGS(byte _address, byte _numRegistersMinusOne); 
     void printHex(byte _data);
     void updateChannelData();
+    void updateChannelData(long *dataTarget);   //same, but put the samples somewhere other than channelData
+    void readFrame(byte *frameTarget);          //read the raw frame in one burst, without converting it
+    void unpackFrame(const byte *frame, long *dataTarget);  //convert a raw frame to status words and 32-bit samples
+    int getFrameBytes(void);                    //number of bytes in each raw frame
     
     //SPI Transfer function
-    byte transfer(byte _data);
+    typedef typename SPI::Lock Lock;            //keeps the DRDY interrupt out while it exists
+    byte transfer(byte _data) { return SPI::transfer(_data); }
+    boolean isDRDY(void) { return SPI::isDataReady(); }	// true when DRDY is low
+    boolean attachDRDY(ADS1299_ISR isr) { return SPI::attachDRDY(isr); }  // false if this board has no interrupt for DRDY
+    void detachDRDY(void) { SPI::detachDRDY(); }
 
     //configuration
-    int DRDY, CS; 		// pin numbers for DRDY and CS 
-    int DIVIDER;		// select SPI SCK frequency
-    int stat_1, stat_2;    // used to hold the status register for boards 1 and 2
+    int DRDY, CS; 		// pin numbers for DRDY and CS (the SPI policy has the same numbers built in)
+    long stat [N_BOARDS];	// used to hold the status register for each board in the daisy chain
     byte regData [24];	// array is used to mirror register data
-    long channelData [16];	// array used when reading channel data board 1+2
+    byte rawFrame [MAX_FRAME_BYTES];	// the most recent frame, exactly as it came from the ADS
+    long channelData [MAX_N_CHAN];	// array used when reading channel data from all boards
     boolean verbose;		// turn on/off Serial feedback
     boolean isDaisy;		// does this have a daisy chain board?
+    int nBoards;		// how many boards are in the daisy chain
     
     
 };
 
+//the driver for the board that we're being compiled for
+typedef ADS1299_Driver<ADS1299_SPI_Board,ADS_MAX_N_BOARDS> ADS1299;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,124 @@
+//
+//  ADS1299BandPower.cpp
+//  Part of the Arduino Library for the ADS1299 Shield
+//
+//  Band power from Goertzel filters.  See ADS1299BandPower.h.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include <math.h>
+#include "ADS1299BandPower.h"
+
+//theta, alpha, and beta, until setBands() says otherwise
+static const float defaultEdges_Hz[] = {4.0, 8.0, 13.0, 30.0};
+
+ADS1299BandPower::ADS1299BandPower(int N, int B) {
+    Nchan = N;
+    maxBins = (B < 1) ? 1 : B;
+    nBins = 0;
+    blockLen = 0;
+    count = 0;
+    cosQ15 = sinQ15 = NULL;
+    state = NULL;
+    power_cB = NULL;
+    setBands(defaultEdges_Hz, 3);
+}
+
+ADS1299BandPower::~ADS1299BandPower() {
+    delete[] power_cB;
+    delete[] state;
+    delete[] sinQ15;
+    delete[] cosQ15;
+}
+
+boolean ADS1299BandPower::setBands(const float *edges, int N) {
+    if ((N < 1) || (N > ADS_BANDPOWER_MAX_BANDS)) return false;
+    for (int i=0; i < N; i++) if (edges[i+1] <= edges[i]) return false;
+    for (int i=0; i <= N; i++) edges_Hz[i] = edges[i];
+    nBands = N;
+    nBins = 0;  //setup() has to pick the bins again
+    return true;
+}
+
+boolean ADS1299BandPower::setup(float fs_Hz, int N) {
+    nBins = 0;
+    if ((fs_Hz <= 0.0) || (N < 4)) return false;
+
+    //the RAM is only taken once, the first time we're used
+    if (state == NULL) {
+        cosQ15 = new int16_t[maxBins];
+        sinQ15 = new int16_t[maxBins];
+        state = new long[Nchan*maxBins*2];
+        power_cB = new unsigned int[Nchan*ADS_BANDPOWER_MAX_BANDS];
+        if ((cosQ15 == NULL) || (sinQ15 == NULL) || (state == NULL) || (power_cB == NULL)) {
+            //out of RAM.  Give it all back.
+            delete[] power_cB; delete[] state; delete[] sinQ15; delete[] cosQ15;
+            cosQ15 = sinQ15 = NULL; state = NULL; power_cB = NULL;
+            return false;
+        }
+    }
+
+    //bin k is at k*fs/N.  Each band gets the bins from its lower edge up to (but not
+    //including) its upper edge.  The bins are all below Nyquist, so each one is
+    //matched by a mirror image above it, which is why its power is doubled below.
+    float binWidth_Hz = fs_Hz / N;
+    int k = (int)ceil(edges_Hz[0] / binWidth_Hz);
+    if (k < 1) k = 1;  //not DC
+    int total = 0;
+    for (int Iband=0; Iband < nBands; Iband++) {
+        int n = 0;
+        for ( ; (k*binWidth_Hz < edges_Hz[Iband+1]) && (2*k < N); k++) {
+            if (total + n >= maxBins) return false;  //too many bins.  Use shorter blocks or fewer bands.
+            float w = 2.0 * M_PI * k / N;
+            cosQ15[total+n] = (int16_t)constrain(floor(32768.0 * cos(w) + 0.5), -32768.0, 32767.0);
+            sinQ15[total+n] = (int16_t)constrain(floor(32768.0 * sin(w) + 0.5), -32768.0, 32767.0);
+            n++;
+        }
+        binsInBand[Iband] = (byte)n;
+        total += n;
+    }
+    for (int i=0; i < Nchan*ADS_BANDPOWER_MAX_BANDS; i++) power_cB[i] = 0;
+    nBins = total;
+    blockLen = N;
+    restart();
+    return true;
+}
+
+void ADS1299BandPower::restart(void) {
+    count = 0;
+    for (int i=0; i < Nchan*nBins*2; i++) state[i] = 0;
+}
+
+unsigned int ADS1299BandPower::getBandPower_cB(int Ichan, int Iband) {
+    if ((power_cB == NULL) || (Ichan < 0) || (Ichan >= Nchan) || (Iband < 0) || (Iband >= nBands)) return 0;
+    return power_cB[Ichan*ADS_BANDPOWER_MAX_BANDS + Iband];
+}
+
+//The end of a block.  For each bin, the DFT is X = s1 - exp(-jw)*s2 (give or take
+//a phase that doesn't change |X|), so |X|^2 = (s1 - cos(w)*s2)^2 + (sin(w)*s2)^2.
+//The real part is the difference of two big numbers, so it's done with integers;
+//only the squares are done in floating point.  A sine of amplitude A right on a bin
+//gives |X| = A*N/2, and its mean square is A^2/2, hence the 2/N^2.  This takes a
+//couple of msec on the Uno, once per block, which the DRDY sample ring covers.
+void ADS1299BandPower::finishBlock(void) {
+    const float scale = 2.0 / ((float)blockLen * (float)blockLen);
+    long *st = state;
+    for (int Ichan=0; Ichan < Nchan; Ichan++) {
+        int Ibin = 0;
+        for (int Iband=0; Iband < nBands; Iband++) {
+            float power = 0.0;
+            for (int i=0; i < binsInBand[Iband]; i++, Ibin++, st += 2) {
+                float re = (float)(st[0] - ((mulQ14(st[1], cosQ15[Ibin]) + 1) >> 1));
+                float im = (float)((mulQ14(st[1], sinQ15[Ibin]) + 1) >> 1);
+                power += re*re + im*im;
+            }
+            power *= scale;
+
+            //hundredths of a dB.  1 count^2 (0 dB) is well below the noise, so that's the floor.
+            float cB = (power > 1.0) ? (1000.0 * log10(power)) : 0.0;
+            power_cB[Ichan*ADS_BANDPOWER_MAX_BANDS + Iband] = (cB < 65535.0) ? (unsigned int)(cB + 0.5) : 65535;
+        }
+    }
+    restart();
+}
@@ -0,0 +1,105 @@
+//
+//  ADS1299BandPower.h
+//  Part of the Arduino Library for the ADS1299 Shield
+//
+//  Band power (theta, alpha, beta, or whatever bands you'd like) for each channel,
+//  worked out right here on the Arduino, so that only a few numbers per channel
+//  have to go over the serial link instead of every sample.  It is used by
+//  ADS1299Manager::writeChannelDataAsBandPower.
+//
+//  How it works:
+//    * the data is cut into blocks of N samples.  A new set of band powers comes
+//      out at the end of each block, so N sets the update rate (fs/N).
+//    * each block gets a DFT, but only at the bins that fall inside the bands.
+//      Each bin is a Goertzel filter, which takes one multiply per sample per bin
+//      and needs no buffer of past samples, so the work is spread evenly over the
+//      block.  The bins are fs/N apart (a rectangular window), so they are exactly
+//      the bins that an FFT of the same block would give.
+//    * at the end of the block, the power in each bin is added up over the bins of
+//      each band.  With the scaling here, that is the mean square of the part of
+//      the signal in the band (Parseval), in counts^2.
+//  Use it like this:
+//     ADS1299BandPower bandPower(8, 6);               //8 channels, up to 6 bins
+//     bandPower.setup(250.0, 50);                     //250 Hz, 50 sample blocks (5 Hz bins, 5 updates/sec)
+//     if (bandPower.process(channelData)) ...         //true when a new set of band powers is ready
+//
+//  The Goertzel states are integers (like Biquad_multiChan_fixed), with the cosines
+//  in Q15.  The state of a bin grows with the block length, so the input should
+//  already have its DC offset removed (highpass it first), and at the higher sample
+//  rates (long blocks) a big signal will saturate.  Up to 1 kHz, EEG is fine.  Against
+//  an FFT of the same block, it's within 0.05 dB at 250 Hz and 0.25 dB at 1 kHz, where the
+//  Q15 cosines of the lowest bins are a little off (see Tests/test_bandpower.cpp).
+//
+//  The RAM for the states is only taken the first time setup() is called: 8 bytes
+//  per bin per channel, plus 2 bytes per band per channel for the results.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#ifndef ____ADS1299BandPower__
+#define ____ADS1299BandPower__
+
+#include <Arduino.h>
+
+#define ADS_BANDPOWER_MAX_BANDS (4)
+#define ADS_BANDPOWER_STATE_LIMIT (1L << 29)   //the Goertzel states saturate here, so 2*cos*state can't overflow
+
+class ADS1299BandPower {
+public:
+    ADS1299BandPower(int Nchan, int maxBins);
+    ~ADS1299BandPower();
+    boolean setBands(const float *edges_Hz, int nBands);  //nBands+1 edges, lowest first.  Call setup() after.
+    boolean setup(float fs_Hz, int blockLen);   //pick the bins.  False if they don't fit in maxBins (or there's no RAM).
+    boolean process(const long *sample);        //add one sample (Nchan values).  True when a block has just finished.
+    void restart(void);                         //throw away the block so far and start a new one
+    unsigned int getBandPower_cB(int Ichan, int Iband);  //from the last block, in hundredths of a dB re 1 count^2
+    int getNChan(void) { return Nchan; }
+    int getNBands(void) { return nBands; }
+    int getNBins(void) { return nBins; }
+    int getBlockLen(void) { return blockLen; }
+
+    static long mulQ14(long value, int16_t coeff);   //value*coeff/2^14, rounded.  |value| must be under 2^29.
+
+protected:
+    int Nchan;
+    int maxBins;
+    int nBands;
+    float edges_Hz[ADS_BANDPOWER_MAX_BANDS+1];
+    byte binsInBand[ADS_BANDPOWER_MAX_BANDS];  //the bins are in order, so band 0 gets the first ones, and so on
+    int nBins;
+    int blockLen;
+    int count;                                  //samples so far in this block
+    int16_t *cosQ15;                            //[maxBins] cos(w) of each bin
+    int16_t *sinQ15;                            //[maxBins]
+    long *state;                                //[Nchan][nBins][s1, s2]
+    unsigned int *power_cB;                     //[Nchan][ADS_BANDPOWER_MAX_BANDS]
+    void finishBlock(void);
+};
+
+//The 32x16 multiply, without a 64-bit product.  value is split into its high and low 16 bits.
+inline long ADS1299BandPower::mulQ14(long value, int16_t coeff) {
+    long hi = value >> 16;                    //signed
+    long lo = value & 0xFFFFL;                //unsigned
+    return ((hi * coeff) << 2) + ((lo * coeff + (1L << 13)) >> 14);
+}
+
+inline boolean ADS1299BandPower::process(const long *sample) {
+    if (nBins == 0) return false;
+    long *st = state;
+    for (int Ichan=0; Ichan < Nchan; Ichan++) {
+        long x = sample[Ichan];
+        for (int Ibin=0; Ibin < nBins; Ibin++, st += 2) {
+            //s[n] = x[n] + 2*cos(w)*s[n-1] - s[n-2].  cos(w) in Q15 is 2*cos(w) in Q14.
+            long s0 = x + mulQ14(st[0], cosQ15[Ibin]) - st[1];
+            if (s0 > ADS_BANDPOWER_STATE_LIMIT) s0 = ADS_BANDPOWER_STATE_LIMIT;
+            if (s0 < -ADS_BANDPOWER_STATE_LIMIT) s0 = -ADS_BANDPOWER_STATE_LIMIT;
+            st[1] = st[0];
+            st[0] = s0;
+        }
+    }
+    if (++count < blockLen) return false;
+    finishBlock();
+    return true;
+}
+
+#endif
@@ -0,0 +1,91 @@
+//
+//  ADS1299Impedance.cpp
+//  Part of the Arduino Library for the ADS1299 Shield
+//
+//  Lock-in measurement of the lead-off signal.  See ADS1299Impedance.h.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include <math.h>
+#include "ADS1299Impedance.h"
+
+ADS1299Impedance::ADS1299Impedance(int N) {
+    Nchan = N;
+    blockLen = 0;
+    count = 0;
+    drive_Hz = 0.0;
+    cosQ15 = sinQ15 = 0;
+    state = NULL;
+    amplitude = NULL;
+    saturated = NULL;
+}
+
+ADS1299Impedance::~ADS1299Impedance() {
+    delete[] saturated;
+    delete[] amplitude;
+    delete[] state;
+}
+
+boolean ADS1299Impedance::setup(float fs_Hz, float f_Hz, float updateRate_Hz) {
+    blockLen = 0;
+    drive_Hz = f_Hz;
+    if ((fs_Hz <= 0.0) || (f_Hz <= 0.0) || (f_Hz >= 0.5*fs_Hz) || (updateRate_Hz <= 0.0)) return false;  //DC lead-off has no tone
+
+    //the RAM is only taken once, the first time we're used
+    if (state == NULL) {
+        state = new long[Nchan*3];
+        amplitude = new float[Nchan];
+        saturated = new byte[Nchan];
+        if ((state == NULL) || (amplitude == NULL) || (saturated == NULL)) {
+            delete[] saturated; delete[] amplitude; delete[] state;
+            state = NULL; amplitude = NULL; saturated = NULL;
+            return false;
+        }
+    }
+
+    //as near to the update rate as we can get with a whole number of periods.  The
+    //lead-off frequencies are all the sample rate divided by a power of two, so each
+    //period is a whole number of samples too.
+    float period = fs_Hz / f_Hz;
+    long nPeriods = (long)(fs_Hz / updateRate_Hz / period + 0.5);
+    if (nPeriods < 1) nPeriods = 1;
+    long N = (long)(nPeriods * period + 0.5);
+    while (N > 32767) N = (long)((--nPeriods) * period + 0.5);
+    blockLen = (int)N;
+
+    float w = 2.0 * M_PI * f_Hz / fs_Hz;
+    cosQ15 = (int16_t)constrain(floor(32768.0 * cos(w) + 0.5), -32768.0, 32767.0);
+    sinQ15 = (int16_t)constrain(floor(32768.0 * sin(w) + 0.5), -32768.0, 32767.0);
+    for (int Ichan=0; Ichan < Nchan; Ichan++) amplitude[Ichan] = 0.0;
+    restart();
+    return true;
+}
+
+void ADS1299Impedance::restart(void) {
+    count = 0;
+    if (state == NULL) return;
+    for (int i=0; i < Nchan*3; i++) state[i] = 0;
+    for (int Ichan=0; Ichan < Nchan; Ichan++) saturated[Ichan] = false;
+}
+
+float ADS1299Impedance::getAmplitude(int Ichan) {
+    if ((amplitude == NULL) || (Ichan < 0) || (Ichan >= Nchan)) return 0.0;
+    return amplitude[Ichan];
+}
+
+//|X|^2 = (s1 - cos(w)*s2)^2 + (sin(w)*s2)^2, as in ADS1299BandPower::finishBlock.  A tone
+//of amplitude A gives |X| = A*N/2.  If the states saturated, that isn't the tone any more.
+void ADS1299Impedance::finishBlock(void) {
+    long *st = state;
+    for (int Ichan=0; Ichan < Nchan; Ichan++, st += 3) {
+        if (saturated[Ichan]) {
+            amplitude[Ichan] = ADS_IMPEDANCE_AMPLITUDE_OVER_RANGE;
+            continue;
+        }
+        float re = (float)(st[0] - ((ADS1299BandPower::mulQ14(st[1], cosQ15) + 1) >> 1));
+        float im = (float)((ADS1299BandPower::mulQ14(st[1], sinQ15) + 1) >> 1);
+        amplitude[Ichan] = 2.0 * sqrt(re*re + im*im) / (float)blockLen;
+    }
+    restart();
+}
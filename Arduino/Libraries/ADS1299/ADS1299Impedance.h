@@ -0,0 +1,88 @@
+//
+//  ADS1299Impedance.h
+//  Part of the Arduino Library for the ADS1299 Shield
+//
+//  Electrode impedance from the ADS1299's AC lead-off current.  With AC lead-off
+//  (configureLeadOffDetection with LOFF_FREQ_7p8HZ, LOFF_FREQ_31p2HZ, or LOFF_FREQ_FS_4)
+//  each channel that has lead-off turned on (changeChannelLeadOffDetection) gets a
+//  small square-wave current pushed through its electrode.  The voltage that this
+//  makes is the current times the electrode's impedance, so it shows up in the data
+//  as a tone at the lead-off frequency.  This measures how big that tone is.
+//
+//  It is a lock-in amplifier: the data is cut into blocks that are a whole number of
+//  periods of the lead-off signal long, and each block gets a single-bin DFT right at
+//  the lead-off frequency (a Goertzel filter, one multiply per sample per channel,
+//  the same as in ADS1299BandPower).  Over a whole number of periods, the electrode's
+//  DC offset and everything else that repeats at that rate drops right out.  It is
+//  used by ADS1299Manager::writeChannelDataAsImpedance, which turns the tone into ohms.
+//
+//  That's in theory, though.  The offset can be 100 mV (millions of counts), and the
+//  Goertzel filter's gain at DC is big (26x at 250 Hz, 400x at 1 kHz, for 7.8 Hz), so
+//  it would fill the integer states and leak into the answer through the rounding of
+//  cos(w).  So each channel's first sample of the block is taken off of the rest of
+//  the block first, which leaves just the tone and whatever the offset drifts by.  If
+//  a state still saturates (a huge impedance, or an electrode that's come off), the
+//  answer for that block is meaningless, so getAmplitude() says so (isOverRange()).
+//
+//  Give it the raw data, before any filters.  A lowpass below the lead-off frequency
+//  would take the tone out.
+//
+//  The RAM for the state (17 bytes per channel) is only taken the first time setup()
+//  is called.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#ifndef ____ADS1299Impedance__
+#define ____ADS1299Impedance__
+
+#include <Arduino.h>
+#include "ADS1299BandPower.h"   //for the multiply
+
+#define ADS_IMPEDANCE_AMPLITUDE_OVER_RANGE (-1.0)   //what getAmplitude() gives if the block saturated
+
+class ADS1299Impedance {
+public:
+    ADS1299Impedance(int Nchan);
+    ~ADS1299Impedance();
+    boolean setup(float fs_Hz, float drive_Hz, float updateRate_Hz);  //false if it's DC lead-off (or there's no RAM)
+    boolean process(const long *sample);        //add one sample (Nchan values).  True when a block has just finished.
+    void restart(void);                         //throw away the block so far and start a new one
+    float getAmplitude(int Ichan);              //peak amplitude of the tone in the last block, in counts, or ADS_IMPEDANCE_AMPLITUDE_OVER_RANGE
+    boolean isOverRange(int Ichan) { return getAmplitude(Ichan) < 0.0; }
+    int getNChan(void) { return Nchan; }
+    int getBlockLen(void) { return blockLen; }
+    float getDriveFrequency_Hz(void) { return drive_Hz; }
+
+protected:
+    int Nchan;
+    int blockLen;                               //0 until setup() works
+    int count;                                  //samples so far in this block
+    float drive_Hz;
+    int16_t cosQ15, sinQ15;                     //of the lead-off frequency
+    long *state;                                //[Nchan][s1, s2, offset]
+    float *amplitude;                           //[Nchan]
+    byte *saturated;                            //[Nchan] true if a state hit the limit in this block
+    void finishBlock(void);
+};
+
+inline boolean ADS1299Impedance::process(const long *sample) {
+    if (blockLen == 0) return false;
+    long *st = state;
+    for (int Ichan=0; Ichan < Nchan; Ichan++, st += 3) {
+        if (count == 0) st[2] = sample[Ichan];   //the offset, for the rest of the block
+        //s[n] = x[n] + 2*cos(w)*s[n-1] - s[n-2], as in ADS1299BandPower::process
+        long s0 = (sample[Ichan] - st[2]) + ADS1299BandPower::mulQ14(st[0], cosQ15) - st[1];
+        if ((s0 > ADS_BANDPOWER_STATE_LIMIT) || (s0 < -ADS_BANDPOWER_STATE_LIMIT)) {
+            s0 = (s0 > 0) ? ADS_BANDPOWER_STATE_LIMIT : -ADS_BANDPOWER_STATE_LIMIT;
+            saturated[Ichan] = true;
+        }
+        st[1] = st[0];
+        st[0] = s0;
+    }
+    if (++count < blockLen) return false;
+    finishBlock();
+    return true;
+}
+
+#endif
@@ -0,0 +1,128 @@
+//
+//  ADS1299LeadOffScan.cpp
+//  Part of the Arduino Library for the ADS1299 Shield
+//
+//  Round-robin impedance scan.  See ADS1299LeadOffScan.h.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "ADS1299LeadOffScan.h"
+
+ADS1299LeadOffScan::ADS1299LeadOffScan(ADS1299Manager *A, ADS1299Impedance *impedance) {
+    ADS = A;
+    imp = impedance;
+    nChan = 0;
+    side = PCHAN;
+    dwell_sec = 1.0;
+    dwellSamples = 0;
+    testChan = -1;
+    waiting = false;
+    for (int chan=0; chan < ADS1299::MAX_N_CHAN; chan++) codes[chan] = ADS_IMPEDANCE_NOT_MEASURED;
+}
+
+boolean ADS1299LeadOffScan::start(int N, byte code_P_N, float dwell)
+{
+    stop();
+    if (imp->getBlockLen() == 0) return false;  //the lock-in isn't set up (DC lead-off?)
+    if ((code_P_N != PCHAN) && (code_P_N != NCHAN)) return false;
+    nChan = constrain(N,0,min(imp->getNChan(),(int)ADS1299::MAX_N_CHAN));
+    side = code_P_N;
+    setDwell(dwell);
+    for (int chan=0; chan < ADS1299::MAX_N_CHAN; chan++) codes[chan] = ADS_IMPEDANCE_NOT_MEASURED;
+
+    int first = nextChannel(-1);
+    if (first < 0) return false;  //no channels are on
+
+    //the lead-off current on just the first channel, all in one burst
+    ADS->beginConfig();
+    for (int Ichan=0; Ichan < OPENBCI_NCHAN_PER_BOARD; Ichan++) ADS->changeChannelLeadOffDetection(Ichan+1,OFF,side);
+    moveTo(first);
+    ADS->commit();
+    return true;
+}
+
+void ADS1299LeadOffScan::stop(void)
+{
+    if (testChan >= 0) ADS->changeChannelLeadOffDetection(testChan+1,OFF,side);
+    testChan = -1;
+    waiting = false;
+}
+
+//Only whole lock-in blocks count, and the first one after a move has the ADS's filter
+//settling in it, so it takes at least two.
+void ADS1299LeadOffScan::setDwell(float dwell)
+{
+    dwell_sec = dwell;
+    dwellSamples = (long)(dwell_sec * ADS->getSampleRate_Hz() + 0.5);
+    dwellSamples = max(dwellSamples,2L*imp->getBlockLen());
+}
+
+unsigned int ADS1299LeadOffScan::getImpedanceCode(int chan)
+{
+    if ((chan < 0) || (chan >= ADS1299::MAX_N_CHAN)) return ADS_IMPEDANCE_NOT_MEASURED;
+    return codes[chan];
+}
+
+boolean ADS1299LeadOffScan::update(long sampleNumber, boolean sendPackets)
+{
+    if (testChan < 0) return false;
+
+    if (waiting) {
+        //Wait for the first sample with the new setting.  With hot reconfiguration, it's
+        //the one marked as a discontinuity.  Without it (or if nothing actually changed,
+        //because only one channel is on) there is no mark, so don't wait forever.
+        if ((ADS->getDiscontinuity() < 0) && (++waitCount <= ADS_LEADOFF_SCAN_MAX_WAIT)) return false;
+        waiting = false;
+        dwellCount = 0;
+        nBlocks = 0;
+        for (int Iboard=0; Iboard < ADS_MAX_N_BOARDS; Iboard++) ampSum[Iboard] = 0.0;
+        imp->restart();
+        if (sendPackets) ADS->writeLeadOffScanPacket(sampleNumber,testChan+1,side);
+    }
+
+    dwellCount++;
+    if (!imp->process(ADS->channelData)) return false;
+    if (nBlocks < 255) nBlocks++;
+    if (nBlocks < 2) return false;  //the one with the settling in it
+
+    //the average tone over the blocks so far.  Once a block saturates, the channel is
+    //over range for the rest of the dwell (the sum stays negative).
+    int Iboard = 0;
+    for (int chan = testChan; chan < nChan; chan += OPENBCI_NCHAN_PER_BOARD, Iboard++) {
+        if (imp->isOverRange(chan) || (ampSum[Iboard] < 0.0)) ampSum[Iboard] = ADS_IMPEDANCE_AMPLITUDE_OVER_RANGE;
+        else ampSum[Iboard] += imp->getAmplitude(chan);
+        codes[chan] = ADS->getImpedanceCode(chan,ampSum[Iboard] / (float)(nBlocks-1),imp->getDriveFrequency_Hz());
+    }
+    if (dwellCount < dwellSamples) return false;
+
+    //done with this channel.  Send all of them, and move on.
+    if (sendPackets) ADS->writeImpedancePacket(sampleNumber,imp->getBlockLen(),nChan,codes);
+    int next = nextChannel(testChan);
+    moveTo((next < 0) ? testChan : next);  //if every channel got turned off, just stay put
+    return true;
+}
+
+//the next channel after Ichan that is on, going around in a circle
+int ADS1299LeadOffScan::nextChannel(int Ichan)
+{
+    int nBoardChan = min(nChan,OPENBCI_NCHAN_PER_BOARD);
+    for (int i=1; i <= nBoardChan; i++) {
+        int chan = (Ichan + i) % nBoardChan;
+        if (ADS->isChannelActive(chan+1)) return chan;
+    }
+    return -1;
+}
+
+//move the lead-off current from the current channel to Ichan.  Both are in the same
+//register, so inside a beginConfig()/commit() it's a single register write.
+void ADS1299LeadOffScan::moveTo(int Ichan)
+{
+    ADS->beginConfig();
+    if (testChan >= 0) ADS->changeChannelLeadOffDetection(testChan+1,OFF,side);
+    ADS->changeChannelLeadOffDetection(Ichan+1,ON,side);
+    ADS->commit();
+    testChan = Ichan;
+    waiting = true;
+    waitCount = 0;
+}
@@ -0,0 +1,75 @@
+//
+//  ADS1299LeadOffScan.h
+//  Part of the Arduino Library for the ADS1299 Shield
+//
+//  Keeps an eye on the electrode impedance of every channel during a long recording,
+//  without stopping the data.  Instead of turning on the lead-off current for all of the
+//  channels (which puts the lead-off tone into all of them), it is turned on for one
+//  channel at a time, and moved on to the next channel every so often (the dwell time).
+//  While it sits on a channel, the lock-in (ADS1299Impedance) measures that channel's
+//  impedance.  At the end of the dwell, a packet goes out with the latest impedance of
+//  every channel, so the PC always has the whole picture, just a little older for some
+//  channels than others.
+//
+//  Moving to the next channel only changes one register (LOFF_SENSP or LOFF_SENSN), as
+//  the old channel's bit and the new channel's bit are in the same one.  With hot
+//  reconfiguration (ADS1299Manager::setHotReconfig), that one register goes out between
+//  two samples, so not a sample is lost.  The first sample with the new setting is marked
+//  with a lead-off scan packet (see ADS1299Manager::writeLeadOffScanPacket) saying which
+//  channel now has the lead-off tone in it.  The other channels aren't touched at all.
+//
+//  The lead-off settings are shared by the daisy-chained boards, so channel 1 is scanned
+//  along with channel 9, and so on.  Channels that are turned off are skipped.  Starting
+//  a scan turns off the lead-off current on all of the other channels on that side.
+//  Use it like this:
+//     ADS1299LeadOffScan scan(&ADSManager,&impedance);
+//     impedance.setup(250.0,ADSManager.getLeadOffFrequency_Hz(),2.0);  //needs AC lead-off
+//     scan.start(8,PCHAN,1.0);                         //8 channels, P side, 1 second each
+//     scan.update(sampleNumber,true);                  //with every sample, before the filters
+//
+//  It uses the lock-in while it runs, so don't also give that lock-in to
+//  ADS1299Manager::writeChannelDataAsImpedance.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#ifndef ____ADS1299LeadOffScan__
+#define ____ADS1299LeadOffScan__
+
+#include <Arduino.h>
+#include "ADS1299Manager.h"
+
+//After moving to the next channel, wait this many samples at most for the sample that's
+//marked as the start of the new setting.  Without hot reconfiguration there is no mark.
+#define ADS_LEADOFF_SCAN_MAX_WAIT (ADS_SAMPLE_RING_LEN+4)
+
+class ADS1299LeadOffScan {
+public:
+    ADS1299LeadOffScan(ADS1299Manager *ADS, ADS1299Impedance *impedance);
+    boolean start(int N, byte code_P_N, float dwell_sec);  //scan the first N channels on the PCHAN or NCHAN side.  Set up the lock-in first.
+    void stop(void);                            //turn the lead-off current back off
+    void setDwell(float dwell_sec);             //how long to stay on each channel.  At least two lock-in blocks.
+    boolean update(long sampleNumber, boolean sendPackets);  //with every raw sample.  True when it has just moved on.
+    boolean isScanning(void) { return (testChan >= 0); }
+    int getChannelUnderTest(void) { return testChan+1; }    //1-8, or 0 if it isn't scanning
+    unsigned int getImpedanceCode(int chan);    //the latest impedance of channel chan (from 0), as in the impedance packet
+
+protected:
+    ADS1299Manager *ADS;
+    ADS1299Impedance *imp;
+    int nChan;                                  //channels in the report, across all of the boards
+    byte side;                                  //PCHAN or NCHAN
+    float dwell_sec;
+    long dwellSamples;
+    int testChan;                               //the channel (from 0) with the lead-off current, or -1
+    boolean waiting;                            //for the first sample with the new setting
+    int waitCount;
+    long dwellCount;                            //samples since then
+    byte nBlocks;                               //lock-in blocks since then
+    float ampSum[ADS_MAX_N_BOARDS];             //the tone on testChan of each board, added up over the blocks
+    unsigned int codes[ADS1299::MAX_N_CHAN];
+    int nextChannel(int Ichan);
+    void moveTo(int Ichan);
+};
+
+#endif
@@ -15,16 +15,38 @@ void ADS1299Manager::initialize(void) {
 //Initilize the ADS1299 controller...call this once
 void ADS1299Manager::initialize(const int version,boolean isDaisy) 
 {
-  ADS1299::initialize(PIN_DRDY,PIN_RST,PIN_CS,SCK_MHZ,isDaisy); // (DRDY pin, RST pin, CS pin, SCK frequency in MHz);
+  int nBoards = 1;
+  if (isDaisy) nBoards = 2;
+  initializeBoards(version,nBoards);
+}
+
+//Initilize the ADS1299 controller for a daisy chain of nBoards...call this once.
+//Note that all of the boards share DIN and CS, so every register write goes to
+//all of them.  So channel 9 always has the same settings as channel 1, and so on.
+void ADS1299Manager::initializeBoards(const int version,int nBoards) 
+{
+  ADS1299::initialize(PIN_DRDY,PIN_RST,PIN_CS,SCK_MHZ,(nBoards > 1)); // (DRDY pin, RST pin, CS pin, SCK frequency in MHz);
+  ADS1299::setNumBoards(nBoards);
+  n_chan_all_boards = ADS1299::nBoards*OPENBCI_NCHAN_PER_BOARD;
   delay(100);
     
   verbose = false;      // when verbose is true, there will be Serial feedback 
+  registersLoaded = false;
+  useDRDYInterrupt = false;
+  ringHead = 0; ringTail = 0; ringPeakDepth = 0;
+  ringSampleCounter = 0; ringOverruns = 0;
+  deltaKeyframeInterval = ADS_DELTA_KEYFRAME_INTERVAL;
+  resetDeltaEncoder();
+  batchCount = 0;
+  setBatchSize(8);
+  txBack = 0; txLen[0] = 0; txLen[1] = 0; txSent = 0;
+  txStalls = 0; txPeakDepth = 0;
+  cobsFraming = false;
+  hotReconfig = false; hotCommitPending = false; hotAtBoundary = false; hotMarker = 0; hotSamplesLost = 0;
+  currentDiscontinuity = -1; currentDiscontinuityChannels = 0;
   setVersionOpenBCI(version);
   reset();
   
-  n_chan_all_boards = OPENBCI_NCHAN_PER_BOARD;
-  if (isDaisy) n_chan_all_boards = 2*OPENBCI_NCHAN_PER_BOARD;
-  
   //set default state for internal test signal
   //ADS1299::WREG(CONFIG2,0b11010000);delay(1);   //set internal test signal, default amplitude, default speed, datasheet PDF Page 41
   //ADS1299::WREG(CONFIG2,0b11010001);delay(1);   //set internal test signal, default amplitude, 2x speed, datasheet PDF Page 41
@@ -45,7 +67,7 @@ void ADS1299Manager::setVersionOpenBCI(const int version)
   	  use_neg_inputs = false;
   	  
   	  //set SRB2
-  	  for (int i=0; i < OPENBCI_NCHAN_PER_BOARD; i++) {
+  	  for (int i=0; i < ADS1299::MAX_N_CHAN; i++) {
   	  	  use_SRB2[i] = false;
   	  }
   } else {
@@ -53,22 +75,31 @@ void ADS1299Manager::setVersionOpenBCI(const int version)
   	  use_neg_inputs = true;
   	  
   	  //set SRB
-  	  for (int i=0; i < OPENBCI_NCHAN_PER_BOARD; i++) {
+  	  for (int i=0; i < ADS1299::MAX_N_CHAN; i++) {
   	  	  use_SRB2[i] = true;
   	  }
   	  
   }
   
-  //set whether or not to flip the polarity of the lead_off drive based
-  //on whether we're sensing the positive or negative inputs
+  //the polarity of the lead_off drive (LOFF_FLIP) follows from use_neg_inputs.  reset()
+  //sets it, as a RESET clears it.  Before that (when called from initializeBoards), the
+  //ADS is still in RDATAC mode and wouldn't hear the write anyway.
+  if (registersLoaded) {
+    beginConfig();
+    writeRegister(LOFF_FLIP,leadOffFlip());
+    setSRB1(use_SRB1());
+    commit();
+  }
+}
+
+//flip the polarity of the lead_off drive if we're sensing the negative inputs
+byte ADS1299Manager::leadOffFlip(void)
+{
   if (use_neg_inputs==false) {
-  	  //we're using positive.  Set to default polarity
-  	  ADS1299::WREG(LOFF_FLIP,0b00000000);delay(1);  //set all channels to zero
+  	  return 0b00000000;  //we're using positive.  Set to default polarity
   } else {
-  	  //we're using negative.  flip the polarity
-  	  ADS1299::WREG(LOFF_FLIP,0b11111111);delay(1);
+  	  return 0b11111111;  //we're using negative.  flip the polarity
   }
-  
 }
 
 //reset all the ADS1299's settings.  Call however you'd like.  Stops all data acquisition
@@ -78,46 +109,60 @@ void ADS1299Manager::reset(void)
   ADS1299::SDATAC();            // exit Read Data Continuous mode to communicate with ADS
   
   delay(100);
+  
+  //load the shadow copy of the registers.  From here on, we read from the shadow copy instead of the ADS.
+  boolean prevVerboseState = verbose;
+  verbose = false;
+  ADS1299::RREGS(0x00,CONFIG4);
+  verbose = prevVerboseState;
+  registersLoaded = true;
+  dirtyRegisters = 0;
+  configDepth = 0;
+  isRunning = false;
     
   // turn off all channels
-  for (int chan=1; chan <= OPENBCI_NCHAN_PER_BOARD; chan++) {
+  beginConfig();
+  writeRegister(LOFF_FLIP,leadOffFlip());  //set the polarity of the lead_off drive
+  for (int chan=1; chan <= n_chan_all_boards; chan++) {
     deactivateChannel(chan);  //turn off the channel
     changeChannelLeadOffDetection(chan,OFF,BOTHCHAN); //turn off any impedance monitoring
   }
   
   setSRB1(use_SRB1());  //set whether SRB1 is active or not
   setAutoBiasGeneration(true); //configure ADS1299 so that bias is generated based on channel state
+  commit();  //send it all at once
 };
 
 
-//deactivate the given channel...note: stops data colleciton to issue its commands
-//  N is the channel number: 1-8
+//deactivate the given channel...note: if running, briefly pauses the data to issue its commands
+//  N is the channel number: 1-8 (or up to 8 times the number of daisy-chained boards)
 // 
 void ADS1299Manager::deactivateChannel(int N)
 {
   byte reg, config;
 	
   //check the inputs
-  if ((N < 1) || (N > OPENBCI_NCHAN_PER_BOARD)) return;
+  if ((N < 1) || (N > n_chan_all_boards)) return;
   
-  //proceed...first, disable any data collection
-  ADS1299::SDATAC(); delay(1);      // exit Read Data Continuous mode to communicate with ADS
+  //stage all of the changes and send them together at the end
+  beginConfig();
 
   //shut down the channel
-  int N_zeroRef = constrain(N-1,0,OPENBCI_NCHAN_PER_BOARD-1);  //subtracts 1 so that we're counting from 0, not 1
-  reg = CH1SET+(byte)N_zeroRef;
-  config = ADS1299::RREG(reg); delay(1);
+  reg = CH1SET+(byte)channelRegIndex(N);
+  config = readRegister(reg);
   bitSet(config,7);  //left-most bit (bit 7) = 1, so this shuts down the channel
   if (use_neg_inputs) bitClear(config,3);  //bit 3 = 0 disconnects SRB2
-  ADS1299::WREG(reg,config); delay(1);
+  writeRegister(reg,config);
   
   //set how this channel affects the bias generation...
   alterBiasBasedOnChannelState(N);
+  
+  commit();
 }; 
     
         
 //Active a channel in single-ended mode  
-//  N is 1 through 8
+//  N is 1 through 8 (or up to 8 times the number of daisy-chained boards)
 //  gainCode is defined in the macros in the header file
 //  inputCode is defined in the macros in the header file
 void ADS1299Manager::activateChannel(int N,byte gainCode,byte inputCode) 
@@ -125,24 +170,24 @@ void ADS1299Manager::activateChannel(int N,byte gainCode,byte inputCode)
   byte reg, config;
 	
    //check the inputs
-  if ((N < 1) || (N > OPENBCI_NCHAN_PER_BOARD)) return;
+  if ((N < 1) || (N > n_chan_all_boards)) return;
   
-  //proceed...first, disable any data collection
-  ADS1299::SDATAC(); delay(1);      // exit Read Data Continuous mode to communicate with ADS
+  //stage all of the changes and send them together at the end
+  beginConfig();
 
   //active the channel using the given gain.  Set MUX for normal operation
   //see ADS1299 datasheet, PDF p44
-  N = constrain(N-1,0,OPENBCI_NCHAN_PER_BOARD-1);  //shift down by one
+  N = constrain(N-1,0,n_chan_all_boards-1);  //shift down by one
   byte configByte = 0b00000000;  //left-most zero (bit 7) is to activate the channel
   gainCode = gainCode & 0b01110000;  //bitwise AND to get just the bits we want and set the rest to zero
   configByte = configByte | gainCode; //bitwise OR to set just the gain bits high or low and leave the rest alone
   inputCode = inputCode & 0b00000111;  //bitwise AND to get just the bits we want and set the rest to zero
   configByte = configByte | inputCode; //bitwise OR to set just the gain bits high or low and leave the rest alone
   if (use_SRB2[N]) configByte |= 0b00001000;  //set the SRB2 flag...p44 in the data sheet
-  ADS1299::WREG(CH1SET+(byte)N,configByte); delay(1);
+  writeRegister(CH1SET+(byte)(N % OPENBCI_NCHAN_PER_BOARD),configByte);
 
   //add this channel to the bias generation
-  alterBiasBasedOnChannelState(N);
+  alterBiasBasedOnChannelState(N+1);  //(N was shifted down above)
   
   // // Now, these actions are necessary whenever there is at least one active channel
   // // though they don't strictly need to be done EVERY time we activate a channel.
@@ -152,17 +197,19 @@ void ADS1299Manager::activateChannel(int N,byte gainCode,byte inputCode)
   setSRB1(use_SRB1());
 
   //Finalize the bias setup...activate buffer and use internal reference for center of bias creation, datasheet PDF p42
-  ADS1299::WREG(CONFIG3,0b11101100); delay(1); 
+  writeRegister(CONFIG3,0b11101100);
+  
+  commit();
 };
 
 //note that N here one-referenced (ie [1...N]), not [0...N-1]
 boolean ADS1299Manager::isChannelActive(int N_oneRef) {
-	 int N_zeroRef = constrain(N_oneRef-1,0,OPENBCI_NCHAN_PER_BOARD-1);  //subtracts 1 so that we're counting from 0, not 1
+	 int N_zeroRef = channelRegIndex(N_oneRef);
 	 
 	 //get whether channel is active or not
 	 byte reg = CH1SET+(byte)N_zeroRef;
-	 byte config = ADS1299::RREG(reg); delay(1);
-	 boolean chanState = bitRead(config,7);
+	 byte config = readRegister(reg);
+	 boolean chanState = !bitRead(config,7);  //bit 7 set means the channel is powered down
 	 return chanState;
 }
 
@@ -170,15 +217,15 @@ void ADS1299Manager::setAutoBiasGeneration(boolean state) {
 	use_channels_for_bias = state;
 	
 	//step through the channels are recompute the bias state
-	for (int Ichan=1; Ichan<OPENBCI_NCHAN_PER_BOARD;Ichan++) {
+	beginConfig();
+	for (int Ichan=1; Ichan<=OPENBCI_NCHAN_PER_BOARD;Ichan++) {
 		alterBiasBasedOnChannelState(Ichan);
 	}
+	commit();
 }
 
 //note that N here one-referenced (ie [1...N]), not [0...N-1]
 void ADS1299Manager::alterBiasBasedOnChannelState(int N_oneRef) {
-	 int N_zeroRef = constrain(N_oneRef-1,0,OPENBCI_NCHAN_PER_BOARD-1);  //subtracts 1 so that we're counting from 0, not 1
-	
 	 boolean activateBias = false;
 	 if ((use_channels_for_bias==true) && (isChannelActive(N_oneRef))) {
 	 	 //activate this channel's bias
@@ -190,7 +237,7 @@ void ADS1299Manager::alterBiasBasedOnChannelState(int N_oneRef) {
 	
 
 void ADS1299Manager::deactivateBiasForChannel(int N_oneRef) {
-	int N_zeroRef = constrain(N_oneRef-1,0,OPENBCI_NCHAN_PER_BOARD-1); //subtracts 1 so that we're counting from 0, not 1
+	int N_zeroRef = channelRegIndex(N_oneRef);  //this channel's bit, which is shared by the daisy-chained boards
  	
 	//deactivate this channel's bias...both positive and negative
 	//see ADS1299 datasheet, PDF p44.
@@ -201,13 +248,13 @@ void ADS1299Manager::deactivateBiasForChannel(int N_oneRef) {
 		} else {
 			reg = BIAS_SENSN;
 		}
-		config = ADS1299::RREG(reg); delay(1);//get the current bias settings
+		config = readRegister(reg);          //get the current bias settings
 		bitClear(config,N_zeroRef);          //clear this channel's bit to remove from bias generation
-		ADS1299::WREG(reg,config); delay(1);  //send the modified byte back to the ADS
+		writeRegister(reg,config);           //send the modified byte back to the ADS
 	}
 }
 void ADS1299Manager::activateBiasForChannel(int N_oneRef) {
-	int N_zeroRef = constrain(N_oneRef-1,0,OPENBCI_NCHAN_PER_BOARD-1); //subtracts 1 so that we're counting from 0, not 1
+	int N_zeroRef = channelRegIndex(N_oneRef);  //this channel's bit, which is shared by the daisy-chained boards
  	
 	//see ADS1299 datasheet, PDF p44.
 	//per Chip's experiments, if using the P inputs, just include the P inputs
@@ -217,52 +264,91 @@ void ADS1299Manager::activateBiasForChannel(int N_oneRef) {
 	for (int i=0; i < nLoop; i++) {
 		reg = BIAS_SENSP;
 		if (i > 0) reg = BIAS_SENSN;
-		config = ADS1299::RREG(reg); //get the current bias settings
-		bitSet(config,N_zeroRef);                   //set this channel's bit
-		ADS1299::WREG(reg,config); delay(1);  //send the modified byte back to the ADS
+		config = readRegister(reg);          //get the current bias settings
+		bitSet(config,N_zeroRef);            //set this channel's bit
+		writeRegister(reg,config);           //send the modified byte back to the ADS
 	}
 }	
 
 
-//change the given channel's lead-off detection state...note: stops data colleciton to issue its commands
-//  N is the channel number: 1-8
+//change the given channel's lead-off detection state...note: if running, briefly pauses the data to issue its commands
+//  N is the channel number: 1-8 (or up to 8 times the number of daisy-chained boards)
 // 
 void ADS1299Manager::changeChannelLeadOffDetection(int N, int code_OFF_ON, int code_P_N_Both)
 {
   byte reg, config;
 	
   //check the inputs
-  if ((N < 1) || (N > OPENBCI_NCHAN_PER_BOARD)) return;
-  N = constrain(N-1,0,OPENBCI_NCHAN_PER_BOARD-1);  //shift down by one
+  if ((N < 1) || (N > n_chan_all_boards)) return;
+  N = channelRegIndex(N);  //this channel's bit
   
-  //proceed...first, disable any data collection
-  ADS1299::SDATAC(); delay(1);      // exit Read Data Continuous mode to communicate with ADS
+  //stage all of the changes and send them together at the end
+  beginConfig();
 
   if ((code_P_N_Both == PCHAN) || (code_P_N_Both == BOTHCHAN)) {
   	  //shut down the lead-off signal on the positive side
   	  reg = LOFF_SENSP;  //are we using the P inptus or the N inputs?
-  	  config = ADS1299::RREG(reg); //get the current lead-off settings
+  	  config = readRegister(reg); //get the current lead-off settings
   	  if (code_OFF_ON == OFF) {
   	  	  bitClear(config,N);                   //clear this channel's bit
   	  } else {
   	  	  bitSet(config,N); 			  //clear this channel's bit
   	  }
-  	  ADS1299::WREG(reg,config); delay(1);  //send the modified byte back to the ADS
+  	  writeRegister(reg,config);  //send the modified byte back to the ADS
   }
   
   if ((code_P_N_Both == NCHAN) || (code_P_N_Both == BOTHCHAN)) {
   	  //shut down the lead-off signal on the negative side
   	  reg = LOFF_SENSN;  //are we using the P inptus or the N inputs?
-  	  config = ADS1299::RREG(reg); //get the current lead-off settings
+  	  config = readRegister(reg); //get the current lead-off settings
   	  if (code_OFF_ON == OFF) {
   	  	  bitClear(config,N);                   //clear this channel's bit
   	  } else {
   	  	  bitSet(config,N); 			  //clear this channel's bit
   	  }           //set this channel's bit
-  	  ADS1299::WREG(reg,config); delay(1);  //send the modified byte back to the ADS
+  	  writeRegister(reg,config);  //send the modified byte back to the ADS
   }
+  
+  commit();
 }; 
 
+//set up channels 1 through nChan at once: whether they're active, their gain and input,
+//and their lead-off detection.  Also sets whether the active channels drive the bias.
+//It's all staged and then sent in one burst, so if we're running, the data only
+//pauses once, instead of once for every channel.
+//The daisy-chained boards share their channel registers, so channel N, N+8, etc. are all
+//one setting.  Those entries get merged: the channel is on if any of them is (with the
+//gain and input of the first one that's on), and lead-off is on if any of them wants it.
+void ADS1299Manager::configureChannels(const ADS1299ChannelConfig *config, int nChan, boolean autoBias)
+{
+  nChan = constrain(nChan,0,n_chan_all_boards);
+  
+  ADS1299ChannelConfig merged[OPENBCI_NCHAN_PER_BOARD];
+  int nReg = min(nChan,OPENBCI_NCHAN_PER_BOARD);
+  for (int Ichan=0; Ichan < nReg; Ichan++) merged[Ichan] = config[Ichan];
+  for (int Ichan=OPENBCI_NCHAN_PER_BOARD; Ichan < nChan; Ichan++) {
+    ADS1299ChannelConfig *m = &merged[Ichan % OPENBCI_NCHAN_PER_BOARD];
+    if ((config[Ichan].flags & ADS_CHANCFG_ACTIVE) && !(m->flags & ADS_CHANCFG_ACTIVE)) {
+      m->gainCode = config[Ichan].gainCode;
+      m->inputCode = config[Ichan].inputCode;
+    }
+    m->flags |= config[Ichan].flags;
+  }
+  
+  beginConfig();
+  for (int Ichan=0; Ichan < nReg; Ichan++) {
+    if (merged[Ichan].flags & ADS_CHANCFG_ACTIVE) {
+      activateChannel(Ichan+1,merged[Ichan].gainCode,merged[Ichan].inputCode);
+    } else {
+      deactivateChannel(Ichan+1);
+    }
+    changeChannelLeadOffDetection(Ichan+1,(merged[Ichan].flags & ADS_CHANCFG_LOFF_P) ? ON : OFF,PCHAN);
+    changeChannelLeadOffDetection(Ichan+1,(merged[Ichan].flags & ADS_CHANCFG_LOFF_N) ? ON : OFF,NCHAN);
+  }
+  setAutoBiasGeneration(autoBias);  //recomputes the bias for every channel, now that they're all set
+  commit();
+}
+
 void ADS1299Manager::configureLeadOffDetection(byte amplitudeCode, byte freqCode)
 {
 	amplitudeCode &= 0b00001100;  //only these two bits should be used
@@ -271,7 +357,7 @@ void ADS1299Manager::configureLeadOffDetection(byte amplitudeCode, byte freqCode
 	//get the current configuration of he byte
 	byte reg, config;
 	reg = LOFF;
-	config = ADS1299::RREG(reg); //get the current bias settings
+	config = readRegister(reg); //get the current bias settings
 	
 	//reconfigure the byte to get what we want
 	config &= 0b11110000;  //clear out the last four bits
@@ -279,15 +365,46 @@ void ADS1299Manager::configureLeadOffDetection(byte amplitudeCode, byte freqCode
 	config |= freqCode;    //set the frequency
 	
 	//send the config byte back to the hardware
-	ADS1299::WREG(reg,config); delay(1);  //send the modified byte back to the ADS
+	writeRegister(reg,config);  //send the modified byte back to the ADS
 	
 }
 
+//the lead-off settings, read back from the LOFF register (datasheet PDF p43)
+float ADS1299Manager::getLeadOffCurrent_A(void)
+{
+	switch (readRegister(LOFF) & LOFF_CURRENT_MASK) {
+		case LOFF_MAG_6NA: return 6.0e-9;
+		case LOFF_MAG_24NA: return 24.0e-9;
+		case LOFF_MAG_6UA: return 6.0e-6;
+		default: return 24.0e-6;
+	}
+}
+
+//The AC lead-off frequencies come from the ADS's 2.048 MHz clock (fclk/2^18 and fclk/2^16),
+//so they're always the sample rate divided by a power of two.
+float ADS1299Manager::getLeadOffFrequency_Hz(void)
+{
+	switch (readRegister(LOFF) & LOFF_FREQ_MASK) {
+		case LOFF_FREQ_7p8HZ: return 7.8125;
+		case LOFF_FREQ_31p2HZ: return 31.25;
+		case LOFF_FREQ_FS_4: return getSampleRate_Hz() / 4.0;
+		default: return 0.0;  //DC
+	}
+}
+
+//the gain codes are in bits 4-6 of CHnSET (datasheet PDF p44)
+float ADS1299Manager::getChannelGain(int N_oneRef)
+{
+	const byte gains[] = {1, 2, 4, 6, 8, 12, 24, 24};  //0b111 is reserved
+	int N_zeroRef = channelRegIndex(N_oneRef);
+	return (float)gains[(readRegister(CH1SET+(byte)N_zeroRef) >> 4) & 0b00000111];
+}
+
 void ADS1299Manager::setSRB1(boolean desired_state) {
 	if (desired_state) {
-		ADS1299::WREG(MISC1,0b00100000); delay(1);  //ADS1299 datasheet, PDF p46
+		writeRegister(MISC1,0b00100000);  //ADS1299 datasheet, PDF p46
 	} else {
-		ADS1299::WREG(MISC1,0b00000000); delay(1);  //ADS1299 datasheet, PDF p46
+		writeRegister(MISC1,0b00000000);  //ADS1299 datasheet, PDF p46
 	}
 }
 
@@ -297,13 +414,13 @@ void ADS1299Manager::setSRB1(boolean desired_state) {
 //Configure the test signals that can be inernally generated by the ADS1299
 void ADS1299Manager::configureInternalTestSignal(byte amplitudeCode, byte freqCode)
 {
-	if (amplitudeCode == ADSTESTSIG_NOCHANGE) amplitudeCode = (ADS1299::RREG(CONFIG2) & (0b00000100));
-	if (freqCode == ADSTESTSIG_NOCHANGE) freqCode = (ADS1299::RREG(CONFIG2) & (0b00000011));
+	if (amplitudeCode == ADSTESTSIG_NOCHANGE) amplitudeCode = (readRegister(CONFIG2) & (0b00000100));
+	if (freqCode == ADSTESTSIG_NOCHANGE) freqCode = (readRegister(CONFIG2) & (0b00000011));
 	freqCode &= 0b00000011;  //only the last two bits should be used
 	amplitudeCode &= 0b00000100;  //only this bit should be used
 	byte message = 0b11010000 | freqCode | amplitudeCode;  //compose the code
 	
-	ADS1299::WREG(CONFIG2,message); delay(1);
+	writeRegister(CONFIG2,message);
 	
        //ADS1299::WREG(CONFIG2,0b11010000);delay(1);   //set internal test signal, default amplitude, default speed, datasheet PDF Page 41
       //ADS1299::WREG(CONFIG2,0b11010001);delay(1);   //set internal test signal, default amplitude, 2x speed, datasheet PDF Page 41
@@ -312,26 +429,371 @@ void ADS1299Manager::configureInternalTestSignal(byte amplitudeCode, byte freqCo
       //ADS1299::WREG(CONFIG3,0b01101100); delay(1);  //use internal reference for center of bias creation, datasheet PDF p42 
 }
  
+//Set the output data rate of the ADS1299 (CONFIG1, datasheet PDF p40).  Use the ADS_RATE
+//codes from the header.  Can be called while running; the data pauses briefly.
+void ADS1299Manager::setSampleRate(byte rateCode)
+{
+	rateCode &= 0b00000111;  //only these three bits should be used
+	if (rateCode > ADS_RATE_250HZ) rateCode = ADS_RATE_250HZ;  //0b111 is not a valid rate
+	byte config = readRegister(CONFIG1);
+	config &= 0b11111000;  //clear out the old rate
+	config |= rateCode;
+	writeRegister(CONFIG1,config);
+}
+
+byte ADS1299Manager::getSampleRateCode(void)
+{
+	return (readRegister(CONFIG1) & 0b00000111);
+}
+
+//each step in the rate code halves the rate, starting from 16 kHz
+float ADS1299Manager::getSampleRate_Hz(void)
+{
+	return 16000.0 / (float)(1 << getSampleRateCode());
+}
+
+//number of bytes in each packet from writeChannelDataAsBinary():
+//start byte, length byte, sample number, N channels, [aux value], end byte
+int ADS1299Manager::getBinaryPacketBytes(int N, boolean sendAuxValue)
+{
+	int nBytes = 1 + 1 + 4 + 4*N + 1;
+	if (sendAuxValue) nBytes += 4;
+	return nBytes;
+}
+
+//number of bytes in each packet from writeChannelDataAsPackedBinary():
+//start byte, length byte, sample number, N channels at 3 bytes each, end byte
+int ADS1299Manager::getPackedBinaryPacketBytes(int N)
+{
+	return 1 + 1 + 4 + 3*N + 1;
+}
+
+//number of bytes in each packet from writeChannelDataAsBatch():
+//start byte, channel count, sample count, first sample number, K samples of N channels at 3 bytes each, end byte
+int ADS1299Manager::getBatchPacketBytes(int N)
+{
+	return 1 + 1 + 1 + 4 + 3*N*getBatchSize(N) + 1;
+}
+
+//number of bytes in each packet from writeChannelDataAsCOBS():
+//start byte, sample number, N channels at 3 bytes each, CRC, one byte of COBS overhead, delimiter
+int ADS1299Manager::getCOBSPacketBytes(int N)
+{
+	return 1 + 4 + 3*N + 2 + 1 + 1;
+}
+
+//number of bytes in each packet from writeChannelDataAsBandPower() (one per block, not per sample):
+//start byte, length byte, sample number, block length, channel count, band count, N channels of nBands at 2 bytes each, end byte
+int ADS1299Manager::getBandPowerPacketBytes(int N, int nBands)
+{
+	return 1 + 1 + 4 + 2 + 1 + 1 + 2*N*nBands + 1;
+}
+
+//Would a packet of this size, sent for every sample at the current sample rate, fit
+//through a serial link at this baud rate?  Each byte costs 10 bits (8N1).
+boolean ADS1299Manager::isStreamSustainable(long baud, int packetBytes)
+{
+	float bytesPerSec = ((float)packetBytes) * getSampleRate_Hz();
+	return (bytesPerSec <= ((float)baud) / 10.0);
+}
+
 //Start continuous data acquisition
 void ADS1299Manager::start(void)
 {
     ADS1299::RDATAC(); delay(1);           // enter Read Data Continuous mode
+    ringHead = 0; ringTail = 0;            // empty the sample ring
+    resetDeltaEncoder();                   // the PC needs a fresh keyframe
+    batchCount = 0;                        // forget any partial batch from last time
+    hotMarker = 0; currentDiscontinuity = -1;  // starting over is not a discontinuity
+    if (useDRDYInterrupt) {
+      //the ISR will collect the data from here on.  If this board can't do that, poll instead.
+      if (!enableDRDYInterrupt()) useDRDYInterrupt = false;
+    }
     ADS1299::START();    //start the data acquisition
+    isRunning = true;
 }
   
 //Query to see if data is available from the ADS1299...return TRUE is data is available
+//In interrupt mode, this says whether there are samples waiting in the ring
 int ADS1299Manager::isDataAvailable(void)
 {
-  return (!(digitalRead(PIN_DRDY)));
+  if (useDRDYInterrupt) return (ringHead != ringTail);
+  return ADS1299::isDRDY();
 }
   
 //Stop the continuous data acquisition
 void ADS1299Manager::stop(void)
 {
+    flushBatch();                          // send the last few samples of a batch
+    flushTX();                             // finish sending whatever data is still queued
+    if (useDRDYInterrupt) disableDRDYInterrupt();  //the ISR must not touch SPI while we send commands
     ADS1299::STOP(); delay(1);   //start the data acquisition
     ADS1299::SDATAC(); delay(1);      // exit Read Data Continuous mode to communicate with ADS
+    isRunning = false;
+    if (hotCommitPending) {
+      hotCommitPending = false;
+      flushRegisters();                    // a hot reconfiguration never got its sample boundary
+    }
+}
+
+//choose whether start() uses the DRDY interrupt to read the data.  Call while stopped.
+void ADS1299Manager::setInterruptMode(boolean state)
+{
+  useDRDYInterrupt = state;
 }
+
+boolean ADS1299Manager::isInterruptMode(void)
+{
+  return useDRDYInterrupt;
+}
+
+//the ISR needs to know which object to service
+static ADS1299Manager *drdyManager = NULL;
+
+static void drdyISR(void)
+{
+  if (drdyManager != NULL) drdyManager->serviceDRDY();
+}
+
+//hook the DRDY pin's interrupt up to serviceDRDY.  How that's done depends on the board (see
+//attachDRDY in ADS1299_SPI.h).  Returns false if this board has no interrupt for DRDY.
+boolean ADS1299Manager::enableDRDYInterrupt(void)
+{
+  drdyManager = this;
+  if (ADS1299::attachDRDY(drdyISR)) return true;
+  drdyManager = NULL;
+  return false;
+}
+
+void ADS1299Manager::disableDRDYInterrupt(void)
+{
+  ADS1299::detachDRDY();
+  drdyManager = NULL;
+}
+
+//Read the new sample into the ring.  Runs in interrupt context.
+void ADS1299Manager::serviceDRDY(void)
+{
+  if (!ADS1299::isDRDY()) return;  //the pin-change fires on both edges.  DRDY is active low.
+  
+  ringSampleCounter++;  //count it even if we drop it, so the PC sees the gap
+  byte next = (ringHead + 1) & (ADS_SAMPLE_RING_LEN-1);
+  if (next == ringTail) {
+    //loop() has fallen behind.  Leave the frame in the ADS; it'll be replaced by the next conversion.
+    ringOverruns++;
+    return;
+  }
+  
+#if ADS_PROFILE
+  isrProfile.begin();
+#endif
+  ADS1299SampleFrame *frame = &sampleRing[ringHead];
+  ADS1299::readFrame(frame->raw);  //just the SPI burst.  Converting it is left to loop().
+  frame->sampleNumber = ringSampleCounter;
+  frame->discontinuity = hotMarker; hotMarker = 0;
+  frame->changedChannels = hotMarkerChannels;
+  ringHead = next;  //publish the frame only after it is complete
+  
+  //we've got the whole sample period before the next DRDY, so this is the time for a hot
+  //reconfiguration.  commit() is waiting for this, and it sends the registers (not us).
+  if (hotCommitPending) hotAtBoundary = true;
+  
+  byte depth = (ringHead - ringTail) & (ADS_SAMPLE_RING_LEN-1);
+  if (depth > ringPeakDepth) ringPeakDepth = depth;
+#if ADS_PROFILE
+  isrProfile.finish(0);
+#endif
+}
+
+//copy the oldest sample from the ring into channelData so that all of the filtering
+//and output functions work as usual.  Returns the sample number, or zero if the ring was empty.
+long ADS1299Manager::popChannelData(void)
+{
+  if (ringHead == ringTail) return 0;
+  
+  ADS1299SampleFrame *frame = &sampleRing[ringTail];
+  for (int i=0; i < ADS1299::getFrameBytes(); i++) rawFrame[i] = frame->raw[i];  //keep the raw frame too
+  ADS1299::unpackFrame(rawFrame,channelData);
+  currentDiscontinuity = (frame->discontinuity > 0) ? (frame->discontinuity - 1) : -1;
+  currentDiscontinuityChannels = frame->changedChannels;
+  long sampleNumber = frame->sampleNumber;
+  ringTail = (ringTail + 1) & (ADS_SAMPLE_RING_LEN-1);  //hand the slot back to the ISR
+  return sampleNumber;
+}
+
+unsigned long ADS1299Manager::getRingOverruns(void)
+{
+  Lock lock;  //the ISR might be halfway through changing it
+  return ringOverruns;
+}
+
+byte ADS1299Manager::getRingPeakDepth(void)
+{
+  return ringPeakDepth;
+}
+
+#if ADS_PROFILE
+//the ISR updates the statistics, so copy them all at once
+void ADS1299Manager::getISRProfile(ADS1299Profiler<1> *target, boolean reset)
+{
+  Lock lock;
+  *target = isrProfile;
+  if (reset) isrProfile.reset();
+}
+#endif
   
+//Queued serial transmission.  The binary writers put their bytes in the back buffer with
+//txWrite().  serviceTX() moves bytes from the front buffer into the Serial port's own
+//(interrupt-driven) transmit buffer, but only as many as will fit without waiting.  When the
+//front buffer is done, the buffers swap.  So, the next sample can be read and encoded while
+//the UART is still busy with this one.  Call serviceTX() often from loop().
+//
+//If the back buffer fills up while the front one is still going out, there's nothing to do
+//but wait.  That is counted as a stall.  The Serial port only reports how much room it has
+//in Arduino 1.6 and later.  Before that, serviceTX() has to send the whole front buffer at once.
+void ADS1299Manager::txWrite(byte value)
+{
+	txWrite(&value,1);
+}
+void ADS1299Manager::txWrite(const byte *data, int nBytes)
+{
+	while (nBytes > 0) {
+		int space = ADS_TX_BUFFER_BYTES - txLen[txBack];
+		if (space == 0) {
+			//the back buffer is full, so we must wait for the front buffer
+			txStalls++;
+			byte front = 1 - txBack;
+			Serial.write(txBuffer[front]+txSent,txLen[front]-txSent);
+			txSent = txLen[front];
+			swapTX();
+			continue;
+		}
+		int count = min(nBytes,space);
+		memcpy(txBuffer[txBack]+txLen[txBack],data,count);
+		txLen[txBack] += count; data += count; nBytes -= count;
+	}
+	int depth = getTXQueueDepth();
+	if (depth > txPeakDepth) txPeakDepth = depth;
+}
+//the front buffer has been sent, so make the back buffer the new front buffer
+void ADS1299Manager::swapTX(void)
+{
+	txBack = 1 - txBack;
+	txLen[txBack] = 0;
+	txSent = 0;
+}
+void ADS1299Manager::serviceTX(void)
+{
+	while (true) {
+		byte front = 1 - txBack;
+		if (txSent >= txLen[front]) {
+			//the front buffer is done.  Is there anything waiting behind it?
+			if (txLen[txBack] == 0) return;
+			swapTX();
+			front = 1 - txBack;
+		}
+		int nBytes = txLen[front] - txSent;
+#if defined(ARDUINO) && (ARDUINO >= 10600)
+		nBytes = min(nBytes,Serial.availableForWrite());
+#endif
+		if (nBytes <= 0) return;  //the Serial port is full.  Try again later.
+		Serial.write(txBuffer[front]+txSent,nBytes);
+		txSent += nBytes;
+	}
+}
+void ADS1299Manager::flushTX(void)
+{
+	byte front = 1 - txBack;
+	Serial.write(txBuffer[front]+txSent,txLen[front]-txSent);
+	Serial.write(txBuffer[txBack],txLen[txBack]);
+	txLen[0] = 0; txLen[1] = 0; txSent = 0;
+}
+int ADS1299Manager::getTXQueueDepth(void)
+{
+	return (txLen[1-txBack] - txSent) + txLen[txBack];
+}
+int ADS1299Manager::getTXPeakDepth(void)
+{
+	return txPeakDepth;
+}
+unsigned long ADS1299Manager::getTXStalls(void)
+{
+	return txStalls;
+}
+
+//Hot reconfiguration.  Normally, commit() sends register changes as soon as it's called,
+//which can land in the middle of reading a sample.  With hot reconfiguration, a commit()
+//made while running waits until a sample has just been read, and then sends the changes.
+//That leaves the whole sample period for the SPI traffic.  If it takes longer than a
+//sample period anyway (at the high sample rates), the samples that went by are counted
+//as lost.  Either way, the next sample is marked as a discontinuity, along with which
+//channels were changed.  A change to CHnSET touches just channel n; anything else
+//(bias, test signals, ...) counts as touching every channel.  The lead-off settings
+//don't change what comes out of any channel's ADC (the lead-off current just adds a
+//little signal on top), so a change to only those is marked with no channels at all.
+//In polling mode, commit() returns right away, and updateChannelData() sends the changes
+//after the next sample.  In interrupt mode, commit() waits (up to ADS_HOT_COMMIT_TIMEOUT_PERIODS
+//sample periods) for the DRDY interrupt to read the next sample, and then sends them
+//itself, with the interrupt off.  The SPI traffic never happens inside the ISR.
+void ADS1299Manager::setHotReconfig(boolean state)
+{
+	hotReconfig = state;
+}
+boolean ADS1299Manager::isHotReconfig(void)
+{
+	return hotReconfig;
+}
+void ADS1299Manager::scheduleHotCommit(void)
+{
+	hotPendingChannels = 0;
+	for (int Ichan=0; Ichan < OPENBCI_NCHAN_PER_BOARD; Ichan++) {
+		if (bitRead(dirtyRegisters,CH1SET+Ichan)) bitSet(hotPendingChannels,Ichan);
+	}
+	unsigned long shared = dirtyRegisters & ~(0xFFUL << CH1SET);
+	shared &= ~((1UL << LOFF) | (1UL << LOFF_SENSP) | (1UL << LOFF_SENSN) | (1UL << LOFF_FLIP));  //lead-off touches nobody
+	if (shared) hotPendingChannels = 0xFF;  //something shared by all channels
+	hotSamplePeriod_us = (unsigned long)(1000000.0 / getSampleRate_Hz());
+	hotAtBoundary = false;
+	hotCommitPending = true;  //last, as the ISR may act on it right away
+}
+//call this right after reading a sample, and never from the ISR
+void ADS1299Manager::applyHotCommit(void)
+{
+	unsigned long start_micros = micros();
+	ADS1299::SDATAC();
+	flushRegisters();
+	ADS1299::RDATAC();
+	unsigned long lost = (micros() - start_micros) / hotSamplePeriod_us;
+	
+	hotSamplesLost += lost;
+	if (useDRDYInterrupt) ringSampleCounter += lost;  //so that the sample numbers show the gap
+	hotMarker = (byte)min(lost+1,255UL);
+	hotMarkerChannels = hotPendingChannels;
+	hotCommitPending = false;
+	hotAtBoundary = false;
+}
+void ADS1299Manager::updateChannelData(void)
+{
+	ADS1299::updateChannelData();
+	currentDiscontinuity = (hotMarker > 0) ? (hotMarker - 1) : -1;
+	currentDiscontinuityChannels = hotMarkerChannels;
+	hotMarker = 0;
+	if (hotCommitPending) applyHotCommit();
+}
+int ADS1299Manager::getDiscontinuity(void)
+{
+	return currentDiscontinuity;
+}
+byte ADS1299Manager::getDiscontinuityChannels(void)
+{
+	return currentDiscontinuityChannels;
+}
+unsigned long ADS1299Manager::getHotSamplesLost(void)
+{
+	Lock lock;  //the ISR might be halfway through changing it
+	return hotSamplesLost;
+}
+
 //print as text each channel's data
 //   print channels 1-N (where N is 1-8...anything else will return with no action)
 //   sampleNumber is a number that, if greater than zero, will be printed at the start of the line
@@ -382,17 +844,17 @@ void ADS1299Manager::writeChannelDataAsBinary(int N, long sampleNumber,boolean s
 	if ((N < 1) || (N > n_chan_all_boards)) return;
 	
 	// Write start byte
-	Serial.write( (byte) PCKT_START);
+	txWrite( (byte) PCKT_START);
 	
 	//write the length of the payload
 	//byte byte_val = (1+8)*4;
 	byte payloadBytes = (byte)((1+N)*4);    //length of data payload, bytes
 	if (sendAuxValue) payloadBytes+= (byte)4;  //add four more bytes for the aux value
-	Serial.write(payloadBytes);  //write the payload length
+	txWrite(payloadBytes);  //write the payload length
 
 	//write the sample number, if not disabled
 	val = sampleNumber;
-	Serial.write(val_ptr,4); //4 bytes long
+	txWrite(val_ptr,4); //4 bytes long
 	
 	//write each channel
 	for (int chan = 0; chan < N; chan++ )
@@ -405,20 +867,459 @@ void ADS1299Manager::writeChannelDataAsBinary(int N, long sampleNumber,boolean s
 			//get the real EEG data for this channel
 			val = channelData[chan];
 		}
-		Serial.write(val_ptr,4); //4 bytes long
+		txWrite(val_ptr,4); //4 bytes long
 	}
 	
 	// Write the AUX value
 	if (sendAuxValue) {
 		val = auxValue;
-		Serial.write(val_ptr,4); //4 bytes long
+		txWrite(val_ptr,4); //4 bytes long
+	}
+	
+	// Write footer
+	txWrite((byte)PCKT_END);
+	
+	// start sending it, without waiting
+	serviceTX();
+};
+
+//write as binary each channel's data, but only send the 24 bits that the ADS1299 actually
+//produces.  Each sample goes out as 3 bytes, most significant byte first, which is exactly
+//how it arrived in the ADS frame.  This saves 25% of the serial link versus the 4-byte format.
+//   Start byte:    PCKT_START_PACKED
+//   Payload bytes: 4 + 3*N
+//   Sample number: 4 bytes (little endian, same as writeChannelDataAsBinary)
+//   Channels 1-N:  3 bytes each (big endian, two's complement)
+//   End byte:      PCKT_END
+#define max_int24 (8388607L)
+#define min_int24 (-8388608L)
+void ADS1299Manager::writeChannelDataAsPackedBinary(int N, long sampleNumber){
+	ADS1299Manager::writeChannelDataAsPackedBinary(N,sampleNumber,false);
+}
+void ADS1299Manager::writeChannelDataAsPackedBinary(int N, long sampleNumber,boolean useSyntheticData)
+{
+	//check the inputs
+	if ((N < 1) || (N > n_chan_all_boards)) return;
+	
+	// Write start byte
+	txWrite( (byte) PCKT_START_PACKED);
+	
+	//write the length of the payload
+	txWrite((byte)(4+3*N));
+
+	//write the sample number
+	val = sampleNumber;
+	txWrite(val_ptr,4); //4 bytes long
+	
+	//write each channel
+	byte packed[3];
+	for (int chan = 0; chan < N; chan++ )
+	{
+		//get this channel's data
+		if (useSyntheticData) {
+			val = makeSyntheticSample(sampleNumber,chan);
+		} else {
+			val = channelData[chan];
+		}
+		
+		//unfiltered data always fits, but the filters can overshoot a little
+		val = constrain(val,min_int24,max_int24);
+		packed[0] = (byte)(val >> 16);
+		packed[1] = (byte)(val >> 8);
+		packed[2] = (byte)val;
+		txWrite(packed,3);
 	}
 	
 	// Write footer
-	Serial.write((byte)PCKT_END);
+	txWrite((byte)PCKT_END);
+	serviceTX();
+};
+
+//write as binary each channel's change since the previous packet.  EEG doesn't change
+//much from one sample to the next, so most of these changes fit in 1 or 2 bytes instead
+//of 3.  Every so often (and after start() or a dropped sample) this sends a normal packed
+//packet instead, which gives the PC a fresh starting point.
+//   Start byte:    PCKT_START_DELTA
+//   Payload bytes: however many it took
+//   Sample number: 1 byte (just the low byte...the PC uses it to spot gaps)
+//   Channels 1-N:  zigzag-encoded change, as a varint (7 bits per byte, low bits first,
+//                  high bit set on every byte except the last)
+//   End byte:      PCKT_END
+void ADS1299Manager::setDeltaKeyframeInterval(int nSamples)
+{
+	deltaKeyframeInterval = max(nSamples,1);
+	resetDeltaEncoder();
+}
+void ADS1299Manager::resetDeltaEncoder(void)
+{
+	deltaSamplesUntilKeyframe = 0;
+	deltaPrevSampleNumber = 0;
+}
+void ADS1299Manager::writeChannelDataAsDelta(int N, long sampleNumber)
+{
+	//check the inputs
+	if ((N < 1) || (N > n_chan_all_boards)) return;
+	
+	//time for a keyframe?  We also need one if a sample went missing.
+	if ((deltaSamplesUntilKeyframe <= 0) || (sampleNumber != deltaPrevSampleNumber+1)) {
+		writeDeltaKeyframe(N,sampleNumber);
+		return;
+	}
+	
+	//build the payload first, so that we know how long it is
+	byte payload[1 + 4*ADS1299::MAX_N_CHAN];  //a 24-bit change takes at most 4 bytes
+	int nBytes = 0;
+	payload[nBytes++] = (byte)sampleNumber;
+	for (int chan = 0; chan < N; chan++ )
+	{
+		long value = constrain(channelData[chan],min_int24,max_int24);
+		long delta = value - deltaPrevValue[chan];
+		
+		//zigzag: 0,-1,1,-2,2... become 0,1,2,3,4... so that small changes are small numbers
+		unsigned long zigzag = (((unsigned long)delta) << 1) ^ ((unsigned long)(delta >> 31));
+		while (zigzag >= 0x80) {
+			payload[nBytes++] = (byte)(zigzag | 0x80);
+			zigzag >>= 7;
+		}
+		payload[nBytes++] = (byte)zigzag;
+	}
 	
-	// force everything out
-	//Serial.flush();	
+	//with lots of channels and big jumps, it may not fit in a packet.  Start over with a keyframe.
+	if (nBytes > 255) {
+		writeDeltaKeyframe(N,sampleNumber);
+		return;
+	}
+	for (int chan = 0; chan < N; chan++) deltaPrevValue[chan] = constrain(channelData[chan],min_int24,max_int24);
+	
+	txWrite((byte)PCKT_START_DELTA);
+	txWrite((byte)nBytes);
+	txWrite(payload,nBytes);
+	txWrite((byte)PCKT_END);
+	serviceTX();
+	
+	deltaSamplesUntilKeyframe--;
+	deltaPrevSampleNumber = sampleNumber;
+};
+void ADS1299Manager::writeDeltaKeyframe(int N, long sampleNumber)
+{
+	writeChannelDataAsPackedBinary(N,sampleNumber);
+	for (int chan = 0; chan < N; chan++) deltaPrevValue[chan] = constrain(channelData[chan],min_int24,max_int24);
+	deltaSamplesUntilKeyframe = deltaKeyframeInterval;
+	deltaPrevSampleNumber = sampleNumber;
+};
+
+//write as binary several samples at once.  Each sample is packed just like in 
+//writeChannelDataAsPackedBinary, but the start byte, sample number, and end byte are
+//only sent once per K samples.  The samples wait in batchBuffer until there are K of them.
+//If a sample goes missing (or N changes), the batch is sent early with however many it has.
+//   Start byte:    PCKT_START_BATCH
+//   Channels:      1 byte (N)
+//   Samples:       1 byte (K)
+//   Sample number: 4 bytes (little endian), for the first sample.  The rest follow in order.
+//   Samples 1-K:   N channels of 3 bytes each (big endian, two's complement)
+//   End byte:      PCKT_END
+void ADS1299Manager::setBatchSize(int K)
+{
+	batchSize = (byte)constrain(K,1,255);
+}
+int ADS1299Manager::getBatchSize(int N)
+{
+	int maxK = ADS_BATCH_BUFFER_BYTES / (3*N);
+	return max(1,min((int)batchSize,maxK));
+}
+void ADS1299Manager::writeChannelDataAsBatch(int N, long sampleNumber)
+{
+	//check the inputs
+	if ((N < 1) || (N > n_chan_all_boards) || (3*N > ADS_BATCH_BUFFER_BYTES)) return;
+	
+	//this sample can only join the batch if it follows right after the previous one
+	if ((batchCount > 0) && ((N != batchN) || (sampleNumber != batchFirstSampleNumber + batchCount))) sendBatch();
+	if (batchCount == 0) {
+		batchN = N;
+		batchFirstSampleNumber = sampleNumber;
+	}
+	
+	//pack this sample into the buffer
+	byte *ptr = batchBuffer + 3*N*batchCount;
+	for (int chan = 0; chan < N; chan++ )
+	{
+		long value = constrain(channelData[chan],min_int24,max_int24);
+		*ptr++ = (byte)(value >> 16);
+		*ptr++ = (byte)(value >> 8);
+		*ptr++ = (byte)value;
+	}
+	batchCount++;
+	
+	if (batchCount >= getBatchSize(N)) sendBatch();
+};
+void ADS1299Manager::flushBatch(void)
+{
+	if (batchCount > 0) sendBatch();
+};
+void ADS1299Manager::sendBatch(void)
+{
+	txWrite((byte)PCKT_START_BATCH);
+	txWrite((byte)batchN);
+	txWrite(batchCount);
+	val = batchFirstSampleNumber;
+	txWrite(val_ptr,4); //4 bytes long
+	txWrite(batchBuffer,3*batchN*batchCount);
+	txWrite((byte)PCKT_END);
+	serviceTX();
+	batchCount = 0;
+};
+
+//CRC-16/CCITT (polynomial 0x1021, starting from 0xFFFF)
+static unsigned int crc16_update(unsigned int crc, byte data)
+{
+	crc ^= ((unsigned int)data) << 8;
+	for (byte i = 0; i < 8; i++) {
+		if (crc & 0x8000) {
+			crc = (crc << 1) ^ 0x1021;
+		} else {
+			crc <<= 1;
+		}
+	}
+	return crc;
+}
+
+unsigned int ADS1299Manager::computeCRC16(const byte *data, int nBytes)
+{
+	unsigned int crc = 0xFFFF;
+	for (int i=0; i < nBytes; i++) crc = crc16_update(crc,data[i]);
+	return crc & 0xFFFF;  //where int is wider than 16 bits, the shifts leave bits up top
+}
+
+//write as binary the same data as writeChannelDataAsPackedBinary, but framed with COBS
+//(see writeCOBSPacket), so that the PC can always find the start of the next packet.
+void ADS1299Manager::writeChannelDataAsCOBS(int N, long sampleNumber)
+{
+	//check the inputs
+	if ((N < 1) || (N > n_chan_all_boards)) return;
+	
+	byte payload[4 + 3*ADS1299::MAX_N_CHAN];
+	byte *ptr = payload;
+	val = sampleNumber;
+	for (int i=0; i < 4; i++) *ptr++ = val_ptr[i];
+	for (int chan = 0; chan < N; chan++ )
+	{
+		long value = constrain(channelData[chan],min_int24,max_int24);
+		*ptr++ = (byte)(value >> 16);
+		*ptr++ = (byte)(value >> 8);
+		*ptr++ = (byte)value;
+	}
+	writeCOBSPacket(PCKT_START_PACKED,payload,ptr-payload);
+};
+void ADS1299Manager::setCOBSFraming(boolean state)
+{
+	cobsFraming = state;
+}
+
+//send a packet framed with the start byte, the length, and the end byte...or with COBS,
+//if that's what the PC is listening for (see setCOBSFraming).
+void ADS1299Manager::writePacket(byte startByte, const byte *payload, int nBytes)
+{
+	if (cobsFraming) {
+		writeCOBSPacket(startByte,payload,nBytes);
+		return;
+	}
+	txWrite(startByte);
+	txWrite((byte)nBytes);
+	txWrite(payload,nBytes);
+	txWrite((byte)PCKT_END);
+	serviceTX();
+};
+
+//With the 0xA0...0xC0 framing, those bytes can show up in the data too, so one bad byte
+//can make the PC lose several packets.  Here, the packet is run through Consistent
+//Overhead Byte Stuffing (COBS), which removes every zero byte, and then a single zero
+//marks the end of the packet.  The PC just splits the stream at the zeros.  A CRC tells
+//the PC whether what it got is intact.
+//   Before stuffing:  start byte (1 byte, the same one the other framing would use)
+//                     payload (the same as with the other framing)
+//                     CRC-16/CCITT of all of the above (2 bytes, high byte first)
+//   After stuffing:   one more byte than that (for every 254, at most), then PCKT_COBS_DELIMITER
+//Each zero is replaced by the distance to the next zero, and a code byte at the front
+//holds the distance to the first one.  A run of 254 bytes without a zero gets a code of
+//0xFF, which means "no zero here".  It's sent as it's stuffed, so it needs no buffer.
+void ADS1299Manager::writeCOBSPacket(byte startByte, const byte *payload, int nBytes)
+{
+	unsigned int crc = crc16_update(0xFFFF,startByte);
+	for (int i=0; i < nBytes; i++) crc = crc16_update(crc,payload[i]);
+	
+	int total = 1 + nBytes + 2;   //bytes to stuff: the start byte, the payload, and the CRC
+	int start = 0;
+	while (true) {
+		//find the next zero (or the end, or 254 bytes without one)
+		int end = start;
+		while ((end < total) && (end - start < 254) && (cobsByteAt(end,startByte,payload,nBytes,crc) != 0)) end++;
+		txWrite((byte)(end - start + 1));
+		for (int i=start; i < end; i++) txWrite(cobsByteAt(i,startByte,payload,nBytes,crc));
+		if (end >= total) break;
+		start = (end - start == 254) ? end : end + 1;  //the code stands for the zero, so skip it
+	}
+	txWrite((byte)PCKT_COBS_DELIMITER);
+	serviceTX();
+};
+//byte i of the packet before it's stuffed
+byte ADS1299Manager::cobsByteAt(int i, byte startByte, const byte *payload, int nBytes, unsigned int crc)
+{
+	if (i == 0) return startByte;
+	if (i <= nBytes) return payload[i-1];
+	return (i == nBytes+1) ? (byte)(crc >> 8) : (byte)crc;
+};
+
+//Instead of the samples, send how much power each channel has in each of a few bands
+//(theta, alpha, beta...), once per block of samples.  Call it with every sample; the
+//estimator takes in all of its channels, and at the end of each block a packet goes out
+//with the first N of them.  See ADS1299BandPower.h for how it's worked out.  At 250 Hz,
+//5 updates per second of 3 bands for 8 channels is 295 bytes/sec, instead of 7750
+//bytes/sec for the packed samples.
+//   Start byte:    PCKT_START_BANDPOWER
+//   Payload bytes: 8 + 2*N*nBands
+//   Sample number: 4 bytes (little endian), of the last sample in the block
+//   Block length:  2 bytes (big endian), samples per block
+//   Channels:      1 byte, N
+//   Bands:         1 byte, nBands
+//   Band power:    2 bytes each (big endian), in hundredths of a dB re 1 count^2,
+//                  all of channel 1's bands, then channel 2's, and so on
+//   End byte:      PCKT_END
+void ADS1299Manager::writeChannelDataAsBandPower(int N, long sampleNumber, ADS1299BandPower *bandPower)
+{
+	if (!bandPower->process(channelData)) return;  //the block isn't done yet
+	N = constrain(N,0,min(bandPower->getNChan(),(int)ADS1299::MAX_N_CHAN));
+	int nBands = bandPower->getNBands();
+	
+	byte payload[8 + 2*ADS1299::MAX_N_CHAN*ADS_BANDPOWER_MAX_BANDS];
+	val = sampleNumber;
+	for (int i=0; i < 4; i++) payload[i] = val_ptr[i];
+	payload[4] = (byte)(bandPower->getBlockLen() >> 8);
+	payload[5] = (byte)bandPower->getBlockLen();
+	payload[6] = (byte)N;
+	payload[7] = (byte)nBands;
+	byte *ptr = payload + 8;
+	for (int chan = 0; chan < N; chan++) {
+		for (int Iband = 0; Iband < nBands; Iband++) {
+			unsigned int power = bandPower->getBandPower_cB(chan,Iband);
+			*ptr++ = (byte)(power >> 8);
+			*ptr++ = (byte)power;
+		}
+	}
+	writePacket(PCKT_START_BANDPOWER,payload,ptr-payload);
+};
+
+//Electrode impedance, from the AC lead-off signal.  Call it with every sample, with the
+//raw data (before any filtering).  The lock-in (see ADS1299Impedance.h) takes in all of
+//its channels, and at the end of each block a packet goes out with the first N of them.
+//The lead-off current is a square wave of +/- I, whose fundamental has an amplitude of
+//4/pi * I.  The ADS's sinc3 decimation filter takes a little off of that (7% at fs/8, and
+//27% at fs/4), so that's taken out too.  If lead-off is on for both the P and the N side
+//of a channel, the current goes through both electrodes, and this is their sum.
+//   Start byte:    PCKT_START_IMPEDANCE
+//   Payload bytes: 7 + 2*N
+//   Sample number: 4 bytes (little endian), of the last sample in the block
+//   Block length:  2 bytes (big endian), samples per block
+//   Channels:      1 byte, N
+//   Impedance:     2 bytes each (big endian), in steps of 100 ohms, or ADS_IMPEDANCE_OVER_RANGE,
+//                  or ADS_IMPEDANCE_NOT_MEASURED if the channel is off or has no lead-off current
+//   End byte:      PCKT_END
+void ADS1299Manager::writeChannelDataAsImpedance(int N, long sampleNumber, ADS1299Impedance *impedance)
+{
+	if (!impedance->process(channelData)) return;  //the block isn't done yet
+	N = constrain(N,0,min(impedance->getNChan(),(int)ADS1299::MAX_N_CHAN));
+	
+	unsigned int codes[ADS1299::MAX_N_CHAN];
+	for (int chan = 0; chan < N; chan++) {
+		codes[chan] = getImpedanceCode(chan,impedance->getAmplitude(chan),impedance->getDriveFrequency_Hz());
+	}
+	writeImpedancePacket(sampleNumber,impedance->getBlockLen(),N,codes);
+};
+
+//The impedance of channel chan (counting from 0, across all of the daisy-chained boards)
+//from the amplitude of its lead-off tone, in the units of the impedance packet.
+unsigned int ADS1299Manager::getImpedanceCode(int chan, float amplitude, float drive_Hz)
+{
+	//the channel settings are shared by all of the daisy-chained boards
+	int Ichan = chan % OPENBCI_NCHAN_PER_BOARD;
+	boolean isDriven = bitRead(readRegister(LOFF_SENSP),Ichan) || bitRead(readRegister(LOFF_SENSN),Ichan);
+	if (!isDriven || !isChannelActive(Ichan+1)) return ADS_IMPEDANCE_NOT_MEASURED;
+	if (amplitude < 0.0) return ADS_IMPEDANCE_OVER_RANGE;  //the lock-in saturated (ADS_IMPEDANCE_AMPLITUDE_OVER_RANGE)
+	
+	//the current that makes the tone, as the ADS sees it
+	float x = M_PI * drive_Hz / getSampleRate_Hz();
+	float droop = sin(x) / x;
+	float drive_A = getLeadOffCurrent_A() * (4.0 / M_PI) * droop * droop * droop;
+	
+	float volts = amplitude * (ADS_VREF_VOLTS / 8388607.0 / getChannelGain(Ichan+1));
+	float steps = volts / drive_A / 100.0 + 0.5;
+	return (steps < (float)ADS_IMPEDANCE_OVER_RANGE) ? (unsigned int)steps : ADS_IMPEDANCE_OVER_RANGE;
+}
+
+void ADS1299Manager::writeImpedancePacket(long sampleNumber, int blockLen, int N, const unsigned int *codes)
+{
+	byte payload[7 + 2*ADS1299::MAX_N_CHAN];
+	N = constrain(N,0,(int)ADS1299::MAX_N_CHAN);
+	val = sampleNumber;
+	for (int i=0; i < 4; i++) payload[i] = val_ptr[i];
+	payload[4] = (byte)(blockLen >> 8);
+	payload[5] = (byte)blockLen;
+	payload[6] = (byte)N;
+	for (int chan = 0; chan < N; chan++) {
+		payload[7+2*chan] = (byte)(codes[chan] >> 8);
+		payload[7+2*chan+1] = (byte)codes[chan];
+	}
+	writePacket(PCKT_START_IMPEDANCE,payload,7 + 2*N);
+};
+
+//tell the PC that, from this sample on, the lead-off scan (see ADS1299LeadOffScan.h) has
+//the lead-off current on channel N (and N+8, etc., on daisy-chained boards) and on no other
+//channel on that side.  That channel's data has the lead-off tone in it until the next one.
+//   Start byte:    PCKT_START_LEADOFF_SCAN
+//   Payload bytes: 6
+//   Sample number: 4 bytes (little endian), of the first sample with the new setting
+//   Channel:       1 byte, 1-8
+//   Side:          1 byte, PCHAN or NCHAN
+//   End byte:      PCKT_END
+void ADS1299Manager::writeLeadOffScanPacket(long sampleNumber, int N_oneRef, byte code_P_N)
+{
+	if (batchCount > 0) sendBatch();  //the samples before the change go first
+	
+	byte payload[6];
+	val = sampleNumber;
+	for (int i=0; i < 4; i++) payload[i] = val_ptr[i];
+	payload[4] = (byte)N_oneRef;
+	payload[5] = code_P_N;
+	writePacket(PCKT_START_LEADOFF_SCAN,payload,6);
+};
+
+//send a reply to a command.  It uses the same framing as the other binary packets,
+//so that the PC can pick it out of the data stream.
+//   Start byte:    PCKT_START_STATUS
+//   Payload bytes: nBytes
+//   Payload:       whatever the command wants to say
+//   End byte:      PCKT_END
+void ADS1299Manager::writeStatusPacket(const byte *payload, int nBytes)
+{
+	writePacket(PCKT_START_STATUS,payload,nBytes);
+};
+
+//tell the PC that the current sample comes right after a hot reconfiguration
+//   Start byte:    PCKT_START_MARKER
+//   Payload bytes: 6
+//   Sample number: 4 bytes (little endian), of the first sample after the change
+//   Samples lost:  1 byte
+//   Channels:      1 byte, a bit for each channel that was changed (bit 0 = channel 1)
+//   End byte:      PCKT_END
+void ADS1299Manager::writeDiscontinuityMarker(long sampleNumber)
+{
+	if (batchCount > 0) sendBatch();  //the samples before the change go first
+	
+	byte payload[6];
+	val = sampleNumber;
+	for (int i=0; i < 4; i++) payload[i] = val_ptr[i];
+	payload[4] = (byte)max(currentDiscontinuity,0);
+	payload[5] = currentDiscontinuityChannels;
+	writePacket(PCKT_START_MARKER,payload,6);
 };
 
 //write channel data using binary format of ModularEEG so that it can be used by BrainBay (P2 protocol)
@@ -435,12 +1336,12 @@ void ADS1299Manager::writeChannelDataAsOpenEEG_P2(long sampleNumber,boolean useS
 	byte sync1 = 0x5A;
 	byte version = 2;
 	
-	Serial.write(sync0);
-	Serial.write(sync1);
-	Serial.write(version);
+	txWrite(sync0);
+	txWrite(sync1);
+	txWrite(version);
 	byte foo = (byte)sampleNumber;
 	if (foo == sync0) foo--;
-	Serial.write(foo);
+	txWrite(foo);
 	
 	long val32; //32-bit
 	int val_i16;  //16-bit
@@ -472,10 +1373,10 @@ void ADS1299Manager::writeChannelDataAsOpenEEG_P2(long sampleNumber,boolean useS
 		//Serial.write((byte)(val_u16 & 0x00FF)); //low byte
 		foo = (byte)((val_u16 >> 8) & 0x00FF); //high byte
 		if (foo == sync0) foo--;
-		Serial.write(foo);
+		txWrite(foo);
 		foo = (byte)(val_u16 & 0x00FF); //high byte
 		if (foo == sync0) foo--;
-		Serial.write(foo);
+		txWrite(foo);
 
 
 		
@@ -486,7 +1387,8 @@ void ADS1299Manager::writeChannelDataAsOpenEEG_P2(long sampleNumber,boolean useS
 	if (count >= 9) {
 		switches = 0x0F;
 	}	
-	Serial.write(switches);
+	txWrite(switches);
+	serviceTX();
 }
 
 #define synthetic_amplitude_counts (8950L)   //counts peak-to-peak...should be 200 uV pk-pk  2.0*(100e-6 / (4.5 / 24 / 2^24))
@@ -511,13 +1413,123 @@ void ADS1299Manager::printAllRegisters(void)
         verbose = prevVerboseState;
 }
 
+//All of the daisy-chained boards hear the same register writes, so channel N (1 to
+//n_chan_all_boards) is set by the same bits as channel N on the first board.  This is
+//which of those (0-7) it is.
+int ADS1299Manager::channelRegIndex(int N_oneRef)
+{
+	return constrain(N_oneRef-1,0,n_chan_all_boards-1) % OPENBCI_NCHAN_PER_BOARD;
+}
+
 //only use SRB1 if all use_SRB2 are set to false
 boolean ADS1299Manager::use_SRB1(void) {
-	for (int Ichan=0; Ichan < OPENBCI_NCHAN_PER_BOARD; Ichan++) {
+	for (int Ichan=0; Ichan < n_chan_all_boards; Ichan++) {
 		if (use_SRB2[Ichan]) {
 			return false;
 		}
 	}
 	return true;
 }
-			
\ No newline at end of file
+			
+
+//The shadow copy of the registers lives in ADS1299::regData.  It is loaded by reset()
+//and kept up to date by every write, so there is no need to read the ADS to find out
+//how it is configured.
+byte ADS1299Manager::readRegister(byte reg)
+{
+	return regData[reg];
+}
+
+//Change a register.  The ADS is only written if the value actually changes.
+void ADS1299Manager::writeRegister(byte reg, byte value)
+{
+	beginConfig();
+	if (regData[reg] != value) {
+		regData[reg] = value;
+		bitSet(dirtyRegisters,reg);
+	}
+	commit();  //sends it now, unless we're inside a beginConfig()
+}
+
+//Send every register that has changed since the last flush.  The registers are
+//sent as one WREGS covering the whole range from the first to the last changed
+//register.  The unchanged ones in the middle simply get their current values again.
+void ADS1299Manager::flushRegisters(void)
+{
+	if (dirtyRegisters == 0) return;
+	byte first = 0, last = CONFIG4;
+	while (!bitRead(dirtyRegisters,first)) first++;
+	while (!bitRead(dirtyRegisters,last)) last--;
+	ADS1299::WREGS(first,last-first);
+	dirtyRegisters = 0;
+}
+
+//Start a configuration transaction.  Until the matching commit(), the Manager's
+//configuration functions only change the shadow copy of the registers.  Transactions
+//can be nested; only the outermost commit() talks to the ADS.
+void ADS1299Manager::beginConfig(void)
+{
+	configDepth++;
+}
+
+//Finish a configuration transaction by sending all of the staged changes in one
+//burst.  If we're running, this is the only interruption to the data: one
+//SDATAC/RDATAC around the burst, without stopping the conversions.
+void ADS1299Manager::commit(void)
+{
+	if (configDepth > 0) configDepth--;
+	if (configDepth > 0) return;  //an outer transaction will send it
+	if (dirtyRegisters == 0) return;  //nothing changed
+	
+	if (isRunning && hotReconfig) {
+		scheduleHotCommit();
+		if (!useDRDYInterrupt) return;  //updateChannelData() sends it right after the next sample
+		
+		//wait for the DRDY interrupt to read the next sample.  Then the rest of the sample
+		//period is ours, and we send the registers from here, with the interrupt off.  If
+		//no sample comes, send them anyway.  That's still a discontinuity, and gets marked.
+		unsigned long start_micros = micros();
+		unsigned long timeout_us = ADS_HOT_COMMIT_TIMEOUT_PERIODS * hotSamplePeriod_us;
+		while (!hotAtBoundary && ((micros() - start_micros) < timeout_us)) ;
+		disableDRDYInterrupt();  //keep the ISR off the SPI bus
+		applyHotCommit();
+		enableDRDYInterrupt();
+		return;
+	}
+	
+	if (isRunning) {
+		if (useDRDYInterrupt) disableDRDYInterrupt();  //keep the ISR off the SPI bus
+		ADS1299::SDATAC();
+	}
+	flushRegisters();
+	if (isRunning) {
+		ADS1299::RDATAC();
+		if (useDRDYInterrupt) enableDRDYInterrupt();
+	}
+}
+
+//Read back all of the registers in one transaction and compare them to the shadow copy.
+//Any register that disagrees is re-sent to the ADS.  Returns the number that disagreed.
+//Must be done while stopped (SDATAC).
+int ADS1299Manager::verifyRegisters(void)
+{
+	byte expected[CONFIG4+1];
+	for (byte reg=0; reg <= CONFIG4; reg++) expected[reg] = regData[reg];
+	
+	ADS1299::RREGS(0x00,CONFIG4);  //note that this overwrites regData
+	
+	int nBad = 0;
+	byte mask;
+	for (byte reg=0; reg <= CONFIG4; reg++) {
+		mask = 0xFF;
+		if ((reg == LOFF_STATP) || (reg == LOFF_STATN)) mask = 0x00;  //read-only status bits
+		if (reg == GPIO) mask = 0x0F;  //the upper bits follow the pins
+		if (((regData[reg] ^ expected[reg]) & mask) != 0) {
+			nBad++;
+			regData[reg] = expected[reg];
+			bitSet(dirtyRegisters,reg);
+		}
+	}
+	flushRegisters();
+	return nBad;
+}
@@ -10,6 +10,8 @@
 #define ____ADS1299Manager__
 
 #include <ADS1299.h>
+#include "ADS1299BandPower.h"
+#include "ADS1299Impedance.h"
 
 //Pick which version of OpenBCI you have
 #define OPENBCI_V1 (1)    //Sept 2013
@@ -24,9 +26,9 @@
   RESET = 9;
   DRDY = 8;
 */
-#define PIN_DRDY (8)
+#define PIN_DRDY (ADS_PIN_DRDY)   //see ADS1299_SPI.h
 #define PIN_RST (9)
-#define PIN_CS (10)
+#define PIN_CS (ADS_PIN_CS)       //see ADS1299_SPI.h
 #define SCK_MHZ (4)
 
 //gainCode choices
@@ -38,6 +40,9 @@
 #define ADS_GAIN12 (0b01010000)
 #define ADS_GAIN24 (0b01100000)
 
+//the ADS1299's internal reference.  Full scale is +/- ADS_VREF_VOLTS / gain.
+#define ADS_VREF_VOLTS (4.5)
+
 //inputCode choices
 #define ADSINPUT_NORMAL (0b00000000)
 #define ADSINPUT_SHORTED (0b00000001)
@@ -51,6 +56,15 @@
 #define ADSTESTSIG_DCSIG (0b00000011)
 #define ADSTESTSIG_NOCHANGE (0b11111111)
 
+//sample rate choices...ADS1299 datasheet page 40
+#define ADS_RATE_16kHZ (0b00000000)
+#define ADS_RATE_8kHZ (0b00000001)
+#define ADS_RATE_4kHZ (0b00000010)
+#define ADS_RATE_2kHZ (0b00000011)
+#define ADS_RATE_1kHZ (0b00000100)
+#define ADS_RATE_500HZ (0b00000101)
+#define ADS_RATE_250HZ (0b00000110)   //default after reset
+
 //Lead-off signal choices
 #define LOFF_MAG_6NA (0b00000000)
 #define LOFF_MAG_24NA (0b00000100)
@@ -60,29 +74,108 @@
 #define LOFF_FREQ_7p8HZ (0b00000001)
 #define LOFF_FREQ_31p2HZ (0b00000010)
 #define LOFF_FREQ_FS_4 (0b00000011)
+#define LOFF_CURRENT_MASK (0b00001100)
+#define LOFF_FREQ_MASK (0b00000011)
 #define PCHAN (1)
 #define NCHAN (2)
 #define BOTHCHAN (3)
 
+//settings for each channel, for configureChannels()
+#define ADS_CHANCFG_ACTIVE (0b00000001)
+#define ADS_CHANCFG_LOFF_P (0b00000010)
+#define ADS_CHANCFG_LOFF_N (0b00000100)
+typedef struct {
+  byte flags;      //any of the ADS_CHANCFG values above, ORed together
+  byte gainCode;   //one of the ADS_GAIN values
+  byte inputCode;  //one of the ADSINPUT values
+} ADS1299ChannelConfig;
+
 #define OFF (0)
 #define ON (1)
 
 //binary communication codes for each packet
 #define PCKT_START 0xA0
+#define PCKT_START_PACKED 0xA1   //same packet, but with 3-byte big-endian samples (see writeChannelDataAsPackedBinary)
+#define PCKT_START_DELTA 0xA2    //change since the previous sample, as zigzag varints (see writeChannelDataAsDelta)
+#define PCKT_START_BATCH 0xA3    //several consecutive samples in one packet (see writeChannelDataAsBatch)
+#define PCKT_START_STATUS 0xA4   //reply to a command (see writeStatusPacket)
+#define PCKT_START_MARKER 0xA5   //discontinuity marker (see writeDiscontinuityMarker)
+#define PCKT_START_BANDPOWER 0xA6  //band power of each channel, once per block (see writeChannelDataAsBandPower)
+#define PCKT_START_IMPEDANCE 0xA7  //electrode impedance of each channel, once per block (see writeChannelDataAsImpedance)
+#define PCKT_START_LEADOFF_SCAN 0xA8  //which channel the lead-off scan is measuring (see writeLeadOffScanPacket)
 #define PCKT_END 0xC0
+#define PCKT_COBS_DELIMITER 0x00  //ends each COBS-framed packet...never appears inside one (see writeCOBSPacket)
+
+//impedance packets give each channel in steps of 100 ohms, or one of these
+#define ADS_IMPEDANCE_OVER_RANGE (0xFFFE)      //6.55 MOhm or more
+#define ADS_IMPEDANCE_NOT_MEASURED (0xFFFF)    //no lead-off current on this channel
+
+//the delta format sends a full (packed) keyframe this often, so that the PC can recover from a lost byte
+#define ADS_DELTA_KEYFRAME_INTERVAL (250)
+
+//RAM set aside for building batched packets.  The default holds 8 samples of 8 channels
+//(or 4 samples of 16 channels).  Define this before including the library to change it.
+#ifndef ADS_BATCH_BUFFER_BYTES
+#define ADS_BATCH_BUFFER_BYTES (8*3*8)
+#endif
+
+//Each of the two transmit buffers holds this many bytes.  A 16-channel binary packet with
+//the aux value is 75 bytes.  Define this before including the library to change it.
+#ifndef ADS_TX_BUFFER_BYTES
+#define ADS_TX_BUFFER_BYTES (80)
+#endif
+
+//DRDY interrupt-driven acquisition.  The ISR reads each raw frame into a ring
+//and loop() drains the ring, converting the frames as it goes.  The ring length
+//must be a power of two.
+#ifndef ADS_SAMPLE_RING_LEN
+#define ADS_SAMPLE_RING_LEN (4)
+#endif
+typedef struct {
+  long sampleNumber;
+  byte raw[ADS1299::MAX_FRAME_BYTES];
+  byte discontinuity;    //0, or 1 + the samples lost if this is the first sample after a hot reconfiguration
+  byte changedChannels;  //which channels that reconfiguration touched (bit 0 = channel 1)
+} ADS1299SampleFrame;
+
+//Hot reconfiguration.  When it is on, a commit() made while running is sent to the ADS
+//right after the next sample has been read, and the first sample after it is marked as a
+//discontinuity.  In interrupt mode, commit() waits up to this many sample periods for the
+//DRDY interrupt to say that a sample has just been read.
+#define ADS_HOT_COMMIT_TIMEOUT_PERIODS (2)
+
+//Set this to 1 to time the DRDY interrupt and (in the StreamRawData sketch) each stage of
+//the acquisition loop.  See ADS1299Profiler.h.  Off by default, as it costs RAM.
+#ifndef ADS_PROFILE
+#define ADS_PROFILE (0)
+#endif
+#if ADS_PROFILE
+#include "ADS1299Profiler.h"
+#endif
 
 class ADS1299Manager : public ADS1299 {
   public:
     void initialize(void);                                     //initialize the ADS1299 controller.  Call once.  Assumes OpenBCI_V2
     void initialize(int version,boolean isDaisy);              //initialize the ADS1299 controller.  Call once.  Set which version of OpenBCI you're using.
+    void initializeBoards(int version,int nBoards);            //same, but for a daisy chain of nBoards (up to ADS_MAX_N_BOARDS)
     void setVersionOpenBCI(int version);			//Set which version of OpenBCI you're using.
     void reset(void);                                          //reset all the ADS1299's settings.  Call however you'd like
     boolean isChannelActive(int N_oneRef);
-    void activateChannel(int N_oneRef, byte gainCode,byte inputCode); //setup the channel 1-8
-    void deactivateChannel(int N_oneRef);                            //disable given channel 1-8
+    void activateChannel(int N_oneRef, byte gainCode,byte inputCode); //setup the channel 1-8 (up to 8 per board)
+    void deactivateChannel(int N_oneRef);                            //disable given channel 1-8 (up to 8 per board)
     void configureLeadOffDetection(byte amplitudeCode, byte freqCode);  //configure the lead-off detection signal parameters
+    float getLeadOffCurrent_A(void);                           //the lead-off current, from the LOFF_MAG setting
+    float getLeadOffFrequency_Hz(void);                        //the lead-off frequency, from the LOFF_FREQ setting.  0 for DC.
+    float getChannelGain(int N_oneRef);                        //the PGA gain of channel 1-8
     void changeChannelLeadOffDetection(int N_oneRef, int code_OFF_ON, int code_P_N_Both);
+    void configureChannels(const ADS1299ChannelConfig *config, int nChan, boolean autoBias);  //set up channels 1-nChan all at once (nChan up to the chain's)
     void configureInternalTestSignal(byte amplitudeCode, byte freqCode);  //configure the test signal parameters
+    void setSampleRate(byte rateCode);                         //set the output data rate using one of the ADS_RATE codes
+    byte getSampleRateCode(void);
+    float getSampleRate_Hz(void);
+    int getBinaryPacketBytes(int N, boolean sendAuxValue);     //size of each packet from writeChannelDataAsBinary
+    int getPackedBinaryPacketBytes(int N);                     //size of each packet from writeChannelDataAsPackedBinary
+    boolean isStreamSustainable(long baud, int packetBytes);   //can the serial link carry this packet at the current sample rate?
     void start(void);
     void stop(void);
     int isDataAvailable(void);
@@ -92,6 +185,27 @@ class ADS1299Manager : public ADS1299 {
     void writeChannelDataAsBinary(int N, long int sampleNumber, long int auxValue);
     void writeChannelDataAsBinary(int N, long int sampleNumber, long int auxValue, boolean useSyntheticData);
     void writeChannelDataAsBinary(int N, long int sampleNumber, boolean sendAuxValue,long int auxValue, boolean useSyntheticData);
+    void writeChannelDataAsPackedBinary(int N, long int sampleNumber);
+    void writeChannelDataAsPackedBinary(int N, long int sampleNumber, boolean useSyntheticData);
+    void writeChannelDataAsDelta(int N, long int sampleNumber);
+    void setDeltaKeyframeInterval(int nSamples);              //how often writeChannelDataAsDelta sends a full keyframe
+    void resetDeltaEncoder(void);                              //make the next delta packet a keyframe
+    void writeChannelDataAsBatch(int N, long int sampleNumber);  //queue this sample.  Sends a packet every K samples.
+    void setBatchSize(int K);                                  //how many samples go in each batched packet
+    void flushBatch(void);                                     //send the samples queued by writeChannelDataAsBatch now.  stop() does this.
+    int getBatchSize(int N);                                   //K, after limiting it to what fits in the buffer for N channels
+    int getBatchPacketBytes(int N);                            //size of each packet from writeChannelDataAsBatch
+    void writeChannelDataAsCOBS(int N, long int sampleNumber);   //packed samples plus CRC, framed with COBS
+    void setCOBSFraming(boolean state);                        //if true, the status, marker, impedance, and lead-off scan packets are framed with COBS too
+    int getCOBSPacketBytes(int N);                             //size of each packet from writeChannelDataAsCOBS
+    void writeChannelDataAsBandPower(int N, long int sampleNumber, ADS1299BandPower *bandPower);  //feed the estimator.  Sends a packet at the end of each block.
+    int getBandPowerPacketBytes(int N, int nBands);            //size of each packet from writeChannelDataAsBandPower
+    void writeChannelDataAsImpedance(int N, long int sampleNumber, ADS1299Impedance *impedance);  //feed the lock-in.  Sends a packet at the end of each block.
+    unsigned int getImpedanceCode(int chan, float amplitude, float drive_Hz);  //a lock-in amplitude (counts) in the units of the impedance packet
+    void writeImpedancePacket(long int sampleNumber, int blockLen, int N, const unsigned int *codes);  //the impedance packet itself
+    void writeLeadOffScanPacket(long int sampleNumber, int N_oneRef, byte code_P_N);  //tell the PC which channel the lead-off scan is on
+    void writeStatusPacket(const byte *payload, int nBytes);   //send a reply to a command, framed like the binary data
+    unsigned int computeCRC16(const byte *data, int nBytes);   //CRC-16/CCITT, as used by the COBS packets and the commands
     void writeChannelDataAsOpenEEG_P2(long int sampleNumber);
     void writeChannelDataAsOpenEEG_P2(long int sampleNumber, boolean useSyntheticData);
     void printAllRegisters(void);
@@ -100,15 +214,96 @@ class ADS1299Manager : public ADS1299 {
     void deactivateBiasForChannel(int N_oneRef);
     void activateBiasForChannel(int N_oneRef);
     void setAutoBiasGeneration(boolean state);
+    byte readRegister(byte reg);                               //read from the shadow copy of the registers (no SPI)
+    void writeRegister(byte reg, byte value);                  //update the shadow copy.  Only goes to the ADS if the value changed.
+    void flushRegisters(void);                                 //send any changed registers to the ADS
+    void beginConfig(void);                                    //start staging register changes instead of sending them
+    void commit(void);                                         //send all staged changes in one burst.  OK to call while running.
+    int verifyRegisters(void);                                 //read back all registers and check them against the shadow copy
+    void setInterruptMode(boolean state);                      //if true, start() reads the data via the DRDY interrupt (or polls, if the board has none)
+    void setHotReconfig(boolean state);                        //if true, commit() while running waits for a sample boundary and marks the data
+    boolean isHotReconfig(void);
+    void updateChannelData(void);                              //polling mode: read a sample, then send any pending hot reconfiguration
+    int getDiscontinuity(void);                                //-1, or how many samples were lost just before the current sample
+    byte getDiscontinuityChannels(void);                       //which channels the reconfiguration before the current sample touched
+    void writeDiscontinuityMarker(long int sampleNumber);      //tell the PC about the discontinuity, in the binary stream
+    unsigned long getHotSamplesLost(void);                     //total samples lost to hot reconfigurations
+    boolean isInterruptMode(void);
+    long popChannelData(void);                                 //copy the oldest buffered sample into channelData.  Returns its sample number
+    unsigned long getRingOverruns(void);                       //number of samples dropped because the ring was full
+    byte getRingPeakDepth(void);                               //the most samples that have ever been waiting in the ring
+    void serviceDRDY(void);                                    //called by the DRDY interrupt.  Don't call it yourself.
+    void serviceTX(void);                                      //hand queued bytes to the Serial port without waiting.  Call often.
+    void flushTX(void);                                        //send everything that's queued, waiting if needed
+    int getTXQueueDepth(void);                                 //bytes queued but not yet given to the Serial port
+    int getTXPeakDepth(void);                                  //the most bytes that have ever been queued
+    unsigned long getTXStalls(void);                           //times that a writer had to wait for the Serial port
+#if ADS_PROFILE
+    void getISRProfile(ADS1299Profiler<1> *target, boolean reset);  //copy the timing of the DRDY interrupt
+#endif
     
     
   private:
     boolean use_neg_inputs;
-    boolean use_SRB2[OPENBCI_NCHAN_PER_BOARD];
+    boolean use_SRB2[ADS1299::MAX_N_CHAN];
     boolean use_channels_for_bias;
     boolean use_SRB1(void);
+    byte leadOffFlip(void);                 //LOFF_FLIP for the inputs we're using
+    boolean registersLoaded;                //the shadow copy has been read from the ADS (by reset())
     long int makeSyntheticSample(long sampleNumber,int chan);
     int n_chan_all_boards;
+    int channelRegIndex(int N_oneRef);      //which CHnSET (and which bit of the other channel registers) channel N uses, from 0
+    unsigned long dirtyRegisters;           //one bit per register that needs to be sent to the ADS
+    byte configDepth;                       //how many beginConfig() calls are waiting for their commit()
+    boolean isRunning;
+    boolean enableDRDYInterrupt(void);
+    void disableDRDYInterrupt(void);
+    boolean useDRDYInterrupt;
+    ADS1299SampleFrame sampleRing[ADS_SAMPLE_RING_LEN];
+    volatile byte ringHead;                 //next slot to be written by the ISR
+    volatile byte ringTail;                 //next slot to be read by loop()
+    volatile byte ringPeakDepth;
+    volatile long ringSampleCounter;
+    volatile unsigned long ringOverruns;
+    long deltaPrevValue[ADS1299::MAX_N_CHAN];  //what the PC thinks each channel was on the last packet
+    int deltaKeyframeInterval;
+    int deltaSamplesUntilKeyframe;
+    long deltaPrevSampleNumber;               //the sample number of the last delta (or keyframe) packet
+    void writeDeltaKeyframe(int N, long sampleNumber);
+    byte batchBuffer[ADS_BATCH_BUFFER_BYTES];  //the packed samples waiting to go out
+    byte batchSize;
+    byte batchCount;                        //how many samples are in batchBuffer
+    int batchN;                             //how many channels each of those samples has
+    long batchFirstSampleNumber;
+    void sendBatch(void);
+    byte txBuffer[2][ADS_TX_BUFFER_BYTES];  //the writers fill the back buffer while the front one is sent
+    int txLen[2];                           //bytes in each buffer
+    byte txBack;                            //which buffer is the back buffer
+    int txSent;                             //bytes of the front buffer already given to the Serial port
+    unsigned long txStalls;
+    int txPeakDepth;
+    void txWrite(byte value);
+    void txWrite(const byte *data, int nBytes);
+    boolean cobsFraming;
+    void writePacket(byte startByte, const byte *payload, int nBytes);   //framed one way or the other
+    void writeCOBSPacket(byte startByte, const byte *payload, int nBytes);
+    byte cobsByteAt(int i, byte startByte, const byte *payload, int nBytes, unsigned int crc);
+    void swapTX(void);
+    boolean hotReconfig;
+    volatile boolean hotCommitPending;      //registers are waiting to go out right after the next sample
+    volatile boolean hotAtBoundary;         //the DRDY interrupt has just read a sample, so it's time to send them
+    byte hotPendingChannels;                //channels touched by those registers
+    unsigned long hotSamplePeriod_us;
+    volatile byte hotMarker;                //discontinuity for the next sample to be read
+    volatile byte hotMarkerChannels;
+    volatile unsigned long hotSamplesLost;
+    int currentDiscontinuity;               //for the sample that's in channelData now
+    byte currentDiscontinuityChannels;
+    void scheduleHotCommit(void);
+    void applyHotCommit(void);
+#if ADS_PROFILE
+    ADS1299Profiler<1> isrProfile;          //time spent in serviceDRDY for each sample that was read
+#endif
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,124 @@
+//
+//  ADS1299Profiler.h
+//  Part of the Arduino Library for the ADS1299 Shield
+//
+//  Timing statistics for the stages of the acquisition loop (reading the ADS,
+//  filtering, encoding, sending).  Each stage keeps its min, max, and mean time
+//  plus a small histogram with one bin per power of two, so that the rare slow
+//  sample shows up too.  It is only compiled in when ADS_PROFILE is set (see
+//  ADS1299Manager.h), as it costs some RAM and a micros() call per stage.
+//
+//  Use it like this:
+//     profiler.begin();       //at the start of a sample
+//     ...read the sample...
+//     profiler.lap(0);        //the time since begin() goes to stage 0
+//     ...filter it...
+//     profiler.lap(1);        //the time since the last lap goes to stage 1
+//     profiler.finish(2);     //the time since begin() goes to stage 2 (the total)
+//
+//  The times come from micros(), which only counts in steps of 4 usec on a 16 MHz Uno.
+//
+//  To see the report while a binary stream is running, packStage() packs a stage into
+//  bytes that can go out in a status packet (ADS1299Manager::writeStatusPacket), so that
+//  it shares the serial link with the data instead of printing text into the middle of it.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#ifndef ____ADS1299Profiler__
+#define ____ADS1299Profiler__
+
+#include <Arduino.h>
+
+//Histogram bins.  Bin 0 is anything under 8 usec, bin 1 is 8-15 usec, bin 2 is 16-31 usec,
+//and so on up to bin 10 (4096-8191 usec).  The last bin gets everything longer.
+#define ADS_PROFILE_N_BINS (12)
+
+//A stage, packed by packStage():
+//   Count:      4 bytes (little endian), samples timed
+//   Total:      4 bytes (little endian), usec.  The mean is total / count.
+//   Min, max:   2 bytes each (big endian), usec
+//   Histogram:  2 bytes per bin (big endian), bin 0 first
+#define ADS_PROFILE_PACKED_BYTES (4 + 4 + 2 + 2 + 2*ADS_PROFILE_N_BINS)
+
+template <int N_STAGES>
+class ADS1299Profiler {
+public:
+    ADS1299Profiler() { reset(); }
+
+    void reset(void) {
+        for (int Istage=0; Istage < N_STAGES; Istage++) {
+            count[Istage] = 0; total_us[Istage] = 0;
+            min_us[Istage] = 0xFFFF; max_us[Istage] = 0;
+            for (int Ibin=0; Ibin < ADS_PROFILE_N_BINS; Ibin++) hist[Istage][Ibin] = 0;
+        }
+    }
+    void begin(void) { startMicros = lastMicros = micros(); }
+    void lap(int stage) {
+        unsigned long now = micros();
+        record(stage, now - lastMicros);
+        lastMicros = now;
+    }
+    void finish(int stage) {
+        lastMicros = micros();
+        record(stage, lastMicros - startMicros);
+    }
+    void record(int stage, unsigned long dt_us) {
+        count[stage]++;
+        total_us[stage] += dt_us;
+        unsigned int dt = (dt_us > 0xFFFF) ? 0xFFFF : (unsigned int)dt_us;
+        if (dt < min_us[stage]) min_us[stage] = dt;
+        if (dt > max_us[stage]) max_us[stage] = dt;
+        byte bin = 0;
+        for (unsigned int v = dt >> 3; (v != 0) && (bin < ADS_PROFILE_N_BINS-1); v >>= 1) bin++;
+        if (hist[stage][bin] < 0xFFFF) hist[stage][bin]++;  //saturate rather than wrap
+    }
+
+    //print one line for the stage.  The percentages are of the sample period.
+    void printStage(const __FlashStringHelper *name, int stage, float period_us) {
+        Serial.print(name);
+        Serial.print(F(": n = ")); Serial.print(count[stage]);
+        if (count[stage] == 0) { Serial.println(); return; }
+        float mean_us = ((float)total_us[stage]) / ((float)count[stage]);
+        Serial.print(F(", min = ")); Serial.print(min_us[stage]);
+        Serial.print(F(", mean = ")); Serial.print(mean_us,1);
+        Serial.print(F(", max = ")); Serial.print(max_us[stage]);
+        Serial.print(F(" usec ("));
+        Serial.print(100.0*mean_us/period_us,1); Serial.print(F("% mean, "));
+        Serial.print(100.0*((float)max_us[stage])/period_us,1); Serial.println(F("% max of the sample period)"));
+
+        //the histogram, labeled by the bottom of each bin
+        Serial.print(F("   usec>="));
+        for (int Ibin=0; Ibin < ADS_PROFILE_N_BINS; Ibin++) {
+            if (hist[stage][Ibin] == 0) continue;  //keep it short
+            Serial.print(' '); Serial.print((Ibin == 0) ? 0 : (4U << Ibin));
+            Serial.print(':'); Serial.print(hist[stage][Ibin]);
+        }
+        Serial.println();
+    }
+
+    //pack the stage into out (ADS_PROFILE_PACKED_BYTES of it).  Returns the bytes used.
+    int packStage(int stage, byte *out) {
+        for (int i=0; i < 4; i++) out[i] = (byte)(count[stage] >> (8*i));
+        for (int i=0; i < 4; i++) out[4+i] = (byte)(total_us[stage] >> (8*i));
+        out[8] = (byte)(min_us[stage] >> 8); out[9] = (byte)min_us[stage];
+        out[10] = (byte)(max_us[stage] >> 8); out[11] = (byte)max_us[stage];
+        for (int Ibin=0; Ibin < ADS_PROFILE_N_BINS; Ibin++) {
+            out[12+2*Ibin] = (byte)(hist[stage][Ibin] >> 8);
+            out[12+2*Ibin+1] = (byte)hist[stage][Ibin];
+        }
+        return ADS_PROFILE_PACKED_BYTES;
+    }
+
+    unsigned long count[N_STAGES];
+    unsigned long total_us[N_STAGES];
+    unsigned int min_us[N_STAGES];
+    unsigned int max_us[N_STAGES];
+    unsigned int hist[N_STAGES][ADS_PROFILE_N_BINS];
+
+private:
+    unsigned long startMicros;
+    unsigned long lastMicros;
+};
+
+#endif
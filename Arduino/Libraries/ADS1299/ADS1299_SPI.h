@@ -0,0 +1,326 @@
+//
+//  ADS1299_SPI.h
+//  Part of the Arduino Library for the ADS1299 Shield
+//
+//  The low-level SPI and pin access used by the ADS1299 driver.  Each kind of
+//  board gets its own "policy" class, and the driver is a template over that
+//  class.  Everything here is static and inline so that the compiler builds
+//  the transfer code straight into the driver, with no function pointers and
+//  no virtual calls.  A policy provides:
+//
+//    begin(FREQ)        set up the SPI port (FREQ is the SCK rate in MHz), CS and DRDY
+//    select()           pull CS low
+//    deselect()         pull CS high
+//    isDataReady()      true when DRDY is low
+//    transfer(byte)     clock one byte out and one byte in
+//    readBlock(buf,N)   clock N bytes in (sending zeros) as fast as possible
+//    Lock               a class whose objects keep interrupts off for as long as they
+//                       exist, for the few things that the DRDY interrupt also touches
+//    attachDRDY(isr)    call isr when DRDY goes low.  False if this board can't, in
+//                       which case the Manager polls DRDY instead.
+//    detachDRDY()       stop calling it
+//
+//  Created by Chip Audette, May 2014
+//
+
+#ifndef ____ADS1299_SPI__
+#define ____ADS1299_SPI__
+
+#include <Arduino.h>
+#include "Definitions.h"
+
+//OpenBCI shield pin assignments.  Define these before including the library to override them.
+#ifndef ADS_PIN_DRDY
+#define ADS_PIN_DRDY (8)
+#endif
+#ifndef ADS_PIN_CS
+#define ADS_PIN_CS (10)
+#endif
+
+typedef void (*ADS1299_ISR)(void);
+
+
+#if defined(__AVR__)
+
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+//Direct port access for a pin on an ATmega328 (Arduino Uno).  Because PIN is known
+//at compile time, each of these collapses to a single sbi/cbi/sbis instruction.
+template <int PIN>
+class ADS1299_AVRPin {
+public:
+    static inline volatile uint8_t &port(void) { return (PIN < 8) ? PORTD : ((PIN < 14) ? PORTB : PORTC); }
+    static inline volatile uint8_t &input(void) { return (PIN < 8) ? PIND : ((PIN < 14) ? PINB : PINC); }
+    static inline uint8_t mask(void) { return _BV((PIN < 8) ? PIN : ((PIN < 14) ? (PIN-8) : (PIN-14))); }
+    static inline void set(void) { port() |= mask(); }
+    static inline void clear(void) { port() &= ~mask(); }
+    static inline boolean read(void) { return (input() & mask()) != 0; }
+};
+#else
+//Other AVRs (the Mega, the Leonardo) put the pins on other ports, so go through the
+//Arduino pin functions.  Slower, but right.
+template <int PIN>
+class ADS1299_AVRPin {
+public:
+    static inline void set(void) { digitalWrite(PIN, HIGH); }
+    static inline void clear(void) { digitalWrite(PIN, LOW); }
+    static inline boolean read(void) { return digitalRead(PIN) == HIGH; }
+};
+#endif
+
+//Hardware SPI on the AVR, polling SPIF
+template <int CS_PIN, int DRDY_PIN>
+class ADS1299_SPI_AVR {
+public:
+    class Lock {
+    public:
+        Lock() { oldSREG = SREG; cli(); }
+        ~Lock() { SREG = oldSREG; }  //only re-enables interrupts if they were enabled before
+    private:
+        byte oldSREG;
+    };
+    static void begin(int FREQ) {
+        // Set direction register for SCK and MOSI pin.
+        // MISO pin automatically overrides to INPUT.
+        // When the SS pin is set as OUTPUT, it can be used as
+        // a general purpose output port (it doesn't influence
+        // SPI operations).
+        pinMode(SCK, OUTPUT);
+        pinMode(MOSI, OUTPUT);
+        pinMode(SS, OUTPUT);
+        digitalWrite(SCK, LOW);
+        digitalWrite(MOSI, LOW);
+        digitalWrite(SS, HIGH);
+
+        // set as master and enable SPI
+        SPCR |= _BV(MSTR);
+        SPCR |= _BV(SPE);
+        //set bit order
+        SPCR &= ~(_BV(DORD)); ////SPI data format is MSB (pg. 25)
+        // set data mode
+        SPCR = (SPCR & ~SPI_MODE_MASK) | SPI_DATA_MODE; //clock polarity = 0; clock phase = 1 (pg. 8)
+        // set clock divider
+        int DIVIDER = SPI_CLOCK_DIV_4;
+        switch (FREQ){
+            case 8:
+                DIVIDER = SPI_CLOCK_DIV_2;
+                break;
+            case 4:
+                DIVIDER = SPI_CLOCK_DIV_4;
+                break;
+            case 1:
+                DIVIDER = SPI_CLOCK_DIV_16;
+                break;
+            default:
+                break;
+        }
+        SPCR = (SPCR & ~SPI_CLOCK_MASK) | (DIVIDER);  // set SCK frequency
+        SPSR = (SPSR & ~SPI_2XCLOCK_MASK) | (DIVIDER); // by dividing 16MHz system clock
+
+        // initalize the data ready and chip select pins
+        pinMode(DRDY_PIN, INPUT);
+        pinMode(CS_PIN, OUTPUT);
+        deselect();
+    }
+    static inline void select(void) { ADS1299_AVRPin<CS_PIN>::clear(); }
+    static inline void deselect(void) { ADS1299_AVRPin<CS_PIN>::set(); }
+    static inline boolean isDataReady(void) { return !ADS1299_AVRPin<DRDY_PIN>::read(); }
+    static inline byte transfer(byte _data) {
+        Lock lock;	//  safe to call from the DRDY ISR, too
+        SPDR = _data;
+        while (!(SPSR & _BV(SPIF)))
+            ;
+        return SPDR;
+    }
+    static inline void readBlock(byte *buf, int N) {
+        Lock lock;			//  once for the whole block, not once per byte
+        for (int i=0; i < N; i++) {
+            SPDR = 0x00;
+            while (!(SPSR & _BV(SPIF)))
+                ;
+            buf[i] = SPDR;
+        }
+    }
+    //DRDY is on pin 8 of the Uno, which is only served by the pin-change interrupt for
+    //port B.  That vector is in ADS1299.cpp, and it calls whatever is in drdyISR().
+    static inline ADS1299_ISR &drdyISR(void) { static ADS1299_ISR isr = NULL; return isr; }
+#if defined(PCINT0_vect)
+    static inline boolean isOnPCINT0(void) {
+        volatile uint8_t *pcicr = digitalPinToPCICR(DRDY_PIN);  //NULL if the pin has no pin-change interrupt
+        return (pcicr != NULL) && (digitalPinToPCICRbit(DRDY_PIN) == 0);
+    }
+#endif
+    static boolean attachDRDY(ADS1299_ISR isr) {
+#if defined(PCINT0_vect)
+        if (!isOnPCINT0()) return false;
+        drdyISR() = isr;
+        *digitalPinToPCMSK(DRDY_PIN) |= _BV(digitalPinToPCMSKbit(DRDY_PIN));  //watch the DRDY pin
+        PCIFR = _BV(digitalPinToPCICRbit(DRDY_PIN));                          //forget any old edge
+        *digitalPinToPCICR(DRDY_PIN) |= _BV(digitalPinToPCICRbit(DRDY_PIN));  //enable the interrupt
+        return true;
+#else
+        return false;
+#endif
+    }
+    static void detachDRDY(void) {
+#if defined(PCINT0_vect)
+        if (!isOnPCINT0()) return;
+        *digitalPinToPCMSK(DRDY_PIN) &= ~_BV(digitalPinToPCMSKbit(DRDY_PIN));
+#endif
+        drdyISR() = NULL;
+    }
+};
+
+typedef ADS1299_SPI_AVR<ADS_PIN_CS,ADS_PIN_DRDY> ADS1299_SPI_Board;
+
+
+#elif defined(__SAM3X8E__)
+
+//Bit-banged SPI on the Arduino DUE (SCK = 13, MISO = 12, MOSI = 11).  With no waiting,
+//each half of the SCK period takes about ADS_DUE_HALF_BIT_CYCLES of the 84 MHz clock,
+//which is faster than the ADS1299 wants, so begin() works out how many spins of a wait
+//loop (ADS_DUE_SPIN_CYCLES each) to add to each half to bring SCK down to FREQ.
+#ifndef ADS_DUE_HALF_BIT_CYCLES
+#define ADS_DUE_HALF_BIT_CYCLES (6)
+#endif
+#ifndef ADS_DUE_SPIN_CYCLES
+#define ADS_DUE_SPIN_CYCLES (5)
+#endif
+template <int CS_PIN, int DRDY_PIN>
+class ADS1299_SPI_DUE {
+public:
+    class Lock {
+    public:
+        Lock() { primask = __get_PRIMASK(); __disable_irq(); }
+        ~Lock() { __set_PRIMASK(primask); }
+    private:
+        uint32_t primask;
+    };
+    //the clock divider: spins of the wait loop in each half of the SCK period
+    static inline uint32_t &clockDivider(void) { static uint32_t spins = 0; return spins; }
+    static inline void waitHalfBit(void) { for (volatile uint32_t i = clockDivider(); i != 0; i--) ; }
+    static void begin(int FREQ) {
+        if (FREQ < 1) FREQ = 1;
+        uint32_t halfBit = (F_CPU / 1000000UL + 2*FREQ - 1) / (2*FREQ);  //cycles, rounded up so SCK is never faster than FREQ
+        clockDivider() = (halfBit > ADS_DUE_HALF_BIT_CYCLES) ?
+            (halfBit - ADS_DUE_HALF_BIT_CYCLES + ADS_DUE_SPIN_CYCLES - 1) / ADS_DUE_SPIN_CYCLES : 0;
+        pinMode(13, OUTPUT);  // SCK
+        pinMode(12, INPUT);   // MISO
+        pinMode(11, OUTPUT);  // MOSI
+        digitalWrite(13, LOW);
+        pinMode(DRDY_PIN, INPUT);
+        pinMode(CS_PIN, OUTPUT);
+        deselect();
+    }
+    static inline void select(void) { digitalWrite(CS_PIN, LOW); }
+    static inline void deselect(void) { digitalWrite(CS_PIN, HIGH); }
+    static inline boolean isDataReady(void) { return !digitalRead(DRDY_PIN); }
+    static inline byte transfer(byte outByte) {
+        byte inByte = 0;
+        for (byte mask = 0x80; mask != 0; mask >>= 1) {
+            REG_PIOB_SODR = 0x08000000;     // set SCK
+            if (outByte & mask) {           // bang out a bit
+                REG_PIOD_SODR = 0x80;       // fastest way to set pin 11
+            } else {
+                REG_PIOD_CODR = 0x80;       // fastest way to clear pin 11
+            }
+            waitHalfBit();
+            REG_PIOB_CODR = 0x08000000;     // clear SCK
+            if (REG_PIOD_PDSR & 0x100) inByte |= mask;  // bang in a bit from pin 12
+            waitHalfBit();
+        }
+        return inByte;
+    }
+    static inline void readBlock(byte *buf, int N) {
+        for (int i=0; i < N; i++) buf[i] = transfer(0x00);
+    }
+    //every pin on the DUE can interrupt
+    static boolean attachDRDY(ADS1299_ISR isr) { attachInterrupt(DRDY_PIN, isr, FALLING); return true; }
+    static void detachDRDY(void) { detachInterrupt(DRDY_PIN); }
+};
+
+typedef ADS1299_SPI_DUE<ADS_PIN_CS,ADS_PIN_DRDY> ADS1299_SPI_Board;
+
+
+#elif defined(__PIC32MX__)
+
+//Hardware SPI on the ChipKIT UNO32 through the DSPI library (DSPI0 is on 13,12,11)
+#include <DSPI.h>
+template <int CS_PIN, int DRDY_PIN>
+class ADS1299_SPI_DSPI {
+public:
+    class Lock {
+    public:
+        Lock() { status = disableInterrupts(); }
+        ~Lock() { restoreInterrupts(status); }
+    private:
+        uint32_t status;
+    };
+    static inline DSPI0 &port(void) { static DSPI0 spi; return spi; }
+    static void begin(int FREQ) {
+        port().begin(CS_PIN);
+        port().setMode(DSPI_MODE1);
+        port().setSpeed(FREQ*1000000UL);
+        pinMode(DRDY_PIN, INPUT);
+        deselect();
+    }
+    static inline void select(void) { port().setSelect(LOW); }
+    static inline void deselect(void) { port().setSelect(HIGH); }
+    static inline boolean isDataReady(void) { return !digitalRead(DRDY_PIN); }
+    static inline byte transfer(byte _data) { return port().transfer(_data); }
+    static inline void readBlock(byte *buf, int N) {
+        for (int i=0; i < N; i++) buf[i] = port().transfer((byte)0x00);
+    }
+    //pin 8 has no interrupt on the UNO32, so the Manager polls it
+    static boolean attachDRDY(ADS1299_ISR isr) { return false; }
+    static void detachDRDY(void) {}
+};
+
+typedef ADS1299_SPI_DSPI<ADS_PIN_CS,ADS_PIN_DRDY> ADS1299_SPI_Board;
+
+
+#elif defined(ADS1299_HOST)
+
+//The host build (Arduino/Tests): a simulated ADS1299 daisy chain on a simulated clock,
+//so that the library can be tested and timed on a PC.  See Arduino/Tests/README.txt.
+#include "ADS1299Sim.h"
+template <int CS_PIN, int DRDY_PIN>
+class ADS1299_SPI_Host {
+public:
+    class Lock {
+    public:
+        Lock() { wasEnabled = hostDisableInterrupts(); }
+        ~Lock() { hostRestoreInterrupts(wasEnabled); }
+    private:
+        boolean wasEnabled;
+    };
+    static void begin(int FREQ) {
+        ADS1299Sim::chip().begin(FREQ, DRDY_PIN);
+        deselect();
+    }
+    static inline void select(void) { ADS1299Sim::chip().select(); }
+    static inline void deselect(void) { ADS1299Sim::chip().deselect(); }
+    static inline boolean isDataReady(void) { return ADS1299Sim::chip().isDRDYLow(); }
+    static inline byte transfer(byte _data) { return ADS1299Sim::chip().transfer(_data); }
+    static inline void readBlock(byte *buf, int N) {
+        for (int i=0; i < N; i++) buf[i] = ADS1299Sim::chip().transfer(0x00);
+    }
+    static boolean attachDRDY(ADS1299_ISR isr) {
+        int num = digitalPinToInterrupt(DRDY_PIN);
+        if (num == NOT_AN_INTERRUPT) return false;
+        attachInterrupt(num, isr, FALLING);
+        return true;
+    }
+    static void detachDRDY(void) {
+        int num = digitalPinToInterrupt(DRDY_PIN);
+        if (num != NOT_AN_INTERRUPT) detachInterrupt(num);
+    }
+};
+
+typedef ADS1299_SPI_Host<ADS_PIN_CS,ADS_PIN_DRDY> ADS1299_SPI_Board;
+
+
+#else
+#error "ADS1299: no SPI policy for this board.  See ADS1299_SPI.h"
+#endif
+
+#endif
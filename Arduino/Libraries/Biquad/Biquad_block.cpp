@@ -0,0 +1,160 @@
+//
+//  Biquad_block.cpp
+//
+//  A biquad run over blocks of samples from many channels at once.  See Biquad_block.h.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "Biquad_multiChan.h"
+#include "Biquad_block.h"
+
+//the SIMD kernels are for x86 PCs, built with GCC or clang (which can build the AVX2 one
+//without building the whole program for AVX2, and can ask the CPU what it has)
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BQ_BLOCK_X86
+#include <immintrin.h>
+#endif
+
+int Biquad_block::kernel = BQ_BLOCK_AUTO;
+
+Biquad_block::Biquad_block(int N, int type, double Fc, double Q, double peakGainDB) {
+    Nchan = N;
+    z1 = new double[Nchan];
+    z2 = new double[Nchan];
+    for (int Ichan=0; Ichan < Nchan; Ichan++) resetChannel(Ichan);
+    setBiquad(type, Fc, Q, peakGainDB);
+}
+
+Biquad_block::~Biquad_block() {
+    delete[] z2;
+    delete[] z1;
+}
+
+void Biquad_block::setBiquad(int type, double Fc, double Q, double peakGainDB) {
+    Biquad_multiChan::calcCoefficients(type, Fc, Q, peakGainDB, coeff);
+}
+
+void Biquad_block::resetChannel(int Ichan) {
+    if ((Ichan < 0) || (Ichan >= Nchan)) return;
+    z1[Ichan] = 0.0;
+    z2[Ichan] = 0.0;
+}
+
+//channels firstChan up to Nchan, without SIMD.  One channel's samples depend on each other,
+//so it goes a sample at a time across the channels, where there's work that can overlap.
+//The arithmetic is exactly that of Biquad_multiChan::process().
+static void processScalar(const double *c, double *z1, double *z2, float *frames, int nFrames, int Nchan, int firstChan) {
+    const double a0 = c[0], a1 = c[1], a2 = c[2], b1 = c[3], b2 = c[4];
+    for (int i=0; i < nFrames; i++) {
+        float *p = frames + i*Nchan;
+        for (int Ichan = firstChan; Ichan < Nchan; Ichan++) {
+            double in = p[Ichan];
+            double out = in * a0 + z1[Ichan];
+            z1[Ichan] = in * a1 + z2[Ichan] - b1 * out;
+            z2[Ichan] = in * a2 - b2 * out;
+            p[Ichan] = (float)out;
+        }
+    }
+}
+
+#ifdef BQ_BLOCK_X86
+
+//two channels to a register (doubles, so that the answer doesn't change), from firstChan on,
+//a sample at a time across the channels, like processScalar().  Returns the first channel
+//that it didn't do.
+__attribute__((target("sse2")))
+static int processSSE2(const double *c, double *z1, double *z2, float *frames, int nFrames, int Nchan, int firstChan) {
+    const __m128d a0 = _mm_set1_pd(c[0]), a1 = _mm_set1_pd(c[1]), a2 = _mm_set1_pd(c[2]);
+    const __m128d b1 = _mm_set1_pd(c[3]), b2 = _mm_set1_pd(c[4]);
+    int lastChan = firstChan + ((Nchan - firstChan) / 2) * 2;
+    for (int i=0; i < nFrames; i++) {
+        float *p = frames + i*Nchan;
+        for (int Ichan = firstChan; Ichan < lastChan; Ichan += 2) {
+            __m128d in = _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double *)(p + Ichan))));   //two floats
+            __m128d out = _mm_add_pd(_mm_mul_pd(in, a0), _mm_loadu_pd(z1 + Ichan));
+            _mm_storeu_pd(z1 + Ichan, _mm_sub_pd(_mm_add_pd(_mm_mul_pd(in, a1), _mm_loadu_pd(z2 + Ichan)), _mm_mul_pd(b1, out)));
+            _mm_storeu_pd(z2 + Ichan, _mm_sub_pd(_mm_mul_pd(in, a2), _mm_mul_pd(b2, out)));
+            _mm_store_sd((double *)(p + Ichan), _mm_castps_pd(_mm_cvtpd_ps(out)));
+        }
+    }
+    return lastChan;
+}
+
+//four channels to a register
+__attribute__((target("avx2")))
+static int processAVX2(const double *c, double *z1, double *z2, float *frames, int nFrames, int Nchan, int firstChan) {
+    const __m256d a0 = _mm256_set1_pd(c[0]), a1 = _mm256_set1_pd(c[1]), a2 = _mm256_set1_pd(c[2]);
+    const __m256d b1 = _mm256_set1_pd(c[3]), b2 = _mm256_set1_pd(c[4]);
+    int lastChan = firstChan + ((Nchan - firstChan) / 4) * 4;
+    for (int i=0; i < nFrames; i++) {
+        float *p = frames + i*Nchan;
+        for (int Ichan = firstChan; Ichan < lastChan; Ichan += 4) {
+            __m256d in = _mm256_cvtps_pd(_mm_loadu_ps(p + Ichan));
+            __m256d out = _mm256_add_pd(_mm256_mul_pd(in, a0), _mm256_loadu_pd(z1 + Ichan));
+            _mm256_storeu_pd(z1 + Ichan, _mm256_sub_pd(_mm256_add_pd(_mm256_mul_pd(in, a1), _mm256_loadu_pd(z2 + Ichan)), _mm256_mul_pd(b1, out)));
+            _mm256_storeu_pd(z2 + Ichan, _mm256_sub_pd(_mm256_mul_pd(in, a2), _mm256_mul_pd(b2, out)));
+            _mm_storeu_ps(p + Ichan, _mm256_cvtpd_ps(out));
+        }
+    }
+    return lastChan;
+}
+
+#endif // BQ_BLOCK_X86
+
+void Biquad_block::process(float *frames, int nFrames) {
+    int done = 0;
+    switch (getKernel()) {
+#ifdef BQ_BLOCK_X86
+        case BQ_BLOCK_AVX2:
+            done = processAVX2(coeff, z1, z2, frames, nFrames, Nchan, 0);
+            //two channels left over can still go together
+            done = processSSE2(coeff, z1, z2, frames, nFrames, Nchan, done);
+            break;
+        case BQ_BLOCK_SSE2:
+            done = processSSE2(coeff, z1, z2, frames, nFrames, Nchan, 0);
+            break;
+#endif
+        default:
+            break;
+    }
+    processScalar(coeff, z1, z2, frames, nFrames, Nchan, done);   //whatever's left
+}
+
+bool Biquad_block::isKernelSupported(int k) {
+    switch (k) {
+        case BQ_BLOCK_SCALAR:
+            return true;
+#ifdef BQ_BLOCK_X86
+        case BQ_BLOCK_SSE2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+        case BQ_BLOCK_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+int Biquad_block::getKernel(void) {
+    if (kernel == BQ_BLOCK_AUTO) setKernel(BQ_BLOCK_AUTO);
+    return kernel;
+}
+
+int Biquad_block::setKernel(int k) {
+    if ((k == BQ_BLOCK_AUTO) || (k > BQ_BLOCK_AVX2)) k = BQ_BLOCK_AVX2;
+    while (!isKernelSupported(k)) k--;   //the best one there is, up to the one asked for
+    kernel = k;
+    return kernel;
+}
+
+const char *Biquad_block::getKernelName(int k) {
+    switch (k) {
+        case BQ_BLOCK_SCALAR: return "scalar";
+        case BQ_BLOCK_SSE2: return "SSE2";
+        case BQ_BLOCK_AVX2: return "AVX2";
+        default: return "auto";
+    }
+}
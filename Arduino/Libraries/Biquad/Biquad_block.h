@@ -0,0 +1,58 @@
+//
+//  Biquad_block.h
+//
+//  The same filter as Biquad_multiChan (the same design, and the same transposed direct
+//  form II in double precision), but run over a whole block of samples from all of the
+//  channels at once, instead of one process() call per channel per sample.  This is for
+//  filtering on the PC side, where there can be a lot of channels (a daisy chain of eight
+//  boards is 64) at a high sample rate.
+//
+//  The channels go in the lanes of the PC's SIMD registers: two at a time with SSE2, four
+//  at a time with AVX2.  The kernel is picked at run time, from what the CPU has, so the
+//  same program runs on any x86 PC.  Anywhere else (including the Arduino itself), it's a
+//  plain loop, which is still faster than a call per sample per channel.
+//
+//  The data is a block of samples, one after the other, with all of the channels of one
+//  sample together (the way that they come from the boards):
+//      frames[Isample*Nchan + Ichan]
+//  and it's filtered in place.  Each lane does the same arithmetic, in the same order, as
+//  Biquad_multiChan::process(), so the answer is the same, to the bit.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#ifndef Biquad_block_h
+#define Biquad_block_h
+
+//the kernels.  BQ_BLOCK_AUTO picks the fastest one that this CPU has.
+enum {
+    BQ_BLOCK_AUTO = -1,
+    BQ_BLOCK_SCALAR = 0,
+    BQ_BLOCK_SSE2,
+    BQ_BLOCK_AVX2
+};
+
+class Biquad_block {
+public:
+    Biquad_block(int Nchan, int type, double Fc, double Q, double peakGainDB);  //type is one of bq_type_*
+    ~Biquad_block();
+    void setBiquad(int type, double Fc, double Q, double peakGainDB);   //keeps each channel's history
+    void process(float *frames, int nFrames);   //frames[Isample*Nchan + Ichan], filtered in place
+    void resetChannel(int Ichan);   //forget this channel's history, as after a break in its data
+    int getNChan(void) { return Nchan; }
+
+    //which kernel process() uses.  It's the same for every Biquad_block in the program.
+    static int getKernel(void);
+    static int setKernel(int kernel);   //for testing.  Returns the one you got (a CPU without AVX2 gets SSE2, say)
+    static bool isKernelSupported(int kernel);
+    static const char *getKernelName(int kernel);
+
+protected:
+    int Nchan;
+    double coeff[5];    //a0, a1, a2, b1, b2
+    double *z1, *z2;    //each channel's state, one after the other, so that they load straight into the lanes
+
+    static int kernel;
+};
+
+#endif // Biquad_block_h
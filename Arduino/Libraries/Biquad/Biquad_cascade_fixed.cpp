@@ -0,0 +1,128 @@
+//
+//  Biquad_cascade_fixed.cpp
+//
+//  A chain of fixed-point biquads, run over whole samples.  See Biquad_cascade_fixed.h.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include <avr/pgmspace.h>
+#include "Biquad_cascade_fixed.h"
+
+Biquad_cascade_fixed::Biquad_cascade_fixed(int N, int S) {
+    Nchan = N;
+    Nstages = S;
+    stateLen = 2 + 2*Nstages;
+    coeff = new BiquadCoeffQ30[Nstages];
+    stageIsQ14 = new boolean[Nstages];
+    coeffQ14 = new BiquadCoeffQ14[Nstages];
+    state = new long[Nchan*stateLen];
+    frac = new uint16_t[Nchan*Nstages];
+    glideFrom = new BiquadCoeffQ30[Nstages];
+    glideTo = new BiquadCoeffQ30[Nstages];
+    glideCount = 0;
+
+    //until it is told otherwise, each stage passes the signal straight through
+    for (int Istage=0; Istage < Nstages; Istage++) {
+        coeff[Istage].a0 = (1L << BQ_Q30_FRAC_BITS);
+        coeff[Istage].a1 = coeff[Istage].a2 = 0;
+        coeff[Istage].nb1 = coeff[Istage].nb2 = 0;
+        updateQ14(Istage);
+        glideFrom[Istage] = glideTo[Istage] = coeff[Istage];
+    }
+    for (int Ichan=0; Ichan < Nchan; Ichan++) resetChannel(Ichan);
+}
+
+Biquad_cascade_fixed::~Biquad_cascade_fixed() {
+    delete[] glideTo;
+    delete[] glideFrom;
+    delete[] frac;
+    delete[] state;
+    delete[] coeffQ14;
+    delete[] stageIsQ14;
+    delete[] coeff;
+}
+
+void Biquad_cascade_fixed::setStage(int Istage, int type, double Fc, double Q, double peakGainDB) {
+    BiquadCoeffQ30 newCoeff;
+    Biquad_multiChan_fixed::calcCoefficientsQ30(type, Fc, Q, peakGainDB, &newCoeff);
+    setStage(Istage, &newCoeff, false);
+}
+
+void Biquad_cascade_fixed::setStage(int Istage, const BiquadCoeffQ14 *newCoeff, boolean glide) {
+    BiquadCoeffQ30 newCoeffQ30;
+    Biquad_multiChan_fixed::toQ30(newCoeff, &newCoeffQ30);
+    setStage(Istage, &newCoeffQ30, glide);
+}
+
+void Biquad_cascade_fixed::setStage(int Istage, const BiquadCoeffQ30 *newCoeff, boolean glide) {
+    if ((Istage < 0) || (Istage >= Nstages)) return;
+    if (glide) {
+        //all of the stages start (or restart) their glide from where they are now
+        for (int i=0; i < Nstages; i++) glideFrom[i] = coeff[i];
+        glideTo[Istage] = *newCoeff;
+        glideCount = 1;
+    } else {
+        coeff[Istage] = *newCoeff;
+        updateQ14(Istage);
+        glideFrom[Istage] = *newCoeff;  //in case the other stages are gliding
+        glideTo[Istage] = *newCoeff;
+    }
+}
+
+//Designing a filter takes tan(), pow(), and sqrt(), which cost a lot of flash and time on
+//the Uno.  If the filters are known ahead of time, their coefficients can be stored in
+//flash instead, and this is all that's needed.  See Biquad_multiChan_fixed::calcCoefficients
+//for how they're rounded.
+void Biquad_cascade_fixed::setStage_P(int Istage, const BiquadCoeffQ30 *coeff_P, boolean glide) {
+    BiquadCoeffQ30 newCoeff;
+    memcpy_P(&newCoeff, coeff_P, sizeof(BiquadCoeffQ30));
+    setStage(Istage, &newCoeff, glide);
+}
+
+//part of the way from 'from' to 'to'.  (to - from)*count could overflow a long, so the top
+//and bottom bits are blended separately.  It's exactly 'to' at the end.
+static long glideStep(long from, long to, byte count) {
+    const long mask = BQ_GLIDE_SAMPLES - 1;
+    long top = (from >> BQ_GLIDE_SHIFT) * (BQ_GLIDE_SAMPLES - count) + (to >> BQ_GLIDE_SHIFT) * count;
+    long bottom = ((from & mask) * (BQ_GLIDE_SAMPLES - count) + (to & mask) * count) >> BQ_GLIDE_SHIFT;
+    return top + bottom;
+}
+
+//Move the coefficients one step along their glide.  Each coefficient moves in a straight
+//line, except that a1 and -b1 are worked out from the sums (as in calcCoefficients) so
+//that the DC gain moves in a straight line too.  A highpass stays a highpass all the way.
+//(The sums are within +/-2, like the coefficients, for all of the filter types except the
+//peak and shelf filters that boost.)  Along the way, the stages run in Q30.
+void Biquad_cascade_fixed::stepGlide(void) {
+    for (int Istage=0; Istage < Nstages; Istage++) {
+        const BiquadCoeffQ30 *f = &glideFrom[Istage], *t = &glideTo[Istage];
+        BiquadCoeffQ30 *c = &coeff[Istage];
+        c->a0 = glideStep(f->a0, t->a0, glideCount);
+        c->a2 = glideStep(f->a2, t->a2, glideCount);
+        c->a1 = glideStep(f->a0 + f->a1 + f->a2, t->a0 + t->a1 + t->a2, glideCount) - c->a0 - c->a2;
+        c->nb2 = glideStep(f->nb2, t->nb2, glideCount);
+        c->nb1 = glideStep(f->nb1 + f->nb2, t->nb1 + t->nb2, glideCount) - c->nb2;
+        updateQ14(Istage);
+    }
+    glideCount++;
+    if (glideCount > BQ_GLIDE_SAMPLES) glideCount = 0;  //we've arrived
+}
+
+//whether this stage's coefficients fit in Q14, and if so, what they are
+void Biquad_cascade_fixed::updateQ14(int Istage) {
+    const BiquadCoeffQ30 *c = &coeff[Istage];
+    BiquadCoeffQ14 *c14 = &coeffQ14[Istage];
+    stageIsQ14[Istage] = Biquad_multiChan_fixed::isQ14(c);
+    c14->a0 = (int16_t)(c->a0 >> 16);
+    c14->a1 = (int16_t)(c->a1 >> 16);
+    c14->a2 = (int16_t)(c->a2 >> 16);
+    c14->nb1 = (int16_t)(c->nb1 >> 16);
+    c14->nb2 = (int16_t)(c->nb2 >> 16);
+}
+
+void Biquad_cascade_fixed::resetChannel(int Ichan) {
+    if ((Ichan < 0) || (Ichan >= Nchan)) return;
+    for (int i=0; i < stateLen; i++) state[Ichan*stateLen + i] = 0;
+    for (int Istage=0; Istage < Nstages; Istage++) frac[Ichan*Nstages + Istage] = 0;
+}
@@ -0,0 +1,110 @@
+//
+//  Biquad_cascade_fixed.h
+//
+//  A chain of fixed-point biquads (second-order sections), run over all of the
+//  channels of a sample at once.  This does the same math as a string of
+//  Biquad_multiChan_fixed objects (see Biquad_multiChan_fixed.h) but:
+//    * it filters the whole sample (or a block of samples) in one call, instead
+//      of one call per channel per filter
+//    * each channel's state for all of the stages sits together in one array,
+//      so the inner loop just walks a pointer along it
+//    * each stage's output history is also the next stage's input history, so
+//      it is only stored once.  For 3 stages, that's 38 bytes per channel
+//      instead of 54.
+//  The coefficients are shared by all of the channels, one set per stage.  They
+//  are kept in Q30, but a stage whose coefficients fit in Q14 (the low 16 bits are
+//  all zero) runs as Q14, which is twice as fast.  Biquad_multiChan_fixed::
+//  calcCoefficientsQ30() only hands out Q30 when Q14 isn't good enough: the low
+//  highpass cutoffs at 500 Hz and up, and the lowpasses at the higher sample rates.
+//  Keeping the coefficients in Q30 (and in Q14 too) costs 41 more bytes of RAM per
+//  stage, for all of the channels together.
+//
+//  New coefficients can be swapped in while it's running.  Asking for a glide
+//  moves the coefficients from the old set to the new one in small steps over
+//  BQ_GLIDE_SAMPLES samples.  The state is kept (in Direct Form I it is just
+//  the recent signal) so there's no restart, and the small steps keep the jump
+//  in the output small.  Every step is stable, because the set of stable
+//  biquads is convex.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#ifndef Biquad_cascade_fixed_h
+#define Biquad_cascade_fixed_h
+
+#include <Arduino.h>
+#include "Biquad_multiChan_fixed.h"
+
+#define BQ_GLIDE_SHIFT (5)
+#define BQ_GLIDE_SAMPLES (1 << BQ_GLIDE_SHIFT)   //32 samples, which is 0.128 sec at 250 Hz
+
+class Biquad_cascade_fixed {
+public:
+    Biquad_cascade_fixed(int Nchan, int Nstages);
+    ~Biquad_cascade_fixed();
+    void setStage(int Istage, int type, double Fc, double Q, double peakGainDB);  //design one of the stages
+    void setStage(int Istage, const BiquadCoeffQ30 *newCoeff, boolean glide);    //use coefficients that were designed ahead of time
+    void setStage(int Istage, const BiquadCoeffQ14 *newCoeff, boolean glide);    //same, in Q14
+    void setStage_P(int Istage, const BiquadCoeffQ30 *coeff_P, boolean glide = false);  //same, but the coefficients are in PROGMEM
+    boolean isStageQ14(int Istage) { return ((Istage >= 0) && (Istage < Nstages)) ? stageIsQ14[Istage] : false; }
+    boolean isGliding(void) { return glideCount != 0; }
+    void process(long *sample);                         //filter one sample (Nchan values) in place
+    void process(long *samples, int nSamples);          //same, for several samples one after the other
+    void resetChannel(int Ichan);                       //forget this channel's history, as after a break in its data
+    int getNStages(void) { return Nstages; }
+
+protected:
+    int Nchan;
+    int Nstages;
+    int stateLen;                   //longs of state for each channel: x1, x2, then y1, y2 for each stage
+    BiquadCoeffQ30 *coeff;          //one set for each stage
+    boolean *stageIsQ14;            //for each stage, whether its coefficients fit in Q14
+    BiquadCoeffQ14 *coeffQ14;       //and if they do, the same coefficients in Q14
+    long *state;                    //[Nchan][stateLen]
+    uint16_t *frac;                 //[Nchan][Nstages], see Biquad_multiChan_fixed::roundOff
+    BiquadCoeffQ30 *glideFrom;      //where each stage's coefficients started the glide
+    BiquadCoeffQ30 *glideTo;        //and where they will end up
+    byte glideCount;                //0 when not gliding, else how far along the glide we are
+    void stepGlide(void);
+    void updateQ14(int Istage);
+};
+
+inline void Biquad_cascade_fixed::process(long *sample) {
+    if (glideCount != 0) stepGlide();
+    long *st = state;
+    uint16_t *fr = frac;
+    for (int Ichan=0; Ichan < Nchan; Ichan++) {
+        long val = Biquad_multiChan_fixed::saturate(sample[Ichan]);
+        const BiquadCoeffQ30 *c = coeff;
+        const BiquadCoeffQ14 *c14 = coeffQ14;
+        for (int Istage=0; Istage < Nstages; Istage++, c++, c14++, st += 2, fr++) {
+            //st[0] and st[1] are this stage's last two inputs.  st[2] and st[3] are its last two outputs.
+            long hi = 0, lo = *fr;
+            if (stageIsQ14[Istage]) {
+                Biquad_multiChan_fixed::multiplyAccumulate(hi, lo, val, c14->a0);
+                Biquad_multiChan_fixed::multiplyAccumulate(hi, lo, st[0], c14->a1);
+                Biquad_multiChan_fixed::multiplyAccumulate(hi, lo, st[1], c14->a2);
+                Biquad_multiChan_fixed::multiplyAccumulate(hi, lo, st[2], c14->nb1);
+                Biquad_multiChan_fixed::multiplyAccumulate(hi, lo, st[3], c14->nb2);
+            } else {
+                Biquad_multiChan_fixed::multiplyAccumulateQ30(hi, lo, val, c->a0);
+                Biquad_multiChan_fixed::multiplyAccumulateQ30(hi, lo, st[0], c->a1);
+                Biquad_multiChan_fixed::multiplyAccumulateQ30(hi, lo, st[1], c->a2);
+                Biquad_multiChan_fixed::multiplyAccumulateQ30(hi, lo, st[2], c->nb1);
+                Biquad_multiChan_fixed::multiplyAccumulateQ30(hi, lo, st[3], c->nb2);
+            }
+            st[1] = st[0]; st[0] = val;
+            val = Biquad_multiChan_fixed::roundOff(hi, lo, fr);
+        }
+        //the last stage's outputs
+        st[1] = st[0]; st[0] = val;
+        st += 2;
+        sample[Ichan] = val;
+    }
+}
+
+inline void Biquad_cascade_fixed::process(long *samples, int nSamples) {
+    for (int Isamp=0; Isamp < nSamples; Isamp++) process(samples + Isamp*Nchan);
+}
+
+#endif // Biquad_cascade_fixed_h
@@ -48,8 +48,14 @@ Biquad_multiChan::Biquad_multiChan(int N,int type, double Fc, double Q, double p
 }
 
 Biquad_multiChan::~Biquad_multiChan() {
-	delete z2;
-	delete z1;
+	delete[] z2;
+	delete[] z1;
+}
+
+void Biquad_multiChan::resetChannel(int Ichan) {
+    if ((Ichan < 0) || (Ichan >= Nchan)) return;
+    z1[Ichan] = 0.0;
+    z2[Ichan] = 0.0;
 }
 
 void Biquad_multiChan::setType(int type) {
@@ -80,10 +86,19 @@ void Biquad_multiChan::setBiquad(int type, double Fc, double Q, double peakGainD
 }
 
 void Biquad_multiChan::calcBiquad(void) {
+    double coeff[5];
+    calcCoefficients(type, Fc, Q, peakGain, coeff);
+    a0 = coeff[0]; a1 = coeff[1]; a2 = coeff[2];
+    b1 = coeff[3]; b2 = coeff[4];
+}
+
+//the filter design itself, so that other kinds of filters (like Biquad_multiChan_fixed) can use it too
+void Biquad_multiChan::calcCoefficients(int type, double Fc, double Q, double peakGain, double *coeff) {
+    double a0 = 1.0, a1 = 0.0, a2 = 0.0, b1 = 0.0, b2 = 0.0;
     double norm;
     double V = pow(10, fabs(peakGain) / 20.0);
     double K = tan(M_PI * Fc);
-    switch (this->type) {
+    switch (type) {
         case bq_type_lowpass:
             norm = 1 / (1 + K / Q + K * K);
             a0 = K * K * norm;
@@ -176,5 +191,7 @@ void Biquad_multiChan::calcBiquad(void) {
             break;
     }
     
+    coeff[0] = a0; coeff[1] = a1; coeff[2] = a2;
+    coeff[3] = b1; coeff[4] = b2;
     return;
 }
@@ -43,6 +43,8 @@ public:
     void setPeakGain(double peakGainDB);
     void setBiquad(int type, double Fc, double Q, double peakGain);
     float process(float in,int Ichan);
+    void resetChannel(int Ichan);   //forget this channel's history, as after a break in its data
+    static void calcCoefficients(int type, double Fc, double Q, double peakGainDB, double *coeff);  //coeff gets a0, a1, a2, b1, b2
     
 protected:
     void calcBiquad(void);
@@ -0,0 +1,175 @@
+//
+//  Biquad_multiChan_fixed.cpp
+//
+//  A fixed-point version of Biquad_multiChan.  See Biquad_multiChan_fixed.h.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include <math.h>
+#include "Biquad_multiChan_fixed.h"
+
+Biquad_multiChan_fixed::Biquad_multiChan_fixed(int N,int type, double Fc, double Q, double peakGainDB) {
+    setBiquad(type, Fc, Q, peakGainDB);
+
+    Nchan = N;
+    x1 = new long[Nchan];
+    x2 = new long[Nchan];
+    y1 = new long[Nchan];
+    y2 = new long[Nchan];
+    frac = new uint16_t[Nchan];
+    for (int Ichan=0;Ichan<Nchan;Ichan++) resetChannel(Ichan);
+}
+
+Biquad_multiChan_fixed::~Biquad_multiChan_fixed() {
+    delete[] frac;
+    delete[] y2;
+    delete[] y1;
+    delete[] x2;
+    delete[] x1;
+}
+
+void Biquad_multiChan_fixed::resetChannel(int Ichan) {
+    if ((Ichan < 0) || (Ichan >= Nchan)) return;
+    x1[Ichan] = 0; x2[Ichan] = 0;
+    y1[Ichan] = 0; y2[Ichan] = 0;
+    frac[Ichan] = 0;
+}
+
+void Biquad_multiChan_fixed::setType(int type) {
+    this->type = type;
+    calcBiquad();
+}
+
+void Biquad_multiChan_fixed::setQ(double Q) {
+    this->Q = Q;
+    calcBiquad();
+}
+
+void Biquad_multiChan_fixed::setFc(double Fc) {
+    this->Fc = Fc;
+    calcBiquad();
+}
+
+void Biquad_multiChan_fixed::setPeakGain(double peakGainDB) {
+    this->peakGain = peakGainDB;
+    calcBiquad();
+}
+
+void Biquad_multiChan_fixed::setBiquad(int type, double Fc, double Q, double peakGainDB) {
+    this->type = type;
+    this->Q = Q;
+    this->Fc = Fc;
+    setPeakGain(peakGainDB);
+}
+
+//round to Q14
+static long toQ14(double val) {
+    return (long)floor(val * (double)(1L << BQ_FIXED_FRAC_BITS) + 0.5);
+}
+
+//stay within what an int16_t can hold
+static int16_t clip16(long val) {
+    if (val > 32767L) return 32767;
+    if (val < -32768L) return -32768;
+    return (int16_t)val;
+}
+
+//round to Q30.  (On the Uno, a double is only a float, so there are really only 24 bits
+//to start from.  Make tables on a PC.)
+static double roundQ30(double val) {
+    return floor(val * (double)(1L << BQ_Q30_FRAC_BITS) + 0.5);
+}
+
+//stay within what an int32_t can hold
+static int32_t clip32(double val) {
+    if (val > 2147483647.0) return 2147483647L;
+    if (val < -2147483648.0) return (-2147483647L - 1);
+    return (int32_t)val;
+}
+
+void Biquad_multiChan_fixed::calcBiquad(void) {
+    calcCoefficients(type, Fc, Q, peakGain, &coeff);
+}
+
+void Biquad_multiChan_fixed::calcCoefficients(int type, double Fc, double Q, double peakGainDB, BiquadCoeffQ14 *coeff) {
+    double c[5];  //a0, a1, a2, b1, b2
+    Biquad_multiChan::calcCoefficients(type, Fc, Q, peakGainDB, c);
+
+    //Round each coefficient, but pick the middle ones so that the sums come out right.
+    //a0+a1+a2 and 1+b1+b2 set the gain at DC.  For the highpass, these are tiny, and
+    //rounding each coefficient on its own would leave a lot of DC in the output.
+    coeff->a0 = clip16(toQ14(c[0]));
+    coeff->a2 = clip16(toQ14(c[2]));
+    coeff->a1 = clip16(toQ14(c[0] + c[1] + c[2]) - coeff->a0 - coeff->a2);
+    long b2 = clip16(toQ14(c[4]));
+    long sumB = toQ14(1.0 + c[3] + c[4]);
+    if (sumB < 1) sumB = 1;  //a stable filter has 1+b1+b2 > 0.  Rounding it to zero would put a pole right on DC.
+    long b1 = sumB - (1L << BQ_FIXED_FRAC_BITS) - b2;
+    coeff->nb1 = clip16(-b1);
+    coeff->nb2 = clip16(-b2);
+}
+
+//The same, in Q30, which gets the low cutoffs at high sample rates right (a 0.5 Hz highpass
+//at 16 kHz, or a 13 Hz lowpass, whose a0 is zero in Q14).  Q30 takes twice as long to run,
+//though, so if the Q14 coefficients are within BQ_Q14_TOLERANCE of the design everywhere,
+//those are what you get (shifted up to Q30), and Biquad_cascade_fixed runs them as Q14.
+void Biquad_multiChan_fixed::calcCoefficientsQ30(int type, double Fc, double Q, double peakGainDB, BiquadCoeffQ30 *coeff) {
+    BiquadCoeffQ14 q14;
+    calcCoefficients(type, Fc, Q, peakGainDB, &q14);
+    toQ30(&q14, coeff);
+    if (calcResponseError(type, Fc, Q, peakGainDB, coeff) <= BQ_Q14_TOLERANCE) return;
+
+    //rounded the same way as the Q14 ones, so that the gain at DC comes out right
+    double c[5];  //a0, a1, a2, b1, b2
+    Biquad_multiChan::calcCoefficients(type, Fc, Q, peakGainDB, c);
+    double a0 = roundQ30(c[0]), a2 = roundQ30(c[2]);
+    double a1 = roundQ30(c[0] + c[1] + c[2]) - a0 - a2;
+    double b2 = roundQ30(c[4]);
+    double sumB = roundQ30(1.0 + c[3] + c[4]);
+    if (sumB < 1.0) sumB = 1.0;
+    double b1 = sumB - (double)(1L << BQ_Q30_FRAC_BITS) - b2;
+    coeff->a0 = clip32(a0);
+    coeff->a1 = clip32(a1);
+    coeff->a2 = clip32(a2);
+    coeff->nb1 = clip32(-b1);
+    coeff->nb2 = clip32(-b2);
+}
+
+//|H|^2 of a0 + a1/z + a2/z^2 at the frequency where phi = sin^2(w/2).  Written in terms of
+//the sum a0+a1+a2 so that it stays accurate near DC, where the highpass's sum is tiny.
+static double responseSquared(double a0, double a1, double a2, double phi) {
+    double sum = a0 + a1 + a2;
+    return sum*sum - 4.0*(a0*a1 + 4.0*a0*a2 + a1*a2)*phi + 16.0*a0*a2*phi*phi;
+}
+
+//How far the rounded coefficients are from the design: the worst difference in |H| (where
+//the passband is 1), on 64 frequencies spaced evenly in octaves from Fc/64 up to Nyquist.
+double Biquad_multiChan_fixed::calcResponseError(int type, double Fc, double Q, double peakGainDB, const BiquadCoeffQ30 *coeff) {
+    double c[5];  //a0, a1, a2, b1, b2
+    Biquad_multiChan::calcCoefficients(type, Fc, Q, peakGainDB, c);
+    const double scale = 1.0 / (double)(1L << BQ_Q30_FRAC_BITS);
+    double q[5] = { coeff->a0 * scale, coeff->a1 * scale, coeff->a2 * scale, -coeff->nb1 * scale, -coeff->nb2 * scale };
+    double worst = 0.0;
+    const int nFreqs = 64;
+    for (int i=0; i < nFreqs; i++) {
+        double f = (Fc / 64.0) * pow(0.5 / (Fc / 64.0), (double)i / (nFreqs - 1));
+        double phi = sin(M_PI * f); phi = phi * phi;
+        double exact = sqrt(responseSquared(c[0], c[1], c[2], phi) / responseSquared(1.0, c[3], c[4], phi));
+        double rounded = sqrt(responseSquared(q[0], q[1], q[2], phi) / responseSquared(1.0, q[3], q[4], phi));
+        if (fabs(rounded - exact) > worst) worst = fabs(rounded - exact);
+    }
+    return worst;
+}
+
+void Biquad_multiChan_fixed::toQ30(const BiquadCoeffQ14 *in, BiquadCoeffQ30 *out) {
+    out->a0 = in->a0 * 65536L;
+    out->a1 = in->a1 * 65536L;
+    out->a2 = in->a2 * 65536L;
+    out->nb1 = in->nb1 * 65536L;
+    out->nb2 = in->nb2 * 65536L;
+}
+
+bool Biquad_multiChan_fixed::isQ14(const BiquadCoeffQ30 *coeff) {
+    return (((coeff->a0 | coeff->a1 | coeff->a2 | coeff->nb1 | coeff->nb2) & 0xFFFFL) == 0);
+}
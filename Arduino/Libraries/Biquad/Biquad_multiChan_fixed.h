@@ -0,0 +1,146 @@
+//
+//  Biquad_multiChan_fixed.h
+//
+//  A fixed-point version of Biquad_multiChan, for when floating point is too
+//  slow (like filtering 16 daisy-chained channels on an Arduino Uno).  It is
+//  designed the same way (same types, Fc, Q, and peak gain) but it filters
+//  long integers, like the ADS1299 samples, using integer math only.
+//
+//  How it works:
+//    * Direct Form I, so the state is the last two inputs and outputs of each
+//      channel, kept as 32-bit integers.  Unlike Direct Form II, the state never
+//      gets bigger than the signal, even for the 0.5 Hz highpass.
+//    * The coefficients are 16-bit, with 14 fractional bits (Q14), so they
+//      cover -2.0 to +2.0.  They are rounded so that the filter's gain at DC
+//      is kept (a highpass still has a true zero at DC).
+//    * Each 32x16 multiply is done as two 16x16 multiplies, which the AVR does
+//      in hardware, and the products are summed exactly (no rounding inside).
+//    * The output is rounded down, and the fraction that was thrown away is
+//      added back in on the next sample (first-order noise shaping).  This
+//      pushes the rounding noise away from DC, where the highpass would
+//      otherwise amplify it into an offset of thousands of counts.
+//    * Inputs and outputs saturate at +/-(2^26 - 1), well beyond a 24-bit sample.
+//
+//  Coefficient resolution is 1/16384, so very low cutoffs at very high sample
+//  rates (below about Fc = 0.0005) come out noticeably off.  At 250 Hz the
+//  0.5 Hz highpass and the 60 Hz notch are fine.  For the ones that aren't, there
+//  are 32-bit (Q30) coefficients too.  This class doesn't use them, but
+//  Biquad_cascade_fixed does: calcCoefficientsQ30() makes them, and
+//  multiplyAccumulateQ30() does the multiply, as four 16x16 multiplies instead of two.
+//
+//  Each channel uses 18 bytes of RAM (the floating-point version uses 8).
+//
+//  Created by Chip Audette, June 2014
+//
+
+#ifndef Biquad_multiChan_fixed_h
+#define Biquad_multiChan_fixed_h
+
+#include <stdint.h>
+#include "Biquad_multiChan.h"   //for the filter types and the filter design
+
+#define BQ_FIXED_FRAC_BITS (14)
+#define BQ_FIXED_LIMIT (0x03FFFFFFL)
+#define BQ_Q30_FRAC_BITS (30)
+#define BQ_Q14_TOLERANCE (0.002)    //how far off (in |H|, where 1 is the passband) Q14 can be before Q30 is used instead
+
+//Q14 coefficients.  The feedback coefficients are stored negated.
+typedef struct {
+    int16_t a0, a1, a2, nb1, nb2;
+} BiquadCoeffQ14;
+
+//Q30 coefficients, the same way around.  The top 16 bits of each are its Q14 part.
+typedef struct {
+    int32_t a0, a1, a2, nb1, nb2;
+} BiquadCoeffQ30;
+
+class Biquad_multiChan_fixed {
+public:
+    Biquad_multiChan_fixed(int Nchan, int type, double Fc, double Q, double peakGainDB);
+    ~Biquad_multiChan_fixed();
+    void setType(int type);
+    void setQ(double Q);
+    void setFc(double Fc);
+    void setPeakGain(double peakGainDB);
+    void setBiquad(int type, double Fc, double Q, double peakGain);
+    long process(long in,int Ichan);
+    void resetChannel(int Ichan);   //forget this channel's history, as after a break in its data
+
+    //the pieces, for other fixed-point filters (like Biquad_cascade_fixed) to use
+    static void calcCoefficients(int type, double Fc, double Q, double peakGainDB, BiquadCoeffQ14 *coeff);
+    static void calcCoefficientsQ30(int type, double Fc, double Q, double peakGainDB, BiquadCoeffQ30 *coeff);  //Q14 (shifted up) if that's close enough
+    static double calcResponseError(int type, double Fc, double Q, double peakGainDB, const BiquadCoeffQ30 *coeff);
+    static void toQ30(const BiquadCoeffQ14 *in, BiquadCoeffQ30 *out);
+    static bool isQ14(const BiquadCoeffQ30 *coeff);   //true if the low 16 bits of every coefficient are zero
+    static long saturate(long val);
+    static void multiplyAccumulate(long &hi, long &lo, long val, int16_t coeff);
+    static void multiplyAccumulateQ30(long &hi, long &lo, long val, int32_t coeff);
+    static long roundOff(long hi, long lo, uint16_t *frac);
+
+protected:
+    void calcBiquad(void);
+
+    int Nchan;
+    int type;
+    BiquadCoeffQ14 coeff;
+    double Fc, Q, peakGain;
+    long *x1, *x2, *y1, *y2;
+    uint16_t *frac;                 //the part of the last output that was rounded away
+};
+
+inline long Biquad_multiChan_fixed::saturate(long val) {
+    if (val > BQ_FIXED_LIMIT) return BQ_FIXED_LIMIT;
+    if (val < -BQ_FIXED_LIMIT) return -BQ_FIXED_LIMIT;
+    return val;
+}
+
+//add val*coeff into the 48-bit sum (hi*65536 + lo).  lo is kept in [0, 65535].
+inline void Biquad_multiChan_fixed::multiplyAccumulate(long &hi, long &lo, long val, int16_t coeff) {
+    hi += (long)((int16_t)(val >> 16)) * coeff;
+    lo += (long)((uint16_t)val) * coeff;
+    hi += lo >> 16;
+    lo &= 0xFFFF;
+}
+
+//add val*coeff into the same sum, where coeff is Q30.  The sum is still in Q14, so the
+//product with the low 16 bits of coeff is rounded to the nearest 1/16384 first.  (The
+//state is saturated to 27 bits, so none of this can overflow.)
+inline void Biquad_multiChan_fixed::multiplyAccumulateQ30(long &hi, long &lo, long val, int32_t coeff) {
+    multiplyAccumulate(hi, lo, val, (int16_t)(coeff >> 16));
+    uint16_t coeffLo = (uint16_t)coeff;
+    long t = (long)((int16_t)(val >> 16)) * (long)coeffLo;
+    t += (long)((((unsigned long)((uint16_t)val)) * coeffLo + 0x8000UL) >> 16);
+    hi += t >> 16;
+    lo += t & 0xFFFF;
+    hi += lo >> 16;
+    lo &= 0xFFFF;
+}
+
+//turn the sum back into a sample.  The fractional bits are dropped, but saved in frac
+//so that they can be added back into the next sum.
+inline long Biquad_multiChan_fixed::roundOff(long hi, long lo, uint16_t *frac) {
+    long out = hi * (1L << (16-BQ_FIXED_FRAC_BITS)) + (lo >> BQ_FIXED_FRAC_BITS);
+    *frac = (uint16_t)(lo & ((1L << BQ_FIXED_FRAC_BITS)-1));
+    if ((out > BQ_FIXED_LIMIT) || (out < -BQ_FIXED_LIMIT)) {
+        out = saturate(out);
+        *frac = 0;
+    }
+    return out;
+}
+
+inline long Biquad_multiChan_fixed::process(long in,int Ichan) {
+    in = saturate(in);
+    long hi = 0, lo = frac[Ichan];
+    multiplyAccumulate(hi, lo, in, coeff.a0);
+    multiplyAccumulate(hi, lo, x1[Ichan], coeff.a1);
+    multiplyAccumulate(hi, lo, x2[Ichan], coeff.a2);
+    multiplyAccumulate(hi, lo, y1[Ichan], coeff.nb1);
+    multiplyAccumulate(hi, lo, y2[Ichan], coeff.nb2);
+    long out = roundOff(hi, lo, &frac[Ichan]);
+
+    x2[Ichan] = x1[Ichan]; x1[Ichan] = in;
+    y2[Ichan] = y1[Ichan]; y1[Ichan] = out;
+    return out;
+}
+
+#endif // Biquad_multiChan_fixed_h
@@ -0,0 +1,81 @@
+//
+//  Biquad_multiChan_static.h
+//
+//  The same filter as Biquad_multiChan, but the number of channels is fixed when
+//  it's compiled, so the filter state is a plain array inside the object:
+//    * no new[] in the constructor.  A global filter doesn't touch the heap before
+//      setup() even starts, and the RAM it takes shows up in the compiler's report.
+//    * the loop over channels in process(sample) has a fixed count, which the
+//      compiler can unroll
+//    * the sample type is a template parameter too, so the filter can take the
+//      ADS1299's long integers directly (the result is truncated back to an integer,
+//      just like the "(long) val" in the sketch)
+//  Use it like this:
+//     Biquad_multiChan_static<8> notch(bq_type_notch, 60.0/250.0, 4.0, 0.0);       //floats
+//     Biquad_multiChan_static<16,long> stopDC(bq_type_highpass, 0.5/250.0, 0.5, 0.0);
+//
+//  The math and the filter design are Biquad_multiChan's (Direct Form II transposed,
+//  with the state in double, which is a float on the Uno).
+//
+//  Created by Chip Audette, June 2014
+//
+
+#ifndef Biquad_multiChan_static_h
+#define Biquad_multiChan_static_h
+
+#include "Biquad_multiChan.h"   //for the filter types and the filter design
+
+template <int N_CHAN, typename T = float>
+class Biquad_multiChan_static {
+public:
+    Biquad_multiChan_static(int type, double Fc, double Q, double peakGainDB) {
+        setBiquad(type, Fc, Q, peakGainDB);
+        for (int Ichan=0; Ichan < N_CHAN; Ichan++) resetChannel(Ichan);
+    }
+    void setType(int type) { this->type = type; calcBiquad(); }
+    void setQ(double Q) { this->Q = Q; calcBiquad(); }
+    void setFc(double Fc) { this->Fc = Fc; calcBiquad(); }
+    void setPeakGain(double peakGainDB) { this->peakGain = peakGainDB; calcBiquad(); }
+    void setBiquad(int type, double Fc, double Q, double peakGainDB) {
+        this->type = type;
+        this->Q = Q;
+        this->Fc = Fc;
+        setPeakGain(peakGainDB);
+    }
+    T process(T in, int Ichan);        //filter one value of one channel
+    void process(T *sample);           //filter one value of every channel, in place
+    void resetChannel(int Ichan) {     //forget this channel's history, as after a break in its data
+        if ((Ichan < 0) || (Ichan >= N_CHAN)) return;
+        z1[Ichan] = 0.0;
+        z2[Ichan] = 0.0;
+    }
+    int getNChan(void) { return N_CHAN; }
+
+protected:
+    void calcBiquad(void) {
+        double coeff[5];
+        Biquad_multiChan::calcCoefficients(type, Fc, Q, peakGain, coeff);
+        a0 = coeff[0]; a1 = coeff[1]; a2 = coeff[2];
+        b1 = coeff[3]; b2 = coeff[4];
+    }
+
+    int type;
+    double a0, a1, a2, b1, b2;
+    double Fc, Q, peakGain;
+    double z1[N_CHAN], z2[N_CHAN];
+};
+
+template <int N_CHAN, typename T>
+inline T Biquad_multiChan_static<N_CHAN,T>::process(T in, int Ichan) {
+    double out = in * a0 + z1[Ichan];
+    z1[Ichan] = in * a1 + z2[Ichan] - b1 * out;
+    z2[Ichan] = in * a2 - b2 * out;
+    return (T)out;
+}
+
+template <int N_CHAN, typename T>
+inline void Biquad_multiChan_static<N_CHAN,T>::process(T *sample) {
+    for (int Ichan=0; Ichan < N_CHAN; Ichan++) sample[Ichan] = process(sample[Ichan], Ichan);
+}
+
+#endif // Biquad_multiChan_static_h
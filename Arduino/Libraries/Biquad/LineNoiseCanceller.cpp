@@ -0,0 +1,147 @@
+//
+//  LineNoiseCanceller.cpp
+//
+//  Adaptive removal of mains interference.  See LineNoiseCanceller.h.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include <math.h>
+#include "LineNoiseCanceller.h"
+
+LineNoiseCanceller::LineNoiseCanceller(int N, int H) {
+    Nchan = N;
+    if (H < 1) H = 1;
+    if (H > LNC_MAX_HARMONICS) H = LNC_MAX_HARMONICS;
+    Nharmonics = H;
+    phase = 0;
+    phaseStep = minStep = maxStep = 0;
+    adaptShift = LNC_DEFAULT_ADAPT_SHIFT;
+    tracking = true;
+    trackChan = -1;
+    trackCount = 0;
+    weights = new long[Nchan*Nharmonics*2];
+    for (int Ichan=0; Ichan < Nchan; Ichan++) resetChannel(Ichan);
+}
+
+LineNoiseCanceller::~LineNoiseCanceller() {
+    delete[] weights;
+}
+
+void LineNoiseCanceller::setFrequency(double f0) {
+    if ((f0 <= 0.0) || (f0 >= 0.5)) {
+        phaseStep = 0;  //off
+        return;
+    }
+    phaseStep = (uint32_t)(f0 * 4294967296.0 + 0.5);
+    minStep = (uint32_t)((1.0 - LNC_TRACK_RANGE) * f0 * 4294967296.0);
+    maxStep = (uint32_t)((1.0 + LNC_TRACK_RANGE) * f0 * 4294967296.0);
+    trackChan = -1;  //start over
+}
+
+double LineNoiseCanceller::getFrequency(void) {
+    return ((double)phaseStep) / 4294967296.0;
+}
+
+void LineNoiseCanceller::setAdaptShift(int shift) {
+    if (shift < LNC_MIN_ADAPT_SHIFT) shift = LNC_MIN_ADAPT_SHIFT;  //any faster and the updates would need more bits
+    if (shift > LNC_MAX_ADAPT_SHIFT) shift = LNC_MAX_ADAPT_SHIFT;
+    adaptShift = shift;
+}
+
+void LineNoiseCanceller::resetChannel(int Ichan) {
+    if ((Ichan < 0) || (Ichan >= Nchan)) return;
+    for (int i=0; i < Nharmonics*2; i++) weights[Ichan*Nharmonics*2 + i] = 0;
+}
+
+//A polynomial instead of a table, so that it costs no RAM and no PROGMEM tricks.  The
+//phase is folded into -90 to +90 deg, and then sin(pi/2*z) ~= z*(1.57025 - z^2*(0.64185 - z^2*0.07166)).
+//Those are the minimax coefficients (for the Q14 math, with each shift rounded), not the
+//Taylor series, whose error all piles up at 90 deg.  It's good to 1.4e-4 (-77 dB), which
+//is 2 counts of Q14, and is more than enough for a reference.
+int16_t LineNoiseCanceller::sinQ14(uint16_t phase) {
+    long z = (int16_t)phase;                   //-32768 to 32767 is -180 to +180 deg
+    if (z > 16384) z = 32768 - z;              //sin(180 - x) = sin(x)
+    else if (z < -16384) z = -32768 - z;
+    //now z is Q14, from -1 to 1 for -90 to +90 deg
+    long z2 = (z * z + 8192) >> 14;
+    long t = 10516 - ((z2 * 1174 + 8192) >> 14);
+    t = 25727 - ((z2 * t + 8192) >> 14);
+    return (int16_t)((z * t + 8192) >> 14);
+}
+
+void LineNoiseCanceller::process(long *sample) {
+    if (phaseStep == 0) return;
+
+    //the references, the same for all of the channels
+    int16_t ref[LNC_MAX_HARMONICS*2];
+    for (int Iharm=0; Iharm < Nharmonics; Iharm++) {
+        uint16_t p = (uint16_t)(((uint32_t)(Iharm+1) * phase) >> 16);
+        ref[2*Iharm] = sinQ14(p);
+        ref[2*Iharm+1] = sinQ14(p + 16384);  //cos
+    }
+    phase += phaseStep;
+
+    //err * ref is Q14 and the weights are Q4, so the update is err * ref >> (10 + adaptShift).
+    //That's the top 16 bits of the 48-bit product (hi), shifted by what's left.
+    const int nRef = 2*Nharmonics;
+    const int shift = adaptShift + LNC_REF_FRAC_BITS - LNC_WEIGHT_FRAC_BITS - 16;
+    const long half = 1L << (shift-1);
+    long *w = weights;
+    for (int Ichan=0; Ichan < Nchan; Ichan++, w += nRef) {
+        //the guess at the interference.  weight (Q4) * ref (Q14) is Q18, so it's hi/4.
+        //(lo >> 15) rounds hi to the nearest, instead of down.
+        long hi = 0, lo = 0;
+        for (int i=0; i < nRef; i++) Biquad_multiChan_fixed::multiplyAccumulate(hi, lo, w[i], ref[i]);
+        long err = Biquad_multiChan_fixed::saturate(sample[Ichan] - ((hi + (lo >> 15) + 2) >> 2));
+        sample[Ichan] = err;
+
+        //LMS: weight += err * ref * 2^-adaptShift, with the Q4 and Q14 worked into the shift
+        for (int i=0; i < nRef; i++) {
+            hi = 0; lo = 0;
+            Biquad_multiChan_fixed::multiplyAccumulate(hi, lo, err, ref[i]);
+            w[i] += (hi + (lo >> 15) + half) >> shift;
+        }
+    }
+
+    if (tracking && (++trackCount >= LNC_TRACK_SAMPLES)) {
+        trackCount = 0;
+        trackFrequency();
+    }
+}
+
+//The fundamental's weights are the interference's sin(phase) and cos(phase) parts.  If the
+//interference is faster than the reference, its angle atan2(cos weight, sin weight) grows
+//by the difference each sample.  Measure that over the last LNC_TRACK_SAMPLES samples and
+//move the reference by that much.  The weights lag a little behind, so this is always a
+//bit short, which keeps it from overshooting; the weights take up what's left.  Floating
+//point is fine here, as it's only one channel, once every LNC_TRACK_SAMPLES samples.
+//Without much interference, the noise pushes it around, so it's kept within
+//LNC_TRACK_RANGE of the set frequency, which is near enough to lock on again.
+void LineNoiseCanceller::trackFrequency(void) {
+    //watch the channel with the most interference
+    const int nRef = 2*Nharmonics;
+    int best = 0;
+    long bestMag = -1;
+    for (int Ichan=0; Ichan < Nchan; Ichan++) {
+        const long *w = weights + Ichan*nRef;
+        long mag = ((w[0] < 0) ? -w[0] : w[0]) + ((w[1] < 0) ? -w[1] : w[1]);
+        if (mag > bestMag) { bestMag = mag; best = Ichan; }
+    }
+    const long *w = weights + best*nRef;
+    if ((best == trackChan) && (bestMag >= LNC_TRACK_MIN_WEIGHT)) {
+        float cross = ((float)trackWeights[0])*((float)w[1]) - ((float)trackWeights[1])*((float)w[0]);
+        float dot = ((float)trackWeights[0])*((float)w[0]) + ((float)trackWeights[1])*((float)w[1]);
+        if (dot > 0.0) {
+            //cross/dot is about the angle (in radians) that it turned
+            float step = (cross / dot) * (4294967296.0 / (2.0 * M_PI * LNC_TRACK_SAMPLES));
+            double newStep = (double)phaseStep + step;
+            if (newStep < (double)minStep) newStep = minStep;
+            if (newStep > (double)maxStep) newStep = maxStep;
+            phaseStep = (uint32_t)newStep;
+        }
+    }
+    trackChan = (bestMag >= LNC_TRACK_MIN_WEIGHT) ? best : -1;
+    trackWeights[0] = w[0];
+    trackWeights[1] = w[1];
+}
@@ -0,0 +1,83 @@
+//
+//  LineNoiseCanceller.h
+//
+//  Removes mains interference (50 or 60 Hz, and if you'd like its 2nd and 3rd
+//  harmonics) by subtracting a sine wave that is fit to each channel as it goes,
+//  instead of notching out a whole band around it.
+//
+//  How it works (the adaptive noise canceller of Widrow et al., 1975):
+//    * one sine and one cosine are made at the line frequency (and its harmonics).
+//      They are shared by all of the channels.
+//    * each channel keeps a weight for each of them.  The weighted sum is our guess
+//      at the interference, and it is subtracted from the input.
+//    * what's left (the output) nudges the weights (LMS), which moves the guess
+//      toward whatever part of the input is in step with the reference.
+//  This acts like a notch that is well under 1 Hz wide and that has an infinitely
+//  deep null.  The width (and how quickly it adapts) is set by the adaptation shift:
+//  each step is 2^-shift of the error.  With the default, it settles in about two
+//  seconds at 250 Hz.
+//
+//  The mains isn't exactly 50 or 60 Hz, though, and a notch that narrow would miss
+//  it.  When the reference is off, the weights turn slowly around (at the difference
+//  frequency), so every LNC_TRACK_SAMPLES samples we see how far the weights of the
+//  channel with the most interference have turned, and nudge the reference's
+//  frequency that way.  It stays within LNC_TRACK_RANGE of where it was set.
+//
+//  It is integer math only, like Biquad_multiChan_fixed, and doesn't need anything
+//  from Arduino, so it can be used the same way on a PC.  Per channel, it is two
+//  multiplies for each reference sine going one way and two going back.  The input
+//  should already have its DC offset removed (highpass first), as the offset only
+//  adds noise to the weights.
+//
+//  Each channel uses 8 bytes of RAM for each harmonic.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#ifndef LineNoiseCanceller_h
+#define LineNoiseCanceller_h
+
+#include <stdint.h>
+#include "Biquad_multiChan_fixed.h"   //for the exact 32x16 multiplies
+
+#define LNC_MAX_HARMONICS (3)
+#define LNC_REF_FRAC_BITS (14)        //the reference sines are Q14
+#define LNC_WEIGHT_FRAC_BITS (4)      //the weights are counts with 4 fractional bits
+#define LNC_MIN_ADAPT_SHIFT (16 - LNC_REF_FRAC_BITS + LNC_WEIGHT_FRAC_BITS + 1)  //7, see process()
+#define LNC_MAX_ADAPT_SHIFT (20)
+#define LNC_DEFAULT_ADAPT_SHIFT (8)
+#define LNC_TRACK_SAMPLES (32)           //how often to check the frequency
+#define LNC_TRACK_MIN_WEIGHT (16L << LNC_WEIGHT_FRAC_BITS)  //don't track noise: |sin weight| + |cos weight| must be at least this
+#define LNC_TRACK_RANGE (0.01)           //as a fraction of the set frequency.  1% is 0.6 Hz at 60 Hz.
+
+class LineNoiseCanceller {
+public:
+    LineNoiseCanceller(int Nchan, int Nharmonics);
+    ~LineNoiseCanceller();
+    void setFrequency(double f0);             //line frequency divided by the sample rate.  Zero turns it off.
+    bool isOn(void) { return phaseStep != 0; }
+    double getFrequency(void);                //where the tracking has taken it, divided by the sample rate
+    void setTracking(bool track) { tracking = track; }
+    void setAdaptShift(int shift);            //each step is 2^-shift of the error.  Bigger is slower and narrower.
+    void process(long *sample);               //filter one sample (Nchan values) in place
+    void resetChannel(int Ichan);             //forget this channel's weights, as after a break in its data
+    int getNHarmonics(void) { return Nharmonics; }
+
+    static int16_t sinQ14(uint16_t phase);    //sin(2*pi*phase/65536) in Q14
+
+protected:
+    int Nchan;
+    int Nharmonics;
+    void trackFrequency(void);
+
+    uint32_t phase, phaseStep;                //one cycle is 2^32
+    uint32_t minStep, maxStep;                //how far the tracking may take phaseStep
+    int adaptShift;
+    long *weights;                            //[Nchan][Nharmonics][sin, cos]
+    bool tracking;
+    int trackChan;                            //the channel whose weights we watched last time
+    long trackWeights[2];                     //and what its fundamental's weights were then
+    int trackCount;
+};
+
+#endif // LineNoiseCanceller_h
@@ -0,0 +1,151 @@
+//
+//  FilterCoefficients.h
+//  Part of the StreamRawData sketch
+//
+//  The bank of filter presets for the StreamRawData sketch, with their fixed-point
+//  coefficients worked out ahead of time so that the Arduino doesn't have to.  Designing
+//  them when the sketch starts pulls tan(), pow(), and sqrt() into the program (several K
+//  of flash on the Uno) and takes a while in the Uno's software floating point.
+//
+//  The filters run as four stages (see FILTER_STAGE_* in the sketch):
+//     highpass, lowpass (or nothing), notch, notch again
+//  A "band" preset sets the first two stages and a "notch" preset sets the last two.  A
+//  bandpass is a 2nd-order Butterworth highpass followed by a 2nd-order Butterworth
+//  lowpass, which is 4th order overall, like butter(2,[f1 f2]) in the GUI.
+//
+//  The tables have one row for each ADS_RATE code (see ADS1299Manager.h), so they can be
+//  indexed by ADSManager.getSampleRateCode().  Each entry is {a0, a1, a2, -b1, -b2} in Q30,
+//  exactly as Biquad_multiChan_fixed::calcCoefficientsQ30() makes them from the designs in
+//  bandPresetDesign_P and notchPresetDesign_Hz_P, but starting from double precision (the
+//  Uno's double is only a float).  If you change a design, remake the tables with
+//  calcCoefficientsQ30() on your PC (../../Tests/test_filter_presets checks them), or set
+//  PRECOMPUTED_FILTERS to 0 in the sketch.
+//
+//  Q14 can't reach the low highpass cutoffs, or the lowpasses, at the higher sample rates
+//  (the 13 Hz lowpass's a0 is zero in Q14 at 8 kHz and up, and the highpasses ring at 1 kHz
+//  and up), so those are in Q30.  The ones that Q14 gets right (to within BQ_Q14_TOLERANCE)
+//  are Q14 shifted up, with the low 16 bits zero, and Biquad_cascade_fixed runs those twice
+//  as fast.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#ifndef ____FilterCoefficients__
+#define ____FilterCoefficients__
+
+#include <Biquad_multiChan_fixed.h>
+
+#define N_BAND_PRESETS (6)
+#define N_NOTCH_PRESETS (3)
+#define BAND_PRESET_DEFAULT (1)    //0.5 Hz highpass
+#define NOTCH_PRESET_DEFAULT (2)   //60 Hz
+#define N_RATE_CODES (7)
+#define BANDPASS_Q (0.7071)        //Butterworth
+#define NOTCH_PRESET_Q (4.0)       //pretty sharp notch
+
+//the designs
+typedef struct {
+  float hp_Hz;
+  float hp_Q;
+  float lp_Hz;   //zero for no lowpass
+} BandPresetDesign;
+const BandPresetDesign bandPresetDesign_P[N_BAND_PRESETS] PROGMEM = {
+  {  0.1, 0.5,        0.0 },  //highpass 0.1 Hz
+  {  0.5, 0.5,        0.0 },  //highpass 0.5 Hz
+  {  1.0, 0.5,        0.0 },  //highpass 1 Hz
+  {  1.0, BANDPASS_Q, 50.0 }, //bandpass 1-50 Hz
+  {  7.0, BANDPASS_Q, 13.0 }, //bandpass 7-13 Hz
+  { 15.0, BANDPASS_Q, 50.0 }  //bandpass 15-50 Hz
+};
+const float notchPresetDesign_Hz_P[N_NOTCH_PRESETS] PROGMEM = { 0.0, 50.0, 60.0 };  //zero for no notch
+
+//[preset][rate code][highpass, lowpass]
+const BiquadCoeffQ30 bandPreset_coeff_P[N_BAND_PRESETS][N_RATE_CODES][2] PROGMEM = {
+  { //highpass 0.1 Hz
+    { {  1073699659, -2147399318,  1073699659,  2147399318, -1073657496 }, {  1073741824,           0,           0,           0,           0 } },  //16kHz
+    { {  1073657497, -2147314994,  1073657497,  2147314991, -1073573174 }, {  1073741824,           0,           0,           0,           0 } },  //8kHz
+    { {  1073573181, -2147146362,  1073573181,  2147146349, -1073404551 }, {  1073741824,           0,           0,           0,           0 } },  //4kHz
+    { {  1073404578, -2146809156,  1073404578,  2146809102, -1073067384 }, {  1073741824,           0,           0,           0,           0 } },  //2kHz
+    { {  1073067490, -2146134980,  1073067490,  2146134768, -1072393368 }, {  1073741824,           0,           0,           0,           0 } },  //1kHz
+    { {  1072393791, -2144787582,  1072393791,  2144786735, -1071046604 }, {  1073741824,           0,           0,           0,           0 } },  //500Hz
+    { {  1071048293, -2142096586,  1071048293,  2142093204, -1068358145 }, {  1073741824,           0,           0,           0,           0 } }   //250Hz
+  },
+  { //highpass 0.5 Hz
+    { {  1073531026, -2147062052,  1073531026,  2147062032, -1073320249 }, {  1073741824,           0,           0,           0,           0 } },  //16kHz
+    { {  1073320291, -2146640582,  1073320291,  2146640498, -1072898840 }, {  1073741824,           0,           0,           0,           0 } },  //8kHz
+    { {  1072899006, -2145798012,  1072899006,  2145797680, -1072056518 }, {  1073741824,           0,           0,           0,           0 } },  //4kHz
+    { {  1072057179, -2144114358,  1072057179,  2144113035, -1070373856 }, {  1073741824,           0,           0,           0,           0 } },  //2kHz
+    { {  1070376493, -2140752986,  1070376493,  2140747705, -1067016445 }, {  1073741824,           0,           0,           0,           0 } },  //1kHz
+    { {  1067026943, -2134053886,  1067026943,  2134032823, -1060333124 }, {  1073741824,           0,           0,           0,           0 } },  //500Hz
+    { {  1060374724, -2120749448,  1060374724,  2120665722, -1047091350 }, {  1073741824,           0,           0,           0,           0 } }   //250Hz
+  },
+  { //highpass 1 Hz
+    { {  1073320291, -2146640582,  1073320291,  2146640498, -1072898840 }, {  1073741824,           0,           0,           0,           0 } },  //16kHz
+    { {  1072899006, -2145798012,  1072899006,  2145797680, -1072056518 }, {  1073741824,           0,           0,           0,           0 } },  //8kHz
+    { {  1072057179, -2144114358,  1072057179,  2144113035, -1070373856 }, {  1073741824,           0,           0,           0,           0 } },  //4kHz
+    { {  1070376493, -2140752986,  1070376493,  2140747705, -1067016445 }, {  1073741824,           0,           0,           0,           0 } },  //2kHz
+    { {  1067026943, -2134053886,  1067026943,  2134032823, -1060333124 }, {  1073741824,           0,           0,           0,           0 } },  //1kHz
+    { {  1060374724, -2120749448,  1060374724,  2120665722, -1047091350 }, {  1073741824,           0,           0,           0,           0 } },  //500Hz
+    { {  1047265280, -2094530560,  1047265280,  2094202880, -1021116416 }, {  1073741824,           0,           0,           0,           0 } }   //250Hz
+  },
+  { //bandpass 1-50 Hz
+    { {  1073443706, -2146887412,  1073443706,  2146887328, -1073145670 }, {      102070,      204140,      102070,  2117669563, -1044336019 } },  //16kHz
+    { {  1073145670, -2146291340,  1073145670,  2146291009, -1072549847 }, {      402728,      805455,      402728,  2087866446, -1015735533 } },  //8kHz
+    { {  1072549847, -2145099694,  1072549847,  2145098372, -1071359194 }, {     1568002,     3136004,     1568002,  2028332801,  -960862985 } },  //4kHz
+    { {  1071359194, -2142718388,  1071359194,  2142713101, -1068981851 }, {     5963776,    11862016,     5963776,  1909784576,  -859832320 } },  //2kHz
+    { {  1068981851, -2137963702,  1068981851,  2137942601, -1064242979 }, {    21561344,    43122688,    21561344,  1676148736,  -688652288 } },  //1kHz
+    { {  1064242979, -2128485958,  1064242979,  2128401926, -1054828165 }, {    72417280,   144900096,    72417280,  1227227136,  -443219968 } },  //500Hz
+    { {  1054828155, -2109656310,  1054828155,  2109323132, -1036247665 }, {   221773824,   443678720,   221773824,   396754944,  -210239488 } }   //250Hz
+  },
+  { //bandpass 7-13 Hz
+    { {  1071656733, -2143313466,  1071656733,  2143309418, -1069575692 }, {        6971,       13941,        6971,  2139731530, -1066017589 } },  //16kHz
+    { {  1069575692, -2139151384,  1069575692,  2139135219, -1065425724 }, {       27783,       55566,       27783,  2131979613, -1058348921 } },  //8kHz
+    { {  1065425724, -2130851448,  1065425724,  2130787040, -1057174031 }, {      110338,      220676,      110338,  2116477159, -1043176687 } },  //4kHz
+    { {  1057174026, -2114348052,  1057174026,  2114092401, -1040861879 }, {      435116,      870232,      435116,  2085482980, -1013481620 } },  //2kHz
+    { {  1040842752, -2081685504,  1040842752,  2080702464, -1008992256 }, {     1703936,     3342336,     1703936,  2023620608,  -956628992 } },  //1kHz
+    { {  1008992256, -2017984512,  1008992256,  2014052352,  -948109312 }, {     6422528,    12779520,     6422528,  1900347392,  -852230144 } },  //500Hz
+    { {   948109312, -1896218624,   948109312,  1881473024,  -837222400 }, {    23134208,    46333952,    23134208,  1657667584,  -676528128 } }   //250Hz
+  },
+  { //bandpass 15-50 Hz
+    { {  1069278730, -2138557460,  1069278730,  2138538909, -1064834187 }, {      102070,      204140,      102070,  2117669563, -1044336019 } },  //16kHz
+    { {  1064834187, -2129668374,  1064834187,  2129594478, -1056000447 }, {      402728,      805455,      402728,  2087866446, -1015735533 } },  //8kHz
+    { {  1055981568, -2111963136,  1055981568,  2111700992, -1038548992 }, {     1568002,     3136004,     1568002,  2028332801,  -960862985 } },  //4kHz
+    { {  1038548992, -2077097984,  1038548992,  2075983872, -1004535808 }, {     5963776,    11862016,     5963776,  1909784576,  -859832320 } },  //2kHz
+    { {  1004535808, -2009071616,  1004535808,  2004549632,  -939720704 }, {    21561344,    43122688,    21561344,  1676148736,  -688652288 } },  //1kHz
+    { {   939720704, -1879441408,   939720704,  1862598656,  -822476800 }, {    72417280,   144900096,    72417280,  1227227136,  -443219968 } },  //500Hz
+    { {   822083584, -1644167168,   822083584,  1584267264,  -630194176 }, {   221773824,   443678720,   221773824,   396754944,  -210239488 } }   //250Hz
+  }
+};
+
+//[preset][rate code].  The same coefficients go into both notch stages.
+const BiquadCoeffQ30 notchPreset_coeff_P[N_NOTCH_PRESETS][N_RATE_CODES] PROGMEM = {
+  { //no notch
+    {  1073741824,           0,           0,           0,           0 },  //16kHz
+    {  1073741824,           0,           0,           0,           0 },  //8kHz
+    {  1073741824,           0,           0,           0,           0 },  //4kHz
+    {  1073741824,           0,           0,           0,           0 },  //2kHz
+    {  1073741824,           0,           0,           0,           0 },  //1kHz
+    {  1073741824,           0,           0,           0,           0 },  //500Hz
+    {  1073741824,           0,           0,           0,           0 }   //250Hz
+  },
+  { //50 Hz notch
+    {  1071113086, -2141813238,  1071113086,  2141813238, -1068484348 },  //16kHz
+    {  1068498194, -2135348841,  1068498194,  2135348840, -1063254563 },  //8kHz
+    {  1063321600, -2120089600,  1063321600,  2120089600, -1052901376 },  //4kHz
+    {  1053148239, -2080364473,  1053148239,  2080364473, -1032554654 },  //2kHz
+    {  1033830400, -1966473216,  1033830400,  1966407680,  -993853440 },  //1kHz
+    {  1000275968, -1618477056,  1000275968,  1618411520,  -926744576 },  //500Hz
+    {   959643648,  -593100800,   959643648,   593100800,  -845545472 }   //250Hz
+  },
+  { //60 Hz notch
+    {  1070588971, -2140583616,  1070588971,  2140583616, -1067436118 },  //16kHz
+    {  1067456314, -2132542608,  1067456314,  2132542608, -1061170804 },  //8kHz
+    {  1061257678, -2113095558,  1061257678,  2113095557, -1048773531 },  //4kHz
+    {  1049165824, -2061172736,  1049165824,  2061172736, -1024589824 },  //2kHz
+    {  1026490368, -1908801536,  1026490368,  1908801536,  -979238912 },  //1kHz
+    {   989134848, -1442119680,   989134848,  1442054144,  -904462336 },  //500Hz
+    {   954662912,  -119930880,   954662912,   119865344,  -835518464 }   //250Hz
+  }
+};
+
+#endif
@@ -16,9 +16,14 @@ typedef long int int32;
 
 //for using a single OpenBCI board
 #include <ADS1299Manager.h>  //for a single OpenBCI board
+#include <ADS1299LeadOffScan.h>
 ADS1299Manager ADSManager; //Uses SPI bus and pins to say data is ready.  Uses Pins 13,12,11,10,9,8,4
 #define MAX_N_CHANNELS (N_CHANNELS_PER_OPENBCI)   //how many channels are available in hardware
 //#define MAX_N_CHANNELS (2*N_CHANNELS_PER_OPENBCI)   //how many channels are available in hardware...use this for daisy-chained board
+//For daisy-chained boards, also raise ADS_MAX_N_BOARDS in ADS1299.h (it's 1, to save RAM on the Uno)
+#if (MAX_N_CHANNELS > N_CHANNELS_PER_OPENBCI*ADS_MAX_N_BOARDS)
+#error "MAX_N_CHANNELS needs more boards than ADS_MAX_N_BOARDS allows.  Raise it in ADS1299.h"
+#endif
 int nActiveChannels = MAX_N_CHANNELS;   //how many active channels would I like?
 
 
@@ -30,6 +35,7 @@ byte inputType = ADSINPUT_NORMAL;   //here's the normal way to setup the channel
 
 //other variables
 long sampleCounter = 0;      // used to time the tesing loop
+long serialBaud;             // speed of the serial link to the PC
 boolean is_running = false;    // this flag is set in serialEvent on reciept of prompt
 #define PIN_STARTBINARY (7)  //pull this pin to ground to start binary transfer
 //define PIN_STARTBINARY_OPENEEG (6)
@@ -48,23 +54,138 @@ int analogVal = 0;
 #define OUTPUT_BINARY_OPENEEG (6)
 #define OUTPUT_BINARY_OPENEEG_SYNTHETIC (7)
 #define OUTPUT_BINARY_WITH_AUX (8)
+#define OUTPUT_BINARY_PACKED (9)
+#define OUTPUT_BINARY_DELTA (10)
+#define OUTPUT_BINARY_BATCH (11)
+#define OUTPUT_BINARY_COBS (12)
+#define OUTPUT_BINARY_BANDPOWER (13)
+#define OUTPUT_BINARY_IMPEDANCE (14)
 int outputType;
 
 //Design filters  (This BIQUAD class requires ~6K of program space!  Ouch.)
 //For frequency response of these filters: http://www.earlevel.com/main/2010/12/20/biquad-calculator/
 #include <Biquad_multiChan.h>   //modified from this source code:  http://www.earlevel.com/main/2012/11/26/biquad-c-source-code/
-#define SAMPLE_RATE_HZ (250.0)  //default setting for OpenBCI
+#include <Biquad_multiChan_static.h>
+//The fixed-point filters are several times faster than floating point on the Uno, which is
+//what lets us filter a daisy chain.  Set this to 0 to go back to the floating-point ones.
+#define FIXED_POINT_FILTERS (1)
+//With the fixed-point filters, the coefficients can come from a table that was worked out
+//ahead of time (FilterCoefficients.h), which keeps the ~6K of filter design code out of the
+//program.  Set this to 0 if you change the filter presets in FilterCoefficients.h.
+#define PRECOMPUTED_FILTERS (1)
+//With the fixed-point filters, the line noise can be taken out by an adaptive canceller
+//(LineNoiseCanceller.h) instead of the two notch stages.  Set this to 1 to use it.  It
+//follows the mains frequency as it drifts, leaves the EEG right next to it alone (the
+//notches take 11 dB off of a tone 3 Hz away), costs less than the notches, and can take out
+//the 2nd and 3rd harmonics too, for 8 more bytes of RAM per channel each.  But it takes out
+//less of the fundamental: 22 to 30 dB, depending on how quickly the mains drifts, where the
+//notches take out 56 dB (see Tests/test_line_noise.cpp).  So the notches are the default.
+//With the canceller, the notch preset ('/') just picks the line frequency.
+#define LINE_NOISE_CANCELLER (0)
+#define LINE_NOISE_HARMONICS (1)   //1 for just the fundamental, up to 3
+#include <Biquad_cascade_fixed.h>   //included either way, so that the IDE's function prototypes know BiquadCoeffQ30
+#include <LineNoiseCanceller.h>
+#include "FilterCoefficients.h"
+#define SAMPLE_RATE_HZ (250.0)  //default setting for OpenBCI...use ';' plus a rate code to change it while running
+float sampleRate_Hz = SAMPLE_RATE_HZ;  //the rate that we're actually running at
 #define FILTER_Q (0.5)        //critically damped is 0.707 (Butterworth)
 #define FILTER_PEAK_GAIN_DB (0.0) //we don't want any gain in the passband
 #define HP_CUTOFF_HZ (0.5)  //set the desired cutoff for the highpass filter
-Biquad_multiChan stopDC_filter(MAX_N_CHANNELS,bq_type_highpass,HP_CUTOFF_HZ / SAMPLE_RATE_HZ, FILTER_Q, FILTER_PEAK_GAIN_DB); //one for each channel because the object maintains the filter states
-//Biquad_multiChan stopDC_filter(MAX_N_CHANNELS,bq_type_bandpass,10.0 / SAMPLE_RATE_HZ, 6.0, FILTER_PEAK_GAIN_DB); //one for each channel because the object maintains the filter states
 #define NOTCH_FREQ_HZ (60.0)
 #define NOTCH_Q (4.0)              //pretty sharp notch
 #define NOTCH_PEAK_GAIN_DB (0.0)  //doesn't matter for this filter type
-Biquad_multiChan notch_filter1(MAX_N_CHANNELS,bq_type_notch,NOTCH_FREQ_HZ / SAMPLE_RATE_HZ, NOTCH_Q, NOTCH_PEAK_GAIN_DB); //one for each channel because the object maintains the filter states
-Biquad_multiChan notch_filter2(MAX_N_CHANNELS,bq_type_notch,NOTCH_FREQ_HZ / SAMPLE_RATE_HZ, NOTCH_Q, NOTCH_PEAK_GAIN_DB); //one for each channel because the object maintains the filter states
-boolean useFilters = false;  //enable or disable as you'd like...turn off if you're daisy chaining!
+#if FIXED_POINT_FILTERS
+//the highpass, lowpass, and both notches in one chain, which filters the whole sample in one
+//call (the notches are left out when the line noise canceller is used instead).  Which filters
+//they are comes from the presets in FilterCoefficients.h.  Use ':' and '/' (or the binary
+//CMD_SET_FILTER_PRESET) to change them while running.  See designFilters().
+#define FILTER_STAGE_HIGHPASS (0)
+#define FILTER_STAGE_LOWPASS (1)
+#define FILTER_STAGE_NOTCH1 (2)
+#define FILTER_STAGE_NOTCH2 (3)
+#if LINE_NOISE_CANCELLER
+#define N_FILTER_STAGES (2)   //no notch stages
+LineNoiseCanceller lineCanceller(MAX_N_CHANNELS,LINE_NOISE_HARMONICS);
+#else
+#define N_FILTER_STAGES (4)
+#endif
+Biquad_cascade_fixed eeg_filters(MAX_N_CHANNELS,N_FILTER_STAGES);
+byte bandPreset = BAND_PRESET_DEFAULT;
+byte notchPreset = NOTCH_PRESET_DEFAULT;
+#else
+//the state for all of the channels is inside each object (no heap), see Biquad_multiChan_static.h
+Biquad_multiChan_static<MAX_N_CHANNELS> stopDC_filter(bq_type_highpass,HP_CUTOFF_HZ / SAMPLE_RATE_HZ, FILTER_Q, FILTER_PEAK_GAIN_DB); //one for each channel because the object maintains the filter states
+//Biquad_multiChan_static<MAX_N_CHANNELS> stopDC_filter(bq_type_bandpass,10.0 / SAMPLE_RATE_HZ, 6.0, FILTER_PEAK_GAIN_DB); //one for each channel because the object maintains the filter states
+Biquad_multiChan_static<MAX_N_CHANNELS> notch_filter1(bq_type_notch,NOTCH_FREQ_HZ / SAMPLE_RATE_HZ, NOTCH_Q, NOTCH_PEAK_GAIN_DB); //one for each channel because the object maintains the filter states
+Biquad_multiChan_static<MAX_N_CHANNELS> notch_filter2(bq_type_notch,NOTCH_FREQ_HZ / SAMPLE_RATE_HZ, NOTCH_Q, NOTCH_PEAK_GAIN_DB); //one for each channel because the object maintains the filter states
+#endif
+boolean useFilters = false;  //enable or disable as you'd like...turn off if you're daisy chaining with floating-point filters!
+
+//Band power output ('j').  Instead of the samples, send the power in the theta, alpha, and
+//beta bands of each channel a few times a second (see ADS1299BandPower.h).  The bins are
+//BAND_POWER_UPDATE_HZ apart, so 5 Hz needs 5 bins for 4-30 Hz.  The RAM for them (8 bytes
+//per bin per channel) is only taken the first time it's used.  It runs after the filters,
+//so turn them on ('f') to keep the DC offset out of it.
+#define BAND_POWER_UPDATE_HZ (5.0)
+#define BAND_POWER_MAX_BINS (6)
+ADS1299BandPower bandPower(MAX_N_CHANNELS,BAND_POWER_MAX_BINS);
+
+//Electrode impedance from the AC lead-off signal (see ADS1299Impedance.h).  Turn on lead-off
+//for the channels you'd like with '!'-'*' (P side) or 'A'-'<' (N side).  Then either 'z'
+//streams just the impedances, or 'l' sends them along with whichever binary format is
+//running.  It works on the raw data, before the filters.  The lead-off frequency is set
+//in setup(); it has to be one of the AC ones.
+#define IMPEDANCE_UPDATE_HZ (2.0)
+ADS1299Impedance impedance(MAX_N_CHANNELS);
+boolean sendImpedanceWithData = false;
+
+//Background impedance scan ('.').  Rather than lead-off on every channel at once, it moves
+//the lead-off current from one channel to the next every LEADOFF_SCAN_DWELL_SEC, between
+//two samples, so that the data never stops (see ADS1299LeadOffScan.h).  It sends the
+//impedance of all of the channels as it finishes each one, and marks which channel has the
+//lead-off tone in it, for any of the framed binary formats.  Use ',' plus a digit to set
+//the dwell in seconds (',0' goes as fast as the lock-in allows).  It needs hot
+//reconfiguration to go without a gap, and it uses the same lock-in as 'z' and 'l'.
+#define LEADOFF_SCAN_DWELL_SEC (1.0)
+#define LEADOFF_SCAN_SIDE (PCHAN)
+ADS1299LeadOffScan leadOffScan(&ADSManager,&impedance);
+boolean useLeadOffScan = false;
+float leadOffScanDwell_sec = LEADOFF_SCAN_DWELL_SEC;
+
+//read the data from the DRDY interrupt (into a small ring of samples) so that slow serial
+//writes in loop() don't cause us to miss samples.  Set to false to poll DRDY instead.  Boards
+//with no interrupt on the DRDY pin poll it anyway.
+boolean useDRDYInterrupt = true;
+
+//change the ADS settings between samples while streaming, instead of stopping and restarting.
+//The first sample after a change is marked in the binary stream, and (if you'd like) the
+//filters forget their history for the channels that changed.
+boolean useHotReconfig = true;
+boolean resetFiltersOnReconfig = true;
+
+//Timing of each stage of the loop, to see how much of the sample period is left over before
+//turning on more channels or filters.  Set ADS_PROFILE to 1 in ADS1299Manager.h to use it.
+//Press 'P' for the report.  While streaming binary, it goes out as status packets instead
+//of text, one stage after each sample, so that it doesn't hold up the data (see
+//sendStageProfile()).
+#if ADS_PROFILE
+#define STAGE_READ (0)     //getting the sample from the ADS (or from the ring)
+#define STAGE_AUX (1)      //analog input and discontinuity handling
+#define STAGE_FILTER (2)
+#define STAGE_ENCODE (3)   //building the output packet
+#define STAGE_TOTAL (4)    //all of the above
+#define STAGE_SERIAL (5)   //serviceTX() at the top of loop()
+#define N_STAGES (6)
+ADS1299Profiler<N_STAGES> stageProfile;
+#define PROFILE_BEGIN() stageProfile.begin()
+#define PROFILE_LAP(stage) stageProfile.lap(stage)
+#define PROFILE_FINISH(stage) stageProfile.finish(stage)
+#else
+#define PROFILE_BEGIN()
+#define PROFILE_LAP(stage)
+#define PROFILE_FINISH(stage)
+#endif
+int profileReportNext = -1;  //the next stage to send, while a report is going out as packets
 
 
 void setup() {
@@ -73,24 +194,29 @@ void setup() {
   pinMode(2,INPUT);  digitalWrite(2,HIGH); //activate pullup...for detecting which version of OpenBCI PCB
   pinMode(3,OUTPUT); digitalWrite(3,LOW);  //act as a ground pin...for detecting which version of OpenBCI PCB
   if (digitalRead(2) == LOW) OpenBCI_version = OPENBCI_V1; //check pins to see if there is a jumper.  if so, it is the older board
-  boolean isDaisy = false; if (MAX_N_CHANNELS > 8) isDaisy = true;
-  ADSManager.initialize(OpenBCI_version,isDaisy);  //must do this VERY early in the setup...preferably first
+  int nBoards = MAX_N_CHANNELS / N_CHANNELS_PER_OPENBCI;  //how many boards are daisy chained
+  ADSManager.initializeBoards(OpenBCI_version,nBoards);  //must do this VERY early in the setup...preferably first
+  ADSManager.setInterruptMode(useDRDYInterrupt);
+  ADSManager.setHotReconfig(useHotReconfig);
 
   // setup the serial link to the PC
   if (MAX_N_CHANNELS > 8) {
-    Serial.begin(115200*2);  //Need 115200 for 16-channels, only need 115200 for 8-channels but let's do 115200*2 for consistency
+    serialBaud = 115200*2;  //Need 115200 for 16-channels, only need 115200 for 8-channels but let's do 115200*2 for consistency
   } else {
-    Serial.begin(115200);
+    serialBaud = 115200;
   }
+  Serial.begin(serialBaud);
   Serial.println(F("ADS1299-Arduino UNO - Stream Raw Data")); //read the string from Flash to save RAM
-  Serial.print(F("Configured as OpenBCI_Version code = "));Serial.print(OpenBCI_version); Serial.print(F(", isDaisy = "));Serial.println(ADSManager.isDaisy);
+  Serial.print(F("Configured as OpenBCI_Version code = "));Serial.print(OpenBCI_version); Serial.print(F(", nBoards = "));Serial.println(ADSManager.nBoards);
   Serial.print(F("Configured for "));Serial.print(MAX_N_CHANNELS); Serial.println(F(" Channels"));
   Serial.flush();
   
   // setup the channels as desired on the ADS1299..set gain, input type, referece (SRB1), and patient bias signal
+  ADSManager.beginConfig();
   for (int chan=1; chan <= nActiveChannels; chan++) {
     ADSManager.activateChannel(chan, gainCode, inputType);
   }
+  ADSManager.commit();
 
   //setup the lead-off detection parameters
   ADSManager.configureLeadOffDetection(LOFF_MAG_6NA, LOFF_FREQ_31p2HZ);
@@ -103,7 +229,8 @@ void setup() {
   //pinMode(PIN_STARTBINARY_OPENEEG,INPUT); digitalWrite(PIN_STARTBINARY_OPENEEG,HIGH);  //activate pullup
   
   //look out for daisy chaining and disable filtering because it'll likely take too much computation
-  if (nActiveChannels > 8) useFilters = false;
+  if ((nActiveChannels > 8) && !FIXED_POINT_FILTERS) useFilters = false;
+  designFilters(false);
   if (useFilters) Serial.print(F("Configured to do some filtering here on the Arduino."));
   
   
@@ -111,19 +238,23 @@ void setup() {
   Serial.println(F("Press '?' to query and print ADS1299 register settings again")); //read it straight from flash
   Serial.println(F("Press 1-8 to disable EEG Channels, q-i to enable (all enabled by default)"));
   Serial.println(F("Press 'f' to enable filters.  'g' to disable filters"));
+  Serial.println(F("Press ';' then 0-6 to set the sample rate (0 = 16kHz, 1 = 8kHz, ... 6 = 250Hz)"));
+#if FIXED_POINT_FILTERS
+  Serial.println(F("Press ':' then 0-5 for the filter band (0-2 = highpass 0.1, 0.5, 1 Hz, 3-5 = bandpass 1-50, 7-13, 15-50 Hz)"));
+  Serial.println(F("Press '/' then 0-2 for the line noise filter (0 = none, 1 = 50 Hz, 2 = 60 Hz)"));
+#endif
   Serial.println(F("Press 'x' (text) or 'b' (binary) to begin streaming data..."));    
  
 } // end of setup
 
 boolean firstReport = true;
-unsigned long totalMicrosBusy = 0;  //use this to count time
 void loop(){
   
   if (digitalRead(PIN_STARTBINARY)==LOW) {
     //button is pressed (or pin is jumpered to ground)
     startBecauseOfPin = true;
     //startRunning(OUTPUT_BINARY_OPENEEG_SYNTHETIC);
-    startRunning(OUTPUT_BINARY_OPENEEG);
+    if (!is_running) startRunning(OUTPUT_BINARY_OPENEEG);  //restarting would empty the DRDY sample ring
     //if (firstReport) { Serial.println(F("Starting Binary_OpenEEG Based on Pin")); firstReport=false;}
   } else {
     if (startBecauseOfPin) {
@@ -134,20 +265,54 @@ void loop(){
   }
   
   if (is_running) {
- 
-    //is data ready?      
-    while(!(ADSManager.isDataAvailable())){            // watch the DRDY pin
-      delayMicroseconds(100);
+    PROFILE_BEGIN();
+    ADSManager.serviceTX();  //keep the previous packets moving out the serial port
+    PROFILE_LAP(STAGE_SERIAL);
+    
+    if (ADSManager.isInterruptMode()) {
+      //the DRDY interrupt has already read the data...just drain whatever is waiting
+      while (ADSManager.isDataAvailable()) {
+        PROFILE_BEGIN();
+        sampleCounter = ADSManager.popChannelData();  // copy the oldest sample into the channelData array
+        PROFILE_LAP(STAGE_READ);
+        processAndWriteSample();
+      }
+    } else {
+      //is data ready?      
+      while(!(ADSManager.isDataAvailable())){            // watch the DRDY pin
+        delayMicroseconds(100);
+      }
+      
+      //get the data
+      PROFILE_BEGIN();
+      ADSManager.updateChannelData();            // update the channelData array 
+      sampleCounter++;                           // increment my sample counter
+      PROFILE_LAP(STAGE_READ);
+      processAndWriteSample();
     }
-    unsigned long start_micros = micros();
-  
-    //get the data
+  }
+
+} // end of loop
+
+//filter and send the sample that is currently in ADSManager.channelData
+void processAndWriteSample(void) {
+    //get the aux data
     analogVal = analogRead(PIN_ANALOGINPUT);   // get analog value
-    ADSManager.updateChannelData();            // update the channelData array 
-    sampleCounter++;                           // increment my sample counter
+    
+    //was the ADS reconfigured just before this sample?
+    if (ADSManager.getDiscontinuity() >= 0) handleDiscontinuity();
+    
+    //the impedance needs the raw data, so it goes before the filters
+    if (leadOffScan.isScanning()) {
+      leadOffScan.update(sampleCounter,isFramedBinaryOutput(outputType));  //it runs the lock-in itself
+    } else if ((outputType == OUTPUT_BINARY_IMPEDANCE) || (sendImpedanceWithData && isFramedBinaryOutput(outputType))) {
+      ADSManager.writeChannelDataAsImpedance(MAX_N_CHANNELS,sampleCounter,&impedance);
+    }
+    PROFILE_LAP(STAGE_AUX);
     
     //Apply  filers to the data
     if (useFilters) applyFilters();
+    PROFILE_LAP(STAGE_FILTER);
 
     //print the data
     switch (outputType) {
@@ -167,6 +332,23 @@ void loop(){
       case OUTPUT_BINARY_4CHAN:
         ADSManager.writeChannelDataAsBinary(4,sampleCounter);  //print 4 channels, whether active or not
         break; 
+      case OUTPUT_BINARY_PACKED:
+        ADSManager.writeChannelDataAsPackedBinary(MAX_N_CHANNELS,sampleCounter);  //print all channels, 3 bytes each
+        break;
+      case OUTPUT_BINARY_DELTA:
+        ADSManager.writeChannelDataAsDelta(MAX_N_CHANNELS,sampleCounter);  //print all channels, compressed
+        break;
+      case OUTPUT_BINARY_BATCH:
+        ADSManager.writeChannelDataAsBatch(MAX_N_CHANNELS,sampleCounter);  //print all channels, several samples per packet
+        break;
+      case OUTPUT_BINARY_COBS:
+        ADSManager.writeChannelDataAsCOBS(MAX_N_CHANNELS,sampleCounter);  //print all channels, with a CRC, framed by COBS
+        break;
+      case OUTPUT_BINARY_BANDPOWER:
+        ADSManager.writeChannelDataAsBandPower(MAX_N_CHANNELS,sampleCounter,&bandPower);  //just the band power, once per block
+        break;
+      case OUTPUT_BINARY_IMPEDANCE:
+        break;  //the impedance went out above, before the filters
       case OUTPUT_BINARY_OPENEEG:
         ADSManager.writeChannelDataAsOpenEEG_P2(sampleCounter);  //this format accepts 6 channels, so that's what it does
         break; 
@@ -176,33 +358,86 @@ void loop(){
       default:
         ADSManager.printChannelDataAsText(MAX_N_CHANNELS,sampleCounter);  //print all channels, whether active or not
     }
+    PROFILE_LAP(STAGE_ENCODE);
+    PROFILE_FINISH(STAGE_TOTAL);
+    if (profileReportNext >= 0) sendStageProfile();  //a piece of the timing report, if one is going out
 
-    
-//    totalMicrosBusy += (micros()-start_micros); //accumulate
-//    if (sampleCounter==250) totalMicrosBusy = 0;  //start from 250th sample
-//    if (sampleCounter==500) {
-//      stopRunning();
-//      Serial.println();
-//      Serial.print(F("Was busy for "));
-//      Serial.print(totalMicrosBusy);
-//      Serial.println(F(" microseconds across 250 samples"));
-//      Serial.print(F("Assuming a 250Hz Sample Rate, it was busy for "));
-//      unsigned long micros_per_250samples = 1000000UL;
-//      Serial.print(((float)totalMicrosBusy/(float)micros_per_250samples)*100.0);
-//      Serial.println(F("% of the available time"));
-//    }
-      
-  }
-
-} // end of loop
+}
 
 
 #define ACTIVATE_SHORTED (2)
 #define ACTIVATE (1)
 #define DEACTIVATE (0)
+//Binary commands.  Besides the single-character commands, the PC can send a framed
+//binary command.  It starts with a byte that no single-character command uses:
+//   CMD_FRAME_START, payload length (1 byte), payload, CRC-16 of the payload (2 bytes, high byte first)
+//The first byte of the payload says which command it is.  Each one is answered with a
+//status packet (see ADS1299Manager::writeStatusPacket) holding the command, CMD_STATUS
+//code, and a bit for each active channel (channel 1 is bit 0 of the first byte, channel 9
+//is bit 0 of the second byte, and so on, with a byte for each board).
+//   CMD_CONFIGURE_CHANNELS:  command, bias (1 = auto), number of channels, then for each
+//                            channel: ADS_CHANCFG flags, ADS_GAIN code, ADSINPUT code.
+//                            Daisy-chained boards share their settings (channel N and N+8
+//                            are the same), so see ADS1299Manager::configureChannels.
+//   CMD_SET_FILTER_PRESET:   command, band preset, notch preset (see FilterCoefficients.h)
+//While a binary format is streaming, the single-character channel commands are answered
+//with the same status packet instead of text, which would get in the way of the packets.
+//The command in it is CMD_CHANNEL_STATE ('1'-'8', 'q'-'i') or CMD_CHANNEL_LEADOFF ('!'-'*',
+//'Q'-'I', 'A'-'K', 'Z'-'<').  The PC can't send those two.  The timing report ('P') goes
+//out the same way, as CMD_PROFILE_REPORT (see sendStageProfile()).
+#define CMD_FRAME_START (0xF0)
+#define CMD_MAX_PAYLOAD (3+3*ADS1299::MAX_N_CHAN)   //a setting for every channel the library can handle
+#define CMD_FRAME_TIMEOUT_MSEC (250)   //give up on a frame that stops halfway
+#define CMD_CONFIGURE_CHANNELS (0x01)
+#define CMD_SET_FILTER_PRESET (0x02)
+#define CMD_CHANNEL_STATE (0x80)
+#define CMD_CHANNEL_LEADOFF (0x81)
+#define CMD_PROFILE_REPORT (0x82)
+#define CMD_STATUS_OK (0)
+#define CMD_STATUS_BAD_CRC (1)
+#define CMD_STATUS_BAD_COMMAND (2)
+byte cmdFrame[1+CMD_MAX_PAYLOAD+2];
+int cmdFrameBytes = -1;  //-1 when we're not in the middle of a binary command
+unsigned long cmdFrameStart_millis;
+
+char commandPrefix = 0;  //';', ':', '/', or ',' when the next character finishes the command
 void serialEvent(){            // send an 'x' on the serial line to trigger ADStest()
+  if ((cmdFrameBytes >= 0) && ((millis() - cmdFrameStart_millis) > CMD_FRAME_TIMEOUT_MSEC)) cmdFrameBytes = -1;  //abandon it
   while(Serial.available()){      
     char inChar = (char)Serial.read();
+    if (cmdFrameBytes >= 0) {
+      //this is part of a binary command
+      collectCommandFrame((byte)inChar);
+      continue;
+    }
+    if ((byte)inChar == CMD_FRAME_START) {
+      cmdFrameBytes = 0;
+      cmdFrameStart_millis = millis();
+      continue;
+    }
+    if (commandPrefix != 0) {
+      //this is the second half of a two-character command
+      char prefix = commandPrefix;
+      commandPrefix = 0;
+      if ((inChar < '0') || (inChar > '9')) continue;
+      byte code = (byte)(inChar - '0');
+      switch (prefix) {
+        case ';':
+          if (code <= 6) changeSampleRate_maintainRunningState(code);
+          break;
+        case ':':
+          if (setFilterPreset(code, getNotchPreset())) printFilterPreset();
+          break;
+        case '/':
+          if (setFilterPreset(getBandPreset(), code)) printFilterPreset();
+          break;
+        case ',':
+          leadOffScanDwell_sec = (code == 0) ? 0.0 : (float)code;
+          leadOffScan.setDwell(leadOffScanDwell_sec);
+          break;
+      }
+      continue;
+    }
     switch (inChar)
     {
       //turn channels on and off
@@ -345,6 +580,58 @@ void serialEvent(){            // send an 'x' on the serial line to trigger ADSt
         startBecauseOfSerial = is_running;
         if (is_running) Serial.println(F("Arduino: Starting binary 4-chan..."));
         break;
+      case 'c':
+        toggleRunState(OUTPUT_BINARY_PACKED);
+        startBecauseOfSerial = is_running;
+        if (is_running) Serial.println(F("Arduino: Starting packed binary..."));
+        break;
+      case 'd':
+        toggleRunState(OUTPUT_BINARY_DELTA);
+        startBecauseOfSerial = is_running;
+        if (is_running) Serial.println(F("Arduino: Starting delta-compressed binary..."));
+        break;
+      case 'm':
+        toggleRunState(OUTPUT_BINARY_BATCH);
+        startBecauseOfSerial = is_running;
+        if (is_running) Serial.println(F("Arduino: Starting batched binary..."));
+        break;
+      case 'k':
+        toggleRunState(OUTPUT_BINARY_COBS);
+        startBecauseOfSerial = is_running;
+        if (is_running) Serial.println(F("Arduino: Starting COBS-framed binary..."));
+        break;
+      case 'j':
+        toggleRunState(OUTPUT_BINARY_BANDPOWER);
+        startBecauseOfSerial = is_running;
+        if (is_running) Serial.println(F("Arduino: Starting band power..."));
+        break;
+      case 'z':
+        toggleRunState(OUTPUT_BINARY_IMPEDANCE);
+        startBecauseOfSerial = is_running;
+        if (is_running) Serial.println(F("Arduino: Starting impedance..."));
+        break;
+      case 'l':
+        //impedance packets along with the data, or not
+        sendImpedanceWithData = !sendImpedanceWithData;
+        ADSManager.flushTX();  //don't put the text in the middle of a packet
+        if (sendImpedanceWithData && is_running && !setupImpedance()) sendImpedanceWithData = false;
+        Serial.println(sendImpedanceWithData ? F("Arduino: sending impedance with the data") : F("Arduino: not sending impedance with the data"));
+        break;
+      case '.':
+        //the background impedance scan, or not
+        useLeadOffScan = !useLeadOffScan;
+        ADSManager.flushTX();  //don't put the text in the middle of a packet
+        if (!useLeadOffScan) {
+          leadOffScan.stop();
+        } else if (is_running && !startLeadOffScan()) {
+          useLeadOffScan = false;
+        }
+        Serial.println(useLeadOffScan ? F("Arduino: scanning the impedance") : F("Arduino: not scanning the impedance"));
+        break;
+      case ',':
+        //the next character says how long the scan stays on each channel
+        commandPrefix = inChar;
+        break;
      case 's':
         stopRunning();
         startBecauseOfSerial = is_running;
@@ -362,16 +649,103 @@ void serialEvent(){            // send an 'x' on the serial line to trigger ADSt
         useFilters = false;
         Serial.println(F("Arduino: disabling filters"));
         break;
+     case ';':
+        //the next character says which sample rate to use
+        commandPrefix = inChar;
+        break;
+     case ':':
+     case '/':
+        //the next character says which filter band or notch preset to use
+        commandPrefix = inChar;
+        break;
      case '?':
         //print state of all registers
         ADSManager.printAllRegisters();
         break;
+     case 'o':
+        //report how well loop() is keeping up with the DRDY interrupt and the serial port
+        ADSManager.flushTX();  //don't put the text in the middle of a packet
+        Serial.print(F("Arduino: samples dropped = ")); Serial.print(ADSManager.getRingOverruns());
+        Serial.print(F(", peak samples waiting = ")); Serial.println(ADSManager.getRingPeakDepth());
+        Serial.print(F("Arduino: serial stalls = ")); Serial.print(ADSManager.getTXStalls());
+        Serial.print(F(", peak bytes queued = ")); Serial.println(ADSManager.getTXPeakDepth());
+        break;
+     case 'P':
+        //report the timing of each stage of the loop
+        if (isStreamingBinary()) {
+          profileReportNext = 0;  //as packets, a stage after each sample
+        } else {
+          printStageProfile();
+        }
+        break;
       default:
         break;
     }
   }
 }
 
+void collectCommandFrame(byte inByte)
+{
+  cmdFrame[cmdFrameBytes++] = inByte;
+  int payloadBytes = cmdFrame[0];
+  if ((payloadBytes < 1) || (payloadBytes > CMD_MAX_PAYLOAD)) {
+    //can't be a real command
+    cmdFrameBytes = -1;
+    sendCommandStatus(0,CMD_STATUS_BAD_COMMAND);
+    return;
+  }
+  if (cmdFrameBytes < 1 + payloadBytes + 2) return;  //wait for the rest
+  
+  //the whole frame is here
+  cmdFrameBytes = -1;
+  byte *payload = cmdFrame+1;
+  unsigned int crc = (((unsigned int)payload[payloadBytes]) << 8) | payload[payloadBytes+1];
+  if (crc != ADSManager.computeCRC16(payload,payloadBytes)) {
+    sendCommandStatus(payload[0],CMD_STATUS_BAD_CRC);
+    return;
+  }
+  
+  switch (payload[0]) {
+    case CMD_CONFIGURE_CHANNELS:
+      if ((payloadBytes >= 3) && (payloadBytes == 3 + 3*payload[2])) {
+        //the per-channel settings are laid out just like ADS1299ChannelConfig
+        ADSManager.configureChannels((ADS1299ChannelConfig *)(payload+3),payload[2],(payload[1] != 0));
+        sendCommandStatus(payload[0],CMD_STATUS_OK);
+      } else {
+        sendCommandStatus(payload[0],CMD_STATUS_BAD_COMMAND);
+      }
+      break;
+    case CMD_SET_FILTER_PRESET:
+      //band preset, then notch preset (see FilterCoefficients.h)
+      if ((payloadBytes == 3) && setFilterPreset(payload[1],payload[2])) {
+        sendCommandStatus(payload[0],CMD_STATUS_OK);
+      } else {
+        sendCommandStatus(payload[0],CMD_STATUS_BAD_COMMAND);
+      }
+      break;
+    default:
+      sendCommandStatus(payload[0],CMD_STATUS_BAD_COMMAND);
+  }
+}
+
+void sendCommandStatus(byte command, byte status)
+{
+  byte reply[2 + (MAX_N_CHANNELS+7)/8];
+  reply[0] = command;
+  reply[1] = status;
+  for (int Ibyte=2; Ibyte < (int)sizeof(reply); Ibyte++) reply[Ibyte] = 0;
+  for (int Ichan=0; Ichan < MAX_N_CHANNELS; Ichan++) {
+    if (ADSManager.isChannelActive(Ichan+1)) bitSet(reply[2 + Ichan/8],Ichan % 8);
+  }
+  ADSManager.writeStatusPacket(reply,sizeof(reply));
+}
+
+//is a binary format going out right now?  Then any text would land in the middle of it.
+boolean isStreamingBinary(void)
+{
+  return is_running && (outputType != OUTPUT_TEXT) && (outputType != OUTPUT_NOTHING);
+}
+
 boolean toggleRunState(int OUT_TYPE)
 {
   if (is_running) {
@@ -382,13 +756,20 @@ boolean toggleRunState(int OUT_TYPE)
 }
 
 boolean stopRunning(void) {
+  while (profileReportNext >= 0) sendStageProfile();  //finish the report while the PC is still reading packets
   ADSManager.stop();                    // stop the data acquisition
+  leadOffScan.stop();                   // startRunning() starts it over
   is_running = false;
   return is_running;
 }
 
 boolean startRunning(int OUT_TYPE) {
-    outputType = OUT_TYPE;
+    outputType = fitOutputTypeToSerialLink(OUT_TYPE);
+    ADSManager.setCOBSFraming(outputType == OUTPUT_BINARY_COBS);  //the PC only splits the stream at the zeros then, so everything needs that framing
+    if ((outputType == OUTPUT_BINARY_BANDPOWER) && !setupBandPower()) outputType = OUTPUT_NOTHING;
+    if ((outputType == OUTPUT_BINARY_IMPEDANCE) && !setupImpedance()) outputType = OUTPUT_NOTHING;
+    if (sendImpedanceWithData && (outputType != OUTPUT_BINARY_IMPEDANCE) && !setupImpedance()) sendImpedanceWithData = false;
+    if (useLeadOffScan && !startLeadOffScan()) useLeadOffScan = false;
     ADSManager.start();    //start the data acquisition
     is_running = true;
     return is_running;
@@ -399,22 +780,25 @@ int changeChannelState_maintainRunningState(int chan, int start)
   boolean is_running_when_called = is_running;
   int cur_outputType = outputType;
   
-  //must stop running to change channel settings
-  stopRunning();
+  //must stop running to change channel settings...unless the ADSManager can do it between samples
+  boolean must_stop = !ADSManager.isHotReconfig();
+  if (must_stop) stopRunning();
+  boolean quiet = isStreamingBinary();  //still streaming, so answer with a status packet, not text
+  if (!quiet) ADSManager.flushTX();  //don't put the text in the middle of a packet
   if (start == true) {
-    Serial.print(F("Activating channel "));
-    Serial.println(chan);
+    if (!quiet) { Serial.print(F("Activating channel ")); Serial.println(chan); }
     ADSManager.activateChannel(chan,gainCode,inputType);
   } else {
-    Serial.print(F("Deactivating channel "));
-    Serial.println(chan);
+    if (!quiet) { Serial.print(F("Deactivating channel ")); Serial.println(chan); }
     ADSManager.deactivateChannel(chan);
   }
+  if (quiet) sendCommandStatus(CMD_CHANNEL_STATE,CMD_STATUS_OK);
   
   //restart, if it was running before
-  if (is_running_when_called == true) {
+  if (must_stop && (is_running_when_called == true)) {
     startRunning(cur_outputType);
   }
+  return is_running;
 }
 
 int changeChannelLeadOffDetection_maintainRunningState(int chan, int start, int code_P_N_Both)
@@ -422,59 +806,280 @@ int changeChannelLeadOffDetection_maintainRunningState(int chan, int start, int
   boolean is_running_when_called = is_running;
   int cur_outputType = outputType;
   
-  //must stop running to change channel settings
-  stopRunning();
-  if (start == true) {
-    Serial.print(F("Activating channel "));
+  //must stop running to change channel settings...unless the ADSManager can do it between samples
+  boolean must_stop = !ADSManager.isHotReconfig();
+  if (must_stop) stopRunning();
+  boolean quiet = isStreamingBinary();  //still streaming, so answer with a status packet, not text
+  if (!quiet) {
+    ADSManager.flushTX();  //don't put the text in the middle of a packet
+    Serial.print((start == true) ? F("Activating channel ") : F("Deactivating channel "));
     Serial.print(chan);
     Serial.println(F(" Lead-Off Detection"));
-    ADSManager.changeChannelLeadOffDetection(chan,ON,code_P_N_Both);
-  } else {
-    Serial.print(F("Deactivating channel "));
-    Serial.print(chan);
-    Serial.println(F(" Lead-Off Detection"));
-    ADSManager.changeChannelLeadOffDetection(chan,OFF,code_P_N_Both);
   }
+  ADSManager.changeChannelLeadOffDetection(chan,(start == true) ? ON : OFF,code_P_N_Both);
+  if (quiet) sendCommandStatus(CMD_CHANNEL_LEADOFF,CMD_STATUS_OK);
   
   //restart, if it was running before
-  if (is_running_when_called == true) {
+  if (must_stop && (is_running_when_called == true)) {
     startRunning(cur_outputType);
   }
+  return is_running;
 }
 
 
-int activateAllChannelsToTestCondition(int testInputCode, byte amplitudeCode, byte freqCode)
+//pick the band power bins for the current sample rate, and start a new block
+boolean setupBandPower(void)
+{
+  int blockLen = (int)(sampleRate_Hz / BAND_POWER_UPDATE_HZ + 0.5);
+  if (bandPower.setup(sampleRate_Hz,blockLen)) return true;
+  Serial.println(F("Arduino: band power needs more bins (or RAM) than it has.  Not sending anything."));
+  return false;
+}
+
+//set the lock-in to the lead-off frequency and the current sample rate, and start a new block
+boolean setupImpedance(void)
+{
+  if (impedance.setup(sampleRate_Hz,ADSManager.getLeadOffFrequency_Hz(),IMPEDANCE_UPDATE_HZ)) return true;
+  Serial.println(F("Arduino: impedance needs AC lead-off (or more RAM).  Not sending it."));
+  return false;
+}
+
+//start the background impedance scan over, from the first channel that's on
+boolean startLeadOffScan(void)
+{
+  if (!setupImpedance()) return false;
+  if (leadOffScan.start(MAX_N_CHANNELS,LEADOFF_SCAN_SIDE,leadOffScanDwell_sec)) return true;
+  Serial.println(F("Arduino: no channels are on to scan."));
+  return false;
+}
+
+//the binary formats whose packets say what kind of packet they are (with a PCKT_START
+//byte, or inside the COBS framing), so that the PC can pick other packets (markers,
+//impedance) out from between them
+boolean isFramedBinaryOutput(int OUT_TYPE)
+{
+  switch (OUT_TYPE) {
+    case OUTPUT_BINARY: case OUTPUT_BINARY_WITH_AUX: case OUTPUT_BINARY_4CHAN:
+    case OUTPUT_BINARY_PACKED: case OUTPUT_BINARY_DELTA: case OUTPUT_BINARY_BATCH:
+    case OUTPUT_BINARY_COBS: case OUTPUT_BINARY_BANDPOWER: case OUTPUT_BINARY_IMPEDANCE:
+      return true;
+    default:
+      return false;  //text and OpenEEG have no place for them
+  }
+}
+
+//make sure that the chosen output will fit through the serial link at the current sample
+//rate.  If it won't, fall back to sending fewer channels.
+int fitOutputTypeToSerialLink(int OUT_TYPE)
+{
+  int packetBytes;
+  switch (OUT_TYPE) {
+    case OUTPUT_BINARY: case OUTPUT_BINARY_SYNTHETIC:
+      packetBytes = ADSManager.getBinaryPacketBytes(MAX_N_CHANNELS,false); break;
+    case OUTPUT_BINARY_WITH_AUX:
+      packetBytes = ADSManager.getBinaryPacketBytes(MAX_N_CHANNELS,true); break;
+    case OUTPUT_BINARY_PACKED:
+      packetBytes = ADSManager.getPackedBinaryPacketBytes(MAX_N_CHANNELS); break;
+    case OUTPUT_BINARY_BATCH:
+      //the bytes for each sample, on average
+      packetBytes = (ADSManager.getBatchPacketBytes(MAX_N_CHANNELS) + ADSManager.getBatchSize(MAX_N_CHANNELS) - 1) / ADSManager.getBatchSize(MAX_N_CHANNELS); break;
+    case OUTPUT_BINARY_COBS:
+      packetBytes = ADSManager.getCOBSPacketBytes(MAX_N_CHANNELS); break;
+    case OUTPUT_BINARY_DELTA:
+      return OUT_TYPE;  //the packets change size with the data, so we can't tell ahead of time
+    default:
+      return OUT_TYPE;  //the other formats are either small or just for humans
+  }
+  if (ADSManager.isStreamSustainable(serialBaud,packetBytes)) return OUT_TYPE;
+  
+  Serial.print(F("Arduino: too much data for the serial link at "));Serial.print(sampleRate_Hz);
+  if ((OUT_TYPE != OUTPUT_BINARY_PACKED) && (ADSManager.isStreamSustainable(serialBaud,ADSManager.getPackedBinaryPacketBytes(MAX_N_CHANNELS)))) {
+    Serial.println(F(" Hz.  Sending packed binary instead."));
+    return OUTPUT_BINARY_PACKED;
+  }
+  if (ADSManager.isStreamSustainable(serialBaud,ADSManager.getBinaryPacketBytes(4,false))) {
+    Serial.println(F(" Hz.  Sending 4 channels instead."));
+    return OUTPUT_BINARY_4CHAN;
+  }
+  Serial.println(F(" Hz.  Not sending anything.  Lower the sample rate."));
+  return OUTPUT_NOTHING;
+}
+
+//change the ADS1299's sample rate and redesign the filters to match
+int changeSampleRate_maintainRunningState(byte rateCode)
 {
   boolean is_running_when_called = is_running;
   int cur_outputType = outputType;
   
+  stopRunning();
+  ADSManager.setSampleRate(rateCode);
+  sampleRate_Hz = ADSManager.getSampleRate_Hz();
+  Serial.print(F("Arduino: sample rate is now ")); Serial.print(sampleRate_Hz); Serial.println(F(" Hz"));
+  
+  //the filters are designed in terms of the sample rate
+  designFilters(false);
+  
+  //restart, if it was running before
+  if (is_running_when_called == true) {
+    startRunning(cur_outputType);
+  }
+  return is_running;
+}
+
+int activateAllChannelsToTestCondition(int testInputCode, byte amplitudeCode, byte freqCode)
+{
+  //stage all of the changes so that they go to the ADS in one burst.  No need to
+  //stop running; the ADSManager pauses the data just long enough to send them.
+  ADSManager.beginConfig();
+  
   //set the test signal to the desired state
   ADSManager.configureInternalTestSignal(amplitudeCode,freqCode);
-  
-  //must stop running to change channel settings
-  stopRunning();
     
   //loop over all channels to change their state
   for (int Ichan=1; Ichan <= 8; Ichan++) {
     ADSManager.activateChannel(Ichan,gainCode,testInputCode);  //Ichan must be [1 8]...it does not start counting from zero
   }
-      
-  //restart, if it was running before
-  if (is_running_when_called == true) {
-    startRunning(cur_outputType);
+  
+  ADSManager.commit();
+  return is_running;
+}
+
+#if FIXED_POINT_FILTERS
+//get the coefficients of all of the stages for the current presets and sample rate
+void getPresetCoefficients(BiquadCoeffQ30 *coeff)
+{
+  byte rateCode = ADSManager.getSampleRateCode();  //the tables have a row for each rate
+  if (rateCode > ADS_RATE_250HZ) rateCode = ADS_RATE_250HZ;
+#if PRECOMPUTED_FILTERS
+  memcpy_P(&coeff[FILTER_STAGE_HIGHPASS],&bandPreset_coeff_P[bandPreset][rateCode][0],2*sizeof(BiquadCoeffQ30));  //highpass and lowpass
+#if !LINE_NOISE_CANCELLER
+  memcpy_P(&coeff[FILTER_STAGE_NOTCH1],&notchPreset_coeff_P[notchPreset][rateCode],sizeof(BiquadCoeffQ30));
+  coeff[FILTER_STAGE_NOTCH2] = coeff[FILTER_STAGE_NOTCH1];  //the notch is applied twice
+#endif
+#else
+  const BiquadCoeffQ30 passThrough = { (1L << BQ_Q30_FRAC_BITS), 0, 0, 0, 0 };
+  BandPresetDesign design;
+  memcpy_P(&design,&bandPresetDesign_P[bandPreset],sizeof(BandPresetDesign));
+  Biquad_multiChan_fixed::calcCoefficientsQ30(bq_type_highpass,design.hp_Hz / sampleRate_Hz,design.hp_Q,FILTER_PEAK_GAIN_DB,&coeff[FILTER_STAGE_HIGHPASS]);
+  coeff[FILTER_STAGE_LOWPASS] = passThrough;
+  if (design.lp_Hz > 0.0) Biquad_multiChan_fixed::calcCoefficientsQ30(bq_type_lowpass,design.lp_Hz / sampleRate_Hz,BANDPASS_Q,FILTER_PEAK_GAIN_DB,&coeff[FILTER_STAGE_LOWPASS]);
+#if !LINE_NOISE_CANCELLER
+  float notch_Hz = pgm_read_float(&notchPresetDesign_Hz_P[notchPreset]);
+  coeff[FILTER_STAGE_NOTCH1] = passThrough;
+  if (notch_Hz > 0.0) Biquad_multiChan_fixed::calcCoefficientsQ30(bq_type_notch,notch_Hz / sampleRate_Hz,NOTCH_PRESET_Q,NOTCH_PEAK_GAIN_DB,&coeff[FILTER_STAGE_NOTCH1]);
+  coeff[FILTER_STAGE_NOTCH2] = coeff[FILTER_STAGE_NOTCH1];  //the notch is applied twice
+#endif
+#endif
+}
+#endif
+
+//(re)design the filters for the current sample rate.  With glide, the filters move over to
+//the new coefficients in small steps while they keep running (see Biquad_cascade_fixed.h),
+//so that changing the preset mid-stream doesn't put a step or a ring into the data.  A new
+//sample rate is a break in the data anyway, so that one can switch right away.
+void designFilters(boolean glide)
+{
+#if FIXED_POINT_FILTERS
+  BiquadCoeffQ30 coeff[N_FILTER_STAGES];
+  getPresetCoefficients(coeff);
+  for (int Istage=0; Istage < N_FILTER_STAGES; Istage++) eeg_filters.setStage(Istage,&coeff[Istage],glide);
+#if LINE_NOISE_CANCELLER
+  //the canceller just needs the line frequency.  Its weights carry on from where they were.
+  lineCanceller.setFrequency(pgm_read_float(&notchPresetDesign_Hz_P[notchPreset]) / sampleRate_Hz);
+#endif
+#else
+  stopDC_filter.setFc(HP_CUTOFF_HZ / sampleRate_Hz);
+  notch_filter1.setFc(NOTCH_FREQ_HZ / sampleRate_Hz);
+  notch_filter2.setFc(NOTCH_FREQ_HZ / sampleRate_Hz);
+#endif
+}
+
+#if FIXED_POINT_FILTERS
+//pick new presets.  Returns false if there's no such preset.
+boolean setFilterPreset(byte band, byte notch)
+{
+  if ((band >= N_BAND_PRESETS) || (notch >= N_NOTCH_PRESETS)) return false;
+  bandPreset = band;
+  notchPreset = notch;
+  designFilters(true);
+  return true;
+}
+byte getBandPreset(void)
+{
+  return bandPreset;
+}
+byte getNotchPreset(void)
+{
+  return notchPreset;
+}
+
+void printFilterPreset(void)
+{
+  BandPresetDesign design;
+  memcpy_P(&design,&bandPresetDesign_P[bandPreset],sizeof(BandPresetDesign));
+  float notch_Hz = pgm_read_float(&notchPresetDesign_Hz_P[notchPreset]);
+  ADSManager.flushTX();  //don't put the text in the middle of a packet
+  if (design.lp_Hz > 0.0) {
+    Serial.print(F("Arduino: filters are now bandpass ")); Serial.print(design.hp_Hz,1);
+    Serial.print('-'); Serial.print(design.lp_Hz,1);
+  } else {
+    Serial.print(F("Arduino: filters are now highpass ")); Serial.print(design.hp_Hz,1);
+  }
+  if (notch_Hz > 0.0) {
+    Serial.print(LINE_NOISE_CANCELLER ? F(" Hz, cancelling ") : F(" Hz, notch ")); Serial.print(notch_Hz,0); Serial.println(F(" Hz"));
+  } else {
+    Serial.println(LINE_NOISE_CANCELLER ? F(" Hz, no line noise canceller") : F(" Hz, no notch"));
   }
 }
+#else
+//the floating-point filters are fixed at the highpass and notch above
+boolean setFilterPreset(byte band, byte notch)
+{
+  ADSManager.flushTX();
+  Serial.println(F("Arduino: the filter presets need FIXED_POINT_FILTERS"));
+  return false;
+}
+byte getBandPreset(void)
+{
+  return 0;
+}
+byte getNotchPreset(void)
+{
+  return 0;
+}
+void printFilterPreset(void)
+{
+}
+#endif
+
+//forget the filter history for one channel
+void resetFilterChannel(int Ichan)
+{
+#if FIXED_POINT_FILTERS
+  eeg_filters.resetChannel(Ichan);
+#if LINE_NOISE_CANCELLER
+  lineCanceller.resetChannel(Ichan);
+#endif
+#else
+  stopDC_filter.resetChannel(Ichan);
+  notch_filter1.resetChannel(Ichan);
+  notch_filter2.resetChannel(Ichan);
+#endif
+}
 
+#if FIXED_POINT_FILTERS
+int applyFilters(void) {
+  //integer math all the way through, all channels at once (see Biquad_cascade_fixed.h)
+  eeg_filters.process(ADSManager.channelData);
+#if LINE_NOISE_CANCELLER
+  lineCanceller.process(ADSManager.channelData);  //after the highpass, so it doesn't see the DC offset
+#endif
+  return 0;
+}
+#else
 long int runningAve[MAX_N_CHANNELS];
 int applyFilters(void) {
-  //scale factor for these coefficients was 32768 = 2^15
-  const static long int a0 = 32360L; //16 bit shift?
-  const static long int a1 = -2L*a0;
-  const static long int a2 = a0;
-  const static long int b1 = -64718L; //this is a shift of 17 bits!
-  const static long int b2 = 31955L;
-  static long int z1[MAX_N_CHANNELS], z2[MAX_N_CHANNELS];
-  long int val_int, val_in_down9, val_out, val_out_down9;
+  long int val_int;
   float val;
   for (int Ichan=0; Ichan < MAX_N_CHANNELS; Ichan++) {
     switch (1) {
@@ -491,14 +1096,6 @@ int applyFilters(void) {
         runningAve[Ichan]=( ((128-1)*(runningAve[Ichan]>>1)) + (val_int>>1) )>>6;  // fs/2.0Hz = ~128 points...7 bits
         val = (float)(val_int - runningAve[Ichan]);  //remove the DC
         break;
-//      case 3:
-//        val_in_down9 = ADSManager.channelData[Ichan] >> 9; //get the stored value for this sample...bring 24-bit value down to 16-bit
-//        val_out = (val_in_down9 * a0  + (z1[Ichan]>>9)) >> (16-9);  //8bits were already removed...results in 24-bit value
-//        val_out_down9 = val_out >> 9;  //remove eight bits to go from 24-bit down to 16 bit
-//        z1[Ichan] = (val_in_down9 * a1 + (z2[Ichan] >> 9) - b1 * val_out_down9  ) >> (16-9);  //8-bits were pre-removed..end in 24 bit number
-//        z2[Ichan] = (val_in_down9 * a2  - b2 * val_out_down9) >> (16-9); //8-bits were pre-removed...end in 24-bit number
-//        val = (float)val_out;
-//        break;
     }
     val = notch_filter1.process(val,Ichan);     //apply 60Hz notch filter
     val = notch_filter2.process(val,Ichan);     //apply it again
@@ -506,6 +1103,28 @@ int applyFilters(void) {
   }
   return 0;
 }
+#endif
+
+//the ADS was reconfigured just before the current sample
+void handleDiscontinuity(void)
+{
+  //the filters' history doesn't apply to the channels that changed.  The channel settings
+  //are shared by all of the daisy-chained boards, so channel 1 is also channel 9, etc.
+  if (resetFiltersOnReconfig) {
+    byte changed = ADSManager.getDiscontinuityChannels();
+    for (int Ichan=0; Ichan < MAX_N_CHANNELS; Ichan++) {
+      if (bitRead(changed,Ichan % N_CHANNELS_PER_OPENBCI)) resetFilterChannel(Ichan);
+    }
+  }
+  
+  //the blocks so far are from before the change.  A change to just the lead-off (like each
+  //step of the impedance scan) doesn't touch any channel's data, so the band power goes on.
+  if (ADSManager.getDiscontinuityChannels() != 0) bandPower.restart();
+  impedance.restart();
+  
+  //mark it in the stream, for the formats that can carry the marker
+  if (isFramedBinaryOutput(outputType)) ADSManager.writeDiscontinuityMarker(sampleCounter);
+}
 
 int freeRam() 
 {
@@ -514,4 +1133,56 @@ int freeRam()
   return (int) &v - (__brkval == 0 ? (int) &__heap_start : (int) __brkval); 
 }
 
-
+
+
+//print the timing of each stage of the loop since the last report, then start over
+void printStageProfile(void)
+{
+  ADSManager.flushTX();  //don't put the text in the middle of a packet
+#if ADS_PROFILE
+  float period_us = 1.0e6 / sampleRate_Hz;
+  Serial.print(F("Arduino: stage timing.  Sample period = ")); Serial.print(period_us,0);
+  Serial.print(F(" usec, filters ")); Serial.println(useFilters ? F("on") : F("off"));
+  ADS1299Profiler<1> isrProfile;
+  ADSManager.getISRProfile(&isrProfile,true);
+  isrProfile.printStage(F("DRDY interrupt"),0,period_us);
+  stageProfile.printStage(F("read"),STAGE_READ,period_us);
+  stageProfile.printStage(F("aux"),STAGE_AUX,period_us);
+  stageProfile.printStage(F("filter"),STAGE_FILTER,period_us);
+  stageProfile.printStage(F("encode"),STAGE_ENCODE,period_us);
+  stageProfile.printStage(F("total per sample"),STAGE_TOTAL,period_us);
+  stageProfile.printStage(F("serviceTX"),STAGE_SERIAL,period_us);
+  stageProfile.reset();
+#else
+  Serial.println(F("Arduino: stage timing is off.  Set ADS_PROFILE to 1 in ADS1299Manager.h"));
+#endif
+}
+
+//send the next stage of the timing report as a status packet: CMD_PROFILE_REPORT,
+//CMD_STATUS_OK, the stage (STAGE_READ through STAGE_SERIAL, then N_STAGES for the DRDY
+//interrupt), and the stage packed by ADS1299Profiler::packStage().  After the last one,
+//the timing starts over, as it does after the printed report.
+void sendStageProfile(void)
+{
+#if ADS_PROFILE
+  byte reply[3 + ADS_PROFILE_PACKED_BYTES];
+  reply[0] = CMD_PROFILE_REPORT;
+  reply[1] = CMD_STATUS_OK;
+  reply[2] = (byte)profileReportNext;
+  if (profileReportNext < N_STAGES) {
+    stageProfile.packStage(profileReportNext,reply+3);
+  } else {
+    ADS1299Profiler<1> isrProfile;
+    ADSManager.getISRProfile(&isrProfile,true);
+    isrProfile.packStage(0,reply+3);
+  }
+  ADSManager.writeStatusPacket(reply,sizeof(reply));
+  if (++profileReportNext > N_STAGES) {
+    stageProfile.reset();
+    profileReportNext = -1;
+  }
+#else
+  sendCommandStatus(CMD_PROFILE_REPORT,CMD_STATUS_BAD_COMMAND);  //there's no timing to report
+  profileReportNext = -1;
+#endif
+}
@@ -0,0 +1,83 @@
+//
+//  HostSignals.h
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  Test data for the benchmarks: synthetic EEG, as counts out of the ADS1299 at gain 24,
+//  and recordings made by the Processing GUI (OpenBCI_GUI's "openBCI_raw_..." files).
+//
+//  The synthetic EEG, for each channel, is the electrode's DC offset, background EEG
+//  (1/f, made from white noise through a few leaky integrators), an alpha rhythm that
+//  comes and goes, a little mains interference, and the amplifier's own white noise.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#ifndef ____HostSignals__
+#define ____HostSignals__
+
+#include <vector>
+#include <random>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <math.h>
+
+#define HOST_COUNTS_PER_VOLT (24.0 / 4.5 * 8388607.0)   //gain 24, 4.5 V reference
+
+typedef std::vector<std::vector<long> > HostRecording;  //[sample][channel], in counts
+
+inline HostRecording makeSyntheticEEG(int nChan, int nSamples, double fs_Hz, unsigned int seed = 1)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> gauss(0.0, 1.0);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    const double pi = 3.14159265358979;
+    HostRecording data(nSamples, std::vector<long>(nChan));
+    for (int chan=0; chan < nChan; chan++) {
+        double dc_V = 20.0e-3 * uniform(rng);                 //electrode offset
+        double alpha_V = 10.0e-6 * (1.0 + 0.5 * uniform(rng));
+        double alpha_Hz = 10.0 + uniform(rng);
+        double mains_V = 3.0e-6 * (1.0 + uniform(rng));
+        double state[3] = { 0.0, 0.0, 0.0 };                 //the 1/f noise: three leaky integrators
+        const double pole[3] = { 0.999, 0.98, 0.7 };
+        const double weight[3] = { 0.3e-6, 1.0e-6, 3.0e-6 };
+        for (int i=0; i < nSamples; i++) {
+            double t = i / fs_Hz;
+            double pink = 0.0;
+            for (int k=0; k < 3; k++) {
+                state[k] = pole[k] * state[k] + sqrt(1.0 - pole[k]*pole[k]) * gauss(rng);
+                pink += weight[k] * state[k];
+            }
+            double alphaEnvelope = 0.5 * (1.0 + sin(2.0*pi*0.1*t + chan));
+            double volts = dc_V + pink
+                + alpha_V * alphaEnvelope * sin(2.0*pi*alpha_Hz*t)
+                + mains_V * sin(2.0*pi*60.0*t + 0.3*chan)
+                + 0.5e-6 * gauss(rng);
+            data[i][chan] = lround(volts * HOST_COUNTS_PER_VOLT);
+        }
+    }
+    return data;
+}
+
+//A recording from the Processing GUI: lines of "sampleIndex, chan1_uV, chan2_uV, ...",
+//with '%' starting a comment.  Returns it in counts, or nothing if the file can't be read.
+inline HostRecording readGUIRecording(const char *fname, int maxChan)
+{
+    HostRecording data;
+    std::ifstream file(fname);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || (line[0] == '%')) continue;
+        std::stringstream ss(line);
+        std::string field;
+        std::vector<long> row;
+        std::getline(ss, field, ',');   //the sample index
+        while (std::getline(ss, field, ',') && ((int)row.size() < maxChan)) {
+            row.push_back(lround(atof(field.c_str()) * 1.0e-6 * HOST_COUNTS_PER_VOLT));
+        }
+        if (!row.empty() && (data.empty() || (row.size() == data[0].size()))) data.push_back(row);
+    }
+    return data;
+}
+
+#endif
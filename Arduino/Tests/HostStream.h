@@ -0,0 +1,39 @@
+//
+//  HostStream.h
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  The StreamRawData sketch's acquisition loop, for the tests that look at what goes out
+//  of the Serial port: wait for DRDY, read the sample, hand it to one of the writers,
+//  and keep the transmit buffers moving.  Polling mode, as in the sketch's default.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#ifndef ____HostStream__
+#define ____HostStream__
+
+#include "HostTest.h"
+#include <ADS1299Manager.h>
+
+//Stream for this long (simulated), calling write(sampleNumber) for each sample.  Returns
+//how many samples were written.  The data is stopped (and the transmit queue flushed) at the end.
+template <class WRITER> long hostStream(ADS1299Manager &ADS, double seconds, WRITER write)
+{
+    long sampleNumber = 0;
+    uint64_t end_ns = hostNanos() + (uint64_t)(seconds * 1.0e9);
+    ADS.start();
+    while (hostNanos() < end_ns) {
+        ADS.serviceTX();
+        if (!ADS.isDataAvailable()) {
+            delayMicroseconds(10);   //poll less often than the Uno would, so that the simulation runs quickly
+            continue;
+        }
+        ADS.updateChannelData();
+        sampleNumber++;
+        write(sampleNumber);
+    }
+    ADS.stop();
+    return sampleNumber;
+}
+
+#endif
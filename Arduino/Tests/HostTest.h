@@ -0,0 +1,67 @@
+//
+//  HostTest.h
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  The few things that every test and benchmark here needs.  A test is a program that
+//  returns 0 when everything passed.  CHECK() prints what failed and carries on, so
+//  that one run shows every problem.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#ifndef ____HostTest__
+#define ____HostTest__
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+static int hostTestFailures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        hostTestFailures++; \
+    } } while (0)
+
+#define CHECK_NEAR(a, b, tol) do { \
+    double _a = (double)(a), _b = (double)(b); \
+    if (!(fabs(_a - _b) <= (tol))) { \
+        printf("%s:%d: CHECK_NEAR failed: %s = %g, %s = %g (tolerance %g)\n", \
+            __FILE__, __LINE__, #a, _a, #b, _b, (double)(tol)); \
+        hostTestFailures++; \
+    } } while (0)
+
+//what main() returns
+inline int hostTestResult(const char *name)
+{
+    if (hostTestFailures == 0) printf("%s: passed\n", name);
+    else printf("%s: %d failed\n", name, hostTestFailures);
+    return (hostTestFailures == 0) ? 0 : 1;
+}
+
+//The benchmarks run a short version under ctest.  Give them "long" on the command line
+//(or set HOST_BENCH_LONG) for numbers worth quoting.
+inline long hostBenchScale(int argc, char **argv)
+{
+    if ((argc > 1) && (strcmp(argv[1], "long") == 0)) return 100;
+    if (getenv("HOST_BENCH_LONG") != NULL) return 100;
+    return 1;
+}
+
+//wall-clock time on the PC, for the benchmarks that time the host itself
+inline double hostWallSeconds(void)
+{
+    using namespace std::chrono;
+    return duration_cast<duration<double> >(steady_clock::now().time_since_epoch()).count();
+}
+
+//keep the compiler from throwing away work whose result isn't otherwise used
+template <class T> inline void hostKeep(const T &value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+#endif
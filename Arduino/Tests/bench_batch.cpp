@@ -0,0 +1,111 @@
+//
+//  bench_batch.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  Batched packets (writeChannelDataAsBatch) with K = 1, 4, 8, and 16 samples per
+//  packet, against one packed packet per sample: the bytes of framing per sample, the
+//  calls to Serial.write() per sample, and how long the writer takes per sample on this
+//  PC.  Every sample has to come back out of the PC's parser as it went in, with the
+//  right sample number, including around a gap in the sample numbers (which sends the
+//  batch early).
+//
+//  The library is built here with a batch buffer big enough for 16 samples of 16
+//  channels (ADS_BATCH_BUFFER_BYTES, see CMakeLists.txt), instead of the Uno's default.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include "HostSignals.h"
+#include "PacketParser.h"
+#include <ADS1299Manager.h>
+
+static ADS1299Manager ADS;
+
+//write the recording with sample numbers from 1, skipping the ones in gaps
+static void writeAll(const HostRecording &data, int K, long skip)
+{
+    int N = data[0].size();
+    for (size_t i=0; i < data.size(); i++) {
+        long sampleNumber = (long)i + 1;
+        if (sampleNumber == skip) continue;
+        for (int chan=0; chan < N; chan++) ADS.channelData[chan] = data[i][chan];
+        if (K == 0) ADS.writeChannelDataAsPackedBinary(N, sampleNumber);
+        else ADS.writeChannelDataAsBatch(N, sampleNumber);
+    }
+    ADS.flushBatch();   //the last few, if they didn't make a whole batch
+    ADS.flushTX();
+}
+
+static int checkDecoded(const HostRecording &data, long skip)
+{
+    PacketParser parser;
+    parser.parse(Serial.sent(), Serial.sentBytes());
+    CHECK(parser.badPackets == 0);
+    size_t expected = data.size() - ((skip > 0) ? 1 : 0);
+    CHECK(parser.samples.size() == expected);
+    int nBad = 0;
+    for (size_t i=0; i < parser.samples.size(); i++) {
+        long n = parser.samples[i].sampleNumber;
+        if ((n < 1) || (n > (long)data.size()) || (n == skip)) { nBad++; continue; }
+        if (parser.samples[i].values != data[n-1]) nBad++;
+    }
+    CHECK(nBad == 0);
+    return nBad;
+}
+
+int main(int argc, char **argv)
+{
+    long reps = 3 * hostBenchScale(argc, argv);
+    ADS1299Sim &chip = ADS1299Sim::chip();
+    hostReset();
+    chip.powerUp(2);
+    ADS.initializeBoards(OPENBCI_V2, 2);
+
+    printf("%-6s %-8s %12s %14s %14s %12s\n", "chans", "K", "bytes/smp", "framing/smp", "writes/smp", "host ns/smp");
+    const int Ks[] = { 0, 1, 4, 8, 16 };   //0 is the packed format, one packet per sample
+    for (int N = 8; N <= 16; N += 8) {
+        HostRecording data = makeSyntheticEEG(N, 2000, 250.0, N);
+        double framing[5];
+        for (int k=0; k < 5; k++) {
+            int K = Ks[k];
+            ADS.setBatchSize(max(K, 1));
+            if (K > 0) CHECK(ADS.getBatchSize(N) == K);
+
+            //it all comes back, in order
+            Serial.begin(0);
+            Serial.clearSent();
+            writeAll(data, K, -1);
+            checkDecoded(data, -1);
+            double bytes = (double)Serial.sentBytes() / data.size();
+            double writes = (double)Serial.getWriteCalls() / data.size();
+            framing[k] = bytes - 3.0*N;
+            if (K > 0) CHECK_NEAR(bytes, (double)ADS.getBatchPacketBytes(N) / K, 1e-9);
+
+            //a gap sends the batch early, and the sample numbers still line up
+            Serial.clearSent();
+            writeAll(data, K, 1003);
+            checkDecoded(data, 1003);
+
+            //time it
+            double best = 1.0e9;
+            for (long r=0; r < reps; r++) {
+                Serial.clearSent();
+                double start = hostWallSeconds();
+                writeAll(data, K, -1);
+                best = min(best, (hostWallSeconds() - start) * 1.0e9 / data.size());
+            }
+            char label[16];
+            if (K == 0) snprintf(label, sizeof(label), "packed");
+            else snprintf(label, sizeof(label), "%d", K);
+            printf("%-6d %-8s %12.2f %14.2f %14.3f %12.0f\n", N, label, bytes, framing[k], writes, best);
+        }
+        //framing per sample: 7 bytes for packed, 8 for K=1, then (8/K)
+        CHECK_NEAR(framing[0], 7.0, 1e-9);
+        CHECK_NEAR(framing[1], 8.0, 1e-9);
+        CHECK_NEAR(framing[3], 1.0, 1e-9);
+        CHECK_NEAR(framing[4], 0.5, 1e-9);
+    }
+
+    return hostTestResult("bench_batch");
+}
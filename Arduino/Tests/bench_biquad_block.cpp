@@ -0,0 +1,81 @@
+//
+//  bench_biquad_block.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  Filtering on the PC side: one biquad (the sketch's 60 Hz notch) over 8, 16, 64, and
+//  256 channels of synthetic EEG, in ns per sample per channel, done four ways:
+//     Biquad:     one Biquad per channel, one process() call per sample
+//     scalar:     Biquad_block, without SIMD (which the compiler may vectorize a little by itself)
+//     SSE2, AVX2: Biquad_block, two and four channels to a register
+//  The data goes through in blocks of 250 samples (a second at the default rate).  All of
+//  them have to give the same answer, to the bit.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include "HostSignals.h"
+#include <Biquad.h>
+#include <Biquad_block.h>
+
+#define FS_HZ (250.0)
+#define BLOCK (250)
+
+int main(int argc, char **argv)
+{
+    long reps = 5 * hostBenchScale(argc, argv);
+    const int Ns[] = { 8, 16, 64, 256 };
+    const double Fc = 60.0 / FS_HZ, Q = 4.0;
+    const int nSamples = 5000;
+
+    printf("%-6s %12s %12s %12s %12s %12s\n", "chans", "Biquad ns", "scalar ns", "SSE2 ns", "AVX2 ns", "speedup");
+    for (int n=0; n < 4; n++) {
+        int N = Ns[n];
+        HostRecording data = makeSyntheticEEG(N, nSamples, FS_HZ, N);
+        std::vector<float> flat(nSamples * N);
+        for (int i=0; i < nSamples; i++) for (int chan=0; chan < N; chan++) flat[i*N + chan] = (float)data[i][chan];
+
+        double best[4] = { 1.0e9, 1.0e9, 1.0e9, 1.0e9 };
+        std::vector<float> outs[4];
+        for (long r=0; r < reps; r++) {
+            //a Biquad per channel, a call per sample
+            {
+                std::vector<Biquad *> filters(N);
+                for (int chan=0; chan < N; chan++) filters[chan] = new Biquad(bq_type_notch, Fc, Q, 0.0);
+                std::vector<float> out(flat);
+                double start = hostWallSeconds();
+                for (int i=0; i < nSamples; i++) {
+                    for (int chan=0; chan < N; chan++) out[i*N + chan] = filters[chan]->process(out[i*N + chan]);
+                }
+                best[0] = min(best[0], (hostWallSeconds() - start) * 1.0e9 / (nSamples * N));
+                for (int chan=0; chan < N; chan++) delete filters[chan];
+                outs[0].swap(out);
+            }
+            //the block filter, with each kernel
+            for (int k = BQ_BLOCK_SCALAR; k <= BQ_BLOCK_AVX2; k++) {
+                if (Biquad_block::setKernel(k) != k) continue;
+                Biquad_block block(N, bq_type_notch, Fc, Q, 0.0);
+                std::vector<float> out(flat);
+                double start = hostWallSeconds();
+                for (int i=0; i < nSamples; i += BLOCK) block.process(&out[i*N], min(BLOCK, nSamples - i));
+                best[1 + k] = min(best[1 + k], (hostWallSeconds() - start) * 1.0e9 / (nSamples * N));
+                outs[1 + k].swap(out);
+            }
+        }
+        Biquad_block::setKernel(BQ_BLOCK_AUTO);
+        int fastest = 1 + Biquad_block::getKernel();
+        printf("%-6d %12.2f %12.2f", N, best[0], best[1]);
+        for (int k = BQ_BLOCK_SSE2; k <= BQ_BLOCK_AVX2; k++) {
+            if (Biquad_block::isKernelSupported(k)) printf(" %12.2f", best[1 + k]);
+            else printf(" %12s", "-");
+        }
+        printf(" %11.2fx\n", best[0] / best[fastest]);
+
+        //the same arithmetic, so the same answer
+        for (int k = BQ_BLOCK_SCALAR; k <= BQ_BLOCK_AVX2; k++) {
+            if (Biquad_block::isKernelSupported(k)) CHECK(outs[1 + k] == outs[0]);
+        }
+    }
+
+    return hostTestResult("bench_biquad_block");
+}
@@ -0,0 +1,118 @@
+//
+//  bench_biquad_static.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  Biquad_multiChan_static against the Biquad_multiChan that it replaces, with the
+//  sketch's 60 Hz notch over 8 and 16 channels of synthetic EEG:
+//     RAM:    what each one takes on this PC (the object, plus what it gets with new[],
+//             which is counted here), and on the Uno, worked out from the same layout
+//             with the Uno's sizes (2-byte int and pointer, 4-byte double, and 2 more
+//             bytes that malloc() keeps in front of every block)
+//     timing: ns per sample per channel on this PC, for Biquad_multiChan (one process()
+//             call per channel, as in the sketch) and for process(sample) on the static
+//             one with float, long, and double samples
+//  The float one has to give the same answer as Biquad_multiChan, to the bit.  The long one
+//  can be 1 count off, since it truncates the filter's double straight to a long, where the
+//  sketch rounds it to a float first.
+//
+//  (There's no flash size here: that needs the AVR compiler.  The template does make a copy
+//  of process() for each channel count and sample type that the sketch uses.)
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include "HostSignals.h"
+#include <Biquad_multiChan.h>
+#include <Biquad_multiChan_static.h>
+#include <new>
+
+#define FS_HZ (250.0)
+
+//count what goes on the heap, so that the RAM numbers below are measured, not guessed
+static long heapBytes = 0;
+void *operator new[](size_t n) { heapBytes += n; void *p = malloc(n); if (p == NULL) throw std::bad_alloc(); return p; }
+void operator delete[](void *p) throw() { free(p); }
+void operator delete[](void *p, size_t) throw() { free(p); }
+
+//the layouts above, with the Uno's sizes
+#define AVR_INT (2)
+#define AVR_PTR (2)
+#define AVR_DOUBLE (4)
+#define AVR_MALLOC_HEADER (2)
+static int avrBytesMultiChan(int N) { return 2*AVR_INT + 8*AVR_DOUBLE + 2*AVR_PTR + 2*(N*AVR_DOUBLE + AVR_MALLOC_HEADER); }
+static int avrBytesStatic(int N) { return AVR_INT + 8*AVR_DOUBLE + 2*N*AVR_DOUBLE; }
+
+//the static filter over the whole recording, a sample at a time.  Returns ns per sample per channel.
+template <int N, typename T>
+static double timeStatic(const std::vector<long> &flat, int nSamples, std::vector<T> &out)
+{
+    Biquad_multiChan_static<N,T> filt(bq_type_notch, 60.0 / FS_HZ, 4.0, 0.0);
+    out.resize(nSamples * N);
+    for (int i=0; i < nSamples * N; i++) out[i] = (T)flat[i];
+    double start = hostWallSeconds();
+    for (int i=0; i < nSamples; i++) filt.process(&out[i*N]);
+    double ns = (hostWallSeconds() - start) * 1.0e9 / (nSamples * N);
+    hostKeep(out[0]);
+    return ns;
+}
+
+template <int N>
+static void runChannels(long reps)
+{
+    const int nSamples = 5000;
+    HostRecording data = makeSyntheticEEG(N, nSamples, FS_HZ, N);
+    std::vector<long> flat(nSamples * N);
+    for (int i=0; i < nSamples; i++) for (int chan=0; chan < N; chan++) flat[i*N + chan] = data[i][chan];
+
+    //RAM
+    long before = heapBytes;
+    Biquad_multiChan *probe = new Biquad_multiChan(N, bq_type_notch, 60.0 / FS_HZ, 4.0, 0.0);
+    long heap = heapBytes - before;
+    delete probe;
+    before = heapBytes;
+    Biquad_multiChan_static<N> probeStatic(bq_type_notch, 60.0 / FS_HZ, 4.0, 0.0);
+    CHECK(heapBytes == before);    //nothing on the heap at all
+    hostKeep(probeStatic);
+    printf("RAM, %2d channels:  Biquad_multiChan %3d + %3ld heap = %3ld bytes (Uno %3d)   static %3d bytes (Uno %3d)\n",
+        N, (int)sizeof(Biquad_multiChan), heap, (long)sizeof(Biquad_multiChan) + heap, avrBytesMultiChan(N),
+        (int)sizeof(Biquad_multiChan_static<N>), avrBytesStatic(N));
+
+    //timing
+    double best[4] = { 1.0e9, 1.0e9, 1.0e9, 1.0e9 };
+    std::vector<float> outMulti(nSamples * N), outFloat;
+    std::vector<long> outSketch(nSamples * N), outLong;
+    std::vector<double> outDouble;
+    for (long r=0; r < reps; r++) {
+        {
+            Biquad_multiChan filt(N, bq_type_notch, 60.0 / FS_HZ, 4.0, 0.0);
+            double start = hostWallSeconds();
+            for (int i=0; i < nSamples; i++) {
+                for (int chan=0; chan < N; chan++) outMulti[i*N + chan] = filt.process((float)flat[i*N + chan], chan);
+            }
+            best[0] = min(best[0], (hostWallSeconds() - start) * 1.0e9 / (nSamples * N));
+            hostKeep(outMulti[0]);
+        }
+        best[1] = min(best[1], timeStatic<N,float>(flat, nSamples, outFloat));
+        best[2] = min(best[2], timeStatic<N,long>(flat, nSamples, outLong));
+        best[3] = min(best[3], timeStatic<N,double>(flat, nSamples, outDouble));
+    }
+    printf("time, %2d channels:  Biquad_multiChan %6.2f ns   static float %6.2f ns  long %6.2f ns  double %6.2f ns   (%.2fx)\n",
+        N, best[0], best[1], best[2], best[3], best[0] / best[1]);
+
+    CHECK(outFloat == outMulti);
+    long worst = 0;
+    for (int i=0; i < nSamples * N; i++) {
+        outSketch[i] = (long)outMulti[i];
+        worst = max(worst, labs(outLong[i] - outSketch[i]));
+    }
+    CHECK(worst <= 1);
+}
+
+int main(int argc, char **argv)
+{
+    long reps = 5 * hostBenchScale(argc, argv);
+    runChannels<8>(reps);
+    runChannels<16>(reps);
+    return hostTestResult("bench_biquad_static");
+}
@@ -0,0 +1,120 @@
+//
+//  bench_cascade.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  The sketch's highpass and two 60 Hz notches, run three ways over 8, 16, and 64
+//  channels of synthetic EEG, in ns per sample per channel on this PC:
+//     float:    three Biquad_multiChan, one process() call per channel per filter (the
+//               sketch before FIXED_POINT_FILTERS)
+//     fixed:    three Biquad_multiChan_fixed, called the same way
+//     cascade:  one Biquad_cascade_fixed over the whole sample, and over blocks of 16, with
+//               the same Q14 coefficients
+//     Q30:      the cascade with the coefficients that setStage() designs, where the
+//               highpass is Q30 (Q14 can't quite do a 0.5 Hz highpass; see
+//               Biquad_multiChan_fixed::calcCoefficientsQ30) and the notches are Q14
+//  The Q14 cascade has to give exactly what the three fixed-point filters in a row give.
+//  (A PC has a floating-point unit, so float wins here.  The Uno doesn't, which is what the
+//  fixed-point filters are for.  Here, it's the cascade against the fixed-point filters
+//  that counts.)
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include "HostSignals.h"
+#include <Biquad_multiChan.h>
+#include <Biquad_multiChan_fixed.h>
+#include <Biquad_cascade_fixed.h>
+
+#define FS_HZ (250.0)
+#define BLOCK (16)
+
+int main(int argc, char **argv)
+{
+    long reps = 5 * hostBenchScale(argc, argv);
+    const int Ns[] = { 8, 16, 64 };
+    const double Fc[3] = { 0.5 / FS_HZ, 60.0 / FS_HZ, 60.0 / FS_HZ };
+    const int types[3] = { bq_type_highpass, bq_type_notch, bq_type_notch };
+    const double Qs[3] = { 0.5, 4.0, 4.0 };
+    const int nSamples = 2000;
+
+    BiquadCoeffQ14 q14[3];
+    for (int s=0; s < 3; s++) Biquad_multiChan_fixed::calcCoefficients(types[s], Fc[s], Qs[s], 0.0, &q14[s]);
+
+    printf("%-6s %12s %12s %12s %14s %10s %10s\n", "chans", "float ns", "fixed ns", "cascade ns", "cascade/16 ns", "speedup", "Q30 ns");
+    for (int n=0; n < 3; n++) {
+        int N = Ns[n];
+        HostRecording data = makeSyntheticEEG(N, nSamples, FS_HZ, N);
+        std::vector<long> flat(nSamples * N);
+        for (int i=0; i < nSamples; i++) for (int chan=0; chan < N; chan++) flat[i*N + chan] = data[i][chan];
+
+        double best[5] = { 1.0e9, 1.0e9, 1.0e9, 1.0e9, 1.0e9 };
+        std::vector<long> outFixed(nSamples * N), outCascade(nSamples * N), outBlock(nSamples * N);
+        for (long r=0; r < reps; r++) {
+            //float, per channel per filter
+            {
+                Biquad_multiChan f0(N, types[0], Fc[0], Qs[0], 0.0), f1(N, types[1], Fc[1], Qs[1], 0.0), f2(N, types[2], Fc[2], Qs[2], 0.0);
+                std::vector<long> out(nSamples * N);
+                double start = hostWallSeconds();
+                for (int i=0; i < nSamples; i++) {
+                    for (int chan=0; chan < N; chan++) {
+                        float val = (float)flat[i*N + chan];
+                        val = f0.process(val, chan);
+                        val = f1.process(val, chan);
+                        val = f2.process(val, chan);
+                        out[i*N + chan] = (long)val;
+                    }
+                }
+                best[0] = min(best[0], (hostWallSeconds() - start) * 1.0e9 / (nSamples * N));
+                hostKeep(out[0]);
+            }
+            //fixed, per channel per filter
+            {
+                Biquad_multiChan_fixed f0(N, types[0], Fc[0], Qs[0], 0.0), f1(N, types[1], Fc[1], Qs[1], 0.0), f2(N, types[2], Fc[2], Qs[2], 0.0);
+                double start = hostWallSeconds();
+                for (int i=0; i < nSamples; i++) {
+                    for (int chan=0; chan < N; chan++) {
+                        long val = flat[i*N + chan];
+                        val = f0.process(val, chan);
+                        val = f1.process(val, chan);
+                        val = f2.process(val, chan);
+                        outFixed[i*N + chan] = val;
+                    }
+                }
+                best[1] = min(best[1], (hostWallSeconds() - start) * 1.0e9 / (nSamples * N));
+            }
+            //the cascade, a sample at a time and then a block at a time
+            for (int blocked = 0; blocked < 2; blocked++) {
+                Biquad_cascade_fixed cascade(N, 3);
+                for (int s=0; s < 3; s++) cascade.setStage(s, &q14[s], false);
+                std::vector<long> &out = blocked ? outBlock : outCascade;
+                out = flat;
+                double start = hostWallSeconds();
+                if (blocked) {
+                    for (int i=0; i < nSamples; i += BLOCK) cascade.process(&out[i*N], BLOCK);
+                } else {
+                    for (int i=0; i < nSamples; i++) cascade.process(&out[i*N]);
+                }
+                best[2 + blocked] = min(best[2 + blocked], (hostWallSeconds() - start) * 1.0e9 / (nSamples * N));
+            }
+            //the cascade as the sketch designs it, with the highpass in Q30
+            {
+                Biquad_cascade_fixed cascade(N, 3);
+                for (int s=0; s < 3; s++) cascade.setStage(s, types[s], Fc[s], Qs[s], 0.0);
+                CHECK(!cascade.isStageQ14(0) && cascade.isStageQ14(1) && cascade.isStageQ14(2));
+                std::vector<long> out(flat);
+                double start = hostWallSeconds();
+                for (int i=0; i < nSamples; i++) cascade.process(&out[i*N]);
+                best[4] = min(best[4], (hostWallSeconds() - start) * 1.0e9 / (nSamples * N));
+                hostKeep(out[0]);
+            }
+        }
+        printf("%-6d %12.2f %12.2f %12.2f %14.2f %9.2fx %10.2f\n", N, best[0], best[1], best[2], best[3], best[1] / best[2], best[4]);
+
+        //the same math, so the same answer, to the count
+        CHECK(outCascade == outFixed);
+        CHECK(outBlock == outFixed);
+    }
+
+    return hostTestResult("bench_cascade");
+}
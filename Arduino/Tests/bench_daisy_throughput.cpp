@@ -0,0 +1,56 @@
+//
+//  bench_daisy_throughput.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  Frame reads per second for daisy chains of 1, 2, 4, and 8 ADS1299s.  "Uno" is in
+//  simulated time (4 MHz SCK plus the per-byte overhead), so it says how fast a chain
+//  that long could be sampled before the frame reads alone fill the sample period.
+//  "host" is the PC's wall clock, reading and unpacking the frames from the simulated chip.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include <ADS1299Manager.h>
+
+static ADS1299Manager ADS;
+
+int main(int argc, char **argv)
+{
+    long reps = 2000 * hostBenchScale(argc, argv);
+    ADS1299Sim &chip = ADS1299Sim::chip();
+
+    printf("%-8s %-8s %14s %16s %16s %14s\n", "boards", "bytes", "Uno us/frame", "Uno frames/sec", "host frames/sec", "fastest rate");
+    for (int nBoards=1; nBoards <= ADS1299::MAX_N_BOARDS; nBoards *= 2) {
+        hostReset();
+        chip.powerUp(nBoards);
+        ADS.initializeBoards(OPENBCI_V2, nBoards);
+        for (int chan=1; chan <= 8*nBoards; chan++) ADS.activateChannel(chan, ADS_GAIN24, ADSINPUT_NORMAL);
+        chip.setTestPattern(true);
+        chip.resetCounters();
+        ADS.start();
+
+        uint64_t simStart = hostNanos();
+        double wallStart = hostWallSeconds();
+        for (long r=0; r < reps; r++) {
+            ADS.readFrame(ADS.rawFrame);
+            ADS.unpackFrame(ADS.rawFrame, ADS.channelData);
+        }
+        double wall = hostWallSeconds() - wallStart;
+        double sim_us = (double)(hostNanos() - simStart) / 1000.0 / reps;
+        ADS.stop();
+        hostKeep(ADS.channelData);
+
+        //the fastest ADS data rate at which reading the frames takes less than half of the time
+        double uno_fps = 1.0e6 / sim_us;
+        int fastest = 0;
+        for (int code=ADS_RATE_250HZ; code >= ADS_RATE_16kHZ; code--) {
+            if (2.0 * (16000 >> code) <= uno_fps) fastest = 16000 >> code;
+        }
+        printf("%-8d %-8d %14.1f %16.0f %16.0f %11d Hz\n", nBoards, ADS.getFrameBytes(), sim_us, uno_fps, reps / wall, fastest);
+
+        CHECK(uno_fps >= 1000.0);   //even 8 boards can be read at 250 Hz with room to spare
+        CHECK(chip.ignoredCommands == 0);
+    }
+    return hostTestResult("bench_daisy_throughput");
+}
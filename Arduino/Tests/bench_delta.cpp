@@ -0,0 +1,184 @@
+//
+//  bench_delta.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  The delta format (writeChannelDataAsDelta) against the packed format that it is
+//  built on: how many bytes each sample takes, what that means at 250 Hz, and how long
+//  the encoder takes per sample on this PC.  Every sample has to decode back exactly.
+//  Then single bytes of the stream are corrupted, to see how much each one costs before
+//  the PC is back in step at the next keyframe.
+//
+//  It runs on synthetic EEG (see HostSignals.h), on data streamed from the simulated
+//  chip, and on a recording from the Processing GUI if one is named on the command line:
+//     bench_delta [long] [openBCI_raw_....txt]
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostStream.h"
+#include "HostSignals.h"
+#include "PacketParser.h"
+
+static ADS1299Manager ADS;
+
+//send the whole recording through one of the writers, and return the bytes sent
+typedef void (*Writer)(int N, long sampleNumber);
+static void writeDelta(int N, long sampleNumber) { ADS.writeChannelDataAsDelta(N, sampleNumber); }
+static void writePacked(int N, long sampleNumber) { ADS.writeChannelDataAsPackedBinary(N, sampleNumber); }
+static std::vector<byte> encode(const HostRecording &data, Writer write)
+{
+    int N = data[0].size();
+    Serial.clearSent();
+    ADS.resetDeltaEncoder();
+    for (size_t i=0; i < data.size(); i++) {
+        for (int chan=0; chan < N; chan++) ADS.channelData[chan] = data[i][chan];
+        write(N, (long)i + 1);
+    }
+    ADS.flushTX();
+    return std::vector<byte>(Serial.sent(), Serial.sent() + Serial.sentBytes());
+}
+
+//wall-clock time per sample of the encoder, including handing the bytes to Serial
+static double encodeTime_ns(const HostRecording &data, Writer write, long reps)
+{
+    int N = data[0].size();
+    double best = 1.0e9;
+    for (long r=0; r < reps; r++) {
+        Serial.clearSent();
+        ADS.resetDeltaEncoder();
+        double start = hostWallSeconds();
+        for (size_t i=0; i < data.size(); i++) {
+            for (int chan=0; chan < N; chan++) ADS.channelData[chan] = data[i][chan];
+            write(N, (long)i + 1);
+        }
+        ADS.flushTX();
+        best = min(best, (hostWallSeconds() - start) * 1.0e9 / data.size());
+    }
+    return best;
+}
+
+static void runDataset(const char *name, const HostRecording &data, long reps, unsigned int seed)
+{
+    int N = data[0].size();
+    std::vector<byte> delta = encode(data, writeDelta);
+    std::vector<byte> packed = encode(data, writePacked);
+
+    //it all has to come back exactly
+    PacketParser parser;
+    parser.parse(&delta[0], delta.size());
+    CHECK(parser.badPackets == 0);
+    CHECK(parser.skippedPackets == 0);
+    CHECK(parser.samples.size() == data.size());
+    int nBad = 0;
+    for (size_t i=0; (i < data.size()) && (i < parser.samples.size()); i++) {
+        if (parser.samples[i].sampleNumber != (long)i + 1) nBad++;
+        if (parser.samples[i].values != data[i]) nBad++;
+    }
+    CHECK(nBad == 0);
+
+    double deltaBytes = (double)delta.size() / data.size();
+    double packedBytes = (double)packed.size() / data.size();
+    printf("%-22s %5d %12.1f %12.1f %8.2f %12.0f %12.0f %10.0f %10.0f\n", name, N, packedBytes, deltaBytes,
+        deltaBytes / packedBytes, packedBytes * 250.0, deltaBytes * 250.0,
+        encodeTime_ns(data, writePacked, reps), encodeTime_ns(data, writeDelta, reps));
+
+    //corrupt one byte at a time, and see what it costs
+    std::mt19937 rng(seed);
+    long worstLost = 0, totalLost = 0, totalWrong = 0;
+    const int nTrials = 20;
+    for (int trial=0; trial < nTrials; trial++) {
+        std::vector<byte> bad = delta;
+        size_t pos = bad.size()/4 + rng() % (bad.size()/2);
+        bad[pos] ^= (byte)(1 + rng() % 255);
+        PacketParser p;
+        p.parse(&bad[0], bad.size());
+        long lost = (long)data.size() - (long)p.samples.size(), wrong = 0;
+        for (size_t i=0; i < p.samples.size(); i++) {
+            long n = p.samples[i].sampleNumber;
+            if ((n < 1) || (n > (long)data.size()) || (p.samples[i].values != data[n-1])) wrong++;
+        }
+        //whatever happened, it's right again by the end
+        CHECK(!p.samples.empty() && (p.samples.back().values == data.back()));
+        worstLost = max(worstLost, lost + wrong);
+        totalLost += lost; totalWrong += wrong;
+    }
+    printf("%-22s   one bad byte: %.1f samples lost and %.1f wrong on average, %ld at worst (keyframes every %d)\n", "",
+        (double)totalLost / nTrials, (double)totalWrong / nTrials, worstLost, ADS_DELTA_KEYFRAME_INTERVAL);
+    CHECK(worstLost <= 2*ADS_DELTA_KEYFRAME_INTERVAL + 2);
+}
+
+int main(int argc, char **argv)
+{
+    long reps = 3 * hostBenchScale(argc, argv);
+    ADS1299Sim &chip = ADS1299Sim::chip();
+    hostReset();
+    chip.powerUp(2);
+    ADS.initializeBoards(OPENBCI_V2, 2);
+    for (int chan=1; chan <= 16; chan++) ADS.activateChannel(chan, ADS_GAIN24, ADSINPUT_NORMAL);
+
+    printf("%-22s %5s %12s %12s %8s %12s %12s %10s %10s\n", "data", "chans", "packed B/smp", "delta B/smp", "ratio",
+        "packed B/s", "delta B/s", "packed ns", "delta ns");
+
+    //synthetic EEG
+    runDataset("synthetic EEG", makeSyntheticEEG(8, 2500, 250.0, 1), reps, 1);
+    runDataset("synthetic EEG", makeSyntheticEEG(16, 2500, 250.0, 2), reps, 2);
+
+    //streamed from the simulated chip: a DC offset, 20 uV of alpha, and 1 uV of noise
+    chip.setNoise(1.0e-6);
+    for (int chan=0; chan < 16; chan++) chip.setSignal(chan, 5.0e-3 * (chan - 8), 20.0e-6, 10.0);
+    HostRecording streamed;
+    hostStream(ADS, 10.0, [&](long sampleNumber) {
+        streamed.push_back(std::vector<long>(ADS.channelData, ADS.channelData + 16));
+    });
+    runDataset("simulated chip", streamed, reps, 3);
+
+    //the worst case: full-scale noise, where nothing can be saved
+    {
+        HostRecording noise(1000, std::vector<long>(16));
+        std::mt19937 rng(4);
+        for (size_t i=0; i < noise.size(); i++) for (int chan=0; chan < 16; chan++) noise[i][chan] = (long)(rng() & 0xFFFFFF) - 0x800000;
+        runDataset("full-scale noise", noise, reps, 4);
+    }
+
+    //a recording from the GUI
+    for (int i=1; i < argc; i++) {
+        if (strcmp(argv[i], "long") == 0) continue;
+        HostRecording recorded = readGUIRecording(argv[i], 16);
+        if (recorded.empty()) {
+            printf("could not read %s\n", argv[i]);
+            continue;
+        }
+        runDataset("recorded", recorded, reps, 5);
+    }
+
+    //at 250 Hz, 16 channels of EEG should fit at 115200 baud (11520 bytes/sec), which the packed format can't
+    {
+        std::vector<byte> delta = encode(makeSyntheticEEG(16, 2500, 250.0, 6), writeDelta);
+        CHECK(delta.size() / 2500.0 * 250.0 < 11520.0);
+        CHECK(ADS.getPackedBinaryPacketBytes(16) * 250.0 > 11520.0);
+    }
+
+    //the encoder's state belongs to each ADS1299Manager.  It used to be partly a static in the
+    //function, so two of them taking turns made every packet a keyframe.
+    {
+        static ADS1299Manager other;
+        other.initializeBoards(OPENBCI_V2, 1);
+        HostRecording data = makeSyntheticEEG(8, 10, 250.0, 7);
+        Serial.clearSent();
+        ADS.resetDeltaEncoder();
+        for (int i=0; i < 10; i++) {
+            for (int chan=0; chan < 8; chan++) ADS.channelData[chan] = other.channelData[chan] = data[i][chan];
+            ADS.writeChannelDataAsDelta(8, i + 1); ADS.flushTX();
+            other.writeChannelDataAsDelta(8, i + 1); other.flushTX();
+        }
+        int nKeyframes = 0, nDeltas = 0;
+        for (size_t pos = 0; pos + 1 < Serial.sentBytes(); pos += Serial.sent()[pos+1] + 3) {
+            if (Serial.sent()[pos] == PCKT_START_PACKED) nKeyframes++;
+            if (Serial.sent()[pos] == PCKT_START_DELTA) nDeltas++;
+        }
+        CHECK(nKeyframes == 2);
+        CHECK(nDeltas == 18);
+    }
+
+    return hostTestResult("bench_delta");
+}
@@ -0,0 +1,172 @@
+//
+//  bench_frame_read.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  The frame read, before and after readFrame()/unpackFrame().  The old way did one
+//  transfer() per byte (each one saving SREG, cli(), and restoring it) and shifted each
+//  byte into the long, then made a second pass to sign-extend with bitRead.  The new way
+//  reads the frame in one readBlock() with interrupts masked once, and unpacks it without
+//  branches.  Both run on the same frames, through an SPI policy that hands out bytes
+//  from memory, so that what's timed is the driver's own work.  They have to agree on
+//  every value.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include <ADS1299.cpp>   //the driver template, to build it for the policy below
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC (1)
+#endif
+
+//an SPI port whose "wire" is a buffer.  Each Lock stands in for the AVR's SREG/cli pair.
+static const byte *benchWire = NULL;
+static volatile int benchPos = 0;
+static volatile byte benchSREG = 0x80;
+static unsigned long benchLocks = 0;
+template <int CS_PIN, int DRDY_PIN>
+class ADS1299_SPI_Bench {
+public:
+    class Lock {
+    public:
+        Lock() { oldSREG = benchSREG; benchSREG = 0; benchLocks++; }
+        ~Lock() { benchSREG = oldSREG; }
+    private:
+        byte oldSREG;
+    };
+    static void begin(int FREQ) {}
+    static inline void select(void) { benchPos = 0; }
+    static inline void deselect(void) {}
+    static inline boolean isDataReady(void) { return true; }
+    static inline byte transfer(byte _data) {
+        Lock lock;
+        return benchWire[benchPos++];
+    }
+    static inline void readBlock(byte *buf, int N) {
+        Lock lock;
+        for (int i=0; i < N; i++) buf[i] = benchWire[benchPos++];
+    }
+    static boolean attachDRDY(ADS1299_ISR isr) { return false; }
+    static void detachDRDY(void) {}
+};
+typedef ADS1299_SPI_Bench<ADS_PIN_CS,ADS_PIN_DRDY> BenchSPI;
+template class ADS1299_Driver<BenchSPI,2>;
+typedef ADS1299_Driver<BenchSPI,2> BenchDriver;
+
+//updateChannelData() as it was, byte by byte
+static void oldUpdateChannelData(BenchDriver &ads, long *dataTarget)
+{
+    byte inByte;
+    int nchan = 8;
+    long stat_1 = 0, stat_2 = 0;
+    BenchSPI::select();
+    for (int i=0; i<3; i++) {
+        inByte = BenchSPI::transfer(0x00);
+        stat_1 = (stat_1<<8) | inByte;
+    }
+    for (int i = 0; i<8; i++) {
+        for (int j=0; j<3; j++) {
+            inByte = BenchSPI::transfer(0x00);
+            dataTarget[i] = (dataTarget[i]<<8) | inByte;
+        }
+    }
+    if (ads.isDaisy) {
+        nchan = 16;
+        for (int i=0; i<3; i++) {
+            inByte = BenchSPI::transfer(0x00);
+            stat_2 = (stat_1<<8) | inByte;
+        }
+        for (int i = 8; i<16; i++) {
+            for (int j=0; j<3; j++) {
+                inByte = BenchSPI::transfer(0x00);
+                dataTarget[i] = (dataTarget[i]<<8) | inByte;
+            }
+        }
+    }
+    BenchSPI::deselect();
+    for (int i=0; i<nchan; i++) {
+        if (bitRead(dataTarget[i],23) == 1) {
+            dataTarget[i] |= 0xFFFFFFFFFF000000LL;   //0xFF000000 where long is 32 bits
+        } else {
+            dataTarget[i] &= 0x00FFFFFF;
+        }
+    }
+    hostKeep(stat_2);
+}
+
+static inline uint64_t ticks(void)
+{
+#ifdef HAVE_RDTSC
+    return __rdtsc();
+#else
+    return (uint64_t)(hostWallSeconds() * 1.0e9);
+#endif
+}
+
+#define N_FRAMES (64)
+
+int main(int argc, char **argv)
+{
+    long reps = 2000 * hostBenchScale(argc, argv);
+
+    //the same frames for both: random bytes, so half of the samples are negative
+    static byte frames[N_FRAMES][2*ADS_FRAME_BYTES_PER_BOARD];
+    srand(1);
+    for (int f=0; f < N_FRAMES; f++) {
+        for (int i=0; i < 2*ADS_FRAME_BYTES_PER_BOARD; i++) frames[f][i] = (byte)(rand() >> 4);
+    }
+
+    static BenchDriver ads;
+    printf("%-8s %-6s %14s %14s %12s\n", "boards", "path", "ticks/frame", "locks/frame", "agree");
+    for (int nBoards=1; nBoards <= 2; nBoards++) {
+        ads.setNumBoards(nBoards);
+        int nChan = nBoards*8;
+
+        //they must agree
+        int nBad = 0;
+        long oldData[16], newData[16];
+        for (int f=0; f < N_FRAMES; f++) {
+            benchWire = frames[f];
+            oldUpdateChannelData(ads, oldData);
+            benchWire = frames[f];
+            ads.updateChannelData(newData);
+            for (int chan=0; chan < nChan; chan++) if (oldData[chan] != newData[chan]) nBad++;
+            //and they're right
+            for (int chan=0; chan < nChan; chan++) {
+                const byte *p = frames[f] + (chan/8)*ADS_FRAME_BYTES_PER_BOARD + ADS_STATUS_BYTES + (chan%8)*3;
+                long expected = ((long)p[0] << 16) | ((long)p[1] << 8) | p[2];
+                if (expected >= 0x800000L) expected -= 0x1000000L;
+                if (newData[chan] != expected) nBad++;
+            }
+        }
+        CHECK(nBad == 0);
+
+        //time them
+        double perFrame[2];
+        unsigned long locks[2];
+        for (int path=0; path < 2; path++) {
+            benchLocks = 0;
+            uint64_t start = ticks();
+            for (long r=0; r < reps; r++) {
+                benchWire = frames[r % N_FRAMES];
+                if (path == 0) oldUpdateChannelData(ads, oldData);
+                else ads.updateChannelData(newData);
+            }
+            uint64_t stop = ticks();
+            hostKeep(oldData); hostKeep(newData);
+            perFrame[path] = (double)(stop - start) / reps;
+            locks[path] = benchLocks / reps;
+            printf("%-8d %-6s %14.1f %14lu %12s\n", nBoards, (path == 0) ? "old" : "new", perFrame[path], locks[path], (nBad == 0) ? "yes" : "NO");
+        }
+        CHECK(locks[0] == (unsigned long)(nBoards*ADS_FRAME_BYTES_PER_BOARD));   //once per byte
+        CHECK(locks[1] == 1);                                                    //once per frame
+    }
+#ifdef HAVE_RDTSC
+    printf("(ticks are TSC cycles of the host)\n");
+#else
+    printf("(ticks are nanoseconds of the host)\n");
+#endif
+
+    return hostTestResult("bench_frame_read");
+}
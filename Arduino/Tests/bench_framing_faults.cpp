@@ -0,0 +1,130 @@
+//
+//  bench_framing_faults.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  What one bad byte on the serial link costs, with the 0xA0...0xC0 framing of the packed
+//  samples (writeChannelDataAsPackedBinary) and with the COBS framing (writeChannelDataAsCOBS,
+//  with setCOBSFraming for the markers).  The stream is 2000 samples of 8 channels of EEG,
+//  with a discontinuity marker every 100 samples.  In each trial, one byte of it is flipped,
+//  dropped, or an extra one is put in, and the PC's parser goes through what's left.  It
+//  counts the samples and markers that never came out, and the samples that came out wrong
+//  (which is the worse of the two, since nothing tells the PC about them).
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include "HostSignals.h"
+#include "PacketParser.h"
+#include <ADS1299Manager.h>
+
+static ADS1299Manager ADS;
+
+#define N_CHAN (8)
+#define MARKER_INTERVAL (100)
+
+static std::vector<byte> encode(const HostRecording &data, boolean cobs)
+{
+    ADS.setCOBSFraming(cobs);
+    Serial.clearSent();
+    for (size_t i=0; i < data.size(); i++) {
+        if ((i % MARKER_INTERVAL) == 0) ADS.writeDiscontinuityMarker((long)i + 1);
+        for (int chan=0; chan < N_CHAN; chan++) ADS.channelData[chan] = data[i][chan];
+        if (cobs) ADS.writeChannelDataAsCOBS(N_CHAN, (long)i + 1);
+        else ADS.writeChannelDataAsPackedBinary(N_CHAN, (long)i + 1);
+    }
+    ADS.flushTX();
+    ADS.setCOBSFraming(false);
+    return std::vector<byte>(Serial.sent(), Serial.sent() + Serial.sentBytes());
+}
+
+#define FAULT_FLIP (0)
+#define FAULT_DROP (1)
+#define FAULT_INSERT (2)
+
+struct FaultResult {
+    double lost;        //samples, on average
+    double wrong;
+    double markersLost;
+    long worstLost;
+    long worstWrong;
+};
+
+static FaultResult injectFaults(const HostRecording &data, const std::vector<byte> &clean, boolean cobs, int fault, int nTrials, unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    FaultResult result = { 0.0, 0.0, 0.0, 0, 0 };
+    long nMarkers = (data.size() + MARKER_INTERVAL - 1) / MARKER_INTERVAL;
+    for (int trial=0; trial < nTrials; trial++) {
+        std::vector<byte> bad = clean;
+        size_t pos = bad.size()/4 + rng() % (bad.size()/2);
+        if (fault == FAULT_FLIP) bad[pos] ^= (byte)(1 << (rng() % 8));
+        else if (fault == FAULT_DROP) bad.erase(bad.begin() + pos);
+        else bad.insert(bad.begin() + pos, (byte)rng());
+
+        PacketParser parser(cobs);
+        parser.parse(&bad[0], bad.size());
+        long wrong = 0;
+        std::vector<boolean> seen(data.size(), false);
+        for (size_t i=0; i < parser.samples.size(); i++) {
+            long n = parser.samples[i].sampleNumber;
+            if ((n < 1) || (n > (long)data.size()) || seen[n-1] || (parser.samples[i].values != data[n-1])) {
+                wrong++;
+            } else {
+                seen[n-1] = true;
+            }
+        }
+        long lost = 0;
+        for (size_t i=0; i < seen.size(); i++) if (!seen[i]) lost++;
+        long markers = 0;
+        for (size_t i=0; i < parser.packets.size(); i++) if (parser.packets[i].format == PCKT_START_MARKER) markers++;
+        result.lost += (double)lost / nTrials;
+        result.wrong += (double)wrong / nTrials;
+        result.markersLost += (double)max(nMarkers - markers, 0L) / nTrials;
+        result.worstLost = max(result.worstLost, lost);
+        result.worstWrong = max(result.worstWrong, wrong);
+    }
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    int nTrials = 200 * hostBenchScale(argc, argv);
+    ADS1299Sim &chip = ADS1299Sim::chip();
+    hostReset();
+    chip.powerUp(1);
+    ADS.initializeBoards(OPENBCI_V2, 1);
+
+    HostRecording data = makeSyntheticEEG(N_CHAN, 2000, 250.0, 1);
+    const char *faultNames[3] = { "flip", "drop", "insert" };
+    printf("%-8s %-8s %10s %12s %12s %14s %12s %12s\n", "framing", "fault", "bytes/smp", "lost/fault", "wrong/fault",
+        "markers lost", "worst lost", "worst wrong");
+    FaultResult results[2][3];
+    for (int cobs = 0; cobs < 2; cobs++) {
+        std::vector<byte> clean = encode(data, cobs == 1);
+
+        //with nothing wrong, everything comes through
+        PacketParser parser(cobs == 1);
+        parser.parse(&clean[0], clean.size());
+        CHECK(parser.badPackets == 0);
+        CHECK(parser.samples.size() == data.size());
+
+        for (int fault = FAULT_FLIP; fault <= FAULT_INSERT; fault++) {
+            FaultResult r = injectFaults(data, clean, cobs == 1, fault, nTrials, 10 + fault);
+            results[cobs][fault] = r;
+            printf("%-8s %-8s %10.2f %12.2f %12.3f %14.3f %12ld %12ld\n", cobs ? "COBS" : "A0..C0", faultNames[fault],
+                (double)clean.size() / data.size(), r.lost, r.wrong, r.markersLost, r.worstLost, r.worstWrong);
+        }
+    }
+
+    //with COBS, a bad byte costs at most the packet it's in and (if it was a delimiter) the
+    //one after, and the CRC keeps anything wrong from getting through
+    for (int fault = FAULT_FLIP; fault <= FAULT_INSERT; fault++) {
+        CHECK(results[1][fault].worstLost <= 2);
+        CHECK(results[1][fault].worstWrong == 0);
+    }
+    //and it's no worse than the old framing
+    CHECK(results[1][FAULT_FLIP].lost + results[1][FAULT_FLIP].wrong <= results[0][FAULT_FLIP].lost + results[0][FAULT_FLIP].wrong);
+
+    return hostTestResult("bench_framing_faults");
+}
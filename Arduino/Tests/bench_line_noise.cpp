@@ -0,0 +1,84 @@
+//
+//  bench_line_noise.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  What it costs to take out the line noise, over 8 and 16 channels of synthetic EEG at
+//  250 Hz, in ns per sample per channel on this PC:
+//     float notches:  two Biquad_multiChan notches, one process() call per channel each
+//                     (the sketch without FIXED_POINT_FILTERS)
+//     fixed notches:  two notch stages of a Biquad_cascade_fixed (the sketch without
+//                     LINE_NOISE_CANCELLER)
+//     LNC x1, x3:     LineNoiseCanceller with just the fundamental, and with the 2nd and 3rd
+//                     harmonics too
+//  How much of the interference each one takes out is in test_line_noise.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include "HostSignals.h"
+#include <Biquad_multiChan.h>
+#include <Biquad_cascade_fixed.h>
+#include <LineNoiseCanceller.h>
+
+#define FS_HZ (250.0)
+
+int main(int argc, char **argv)
+{
+    long reps = 5 * hostBenchScale(argc, argv);
+    const int Ns[] = { 8, 16 };
+    const double Fc = 60.0 / FS_HZ, Q = 4.0;
+    const int nSamples = 5000;
+
+    printf("%-6s %16s %16s %12s %12s\n", "chans", "float notch ns", "fixed notch ns", "LNC x1 ns", "LNC x3 ns");
+    for (int n=0; n < 2; n++) {
+        int N = Ns[n];
+        HostRecording data = makeSyntheticEEG(N, nSamples, FS_HZ, N);
+        std::vector<long> flat(nSamples * N);
+        for (int i=0; i < nSamples; i++) for (int chan=0; chan < N; chan++) flat[i*N + chan] = data[i][chan];
+
+        double best[4] = { 1.0e9, 1.0e9, 1.0e9, 1.0e9 };
+        for (long r=0; r < reps; r++) {
+            //float notches, per channel per filter
+            {
+                Biquad_multiChan f1(N, bq_type_notch, Fc, Q, 0.0), f2(N, bq_type_notch, Fc, Q, 0.0);
+                std::vector<long> out(nSamples * N);
+                double start = hostWallSeconds();
+                for (int i=0; i < nSamples; i++) {
+                    for (int chan=0; chan < N; chan++) {
+                        float val = (float)flat[i*N + chan];
+                        val = f1.process(val, chan);
+                        val = f2.process(val, chan);
+                        out[i*N + chan] = (long)val;
+                    }
+                }
+                best[0] = min(best[0], (hostWallSeconds() - start) * 1.0e9 / (nSamples * N));
+                hostKeep(out[0]);
+            }
+            //fixed-point notches, the whole sample at once
+            {
+                Biquad_cascade_fixed notches(N, 2);
+                for (int s=0; s < 2; s++) notches.setStage(s, bq_type_notch, Fc, Q, 0.0);
+                std::vector<long> out(flat);
+                double start = hostWallSeconds();
+                for (int i=0; i < nSamples; i++) notches.process(&out[i*N]);
+                best[1] = min(best[1], (hostWallSeconds() - start) * 1.0e9 / (nSamples * N));
+                hostKeep(out[0]);
+            }
+            //the canceller, with one and with three harmonics
+            for (int h=0; h < 2; h++) {
+                LineNoiseCanceller lnc(N, h ? 3 : 1);
+                lnc.setFrequency(Fc);
+                CHECK(lnc.getNHarmonics() == (h ? 3 : 1));
+                std::vector<long> out(flat);
+                double start = hostWallSeconds();
+                for (int i=0; i < nSamples; i++) lnc.process(&out[i*N]);
+                best[2 + h] = min(best[2 + h], (hostWallSeconds() - start) * 1.0e9 / (nSamples * N));
+                hostKeep(out[0]);
+            }
+        }
+        printf("%-6d %16.2f %16.2f %12.2f %12.2f\n", N, best[0], best[1], best[2], best[3]);
+    }
+
+    return hostTestResult("bench_line_noise");
+}
@@ -0,0 +1,123 @@
+//
+//  bench_reconfig.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  The dead time of a full reconfiguration (every channel's gain, lead-off, and the bias,
+//  with configureChannels) of 8 and 16 channels, against the simulated chip, at 250 Hz and
+//  1 kHz, done three ways while streaming:
+//     stop/start:  stop(), reconfigure, start(), the way that the sketch did it before
+//                  beginConfig()/commit()
+//     commit:      reconfigure while running.  The commit() is one SDATAC, one WREGS, and
+//                  one RDATAC, sent right away.
+//     hot:         the same, with setHotReconfig(true), so the burst goes out right after
+//                  a sample has been read (polling mode, as in the sketch)
+//  For each, it prints the time on the SPI bus that the reconfiguration took, and how many
+//  samples it cost, averaged over the reconfigurations.  Times are simulated Uno time
+//  (4 MHz SCK plus the per-byte overhead).  The samples lost are read off of when the
+//  samples around the change arrived.  The daisy-chained boards all hear the same WREGS, so
+//  16 channels take no longer than 8.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include <ADS1299Manager.h>
+
+static ADS1299Manager ADS;
+
+enum { MODE_STOP_START = 0, MODE_COMMIT, MODE_HOT, N_MODES };
+
+//wait for the next sample and read it.  Returns when it was ready (simulated ns), and how
+//long reading it took.
+static uint64_t readSample(uint64_t *read_ns = NULL)
+{
+    for (long i=0; i < 1000000L; i++) {
+        if (ADS.isDataAvailable()) {
+            uint64_t ready = hostNanos();
+            ADS.updateChannelData();
+            if (read_ns != NULL) *read_ns = hostNanos() - ready;
+            return ready;
+        }
+        hostAdvance(2000);
+    }
+    return hostNanos();
+}
+
+//every channel, with alternating settings, so that every reconfiguration changes something
+static void reconfigure(int nChan, int k)
+{
+    ADS1299ChannelConfig config[ADS1299::MAX_N_CHAN];
+    for (int i=0; i < nChan; i++) {
+        config[i].flags = ADS_CHANCFG_ACTIVE | ((k & 1) ? ADS_CHANCFG_LOFF_P : 0);
+        config[i].gainCode = (k & 1) ? ADS_GAIN12 : ADS_GAIN24;
+        config[i].inputCode = ADSINPUT_NORMAL;
+    }
+    ADS.configureChannels(config, nChan, (k & 1) == 0);
+}
+
+int main(int argc, char **argv)
+{
+    int reps = 10 * (int)hostBenchScale(argc, argv);
+    ADS1299Sim &chip = ADS1299Sim::chip();
+    const char *modeNames[N_MODES] = { "stop/start", "commit", "hot" };
+    const byte rates[] = { ADS_RATE_250HZ, ADS_RATE_1kHZ };
+
+    printf("%-6s %-6s %-12s %12s %14s %12s\n", "chans", "rate", "mode", "bus us", "samples lost", "marked");
+    for (int nBoards=1; nBoards <= 2; nBoards++) {
+        int nChan = 8 * nBoards;
+        for (int r=0; r < 2; r++) {
+            for (int mode=0; mode < N_MODES; mode++) {
+                hostReset();
+                chip.powerUp(nBoards);
+                ADS.initializeBoards(OPENBCI_V2, nBoards);
+                reconfigure(nChan, 0);
+                ADS.setSampleRate(rates[r]);
+                ADS.setHotReconfig(mode == MODE_HOT);
+                double period_ns = 1.0e9 / ADS.getSampleRate_Hz();
+                chip.resetCounters();
+
+                ADS.start();
+                readSample();
+                double bus_ns = 0.0, lost = 0.0;
+                long marked = 0;
+                for (int k=1; k <= reps; k++) {
+                    //a few ordinary samples, and how long reading one takes
+                    uint64_t read0_ns = 0, read1_ns = 0;
+                    readSample();
+                    uint64_t t0 = readSample(&read0_ns);
+
+                    //the reconfiguration
+                    uint64_t start = hostNanos();
+                    if (mode == MODE_STOP_START) ADS.stop();
+                    reconfigure(nChan, k);
+                    if (mode == MODE_STOP_START) ADS.start();
+                    bus_ns += (double)(hostNanos() - start);
+
+                    //the next two samples.  With hot reconfiguration, the burst goes out right
+                    //after the first of them is read, so that read takes longer by the burst.
+                    uint64_t t1 = readSample(&read1_ns);
+                    if (mode == MODE_HOT) bus_ns += (double)read1_ns - (double)read0_ns;
+                    uint64_t t2 = readSample();
+                    if (ADS.getDiscontinuity() >= 0) marked += ADS.getDiscontinuity();
+                    double gap = max((double)(t1 - t0), (double)(t2 - t1));
+                    lost += max(0.0, floor(gap / period_ns + 0.5) - 1.0);
+                }
+                ADS.stop();
+                printf("%-6d %-6.0f %-12s %12.0f %14.2f %12.2f\n", nChan, ADS.getSampleRate_Hz(), modeNames[mode],
+                    bus_ns / 1000.0 / reps, lost / reps, (double)marked / reps);
+
+                CHECK(chip.ignoredCommands == 0);
+                CHECK(chip.framesTorn == 0);
+                CHECK(ADS.verifyRegisters() == 0);
+                if (mode == MODE_HOT) CHECK(marked == (long)ADS.getHotSamplesLost());
+                if (mode != MODE_STOP_START) {
+                    //well under a sample period, even at 1 kHz, and nothing lost
+                    CHECK(bus_ns / reps < 0.25 * period_ns);
+                    CHECK(lost == 0.0);
+                    CHECK(chip.framesLost == 0);
+                }
+            }
+        }
+    }
+    return hostTestResult("bench_reconfig");
+}
@@ -0,0 +1,129 @@
+//
+//  bench_serial_tx.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  The double-buffered transmit queue (serviceTX) against the way the binary packets
+//  used to be sent, with a Serial.write() for each field straight from loop().  Both
+//  stream 4-byte binary samples from the simulated chip out of the simulated UART, at a
+//  few baud rates and loads up to (and past) what the link can carry.  For each, it says
+//  how much of the line rate was used, how long the writer held up loop() (on the Uno's
+//  clock), and how many conversions were never read because loop() was late for DRDY.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostStream.h"
+#include "PacketParser.h"
+
+static ADS1299Manager ADS;
+
+//the binary packet, as it was written before the queue
+static void writeDirect(int N, long sampleNumber)
+{
+    union { long val; byte bytes[4]; } v;
+    Serial.write((byte)PCKT_START);
+    Serial.write((byte)((1+N)*4));
+    v.val = sampleNumber;
+    Serial.write(v.bytes, 4);
+    for (int chan=0; chan < N; chan++) {
+        v.val = ADS.channelData[chan];
+        Serial.write(v.bytes, 4);
+    }
+    Serial.write((byte)PCKT_END);
+}
+
+struct TXResult {
+    double lineFraction;        //bytes/sec sent over what the baud rate could carry
+    double meanWrite_us;        //time spent in the writer, per sample
+    double worstWrite_us;
+    unsigned long framesLost;
+    unsigned long stalls;
+    int peakDepth;
+    long nSamples;
+    long nDecoded;
+};
+
+static TXResult run(boolean queued, int N, int rate, unsigned long baud, double seconds)
+{
+    //start from scratch, so that the queue's counters are for this run alone
+    ADS.initializeBoards(OPENBCI_V2, 2);
+    for (int chan=1; chan <= 16; chan++) ADS.activateChannel(chan, ADS_GAIN24, ADSINPUT_NORMAL);
+    ADS.setSampleRate(rate);
+    Serial.begin(baud);
+    Serial.clearSent();
+    ADS1299Sim::chip().resetCounters();
+    TXResult r;
+    uint64_t total_ns = 0, worst_ns = 0;
+    uint64_t start_ns = hostNanos();
+    r.nSamples = hostStream(ADS, seconds, [&](long sampleNumber) {
+        uint64_t t0 = hostNanos();
+        if (queued) ADS.writeChannelDataAsBinary(N, sampleNumber);
+        else writeDirect(N, sampleNumber);
+        uint64_t dt = hostNanos() - t0;
+        total_ns += dt;
+        worst_ns = max(worst_ns, dt);
+    });
+    double elapsed = (double)(hostNanos() - start_ns) * 1.0e-9;
+    r.lineFraction = Serial.sentBytes() * 10.0 / baud / elapsed;
+    r.meanWrite_us = total_ns * 1.0e-3 / max(r.nSamples, 1L);
+    r.worstWrite_us = worst_ns * 1.0e-3;
+    r.framesLost = ADS1299Sim::chip().framesLost;
+    r.stalls = ADS.getTXStalls();
+    r.peakDepth = ADS.getTXPeakDepth();
+
+    PacketParser parser;
+    parser.parse(Serial.sent(), Serial.sentBytes());
+    r.nDecoded = parser.samples.size();
+    CHECK(parser.badPackets == 0);
+    return r;
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = 2.0 * hostBenchScale(argc, argv);
+    ADS1299Sim &chip = ADS1299Sim::chip();
+    hostReset();
+    chip.powerUp(2);
+    ADS.initializeBoards(OPENBCI_V2, 2);
+    chip.setNoise(5.0e-6);
+
+    struct Case { int N; int rate; unsigned long baud; };
+    const Case cases[] = {
+        { 8, ADS_RATE_250HZ, 115200 },      //85% of the line
+        { 8, ADS_RATE_500HZ, 230400 },      //85%
+        { 16, ADS_RATE_250HZ, 230400 },     //77%
+        { 16, ADS_RATE_250HZ, 115200 },     //154%: it can't keep up, one way or the other
+    };
+    const int nCases = sizeof(cases)/sizeof(cases[0]);
+    printf("%-6s %-6s %8s %8s %-7s %8s %10s %10s %8s %8s %8s\n", "chans", "rate", "baud", "load", "writer",
+        "line", "mean us", "worst us", "lost", "stalls", "peak");
+    for (int c=0; c < nCases; c++) {
+        const Case &k = cases[c];
+        ADS.setSampleRate(k.rate);
+        double load = ADS.getBinaryPacketBytes(k.N, false) * 10.0 * ADS.getSampleRate_Hz() / k.baud;
+        TXResult res[2];
+        for (int queued = 0; queued < 2; queued++) {
+            TXResult &r = res[queued];
+            r = run(queued == 1, k.N, k.rate, k.baud, seconds);
+            printf("%-6d %-6.0f %8lu %7.0f%% %-7s %7.1f%% %10.1f %10.1f %8lu %8lu %8d\n", k.N, ADS.getSampleRate_Hz(), k.baud,
+                100.0 * load, queued ? "queued" : "direct", 100.0 * r.lineFraction, r.meanWrite_us, r.worstWrite_us,
+                r.framesLost, r.stalls, r.peakDepth);
+            CHECK(r.nDecoded == r.nSamples);   //whatever was written got there
+        }
+        if (load < 1.0) {
+            //the queue hands off a packet without waiting, so loop() is back in time for DRDY,
+            //and the line carries everything that's offered
+            //(a packet that fits in the UART's own 64 bytes never waited, even before)
+            CHECK(res[1].framesLost == 0);
+            CHECK(res[1].worstWrite_us <= res[0].worstWrite_us);
+            if (ADS.getBinaryPacketBytes(k.N, false) > SERIAL_TX_BUFFER_SIZE) CHECK(res[1].worstWrite_us < 0.1 * res[0].worstWrite_us);
+            CHECK(res[1].lineFraction > 0.95 * load);
+        } else {
+            //too much for the link: either way, it runs close to line rate
+            CHECK(res[1].lineFraction > 0.95);
+        }
+    }
+    ADS.setSampleRate(ADS_RATE_250HZ);
+
+    return hostTestResult("bench_serial_tx");
+}
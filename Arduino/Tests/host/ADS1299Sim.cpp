@@ -0,0 +1,377 @@
+//
+//  ADS1299Sim.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see ../README.txt)
+//
+//  The simulated ADS1299 daisy chain.  See ADS1299Sim.h.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "ADS1299Sim.h"
+#include <Definitions.h>
+
+//register values after a reset (datasheet, p39)
+static const byte resetValues[ADS_SIM_N_REGISTERS] = {
+    ADS_SIM_DEVICE_ID, 0x96, 0xC0, 0x60, 0x00,               //ID, CONFIG1-3, LOFF
+    0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61,          //CH1SET-CH8SET
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,                //BIAS_SENSP/N, LOFF_SENSP/N, LOFF_FLIP, LOFF_STATP/N
+    0x0F, 0x00, 0x00, 0x00                                   //GPIO, MISC1, MISC2, CONFIG4
+};
+
+//the sinc3 filter, sampled finely enough for the square waves (see squareThroughSinc3)
+#define SINC3_POINTS (48)
+static double sinc3Weight[SINC3_POINTS];
+
+ADS1299Sim &ADS1299Sim::chip()
+{
+    static ADS1299Sim sim;
+    return sim;
+}
+
+ADS1299Sim::ADS1299Sim() : gauss(0.0, 1.0)
+{
+    //the sinc3 impulse response is three boxcars of one sample period, convolved: a
+    //quadratic B-spline 3 periods long
+    double total = 0.0;
+    for (int i=0; i < SINC3_POINTS; i++) {
+        double x = 3.0 * (i + 0.5) / SINC3_POINTS;
+        double w;
+        if (x < 1.0) w = 0.5*x*x;
+        else if (x < 2.0) w = 0.75 - (x-1.5)*(x-1.5);
+        else w = 0.5*(3.0-x)*(3.0-x);
+        sinc3Weight[i] = w;
+        total += w;
+    }
+    for (int i=0; i < SINC3_POINTS; i++) sinc3Weight[i] /= total;
+
+    drdyPin = -1;
+    byte_ns = 2000;
+    byteOverhead_ns = 250;
+    pinRead_ns = 125;
+    powerUp(1);
+    hostAttachDevice(&ADS1299Sim::update, &ADS1299Sim::nextEvent);
+}
+
+void ADS1299Sim::powerUp(int N)
+{
+    nDevices = constrain(N, 1, ADS_SIM_MAX_DEVICES);
+    for (int d=0; d < ADS_SIM_MAX_DEVICES; d++) {
+        for (int r=0; r < ADS_SIM_N_REGISTERS; r++) regs[d][r] = resetValues[r];
+    }
+    converting = false;
+    rdatac = true;   //that's how it powers up
+    drdyLow = false;
+    frameFresh = false;
+    frameConversion = 0;
+    memset(frame, 0, sizeof(frame));
+    selected = false;
+    readPos = -1;
+    opcodeBytes = 0;
+    bytesLeft = 0;
+    for (int chan=0; chan < ADS_SIM_MAX_CHAN; chan++) {
+        dc_V[chan] = amp_V[chan] = freq_Hz[chan] = 0.0;
+        ohmsP[chan] = ohmsN[chan] = 0.0;
+    }
+    noise_V = 0.0;
+    testPattern = false;
+    logReads = false;
+    readLog.clear();
+    resetCounters();
+    restartConversions();
+}
+
+void ADS1299Sim::resetCounters(void)
+{
+    conversions = framesRead = framesLost = framesTorn = rereads = 0;
+    ignoredCommands = registerWrites = spiBytes = 0;
+    readLog.clear();
+}
+
+void ADS1299Sim::begin(int sck_MHz, int pin)
+{
+    drdyPin = pin;
+    byte_ns = 8000 / max(sck_MHz, 1);
+}
+
+double ADS1299Sim::getSampleRate_Hz(void)
+{
+    return 16000.0 / (double)(1 << (regs[0][CONFIG1] & 0x07));
+}
+
+void ADS1299Sim::setSignal(int chan, double dc, double amp, double f)
+{
+    if ((chan < 0) || (chan >= ADS_SIM_MAX_CHAN)) return;
+    dc_V[chan] = dc; amp_V[chan] = amp; freq_Hz[chan] = f;
+}
+
+void ADS1299Sim::setElectrodes(int chan, double P, double N)
+{
+    if ((chan < 0) || (chan >= ADS_SIM_MAX_CHAN)) return;
+    ohmsP[chan] = P; ohmsN[chan] = N;
+}
+
+void ADS1299Sim::setNoise(double rms_V, unsigned int seed)
+{
+    noise_V = rms_V;
+    rng.seed(seed);
+    gauss.reset();
+}
+
+long ADS1299Sim::patternValue(long conversion, int chan)
+{
+    return ((conversion * ADS_SIM_MAX_CHAN + chan) & 0xFFFFFFL) - 0x800000L;
+}
+
+
+//---------------------------------------------------------------------------------
+//conversions
+
+void ADS1299Sim::restartConversions(void)
+{
+    period_ns = (uint64_t)(62500ULL << (regs[0][CONFIG1] & 0x07));  //16 kHz, halved for each step
+    startTime_ns = hostNanos();
+    nextConversion_ns = startTime_ns + period_ns;
+}
+
+void ADS1299Sim::update(uint64_t now_ns)
+{
+    ADS1299Sim &sim = chip();
+    while (sim.converting && (now_ns >= sim.nextConversion_ns)) {
+        sim.convert(sim.nextConversion_ns);
+        sim.nextConversion_ns += sim.period_ns;
+    }
+}
+
+uint64_t ADS1299Sim::nextEvent(void)
+{
+    ADS1299Sim &sim = chip();
+    return sim.converting ? sim.nextConversion_ns : (uint64_t)-1;
+}
+
+void ADS1299Sim::convert(uint64_t t_ns)
+{
+    conversions++;
+    if (frameFresh) framesLost++;                 //nobody read the last one
+    if (selected && (readPos > 0) && (readPos < nDevices*ADS_SIM_FRAME_BYTES_PER_DEVICE)) framesTorn++;
+    frameConversion = conversions;
+
+    double t_sec = (double)(t_ns - startTime_ns) * 1.0e-9;
+    byte *p = frame;
+    for (int d=0; d < nDevices; d++) {
+        //status: 1100, LOFF_STATP, LOFF_STATN, GPIO[7:4]
+        byte statp = regs[d][LOFF_STATP], statn = regs[d][LOFF_STATN];
+        *p++ = 0xC0 | (statp >> 4);
+        *p++ = (byte)((statp << 4) | (statn >> 4));
+        *p++ = (byte)((statn << 4) | (regs[d][GPIO] >> 4));
+        for (int i=0; i < ADS_SIM_CHAN_PER_DEVICE; i++) {
+            int chan = d*ADS_SIM_CHAN_PER_DEVICE + i;
+            long code;
+            if (testPattern) {
+                code = patternValue(conversions, chan);
+            } else {
+                byte chset = regs[d][CH1SET+i];
+                static const double gains[] = {1, 2, 4, 6, 8, 12, 24, 24};
+                double v = (chset & 0x80) ? 0.0 : channelVolts(chan, t_sec);
+                if (noise_V > 0.0) v += noise_V * gauss(rng);
+                double x = floor(v * gains[(chset >> 4) & 0x07] / ADS_SIM_VREF * 8388607.0 + 0.5);
+                if (x > 8388607.0) x = 8388607.0;
+                if (x < -8388608.0) x = -8388608.0;
+                code = (long)x;
+            }
+            *p++ = (byte)(code >> 16);
+            *p++ = (byte)(code >> 8);
+            *p++ = (byte)code;
+        }
+    }
+
+    frameFresh = true;
+    drdyLow = true;
+    hostRaiseInterrupt(drdyPin);
+}
+
+//a +/-1 square wave of frequency f_Hz, starting high at phase0 (in cycles), as it comes
+//out of the sinc3 filter for the sample at t_sec
+double ADS1299Sim::squareThroughSinc3(double f_Hz, double phase0, double t_sec)
+{
+    double T = 1.0 / getSampleRate_Hz();
+    double sum = 0.0;
+    for (int i=0; i < SINC3_POINTS; i++) {
+        double t = t_sec - 3.0*T*(i + 0.5)/SINC3_POINTS;
+        double cycles = f_Hz*t + phase0;
+        double frac = cycles - floor(cycles);
+        sum += sinc3Weight[i] * ((frac < 0.5) ? 1.0 : -1.0);
+    }
+    return sum;
+}
+
+double ADS1299Sim::channelVolts(int chan, double t_sec)
+{
+    int d = chan / ADS_SIM_CHAN_PER_DEVICE, i = chan % ADS_SIM_CHAN_PER_DEVICE;
+    byte mux = regs[d][CH1SET+i] & 0x07;
+    double fs = getSampleRate_Hz();
+    if (mux == 0b101) {
+        //the internal test signal: +/- (VREF/2.4) mV, or twice that, from CONFIG2
+        byte config2 = regs[d][CONFIG2];
+        double amp = ((config2 & 0x04) ? 2.0 : 1.0) * ADS_SIM_VREF / 2.4 * 1.0e-3;
+        switch (config2 & 0x03) {
+            case 0: return amp * squareThroughSinc3(ADS_SIM_FCLK_HZ / (1 << 21), 0.0, t_sec);
+            case 1: return amp * squareThroughSinc3(ADS_SIM_FCLK_HZ / (1 << 20), 0.0, t_sec);
+            case 3: return amp;
+            default: return 0.0;
+        }
+    }
+    if (mux != 0b000) return 0.0;  //shorted, or one of the supply or temperature readings
+
+    //the electrode: its offset, plus whatever signal is on it
+    double v = dc_V[chan];
+    if (amp_V[chan] != 0.0) {
+        //the sinc3 filter takes a little off, and delays it by 1.5 samples
+        double x = M_PI * freq_Hz[chan] / fs;
+        double droop = (x > 0.0) ? pow(sin(x)/x, 3) : 1.0;
+        v += amp_V[chan] * droop * sin(2.0*M_PI*freq_Hz[chan]*(t_sec - 1.5/fs));
+    }
+
+    //the lead-off current, through the electrode on each side that has it.  The N side is
+    //driven the other way, so in the difference that we measure, the two add up.
+    boolean onP = bitRead(regs[d][LOFF_SENSP], i), onN = bitRead(regs[d][LOFF_SENSN], i);
+    if (onP || onN) {
+        byte loff = regs[d][LOFF];
+        static const double current_A[] = {6.0e-9, 24.0e-9, 6.0e-6, 24.0e-6};
+        double drive_V = current_A[(loff >> 2) & 0x03] * ((onP ? ohmsP[chan] : 0.0) + (onN ? ohmsN[chan] : 0.0));
+        if (bitRead(regs[d][LOFF_FLIP], i)) drive_V = -drive_V;
+        switch (loff & 0x03) {
+            case 0: v += drive_V; break;                                                          //DC
+            case 1: v += drive_V * squareThroughSinc3(ADS_SIM_FCLK_HZ / (1 << 18), 0.0, t_sec); break;  //7.8 Hz
+            case 2: v += drive_V * squareThroughSinc3(ADS_SIM_FCLK_HZ / (1 << 16), 0.0, t_sec); break;  //31.2 Hz
+            case 3: v += drive_V * squareThroughSinc3(fs / 4.0, 0.125, t_sec); break;                 //fs/4
+        }
+    }
+    return v;
+}
+
+
+//---------------------------------------------------------------------------------
+//the serial interface
+
+void ADS1299Sim::select(void)
+{
+    selected = true;
+    opcodeBytes = 0;
+    bytesLeft = 0;
+    readPos = rdatac ? 0 : -1;  //in RDATAC mode, the frame comes out as soon as we start clocking
+}
+
+void ADS1299Sim::deselect(void)
+{
+    selected = false;
+    readPos = -1;
+    opcodeBytes = 0;   //CS high resets the serial interface
+    bytesLeft = 0;
+}
+
+boolean ADS1299Sim::isDRDYLow(void)
+{
+    hostAdvance(pinRead_ns);
+    return drdyLow;
+}
+
+byte ADS1299Sim::nextOutput(void)
+{
+    if ((readPos >= 0) && (readPos < nDevices*ADS_SIM_FRAME_BYTES_PER_DEVICE)) {
+        if (readPos == 0) {
+            //the first clock of the frame
+            if (frameFresh) {
+                framesRead++;
+                if (logReads) readLog.push_back(frameConversion);
+            } else {
+                rereads++;
+            }
+            frameFresh = false;
+            drdyLow = false;
+        }
+        return frame[readPos++];
+    }
+    if ((opcodeBytes == 2) && (command >= 0x20) && (command < 0x40) && (bytesLeft > 0)) {
+        bytesLeft--;
+        return regs[0][(regAddr++) % ADS_SIM_N_REGISTERS];
+    }
+    return 0x00;
+}
+
+byte ADS1299Sim::transfer(byte in)
+{
+    spiBytes++;
+    byte out = selected ? nextOutput() : 0x00;
+    hostAdvance(byte_ns + byteOverhead_ns);
+    if (selected) handleCommand(in);
+    return out;
+}
+
+void ADS1299Sim::handleCommand(byte in)
+{
+    //the rest of a RREG or WREG
+    if (opcodeBytes == 1) {
+        bytesLeft = (in & 0x1F) + 1;
+        opcodeBytes = 2;
+        return;
+    }
+    if (opcodeBytes == 2) {
+        if ((command >= 0x40) && (bytesLeft > 0)) {
+            int reg = (regAddr++) % ADS_SIM_N_REGISTERS;
+            bytesLeft--;
+            if ((reg == ID) || (reg == LOFF_STATP) || (reg == LOFF_STATN)) return;  //read-only
+            boolean newRate = (reg == CONFIG1) && ((in ^ regs[0][CONFIG1]) & 0x07);
+            for (int d=0; d < nDevices; d++) regs[d][reg] = in;
+            if (newRate && converting) restartConversions();  //the new rate starts from here
+        }
+        if ((command >= 0x20) && (command < 0x40)) return;  //RREG: the bytes coming in don't matter
+        if (bytesLeft == 0) opcodeBytes = 0;
+        return;
+    }
+
+    //a new command
+    if ((in >= 0x20) && (in < 0x60)) {
+        if (rdatac) {
+            ignoredCommands++;   //the datasheet says to send SDATAC first
+            return;
+        }
+        command = in;
+        regAddr = in & 0x1F;
+        opcodeBytes = 1;
+        if (in >= 0x40) registerWrites++;
+        return;
+    }
+    switch (in) {
+        case _WAKEUP:
+        case _STANDBY:
+            break;
+        case _RESET:
+            for (int d=0; d < ADS_SIM_MAX_DEVICES; d++) {
+                for (int r=0; r < ADS_SIM_N_REGISTERS; r++) regs[d][r] = resetValues[r];
+            }
+            rdatac = true;   //as at power up
+            if (converting) restartConversions();
+            break;
+        case _START:
+            converting = true;
+            frameFresh = false;
+            drdyLow = false;
+            restartConversions();
+            break;
+        case _STOP:
+            converting = false;
+            break;
+        case _RDATAC:
+            rdatac = true;
+            break;
+        case _SDATAC:
+            rdatac = false;
+            readPos = -1;
+            break;
+        case _RDATA:
+            if (!rdatac) readPos = 0;  //the frame comes out on the next clocks
+            break;
+        default:
+            break;   //0x00 is what we send while reading, and means nothing
+    }
+}
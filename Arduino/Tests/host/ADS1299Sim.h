@@ -0,0 +1,138 @@
+//
+//  ADS1299Sim.h
+//  Part of the host build of the OpenBCI Arduino libraries (see ../README.txt)
+//
+//  A simulated daisy chain of ADS1299s, sitting on the host's "SPI port" (the
+//  ADS1299_SPI_Host policy in ADS1299_SPI.h talks to it).  It is the chip as the
+//  driver sees it, from the datasheet:
+//    * the SPI commands (WAKEUP, STANDBY, RESET, START, STOP, RDATAC, SDATAC, RDATA,
+//      RREG, WREG).  In RDATAC mode, only the commands that don't need more bytes are
+//      heard, so a RREG or WREG sent then is ignored (and counted, as it's a bug).
+//    * the registers, with their reset values.  All of the chips in the chain hear
+//      every command, so they all get the same register writes.
+//    * conversions at the rate in CONFIG1, once START has been sent.  DRDY goes low
+//      when a conversion is done and goes back high when the frame starts to be read.
+//      If the frame isn't read before the next conversion, it is lost.  The frame is
+//      27 bytes per chip: 3 status bytes and 8 channels of 3 bytes, first chip first.
+//    * what each channel measures: a DC offset plus a sine wave, the lead-off current
+//      (DC or AC square wave, at the LOFF settings) times the electrode impedance,
+//      the internal test signal, or nothing (shorted or powered down), at the channel's
+//      gain, through the sinc3 decimation filter, plus noise.
+//  Register writes don't restart the conversions here (the real chip doesn't either,
+//  except for a few settings), so the only gaps in the data are the frames that the
+//  code didn't read in time.
+//
+//  It keeps count of the conversions, the frames read, the frames lost, and the frames
+//  that were still being read when the next conversion landed (torn), and it can
+//  remember which conversion each frame that was read came from.  With the test pattern
+//  on, every value in the frame says which conversion and channel it came from.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#ifndef ____ADS1299Sim__
+#define ____ADS1299Sim__
+
+#include <Arduino.h>
+#include <vector>
+#include <random>
+
+#define ADS_SIM_MAX_DEVICES (8)
+#define ADS_SIM_CHAN_PER_DEVICE (8)
+#define ADS_SIM_MAX_CHAN (ADS_SIM_MAX_DEVICES*ADS_SIM_CHAN_PER_DEVICE)
+#define ADS_SIM_N_REGISTERS (24)
+#define ADS_SIM_FRAME_BYTES_PER_DEVICE (27)
+#define ADS_SIM_VREF (4.5)
+#define ADS_SIM_FCLK_HZ (2048000.0)
+#define ADS_SIM_DEVICE_ID (0x3E)
+
+class ADS1299Sim {
+public:
+    static ADS1299Sim &chip();                  //the one on the SPI port
+
+    void powerUp(int nDevices);                 //registers to their defaults, stopped, in RDATAC mode, counters cleared
+    int getNDevices(void) { return nDevices; }
+
+    //the SPI port (through ADS1299_SPI_Host)
+    void begin(int sck_MHz, int drdyPin);
+    void select(void);
+    void deselect(void);
+    byte transfer(byte in);
+    boolean isDRDYLow(void);                    //reading the pin takes a moment, like anything else
+    void setByteOverhead_ns(uint32_t ns) { byteOverhead_ns = ns; }  //CPU time per SPI byte on top of the 8 clocks
+    void setPinReadCost_ns(uint32_t ns) { pinRead_ns = ns; }
+
+    //what the channels (counting from 0, across all of the chips) are hooked up to
+    void setSignal(int chan, double dc_V, double amp_V, double freq_Hz);
+    void setElectrodes(int chan, double ohmsP, double ohmsN);  //the impedance the lead-off current goes through
+    void setNoise(double rms_V, unsigned int seed = 1);
+    void setTestPattern(boolean state) { testPattern = state; }  //see patternValue()
+    static long patternValue(long conversion, int chan);        //what each channel says with the test pattern on
+
+    //the registers of one chip, as they are now
+    byte getRegister(int reg, int device = 0) { return regs[device][reg]; }
+    double getSampleRate_Hz(void);
+    boolean isConverting(void) { return converting; }
+    boolean isRDATAC(void) { return rdatac; }
+
+    //what has happened since powerUp() (or resetCounters())
+    void resetCounters(void);
+    unsigned long conversions;                  //since START
+    unsigned long framesRead;                   //conversions whose frames were read (at least started)
+    unsigned long framesLost;                   //conversions that were replaced before anyone read them
+    unsigned long framesTorn;                   //reads that a new conversion landed in the middle of
+    unsigned long rereads;                      //frames read a second time (nothing new since the last read)
+    unsigned long ignoredCommands;              //RREG/WREG sent in RDATAC mode
+    unsigned long registerWrites;               //WREG commands
+    unsigned long spiBytes;
+    void setLogReads(boolean state) { logReads = state; readLog.clear(); }
+    std::vector<long> readLog;                  //which conversion (from 1) each frame that was read came from
+
+    //the simulated clock hooks (see hostAttachDevice)
+    static void update(uint64_t now_ns);
+    static uint64_t nextEvent(void);
+
+private:
+    ADS1299Sim();
+    int nDevices;
+    byte regs[ADS_SIM_MAX_DEVICES][ADS_SIM_N_REGISTERS];
+    int drdyPin;
+    uint64_t byte_ns;
+    uint32_t byteOverhead_ns, pinRead_ns;
+
+    //conversions
+    boolean converting;
+    boolean rdatac;
+    uint64_t startTime_ns;                      //when START was sent
+    uint64_t nextConversion_ns;
+    uint64_t period_ns;
+    boolean drdyLow;
+    boolean frameFresh;                         //converted, and not yet read
+    long frameConversion;                       //which conversion is in the output register
+    byte frame[ADS_SIM_MAX_DEVICES*ADS_SIM_FRAME_BYTES_PER_DEVICE];
+    void convert(uint64_t t_ns);
+    void restartConversions(void);
+    double channelVolts(int chan, double t_sec);
+    double squareThroughSinc3(double f_Hz, double phase0, double t_sec);
+
+    //the serial interface
+    boolean selected;
+    int readPos;                                //next frame byte to go out, or -1 if we're not sending the frame
+    byte command;                               //RREG or WREG opcode waiting for its second byte, or the one in progress
+    int bytesLeft;                              //register bytes still to come (WREG) or go (RREG)
+    int regAddr;
+    int opcodeBytes;                            //0, 1 (have the first opcode byte), 2 (have both)
+    void handleCommand(byte in);
+    byte nextOutput(void);
+
+    //the inputs
+    double dc_V[ADS_SIM_MAX_CHAN], amp_V[ADS_SIM_MAX_CHAN], freq_Hz[ADS_SIM_MAX_CHAN];
+    double ohmsP[ADS_SIM_MAX_CHAN], ohmsN[ADS_SIM_MAX_CHAN];
+    double noise_V;
+    std::mt19937 rng;
+    std::normal_distribution<double> gauss;
+    boolean testPattern;
+    boolean logReads;
+};
+
+#endif
@@ -0,0 +1,272 @@
+//
+//  Arduino.cpp (host)
+//  Part of the host build of the OpenBCI Arduino libraries (see ../README.txt)
+//
+//  The simulated clock, pins, interrupts, and Serial port.  See Arduino.h.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "Arduino.h"
+#include <deque>
+#include <vector>
+
+HardwareSerial Serial;
+uint32_t hostCallCost_ns = 250;   //about four instructions on a 16 MHz Uno
+
+static uint64_t now_ns = 0;
+static int pinValue[HOST_N_PINS];
+
+#define HOST_MAX_DEVICES (4)
+static HostDeviceUpdate devices[HOST_MAX_DEVICES];
+static HostDeviceNextEvent deviceEvents[HOST_MAX_DEVICES];
+static int nDevices = 0;
+
+static void (*isrs[HOST_N_PINS])(void);
+static boolean pending[HOST_N_PINS];
+static unsigned long isrCount[HOST_N_PINS];
+static boolean interruptsOn = true;
+static boolean inISR = false;
+
+//run any interrupt that is waiting, unless we're already in one or they're off
+static void dispatchInterrupts(void)
+{
+    if (inISR) return;
+    boolean again = true;
+    while (again && interruptsOn) {
+        again = false;
+        for (int i=0; i < HOST_N_PINS; i++) {
+            if (!pending[i] || (isrs[i] == NULL)) continue;
+            pending[i] = false;
+            isrCount[i]++;
+            inISR = true;
+            interruptsOn = false;   //as on the AVR, an ISR runs with interrupts off
+            isrs[i]();
+            interruptsOn = true;
+            inISR = false;
+            again = true;
+        }
+    }
+}
+
+uint64_t hostNanos(void) { return now_ns; }
+
+//Move time forward, stopping at each thing that the hardware does on the way, so that an
+//interrupt gets to run right when it would have.  Time spent in the interrupt comes out of
+//the time that we were asked to wait, just like on the real thing.
+void hostAdvance(uint64_t ns)
+{
+    uint64_t target = now_ns + ns;
+    do {
+        uint64_t step = target;
+        for (int i=0; i < nDevices; i++) {
+            uint64_t t = deviceEvents[i]();
+            if ((t > now_ns) && (t < step)) step = t;
+        }
+        if (step > now_ns) now_ns = step;
+        for (int i=0; i < nDevices; i++) devices[i](now_ns);
+        dispatchInterrupts();
+    } while (now_ns < target);
+}
+
+void hostAttachDevice(HostDeviceUpdate update, HostDeviceNextEvent nextEvent)
+{
+    for (int i=0; i < nDevices; i++) if (devices[i] == update) return;
+    if (nDevices >= HOST_MAX_DEVICES) return;
+    devices[nDevices] = update;
+    deviceEvents[nDevices] = nextEvent;
+    nDevices++;
+}
+
+void hostReset(void)
+{
+    now_ns = 0;
+    for (int i=0; i < HOST_N_PINS; i++) {
+        pinValue[i] = LOW;
+        isrs[i] = NULL;
+        pending[i] = false;
+        isrCount[i] = 0;
+    }
+    interruptsOn = true;
+    inISR = false;
+    hostPinInterrupts = true;
+    Serial.begin(0);
+    Serial.clearSent();
+}
+
+boolean hostDisableInterrupts(void)
+{
+    boolean wasOn = interruptsOn;
+    interruptsOn = false;
+    return wasOn;
+}
+
+void hostRestoreInterrupts(boolean wasEnabled)
+{
+    interruptsOn = wasEnabled;
+    if (interruptsOn) dispatchInterrupts();
+}
+
+void hostRaiseInterrupt(int interruptNum)
+{
+    if ((interruptNum < 0) || (interruptNum >= HOST_N_PINS)) return;
+    if (isrs[interruptNum] != NULL) pending[interruptNum] = true;  //it runs when time next moves
+}
+
+unsigned long hostInterruptCount(int interruptNum)
+{
+    if ((interruptNum < 0) || (interruptNum >= HOST_N_PINS)) return 0;
+    return isrCount[interruptNum];
+}
+
+void interrupts(void) { hostRestoreInterrupts(true); }
+void noInterrupts(void) { hostDisableInterrupts(); }
+
+boolean hostPinInterrupts = true;
+
+int digitalPinToInterrupt(int pin)
+{
+    if (!hostPinInterrupts) return NOT_AN_INTERRUPT;
+    return ((pin >= 0) && (pin < HOST_N_PINS)) ? pin : NOT_AN_INTERRUPT;
+}
+
+//every pin can interrupt, on the falling edge (that's all the simulated chip makes)
+void attachInterrupt(int interruptNum, void (*isr)(void), int mode)
+{
+    if ((interruptNum < 0) || (interruptNum >= HOST_N_PINS)) return;
+    isrs[interruptNum] = isr;
+    pending[interruptNum] = false;
+}
+
+void detachInterrupt(int interruptNum)
+{
+    if ((interruptNum < 0) || (interruptNum >= HOST_N_PINS)) return;
+    isrs[interruptNum] = NULL;
+    pending[interruptNum] = false;
+}
+
+void pinMode(int pin, int mode)
+{
+    if ((pin >= 0) && (pin < HOST_N_PINS) && (mode == INPUT_PULLUP)) pinValue[pin] = HIGH;
+}
+
+void digitalWrite(int pin, int value)
+{
+    if ((pin >= 0) && (pin < HOST_N_PINS)) pinValue[pin] = value;
+}
+
+int digitalRead(int pin)
+{
+    return ((pin >= 0) && (pin < HOST_N_PINS)) ? pinValue[pin] : LOW;
+}
+
+int analogRead(int pin)
+{
+    return 512;
+}
+
+void delay(unsigned long ms) { hostAdvance((uint64_t)ms * 1000000ULL); }
+void delayMicroseconds(unsigned int us) { hostAdvance((uint64_t)us * 1000ULL); }
+unsigned long micros(void) { hostAdvance(hostCallCost_ns); return (unsigned long)(now_ns / 1000ULL); }
+unsigned long millis(void) { hostAdvance(hostCallCost_ns); return (unsigned long)(now_ns / 1000000ULL); }
+
+
+//The UART.  txDoneAt is when the last byte in the buffer will have gone out, so the
+//number of bytes still waiting at any moment follows from it.
+static uint64_t txDoneAt = 0;
+static uint64_t byte_ns = 0;
+static std::vector<uint8_t> sentData;
+static std::deque<uint8_t> rxData;
+
+void HardwareSerial::begin(unsigned long b)
+{
+    baud = b;
+    byte_ns = (baud > 0) ? (10ULL * 1000000000ULL + baud/2) / baud : 0;  //8N1
+    txDoneAt = now_ns;
+    blockedWrites = 0;
+    busy_ns = 0;
+    writeCalls = 0;
+    rxData.clear();
+}
+
+static int txQueued(void)
+{
+    if ((byte_ns == 0) || (txDoneAt <= now_ns)) return 0;
+    return (int)((txDoneAt - now_ns + byte_ns - 1) / byte_ns);
+}
+
+int HardwareSerial::availableForWrite(void)
+{
+    return SERIAL_TX_BUFFER_SIZE - txQueued();
+}
+
+void HardwareSerial::flush(void)
+{
+    if (txDoneAt > now_ns) hostAdvance(txDoneAt - now_ns);
+}
+
+size_t HardwareSerial::write(uint8_t value)
+{
+    return write(&value, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    writeCalls++;
+    for (size_t i=0; i < size; i++) {
+        if (txQueued() >= SERIAL_TX_BUFFER_SIZE) {
+            //wait for the oldest byte to go out, like the Arduino core does
+            uint64_t wait = txDoneAt - (SERIAL_TX_BUFFER_SIZE-1)*byte_ns - now_ns;
+            blockedWrites++;
+            busy_ns += wait;
+            hostAdvance(wait);
+        }
+        if (txDoneAt < now_ns) txDoneAt = now_ns;
+        txDoneAt += byte_ns;
+        sentData.push_back(buffer[i]);
+    }
+    return size;
+}
+
+size_t HardwareSerial::print(long value, int base)
+{
+    if ((base == DEC) || (value >= 0)) {
+        char str[24];
+        snprintf(str, sizeof(str), (base == HEX) ? "%lX" : "%ld", value);
+        return write(str);
+    }
+    return print((unsigned long)value, base);
+}
+
+size_t HardwareSerial::print(unsigned long value, int base)
+{
+    char str[24];
+    snprintf(str, sizeof(str), (base == HEX) ? "%lX" : "%lu", value);
+    return write(str);
+}
+
+size_t HardwareSerial::print(double value, int digits)
+{
+    char str[48];
+    snprintf(str, sizeof(str), "%.*f", digits, value);
+    return write(str);
+}
+
+int HardwareSerial::available(void) { return (int)rxData.size(); }
+int HardwareSerial::peek(void) { return rxData.empty() ? -1 : rxData.front(); }
+int HardwareSerial::read(void)
+{
+    if (rxData.empty()) return -1;
+    int value = rxData.front();
+    rxData.pop_front();
+    return value;
+}
+
+void HardwareSerial::injectInput(const uint8_t *data, size_t size)
+{
+    for (size_t i=0; i < size; i++) rxData.push_back(data[i]);
+}
+
+size_t HardwareSerial::sentBytes(void) { return sentData.size(); }
+const uint8_t *HardwareSerial::sent(void) { return sentData.empty() ? NULL : &sentData[0]; }
+void HardwareSerial::clearSent(void) { sentData.clear(); }
@@ -0,0 +1,148 @@
+//
+//  Arduino.h (host)
+//  Part of the host build of the OpenBCI Arduino libraries (see ../README.txt)
+//
+//  Just enough of the Arduino core to build the ADS1299 and Biquad libraries on a
+//  PC, so that they can be tested and timed there.  Time is simulated: it only moves
+//  when the code waits (delay, delayMicroseconds), moves bytes over the SPI port or
+//  the Serial port, or asks what time it is.  Everything that happens "in hardware"
+//  (the ADS1299 converting, the UART sending) happens as time moves, and that is when
+//  an attached interrupt can fire, just as it would between two instructions on the
+//  real thing.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#ifndef ____HostArduino__
+#define ____HostArduino__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <type_traits>
+
+#define ARDUINO (10600)       //this core has Serial.availableForWrite()
+#define ADS1299_HOST (1)      //picks the simulated chip in ADS1299_SPI.h
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef unsigned int word;
+
+#define HIGH (1)
+#define LOW (0)
+#define INPUT (0)
+#define OUTPUT (1)
+#define INPUT_PULLUP (2)
+#define CHANGE (1)
+#define FALLING (2)
+#define RISING (3)
+#define DEC (10)
+#define HEX (16)
+#define A0 (14)
+#define NOT_AN_INTERRUPT (-1)
+#define HOST_N_PINS (20)
+
+#define _BV(bit) (1UL << (bit))
+#define bit(b) (1UL << (b))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+
+//functions rather than the usual macros, so that the C++ library headers still work
+template <class T, class U> inline typename std::common_type<T,U>::type min(T a, U b) { return (b < a) ? b : a; }
+template <class T, class U> inline typename std::common_type<T,U>::type max(T a, U b) { return (a < b) ? b : a; }
+
+//strings in "flash" are just strings
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+#define PROGMEM
+#define PSTR(s) (s)
+
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+int analogRead(int pin);
+int digitalPinToInterrupt(int pin);
+void attachInterrupt(int interruptNum, void (*isr)(void), int mode);
+void detachInterrupt(int interruptNum);
+void interrupts(void);
+void noInterrupts(void);
+
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+unsigned long micros(void);
+unsigned long millis(void);
+
+//The simulated clock, in nanoseconds.  hostAdvance() is how the simulated hardware
+//(and the waiting functions above) move time along.
+uint64_t hostNanos(void);
+void hostAdvance(uint64_t ns);
+void hostReset(void);                            //time back to zero, pins and interrupts cleared
+extern uint32_t hostCallCost_ns;                 //what each micros()/millis() call costs
+//Simulated hardware is told whenever time moves, and says when it next has something to do
+//(like finishing a conversion), so that time never jumps over it.
+typedef void (*HostDeviceUpdate)(uint64_t now_ns);
+typedef uint64_t (*HostDeviceNextEvent)(void);
+void hostAttachDevice(HostDeviceUpdate update, HostDeviceNextEvent nextEvent);
+
+//What the SPI policy's Lock uses.  Turns interrupts off, and says whether they were on.
+boolean hostDisableInterrupts(void);
+void hostRestoreInterrupts(boolean wasEnabled);
+void hostRaiseInterrupt(int interruptNum);       //the simulated hardware's edge on that pin
+extern boolean hostPinInterrupts;                //false makes it a board with no pin interrupts at all
+unsigned long hostInterruptCount(int interruptNum);
+
+//The UART.  It sends at the baud rate (10 bits per byte) out of a 64 byte buffer, like the
+//Uno's, and keeps everything it has been given so that the tests can decode it.
+#define SERIAL_TX_BUFFER_SIZE (64)
+class HardwareSerial {
+public:
+    void begin(unsigned long baud);
+    void end(void) {}
+    int available(void);
+    int read(void);
+    int peek(void);
+    void flush(void);                            //wait until the buffer is empty
+    int availableForWrite(void);
+    size_t write(uint8_t value);
+    size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *str) { return write((const uint8_t *)str, strlen(str)); }
+    operator bool() { return true; }
+
+    size_t print(const __FlashStringHelper *s) { return write((const char *)s); }
+    size_t print(const char *s) { return write(s); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+    size_t println(void) { return write("\r\n"); }
+    template <class T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <class T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+
+    //for the tests
+    unsigned long getBaud(void) { return baud; }
+    void injectInput(const uint8_t *data, size_t size);   //as if the PC had sent it
+    size_t sentBytes(void);                      //bytes given to write() since clearSent()
+    const uint8_t *sent(void);
+    void clearSent(void);
+    unsigned long getBlockedWrites(void) { return blockedWrites; }  //writes that had to wait for room
+    uint64_t getBusy_ns(void) { return busy_ns; }                   //time spent waiting for room
+    unsigned long getWriteCalls(void) { return writeCalls; }        //calls to write(), since begin()
+
+private:
+    unsigned long baud;
+    unsigned long blockedWrites;
+    uint64_t busy_ns;
+    unsigned long writeCalls;
+};
+extern HardwareSerial Serial;
+
+#endif
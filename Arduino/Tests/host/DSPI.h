@@ -0,0 +1,42 @@
+//
+//  DSPI.h (host)
+//  Part of the host build of the OpenBCI Arduino libraries (see ../README.txt)
+//
+//  Just enough of chipKIT's DSPI library, and of the chipKIT core's interrupt
+//  functions, for test_spi_policy to build the ADS1299_SPI_DSPI policy.  The port
+//  remembers how it was set up and what went through it, and it answers each byte
+//  with its complement.
+//
+
+#ifndef ____HostDSPI__
+#define ____HostDSPI__
+
+#include <Arduino.h>
+
+#define DSPI_MODE0 (0)
+#define DSPI_MODE1 (1)
+#define DSPI_MODE2 (2)
+#define DSPI_MODE3 (3)
+
+class DSPI0 {
+public:
+    DSPI0() : csPin(-1), mode(-1), speed(0), csLevel(-1), nBytes(0), lastByte(0) {}
+    boolean begin(int pin) { csPin = pin; csLevel = HIGH; return true; }
+    void setMode(int m) { mode = m; }
+    unsigned long setSpeed(unsigned long spd) { speed = spd; return speed; }
+    void setSelect(int level) { csLevel = level; }
+    byte transfer(byte val) { nBytes++; lastByte = val; return (byte)~val; }
+
+    int csPin, mode;
+    unsigned long speed;
+    int csLevel;
+    unsigned long nBytes;
+    byte lastByte;
+};
+
+//the core's, which return the old interrupt state and put it back
+static uint32_t hostPic32Status = 1;   //bit 0 is "interrupts on"
+inline uint32_t disableInterrupts(void) { uint32_t old = hostPic32Status; hostPic32Status &= ~1UL; return old; }
+inline void restoreInterrupts(uint32_t status) { hostPic32Status = status; }
+
+#endif
@@ -0,0 +1,241 @@
+//
+//  PacketParser.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see ../README.txt)
+//
+//  See PacketParser.h.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "PacketParser.h"
+#include <ADS1299Manager.h>
+
+long parseInt32(const byte *ptr)
+{
+    uint32_t value = (uint32_t)ptr[0] | ((uint32_t)ptr[1] << 8) | ((uint32_t)ptr[2] << 16) | ((uint32_t)ptr[3] << 24);
+    return (long)(int32_t)value;
+}
+
+long parseInt24(const byte *ptr)
+{
+    uint32_t value = ((uint32_t)ptr[0] << 16) | ((uint32_t)ptr[1] << 8) | (uint32_t)ptr[2];
+    if (value & 0x800000) value |= 0xFF000000;
+    return (long)(int32_t)value;
+}
+
+void PacketParser::reset(void)
+{
+    samples.clear();
+    packets.clear();
+    cobsBuffer.clear();
+    goodPackets = 0;
+    badPackets = 0;
+    skippedPackets = 0;
+    state = 0;
+    haveDeltaRef = false;
+    prevSampleNumber = 0;
+}
+
+void PacketParser::parse(const byte *data, size_t nBytes)
+{
+    for (size_t i=0; i < nBytes; i++) parse(data[i]);
+}
+
+void PacketParser::parse(byte actbyte)
+{
+    if (cobs) {
+        parseCOBS(actbyte);
+        return;
+    }
+    switch (state) {
+        case 0:
+            //look for a start byte
+            if ((actbyte >= PCKT_START) && (actbyte <= PCKT_START_LEADOFF_SCAN)) {
+                format = actbyte;
+                state = 1;
+            }
+            break;
+        case 1:
+            if (format == PCKT_START_BATCH) {
+                //a batch gives the number of channels, and then the number of samples
+                batchN = actbyte;
+                if (batchN == 0) {
+                    badPackets++;
+                    state = 0;
+                } else {
+                    state = 4;
+                }
+                break;
+            }
+            //the length of the payload, which has to be a sample number and whole samples
+            payloadLength = actbyte;
+            byteCount = 0;
+            if ((format == PCKT_START) && ((payloadLength < 8) || ((payloadLength % 4) != 0))) payloadLength = -1;
+            if ((format == PCKT_START_PACKED) && ((payloadLength < 7) || (((payloadLength-4) % 3) != 0))) payloadLength = -1;
+            if ((format == PCKT_START_DELTA) && (payloadLength < 2)) payloadLength = -1;
+            if (payloadLength == 0) payloadLength = -1;
+            if (payloadLength < 0) {
+                badPackets++;
+                state = 0;
+            } else {
+                payload.resize(payloadLength);
+                state = 2;
+            }
+            break;
+        case 2:
+            //collect the payload
+            payload[byteCount++] = actbyte;
+            if (byteCount == payloadLength) state = 3;
+            break;
+        case 3:
+            //look for the end byte.  Either way, look for the next packet after this.
+            if (actbyte == PCKT_END) {
+                goodPackets++;
+                interpretPayload();
+            } else {
+                badPackets++;
+                haveDeltaRef = false;   //we may have missed a keyframe
+            }
+            state = 0;
+            break;
+        case 4:
+            //the number of samples in a batch.  Then it's the sample number and the samples.
+            if (actbyte == 0) {
+                badPackets++;
+                state = 0;
+            } else {
+                payloadLength = 4 + 3*batchN*actbyte;
+                byteCount = 0;
+                payload.resize(payloadLength);
+                state = 2;
+            }
+            break;
+    }
+}
+
+void PacketParser::interpretPayload(void)
+{
+    if ((format != PCKT_START) && (format != PCKT_START_PACKED) && (format != PCKT_START_DELTA) && (format != PCKT_START_BATCH)) {
+        ParsedPacket packet;
+        packet.format = format;
+        packet.payload.assign(payload.begin(), payload.begin() + payloadLength);
+        packet.nSamplesBefore = samples.size();
+        packets.push_back(packet);
+        return;
+    }
+    ParsedSample sample;
+    sample.format = format;
+    sample.sampleNumber = 0;
+    if (format == PCKT_START_DELTA) {
+        if (!interpretDeltaPayload(&sample)) {
+            skippedPackets++;
+            return;
+        }
+    } else if (format == PCKT_START_BATCH) {
+        //each sample of the batch is its own sample, numbered on from the first
+        long firstSampleNumber = parseInt32(&payload[0]);
+        int K = (payloadLength - 4) / (3*batchN);
+        for (int Isamp=0; Isamp < K; Isamp++) {
+            sample.sampleNumber = firstSampleNumber + Isamp;
+            sample.values.clear();
+            for (int Ichan=0; Ichan < batchN; Ichan++) sample.values.push_back(parseInt24(&payload[4 + 3*(Isamp*batchN + Ichan)]));
+            samples.push_back(sample);
+        }
+        prevSampleNumber = sample.sampleNumber;
+        return;
+    } else {
+        sample.sampleNumber = parseInt32(&payload[0]);
+        if (format == PCKT_START) {
+            //(the aux value, if there is one, looks just like another channel)
+            for (int i=4; i < payloadLength; i += 4) sample.values.push_back(parseInt32(&payload[i]));
+        } else {
+            for (int i=4; i < payloadLength; i += 3) sample.values.push_back(parseInt24(&payload[i]));
+            deltaRef = sample.values;   //a packed packet is also a keyframe for the delta format
+            haveDeltaRef = true;
+        }
+    }
+    prevSampleNumber = sample.sampleNumber;
+    samples.push_back(sample);
+}
+
+//rebuild the values from a delta packet.  Returns false if we can't.
+boolean PacketParser::interpretDeltaPayload(ParsedSample *sample)
+{
+    if (!haveDeltaRef) return false;   //still waiting for a keyframe
+
+    //make sure that this packet follows right after the previous one
+    sample->sampleNumber = prevSampleNumber + 1;
+    if (payload[0] != (byte)sample->sampleNumber) {
+        haveDeltaRef = false;
+        return false;
+    }
+
+    //decode each channel
+    size_t Ichan = 0;
+    int shift = 0;
+    uint32_t zigzag = 0;
+    for (int Ibyte = 1; Ibyte < payloadLength; Ibyte++) {
+        zigzag |= (uint32_t)(payload[Ibyte] & 0x7F) << shift;
+        shift += 7;
+        if ((payload[Ibyte] & 0x80) == 0) {
+            //that was the last byte of this channel
+            if (Ichan >= deltaRef.size()) break;
+            deltaRef[Ichan] += (long)(int32_t)((zigzag >> 1) ^ (0U - (zigzag & 1)));
+            Ichan++; shift = 0; zigzag = 0;
+        } else if (shift >= 28) {
+            break;   //no 24-bit change takes more than 4 bytes
+        }
+    }
+    if ((Ichan != deltaRef.size()) || (shift != 0)) {
+        haveDeltaRef = false;
+        return false;
+    }
+    sample->values = deltaRef;
+    return true;
+}
+
+//the COBS framing: everything up to the next zero is one packet
+void PacketParser::parseCOBS(byte actbyte)
+{
+    if (actbyte != PCKT_COBS_DELIMITER) {
+        cobsBuffer.push_back(actbyte);
+        return;
+    }
+    if (cobsBuffer.empty()) return;   //nothing there
+
+    //undo the byte stuffing
+    std::vector<byte> decoded;
+    size_t Ibyte = 0;
+    boolean ok = true;
+    while (Ibyte < cobsBuffer.size()) {
+        int code = cobsBuffer[Ibyte];
+        if (Ibyte + code > cobsBuffer.size()) { ok = false; break; }
+        for (int j=1; j < code; j++) decoded.push_back(cobsBuffer[Ibyte+j]);
+        Ibyte += code;
+        if ((code < 0xFF) && (Ibyte < cobsBuffer.size())) decoded.push_back(0);   //this is where a zero was
+    }
+    cobsBuffer.clear();
+
+    //the CRC covers the start byte and the payload
+    if (ok && (decoded.size() >= 3)) {
+        unsigned int crc = 0xFFFF;
+        for (size_t i=0; i < decoded.size()-2; i++) {
+            crc ^= (unsigned int)decoded[i] << 8;
+            for (int b=0; b < 8; b++) crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+        ok = ((crc & 0xFFFF) == (((unsigned int)decoded[decoded.size()-2] << 8) | decoded[decoded.size()-1]));
+    } else {
+        ok = false;
+    }
+    format = ok ? decoded[0] : 0;
+    payloadLength = ok ? (int)decoded.size() - 3 : 0;
+    if ((format == PCKT_START_PACKED) && ((payloadLength < 7) || (((payloadLength-4) % 3) != 0))) ok = false;
+    if ((format < PCKT_START) || (format > PCKT_START_LEADOFF_SCAN) || (format == PCKT_START_BATCH) || (format == PCKT_START_DELTA)) ok = false;
+    if (!ok) {
+        badPackets++;
+        return;
+    }
+    goodPackets++;
+    payload.assign(decoded.begin() + 1, decoded.end() - 2);
+    interpretPayload();
+}
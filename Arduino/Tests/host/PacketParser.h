@@ -0,0 +1,85 @@
+//
+//  PacketParser.h
+//  Part of the host build of the OpenBCI Arduino libraries (see ../README.txt)
+//
+//  The PC's side of the binary stream, as in interpretBinaryStream() in the Processing
+//  GUI (OpenBCI_ADS1299.pde), so that the tests can check what the Arduino sends against
+//  what the PC makes of it.  Feed it the bytes as they arrive, and it keeps every sample
+//  that it decodes.  Like the GUI, it looks for a start byte, reads the length, collects
+//  the payload, and throws the packet away if the end byte isn't where it should be.
+//
+//  The formats (see ADS1299Manager.h for the start bytes):
+//     PCKT_START          4-byte little-endian samples (writeChannelDataAsBinary)
+//     PCKT_START_PACKED   3-byte big-endian samples (writeChannelDataAsPackedBinary)
+//     PCKT_START_DELTA    the change since the previous sample, as zigzag varints
+//                         (writeChannelDataAsDelta).  Each packed packet is a keyframe.
+//                         After a bad or missing packet, the delta packets are skipped
+//                         until the next keyframe.
+//     PCKT_START_BATCH    K samples of N channels, packed, after the first one's sample
+//                         number (writeChannelDataAsBatch).  Each comes out as its own sample.
+//     PCKT_START_STATUS, _MARKER, _BANDPOWER, _IMPEDANCE, _LEADOFF_SCAN
+//                         kept as they came, in packets, along with where they were
+//                         in the stream of samples.
+//
+//  Or, made with cobs set, it's the COBS framing (writeCOBSPacket): the stream is split at
+//  the zeros, the byte stuffing is undone, and the CRC is checked.  What's inside is one
+//  of the packets above (just the packed samples, for the data), minus its length and end byte.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#ifndef ____PacketParser__
+#define ____PacketParser__
+
+#include <Arduino.h>
+#include <vector>
+
+//one sample, as the PC sees it
+struct ParsedSample {
+    byte format;                                //the start byte of the packet it came in
+    long sampleNumber;
+    std::vector<long> values;
+};
+
+//any other packet
+struct ParsedPacket {
+    byte format;                                //its start byte
+    std::vector<byte> payload;
+    size_t nSamplesBefore;                      //how many samples had come through before it
+};
+
+class PacketParser {
+public:
+    PacketParser(boolean cobs = false) : cobs(cobs) { reset(); }
+    void reset(void);                           //forget everything, and look for a start byte
+    void parse(byte actbyte);
+    void parse(const byte *data, size_t nBytes);
+
+    std::vector<ParsedSample> samples;          //every sample decoded so far
+    std::vector<ParsedPacket> packets;          //and every other packet
+    unsigned long goodPackets;
+    unsigned long badPackets;                   //bad length or missing end byte (or bad COBS, or bad CRC)
+    unsigned long skippedPackets;               //good packets that couldn't be decoded (a delta packet with no keyframe)
+
+private:
+    boolean cobs;
+    std::vector<byte> cobsBuffer;               //since the last zero
+    void parseCOBS(byte actbyte);
+    int state;
+    byte format;
+    int payloadLength;
+    int byteCount;
+    int batchN;                                 //channels in each sample of a batch packet
+    std::vector<byte> payload;
+    void interpretPayload(void);
+    std::vector<long> deltaRef;                 //the values of the previous sample, for the delta packets
+    boolean haveDeltaRef;
+    long prevSampleNumber;
+    boolean interpretDeltaPayload(ParsedSample *sample);
+};
+
+//the ways the values are written
+long parseInt32(const byte *ptr);               //little endian
+long parseInt24(const byte *ptr);               //big endian, two's complement
+
+#endif
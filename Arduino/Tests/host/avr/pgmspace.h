@@ -0,0 +1,24 @@
+//
+//  avr/pgmspace.h (host)
+//  Part of the host build of the OpenBCI Arduino libraries (see ../../README.txt)
+//
+//  On a PC there's only the one kind of memory, so reading "program memory" is
+//  just reading memory.
+//
+
+#ifndef ____HostPgmspace__
+#define ____HostPgmspace__
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define pgm_read_float(addr) (*(const float *)(addr))
+#define memcpy_P(dest, src, n) memcpy((dest), (src), (n))
+
+#endif
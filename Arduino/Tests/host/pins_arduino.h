@@ -0,0 +1,6 @@
+//
+//  pins_arduino.h (host)
+//  Part of the host build of the OpenBCI Arduino libraries (see ../README.txt)
+//
+//  Nothing to map: the simulated board's pins are just numbers (see Arduino.h).
+//
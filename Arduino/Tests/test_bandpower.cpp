@@ -0,0 +1,226 @@
+//
+//  test_bandpower.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  ADS1299BandPower (the Goertzel bins) against the math it stands in for, with the default
+//  theta, alpha, and beta bands (4-8, 8-13, and 13-30 Hz), 5 updates per second, at 250 Hz
+//  and 1 kHz.  Each channel gets something different: tones right on a bin, tones between
+//  bins (which leak into the other bands, with the rectangular window), white noise, a tone
+//  in noise, a tone outside of the bands, and nothing at all.  It checks that:
+//     * every band of every block matches the same bins worked out with a double-precision
+//       DFT of the same block (as an FFT would give them) to within 0.05 dB at 250 Hz and
+//       0.25 dB at 1 kHz, give or take a floor of leakage, in rms counts, 50 dB (250 Hz) or
+//       40 dB (1 kHz) below the channel's rms.  The bins are tuned with Q15 cosines, which
+//       are a little off at the low end of a long block (0.6% of a bin at 5 Hz, with 1 kHz).
+//       A tone between bins sits on the slope of the bin, so that's where it differs most,
+//       and a big tone leaks a little into the other bins (-43 dB at 1 kHz, -60 at 250 Hz).
+//     * a tone of amplitude A on a bin reads A^2/2 (its mean square) in its band, within
+//       the same tolerance, and nothing (below the floor) in the others
+//     * white noise of variance s^2 reads s^2 * 2*nBins/N in each band, on average over the
+//       300 blocks, within 20% (the theta band at 1 kHz is a single bin, which wanders 6%)
+//     * the packets from writeChannelDataAsBandPower, in the 0xA0...0xC0 framing and in COBS,
+//       come out of the PC's parser with the same band powers, one packet per block
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include "PacketParser.h"
+#include <ADS1299Manager.h>
+#include <vector>
+#include <random>
+#include <math.h>
+
+static ADS1299Manager ADS;
+
+#define N_CHAN (8)
+#define N_BANDS (3)
+#define UPDATE_HZ (5.0)
+#define DURATION_SEC (60.0)
+#define NOISE_SIGMA (300.0)      //counts
+
+static const double edges_Hz[N_BANDS+1] = { 4.0, 8.0, 13.0, 30.0 };
+
+//what's on each channel: a tone (amplitude in counts, frequency in Hz), and white noise
+struct ChannelSignal { double amp; double freq_Hz; double sigma; };
+static const ChannelSignal signals[N_CHAN] = {
+    { 2000.0, 10.0, 0.0 },          //on a bin, alpha
+    {  500.0, 20.0, 0.0 },          //on a bin, beta
+    { 2000.0,  6.0, 0.0 },          //between bins, theta
+    { 2000.0,  7.5, 0.0 },          //halfway between bins, right next to the alpha band
+    {    0.0,  0.0, NOISE_SIGMA },  //white noise
+    { 2000.0, 10.0, NOISE_SIGMA },  //a tone in the noise
+    { 2000.0, 50.0, 0.0 },          //on a bin, but above all of the bands
+    {    0.0,  0.0, 0.0 }           //nothing
+};
+
+//the power in each band, the way ADS1299BandPower defines it, from a DFT in double precision:
+//for each bin k in the band (k*fs/N from the lower edge up to the upper), 2*|X(k)|^2/N^2
+static double referencePower(const std::vector<long> &block, double fs_Hz, int Iband)
+{
+    const int N = block.size();
+    const double binWidth_Hz = fs_Hz / N;
+    double power = 0.0;
+    for (int k=1; 2*k < N; k++) {
+        double f_Hz = k * binWidth_Hz;
+        if ((f_Hz < edges_Hz[Iband]) || (f_Hz >= edges_Hz[Iband+1])) continue;
+        double re = 0.0, im = 0.0;
+        for (int n=0; n < N; n++) {
+            re += block[n] * cos(2.0*M_PI*k*n / N);
+            im -= block[n] * sin(2.0*M_PI*k*n / N);
+        }
+        power += 2.0 * (re*re + im*im) / ((double)N * N);
+    }
+    return power;
+}
+
+static double toCB(double power) { return (power > 1.0) ? 1000.0 * log10(power) : 0.0; }
+
+//the bins in a band
+static int binsInBand(double fs_Hz, int N, int Iband)
+{
+    int n = 0;
+    for (int k=1; 2*k < N; k++) if ((k * fs_Hz / N >= edges_Hz[Iband]) && (k * fs_Hz / N < edges_Hz[Iband+1])) n++;
+    return n;
+}
+
+//the band powers of one block, as they'd come out of the packets
+typedef std::vector<unsigned int> BlockPowers;   //[chan*N_BANDS + band]
+
+//run the packets through the PC's parser, and check that they say what bandPower said
+static void checkPackets(boolean cobs, const std::vector<BlockPowers> &expected, const std::vector<long> &lastSample, int blockLen)
+{
+    PacketParser parser(cobs);
+    parser.parse(Serial.sent(), Serial.sentBytes());
+    CHECK(parser.badPackets == 0);
+    CHECK(parser.samples.empty());
+    CHECK(parser.packets.size() == expected.size());
+    if (cobs) {
+        int nZeros = 0;
+        for (size_t i=0; i < Serial.sentBytes(); i++) if (Serial.sent()[i] == PCKT_COBS_DELIMITER) nZeros++;
+        CHECK(nZeros == (int)expected.size());
+    } else {
+        CHECK(Serial.sentBytes() == expected.size() * ADS.getBandPowerPacketBytes(N_CHAN, N_BANDS));
+    }
+    int nBad = 0;
+    for (size_t b=0; (b < parser.packets.size()) && (b < expected.size()); b++) {
+        const ParsedPacket &packet = parser.packets[b];
+        if ((packet.format != PCKT_START_BANDPOWER) || (packet.payload.size() != 8 + 2*N_CHAN*N_BANDS)) { nBad++; continue; }
+        const byte *p = &packet.payload[0];
+        if (parseInt32(p) != lastSample[b]) nBad++;
+        if (((p[4] << 8) | p[5]) != blockLen) nBad++;
+        if ((p[6] != N_CHAN) || (p[7] != N_BANDS)) nBad++;
+        for (int i=0; i < N_CHAN*N_BANDS; i++) {
+            if ((unsigned int)((p[8+2*i] << 8) | p[8+2*i+1]) != expected[b][i]) nBad++;
+        }
+    }
+    CHECK(nBad == 0);
+}
+
+int main(void)
+{
+    ADS1299Sim &chip = ADS1299Sim::chip();
+    const double rates_Hz[] = { 250.0, 1000.0 };
+    const double tol_cB[] = { 5.0, 25.0 };          //0.05 and 0.25 dB
+    const double floor_dB[] = { -50.0, -40.0 };     //re the channel's rms
+
+    for (int r=0; r < 2; r++) {
+        const double fs_Hz = rates_Hz[r];
+        const int blockLen = (int)(fs_Hz / UPDATE_HZ + 0.5);
+        const int nBlocks = (int)(DURATION_SEC * UPDATE_HZ);
+        ADS1299BandPower bandPower(N_CHAN, 6);
+        CHECK(bandPower.setup(fs_Hz, blockLen));
+        CHECK(bandPower.getNBands() == N_BANDS);
+
+        //the signal, rounded to counts
+        std::mt19937 rng(r+1);
+        std::normal_distribution<double> gauss(0.0, 1.0);
+        std::vector<std::vector<long> > data(N_CHAN, std::vector<long>(nBlocks * blockLen));
+        for (int chan=0; chan < N_CHAN; chan++) {
+            for (int i=0; i < nBlocks * blockLen; i++) {
+                double x = signals[chan].amp * sin(2.0*M_PI*signals[chan].freq_Hz*i / fs_Hz + 0.3*chan) + signals[chan].sigma * gauss(rng);
+                data[chan][i] = lround(x);
+            }
+        }
+
+        //the Goertzel bins, block by block, against the DFT of the same block
+        std::vector<BlockPowers> blocks;
+        std::vector<long> lastSample;
+        const double tolAmp = pow(10.0, tol_cB[r] / 2000.0) - 1.0;   //the tolerance, on the rms
+        double worstCB = 0.0, worstLeak = 0.0;
+        double noisePower[N_BANDS] = { 0.0, 0.0, 0.0 };
+        long sample[N_CHAN];
+        for (int b=0; b < nBlocks; b++) {
+            for (int i=0; i < blockLen; i++) {
+                for (int chan=0; chan < N_CHAN; chan++) sample[chan] = data[chan][b*blockLen + i];
+                boolean done = bandPower.process(sample);
+                CHECK(done == (i == blockLen-1));
+            }
+            BlockPowers powers(N_CHAN * N_BANDS);
+            for (int chan=0; chan < N_CHAN; chan++) {
+                std::vector<long> block(data[chan].begin() + b*blockLen, data[chan].begin() + (b+1)*blockLen);
+                double total = 1.0;   //the channel's mean square (plus a count^2, for the empty channel)
+                for (int i=0; i < blockLen; i++) total += (double)block[i] * block[i] / blockLen;
+                for (int Iband=0; Iband < N_BANDS; Iband++) {
+                    unsigned int cB = bandPower.getBandPower_cB(chan, Iband);
+                    powers[chan*N_BANDS + Iband] = cB;
+                    double ref = referencePower(block, fs_Hz, Iband);
+                    double power = (cB > 0) ? pow(10.0, cB / 1000.0) : 0.0;
+                    if (ref >= 0.1 * total) worstCB = max(worstCB, fabs(cB - toCB(ref)));
+                    //whatever the relative tolerance doesn't cover, on the rms, re the channel's rms
+                    double leak = (fabs(sqrt(power) - sqrt(ref)) - tolAmp * sqrt(ref)) / sqrt(total);
+                    worstLeak = max(worstLeak, leak);
+                    if (chan == 4) noisePower[Iband] += power / nBlocks;
+                }
+            }
+            blocks.push_back(powers);
+            lastSample.push_back((b+1)*blockLen - 1);
+        }
+        printf("%4.0f Hz, %d-sample blocks: worst error against the DFT %.1f cB (the big bands), leakage %.1f dB\n",
+            fs_Hz, blockLen, worstCB, 20.0 * log10(max(worstLeak, 1.0e-6)));
+        CHECK(worstCB <= tol_cB[r]);
+        CHECK(20.0 * log10(max(worstLeak, 1.0e-6)) <= floor_dB[r]);
+
+        //the tones on a bin, against A^2/2, from the last block.  Nothing else in the bands.
+        const BlockPowers &last = blocks.back();
+        const int toneChans[3] = { 0, 1, 6 };
+        for (int i=0; i < 3; i++) {
+            int chan = toneChans[i];
+            double expected = toCB(signals[chan].amp * signals[chan].amp / 2.0);
+            for (int Iband=0; Iband < N_BANDS; Iband++) {
+                boolean inBand = (signals[chan].freq_Hz >= edges_Hz[Iband]) && (signals[chan].freq_Hz < edges_Hz[Iband+1]);
+                if (inBand) CHECK_NEAR(last[chan*N_BANDS + Iband], expected, tol_cB[r]);
+                else CHECK(last[chan*N_BANDS + Iband] <= max(0.0, expected + 100.0 * floor_dB[r]));
+            }
+        }
+        for (int Iband=0; Iband < N_BANDS; Iband++) CHECK(last[7*N_BANDS + Iband] == 0);
+
+        //the white noise, on average, against its variance
+        printf("   white noise (%.0f counts rms), band power / expected:", NOISE_SIGMA);
+        for (int Iband=0; Iband < N_BANDS; Iband++) {
+            double expected = NOISE_SIGMA * NOISE_SIGMA * 2.0 * binsInBand(fs_Hz, blockLen, Iband) / blockLen;
+            printf(" %.3f", noisePower[Iband] / expected);
+            CHECK_NEAR(noisePower[Iband] / expected, 1.0, 0.20);
+        }
+        printf("\n");
+
+        //and the same thing again through writeChannelDataAsBandPower, in both framings
+        for (int cobs=0; cobs < 2; cobs++) {
+            hostReset();
+            chip.powerUp(1);
+            ADS.initialize(OPENBCI_V2, false);
+            ADS.setCOBSFraming(cobs != 0);
+            ADS1299BandPower packetPower(N_CHAN, 6);
+            CHECK(packetPower.setup(fs_Hz, blockLen));
+            Serial.clearSent();
+            for (long i=0; i < nBlocks * blockLen; i++) {
+                for (int chan=0; chan < N_CHAN; chan++) ADS.channelData[chan] = data[chan][i];
+                ADS.writeChannelDataAsBandPower(N_CHAN, i, &packetPower);
+            }
+            ADS.flushTX();
+            checkPackets(cobs != 0, blocks, lastSample, blockLen);
+        }
+    }
+
+    return hostTestResult("test_bandpower");
+}
@@ -0,0 +1,112 @@
+//
+//  test_biquad_block.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  Biquad_block, with each of its kernels (scalar, SSE2, AVX2, whichever this CPU has),
+//  against one Biquad per channel calling process() a sample at a time.  The lanes do the
+//  same arithmetic in the same order, so the answer has to be the same to the bit (it's
+//  checked to within 1e-6 of full scale anyway, so that a compiler that fuses a multiply
+//  and an add doesn't fail it).  The channel counts include ones that don't fill the
+//  lanes, and the data goes in as blocks of uneven length, so that each channel's history
+//  has to carry over from one block to the next.  It prints the worst difference.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include "HostSignals.h"
+#include <Biquad.h>
+#include <Biquad_block.h>
+
+struct FilterCase {
+    const char *name;
+    int type;
+    double Fc_Hz;
+    double Q;
+    double peakGainDB;
+};
+
+int main(void)
+{
+    const FilterCase filters[] = {
+        { "highpass 0.5 Hz", bq_type_highpass, 0.5, 0.5, 0.0 },
+        { "notch 60 Hz", bq_type_notch, 60.0, 4.0, 0.0 },
+        { "lowpass 40 Hz", bq_type_lowpass, 40.0, 0.707, 0.0 },
+        { "bandpass 10 Hz", bq_type_bandpass, 10.0, 2.0, 0.0 },
+        { "peak -12 dB 50 Hz", bq_type_peak, 50.0, 2.0, -12.0 },
+    };
+    const int nFilters = sizeof(filters)/sizeof(filters[0]);
+    const int Ns[] = { 1, 2, 3, 5, 8, 11, 16, 64 };
+    const int nNs = sizeof(Ns)/sizeof(Ns[0]);
+    const int blockLens[] = { 1, 16, 7, 250, 3 };   //over and over, until the data runs out
+    const double fs = 250.0;
+    const int nSamples = 5000;
+    const float fullScale = 8388607.0f;
+
+    printf("%-8s %-20s %14s %12s\n", "kernel", "filter", "worst diff", "bit-exact");
+    for (int k = BQ_BLOCK_SCALAR; k <= BQ_BLOCK_AVX2; k++) {
+        if (!Biquad_block::isKernelSupported(k)) {
+            printf("%-8s (this CPU doesn't have it)\n", Biquad_block::getKernelName(k));
+            continue;
+        }
+        CHECK(Biquad_block::setKernel(k) == k);
+        CHECK(Biquad_block::getKernel() == k);
+        for (int f=0; f < nFilters; f++) {
+            double worst = 0.0;
+            boolean exact = true;
+            for (int n=0; n < nNs; n++) {
+                int N = Ns[n];
+                HostRecording data = makeSyntheticEEG(N, nSamples, fs, 100*f + N);
+                std::vector<float> frames(nSamples * N);
+                for (int i=0; i < nSamples; i++) for (int chan=0; chan < N; chan++) frames[i*N + chan] = (float)data[i][chan];
+
+                std::vector<Biquad *> ref(N);
+                for (int chan=0; chan < N; chan++) ref[chan] = new Biquad(filters[f].type, filters[f].Fc_Hz / fs, filters[f].Q, filters[f].peakGainDB);
+                std::vector<float> expected(frames);
+                for (int i=0; i < nSamples; i++) {
+                    for (int chan=0; chan < N; chan++) expected[i*N + chan] = ref[chan]->process(expected[i*N + chan]);
+                }
+                for (int chan=0; chan < N; chan++) delete ref[chan];
+
+                Biquad_block block(N, filters[f].type, filters[f].Fc_Hz / fs, filters[f].Q, filters[f].peakGainDB);
+                CHECK(block.getNChan() == N);
+                for (int i=0, b=0; i < nSamples; b++) {
+                    int len = min(blockLens[b % 5], nSamples - i);
+                    block.process(&frames[i*N], len);
+                    i += len;
+                }
+                for (size_t i=0; i < frames.size(); i++) {
+                    worst = max(worst, (double)fabs(frames[i] - expected[i]));
+                    if (frames[i] != expected[i]) exact = false;
+                }
+            }
+            printf("%-8s %-20s %14.3g %12s\n", Biquad_block::getKernelName(k), filters[f].name, worst, exact ? "yes" : "no");
+            CHECK(worst <= 1.0e-6 * fullScale);
+        }
+    }
+
+    //resetChannel() forgets only that channel
+    {
+        Biquad_block::setKernel(BQ_BLOCK_AUTO);
+        const int N = 8;
+        Biquad_block block(N, bq_type_lowpass, 10.0 / fs, 0.707, 0.0);
+        std::vector<float> frames(N, 1000.0f);
+        for (int i=0; i < 100; i++) { std::fill(frames.begin(), frames.end(), 1000.0f); block.process(&frames[0], 1); }
+        block.resetChannel(5);
+        block.resetChannel(-1);   //ignored
+        block.resetChannel(N);
+        std::fill(frames.begin(), frames.end(), 0.0f);
+        block.process(&frames[0], 1);
+        for (int chan=0; chan < N; chan++) {
+            if (chan == 5) CHECK(frames[chan] == 0.0f);
+            else CHECK(frames[chan] != 0.0f);
+        }
+    }
+
+    //asking for a kernel gives the best one there is, up to that one
+    CHECK(Biquad_block::setKernel(BQ_BLOCK_SCALAR) == BQ_BLOCK_SCALAR);
+    CHECK(Biquad_block::setKernel(BQ_BLOCK_AUTO) >= BQ_BLOCK_SCALAR);
+    CHECK(Biquad_block::isKernelSupported(Biquad_block::getKernel()));
+
+    return hostTestResult("test_biquad_block");
+}
@@ -0,0 +1,144 @@
+//
+//  test_biquad_fixed.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  Biquad_multiChan_fixed against Biquad_multiChan, the floating-point filter that it
+//  stands in for, on the filters that StreamRawData uses (and a few more), at 250, 500,
+//  and 1000 Hz.  Two things are checked separately:
+//     the arithmetic: the same Q14 coefficients, run in double precision, have to give
+//        the same output to within a few counts.  This is the rounding, the saturation,
+//        and the noise shaping.  It prints the worst and rms difference, in counts.
+//     the design: against the floating-point filter itself, where the Q14 coefficients
+//        come in too, the difference has to be small next to the signal.
+//  It also checks that the highpass takes a DC offset all the way to zero, that the
+//  rounding doesn't leave an offset, and that overloads saturate instead of wrapping.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include "HostSignals.h"
+#include <Biquad_multiChan.h>
+#include <Biquad_multiChan_fixed.h>
+
+//Direct Form I in double precision, with the Q14 coefficients
+struct ReferenceDF1 {
+    double a0, a1, a2, nb1, nb2;
+    double x1, x2, y1, y2;
+    ReferenceDF1(const BiquadCoeffQ14 &c) {
+        const double scale = 1.0 / (1L << BQ_FIXED_FRAC_BITS);
+        a0 = c.a0 * scale; a1 = c.a1 * scale; a2 = c.a2 * scale;
+        nb1 = c.nb1 * scale; nb2 = c.nb2 * scale;
+        x1 = x2 = y1 = y2 = 0.0;
+    }
+    double process(double in) {
+        double out = a0*in + a1*x1 + a2*x2 + nb1*y1 + nb2*y2;
+        x2 = x1; x1 = in; y2 = y1; y1 = out;
+        return out;
+    }
+};
+
+struct FilterCase {
+    const char *name;
+    int type;
+    double Fc_Hz;
+    double Q;
+};
+
+int main(void)
+{
+    const FilterCase filters[] = {
+        { "highpass 0.5 Hz", bq_type_highpass, 0.5, 0.5 },
+        { "highpass 1 Hz", bq_type_highpass, 1.0, 0.707 },
+        { "notch 60 Hz", bq_type_notch, 60.0, 4.0 },
+        { "notch 50 Hz", bq_type_notch, 50.0, 4.0 },
+        { "lowpass 40 Hz", bq_type_lowpass, 40.0, 0.707 },
+        { "bandpass 10 Hz", bq_type_bandpass, 10.0, 2.0 },
+    };
+    const int nFilters = sizeof(filters)/sizeof(filters[0]);
+    const double rates[] = { 250.0, 500.0, 1000.0 };
+    const int nChan = 4;
+
+    printf("%-18s %6s %16s %16s %18s %14s\n", "filter", "fs", "arith max err", "arith rms err", "vs float (rel rms)", "mean err");
+    for (int f=0; f < nFilters; f++) {
+        for (int r=0; r < 3; r++) {
+            double fs = rates[r];
+            double Fc = filters[f].Fc_Hz / fs;
+            Biquad_multiChan floatFilter(nChan, filters[f].type, Fc, filters[f].Q, 0.0);
+            Biquad_multiChan_fixed fixedFilter(nChan, filters[f].type, Fc, filters[f].Q, 0.0);
+            BiquadCoeffQ14 coeff;
+            Biquad_multiChan_fixed::calcCoefficients(filters[f].type, Fc, filters[f].Q, 0.0, &coeff);
+
+            //EEG with its electrode offsets, plus a few seconds of a sine sweep through the band
+            int nSamples = (int)(20.0 * fs);
+            HostRecording data = makeSyntheticEEG(nChan, nSamples, fs, 10 + f);
+            for (int i=0; i < nSamples; i++) {
+                double t = i / fs;
+                double sweep_Hz = 0.2 + (0.45 * fs) * t / 20.0;
+                data[i][nChan-1] = lround(2.0e6 * sin(2.0 * M_PI * sweep_Hz * t));
+            }
+
+            double maxArith = 0.0, sumArith2 = 0.0, sumDesign2 = 0.0, sumSignal2 = 0.0, sumErr = 0.0;
+            long nCounted = 0;
+            for (int chan=0; chan < nChan; chan++) {
+                ReferenceDF1 ref(coeff);
+                for (int i=0; i < nSamples; i++) {
+                    long in = data[i][chan];
+                    long out = fixedFilter.process(in, chan);
+                    double refOut = ref.process((double)in);
+                    double floatOut = floatFilter.process((float)in, chan);
+                    if (i < nSamples / 4) continue;   //let the highpass settle from the electrode offset
+                    double arith = out - refOut;
+                    maxArith = max(maxArith, fabs(arith));
+                    sumArith2 += arith * arith;
+                    sumErr += arith;
+                    sumDesign2 += (out - floatOut) * (out - floatOut);
+                    sumSignal2 += floatOut * floatOut;
+                    nCounted++;
+                }
+            }
+            double rmsArith = sqrt(sumArith2 / nCounted);
+            double relDesign = sqrt(sumDesign2 / max(sumSignal2, 1.0));
+            double meanErr = sumErr / nCounted;
+            printf("%-18s %6.0f %16.2f %16.3f %18.2e %14.3f\n", filters[f].name, fs, maxArith, rmsArith, relDesign, meanErr);
+
+            //the arithmetic: within a few counts of the exact result, and no offset.  The rounding
+            //noise grows as the poles get closer to 1 (low cutoffs at high sample rates), but it
+            //stays well under the ADS1299's own noise (about 8 counts rms at gain 24).
+            CHECK(maxArith < 12.0);
+            CHECK(rmsArith < 3.0);
+            CHECK(fabs(meanErr) < 0.5);
+            //the design: within -40 dB of the floating-point filter (the coefficients are Q14)
+            CHECK(relDesign < 0.01);
+        }
+    }
+
+    //the highpass takes a DC offset all the way to zero, even a big one
+    {
+        Biquad_multiChan_fixed hp(2, bq_type_highpass, 0.5 / 250.0, 0.5, 0.0);
+        long last[2] = { 1, 1 };
+        for (int i=0; i < 250 * 60; i++) {
+            last[0] = hp.process(8000000L, 0);
+            last[1] = hp.process(-1234567L, 1);
+        }
+        CHECK(last[0] == 0);
+        CHECK(last[1] == 0);
+    }
+
+    //an overload saturates, and never wraps around to the other sign
+    {
+        Biquad_multiChan_fixed lp(1, bq_type_lowpass, 40.0 / 250.0, 0.707, 0.0);
+        Biquad_multiChan floatLp(1, bq_type_lowpass, 40.0 / 250.0, 0.707, 0.0);
+        int nWrong = 0;
+        for (int i=0; i < 2000; i++) {
+            long in = ((i / 7) % 2) ? 2000000000L : -2000000000L;   //far past the limit
+            long out = lp.process(in, 0);
+            double ideal = floatLp.process((float)Biquad_multiChan_fixed::saturate(in), 0);
+            if ((out > BQ_FIXED_LIMIT) || (out < -BQ_FIXED_LIMIT)) nWrong++;
+            if ((fabs(ideal) > 0.5 * BQ_FIXED_LIMIT) && ((out > 0) != (ideal > 0))) nWrong++;
+        }
+        CHECK(nWrong == 0);
+    }
+
+    return hostTestResult("test_biquad_fixed");
+}
@@ -0,0 +1,93 @@
+//
+//  test_channel_config.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  Turning channels on and off, singly and all at once with configureChannels(), on a
+//  chain of two boards: the channel registers end up as asked, isChannelActive() says
+//  so, each active channel (and only those) drives the bias, and the settings for the
+//  second board's channels are merged with the first's, since they share the registers.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include <ADS1299Manager.h>
+
+static ADS1299Manager ADS;
+
+//every board in the chain has the same setting as the shadow copy
+static boolean chipAgrees(void)
+{
+    for (int dev=0; dev < 2; dev++) {
+        for (byte reg=CH1SET; reg <= BIAS_SENSN; reg++) {
+            if (ADS1299Sim::chip().getRegister(reg, dev) != ADS.readRegister(reg)) return false;
+        }
+    }
+    return true;
+}
+
+int main(void)
+{
+    ADS1299Sim &chip = ADS1299Sim::chip();
+    hostReset();
+    chip.powerUp(2);
+    ADS.initializeBoards(OPENBCI_V2, 2);
+
+    //after the reset, everything is off, and nothing drives the bias
+    for (int chan=1; chan <= 16; chan++) CHECK(!ADS.isChannelActive(chan));
+    CHECK(ADS.readRegister(BIAS_SENSP) == 0);
+
+    //one channel at a time.  Its own bit of the bias goes on (channel 3 used to set channel 2's)
+    ADS.activateChannel(3, ADS_GAIN24, ADSINPUT_NORMAL);
+    CHECK(ADS.isChannelActive(3));
+    CHECK(ADS.isChannelActive(11));   //the same register, on the second board
+    CHECK(!ADS.isChannelActive(2));
+    CHECK(ADS.readRegister(BIAS_SENSP) == 0b00000100);
+    ADS.activateChannel(8, ADS_GAIN24, ADSINPUT_NORMAL);
+    CHECK(ADS.readRegister(BIAS_SENSP) == 0b10000100);
+    ADS.activateChannel(1, ADS_GAIN12, ADSINPUT_SHORTED);
+    CHECK(ADS.readRegister(BIAS_SENSP) == 0b10000101);
+    CHECK(ADS.readRegister(CH1SET) == (ADS_GAIN12 | ADSINPUT_SHORTED | 0b00001000));   //V2 uses SRB2
+    ADS.deactivateChannel(3);
+    CHECK(!ADS.isChannelActive(3));
+    CHECK(ADS.readRegister(BIAS_SENSP) == 0b10000001);
+    CHECK(chipAgrees());
+
+    //recomputing the bias covers channel 8 too
+    ADS.setAutoBiasGeneration(false);
+    CHECK(ADS.readRegister(BIAS_SENSP) == 0);
+    ADS.setAutoBiasGeneration(true);
+    CHECK(ADS.readRegister(BIAS_SENSP) == 0b10000001);
+
+    //all at once, in one burst of register writes
+    ADS1299ChannelConfig config[16];
+    for (int i=0; i < 16; i++) {
+        config[i].flags = (i % 2 == 0) ? ADS_CHANCFG_ACTIVE : 0;   //1, 3, 5, 7 on
+        config[i].gainCode = ADS_GAIN24;
+        config[i].inputCode = ADSINPUT_NORMAL;
+    }
+    config[9].flags = ADS_CHANCFG_ACTIVE | ADS_CHANCFG_LOFF_P;      //channel 10 turns channel 2 on too
+    config[9].gainCode = ADS_GAIN08;
+    config[12].flags = ADS_CHANCFG_LOFF_N;                          //and channel 13 asks for lead-off on 5
+    chip.resetCounters();
+    ADS.configureChannels(config, 16, true);
+    for (int chan=1; chan <= 8; chan++) {
+        boolean expected = (chan % 2 == 1) || (chan == 2);
+        CHECK(ADS.isChannelActive(chan) == expected);
+        CHECK(ADS.isChannelActive(chan + 8) == expected);
+    }
+    CHECK((ADS.readRegister(CH2SET) & 0b01110000) == ADS_GAIN08);
+    CHECK(ADS.readRegister(BIAS_SENSP) == 0b01010111);
+    CHECK(ADS.readRegister(LOFF_SENSP) == 0b00000010);
+    CHECK(ADS.readRegister(LOFF_SENSN) == 0b00010000);
+    CHECK(chipAgrees());
+    CHECK(chip.ignoredCommands == 0);
+
+    //more entries than the chain has channels are ignored
+    for (int i=0; i < 16; i++) config[i].flags = 0;
+    ADS.configureChannels(config, 200, false);
+    for (int chan=1; chan <= 16; chan++) CHECK(!ADS.isChannelActive(chan));
+    CHECK(ADS.readRegister(BIAS_SENSP) == 0);
+
+    return hostTestResult("test_channel_config");
+}
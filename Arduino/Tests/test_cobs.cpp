@@ -0,0 +1,168 @@
+//
+//  test_cobs.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  The COBS framing (writeChannelDataAsCOBS, and the other packets with setCOBSFraming):
+//  every sample has to come back out of the PC's parser as it went in, and the markers,
+//  impedance, lead-off scan, and status packets have to say the same thing that they do
+//  in the 0xA0...0xC0 framing.  Then the stuffing itself is pushed at its edges: zeros at
+//  the start and end, long runs with no zeros at all (the 254-byte limit), and payloads
+//  of every length up to 255.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include "PacketParser.h"
+#include <ADS1299Manager.h>
+#include <random>
+
+static ADS1299Manager ADS;
+
+//the stream has no zeros in it, except one at the end of each packet
+static int countZeros(const byte *data, size_t nBytes)
+{
+    int nZeros = 0;
+    for (size_t i=0; i < nBytes; i++) if (data[i] == PCKT_COBS_DELIMITER) nZeros++;
+    return nZeros;
+}
+
+//send a status packet with this payload, and see that it comes back as it went
+static int checkStatusRoundTrip(const std::vector<byte> &payload)
+{
+    Serial.clearSent();
+    ADS.writeStatusPacket(payload.empty() ? NULL : &payload[0], payload.size());
+    ADS.flushTX();
+    int nBad = 0;
+    if (countZeros(Serial.sent(), Serial.sentBytes()) != 1) nBad++;
+    if (Serial.sent()[Serial.sentBytes()-1] != PCKT_COBS_DELIMITER) nBad++;
+    //one byte of overhead for each 254 bytes (or part of it), plus the delimiter
+    size_t stuffed = 1 + payload.size() + 2;
+    if (Serial.sentBytes() > stuffed + (stuffed + 253) / 254 + 1) nBad++;
+    PacketParser parser(true);
+    parser.parse(Serial.sent(), Serial.sentBytes());
+    if ((parser.goodPackets != 1) || (parser.badPackets != 0) || (parser.packets.size() != 1)) return nBad + 1;
+    if (parser.packets[0].format != PCKT_START_STATUS) nBad++;
+    if (parser.packets[0].payload != payload) nBad++;
+    return nBad;
+}
+
+int main(int argc, char **argv)
+{
+    ADS1299Sim &chip = ADS1299Sim::chip();
+    hostReset();
+    chip.powerUp(2);
+    ADS.initializeBoards(OPENBCI_V2, 2);
+
+    //round trip of the samples, including the edges of the 24-bit range and values full of zeros
+    const long edges[] = { 0, 1, -1, 8388607L, -8388608L, 8388608L, -8388609L, 256, 65536, -65536, 0x010000, 0x000100 };
+    const int nEdges = sizeof(edges)/sizeof(edges[0]);
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<long> uniform24(-8388608L, 8388607L);
+    for (int N = 1; N <= 16; N++) {
+        std::vector<std::vector<long> > sent;
+        Serial.clearSent();
+        for (long s = 0; s < 50; s++) {
+            std::vector<long> values(N);
+            for (int chan=0; chan < N; chan++) {
+                values[chan] = (s < nEdges) ? edges[(s + chan) % nEdges] : uniform24(rng);
+                ADS.channelData[chan] = values[chan];
+                values[chan] = constrain(values[chan], -8388608L, 8388607L);
+            }
+            ADS.writeChannelDataAsCOBS(N, (s == 1) ? 0 : 0x100 * s);   //sample numbers with zero bytes in them
+            sent.push_back(values);
+        }
+        ADS.flushTX();
+        CHECK(Serial.sentBytes() == sent.size() * ADS.getCOBSPacketBytes(N));
+        CHECK(countZeros(Serial.sent(), Serial.sentBytes()) == (int)sent.size());
+
+        PacketParser parser(true);
+        parser.parse(Serial.sent(), Serial.sentBytes());
+        CHECK(parser.badPackets == 0);
+        CHECK(parser.samples.size() == sent.size());
+        int nBad = 0;
+        for (size_t s=0; (s < sent.size()) && (s < parser.samples.size()); s++) {
+            if (parser.samples[s].format != PCKT_START_PACKED) nBad++;
+            if (parser.samples[s].sampleNumber != ((s == 1) ? 0 : 0x100 * (long)s)) nBad++;
+            if (parser.samples[s].values != sent[s]) nBad++;
+        }
+        CHECK(nBad == 0);
+    }
+
+    //the other packets say the same thing in either framing
+    const unsigned int codes[16] = { 0, 1, 0x100, 0xFFFF, 12, 0, 0, 7, 0x8000, 3, 4, 5, 6, 7, 8, 9 };
+    std::vector<byte> status;
+    status.push_back(0x00); status.push_back(0x4F); status.push_back(0x00);
+    std::vector<ParsedPacket> classic, cobs;
+    for (int framing = 0; framing < 2; framing++) {
+        ADS.setCOBSFraming(framing == 1);
+        Serial.clearSent();
+        ADS.writeDiscontinuityMarker(0x1000);
+        ADS.writeImpedancePacket(0x20000, 256, 16, codes);
+        ADS.writeLeadOffScanPacket(3, 5, PCHAN);
+        ADS.writeStatusPacket(&status[0], status.size());
+        ADS.flushTX();
+        PacketParser parser(framing == 1);
+        parser.parse(Serial.sent(), Serial.sentBytes());
+        CHECK(parser.badPackets == 0);
+        CHECK(parser.packets.size() == 4);
+        if (framing == 1) CHECK(countZeros(Serial.sent(), Serial.sentBytes()) == 4);
+        ((framing == 0) ? classic : cobs) = parser.packets;
+    }
+    ADS.setCOBSFraming(false);
+    const byte formats[4] = { PCKT_START_MARKER, PCKT_START_IMPEDANCE, PCKT_START_LEADOFF_SCAN, PCKT_START_STATUS };
+    for (size_t i=0; (i < 4) && (i < classic.size()) && (i < cobs.size()); i++) {
+        CHECK(classic[i].format == formats[i]);
+        CHECK(cobs[i].format == formats[i]);
+        CHECK(classic[i].payload == cobs[i].payload);
+    }
+    CHECK((cobs.size() == 4) && (cobs[3].payload == status));
+
+    //the stuffing at its edges, through the status packet (whose payload is anything)
+    ADS.setCOBSFraming(true);
+    int nBad = 0;
+    for (int len = 0; len <= 255; len++) {
+        std::vector<byte> payload(len);
+        for (int i=0; i < len; i++) payload[i] = (byte)(1 + rng() % 255);   //no zeros at all
+        nBad += checkStatusRoundTrip(payload);
+        if (len > 0) {
+            std::vector<byte> zeros = payload;
+            zeros[0] = 0; zeros[len-1] = 0;                                  //zeros at both ends
+            nBad += checkStatusRoundTrip(zeros);
+            std::fill(zeros.begin(), zeros.end(), 0);                        //nothing but zeros
+            nBad += checkStatusRoundTrip(zeros);
+        }
+        for (int i=0; i < len; i++) payload[i] = (byte)((rng() % 4 == 0) ? 0 : rng());   //random
+        nBad += checkStatusRoundTrip(payload);
+    }
+    //a zero right at the 254-byte limit, and just either side of it
+    for (int pos = 250; pos <= 255; pos++) {
+        std::vector<byte> payload(255, 0x55);
+        if (pos < 255) payload[pos] = 0;
+        nBad += checkStatusRoundTrip(payload);
+    }
+    CHECK(nBad == 0);
+    ADS.setCOBSFraming(false);
+
+    //the parser throws away what it can't trust: a bad CRC, and a code that runs past the end
+    {
+        Serial.clearSent();
+        ADS.writeChannelDataAsCOBS(8, 1);
+        ADS.flushTX();
+        std::vector<byte> good(Serial.sent(), Serial.sent() + Serial.sentBytes());
+        std::vector<byte> bad = good;
+        bad[5] ^= 0x01;
+        if (bad[5] == 0) bad[5] = 0x02;
+        PacketParser parser(true);
+        parser.parse(&bad[0], bad.size());
+        parser.parse(&good[0], good.size());
+        CHECK((parser.badPackets == 1) && (parser.samples.size() == 1));
+        bad = good;
+        bad[0] = 0xFE;
+        parser.reset();
+        parser.parse(&bad[0], bad.size());
+        CHECK((parser.badPackets == 1) && parser.samples.empty());
+    }
+
+    return hostTestResult("test_cobs");
+}
@@ -0,0 +1,87 @@
+//
+//  test_daisy_chain.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  A daisy chain as long as the library was built for (ADS_MAX_N_BOARDS, which
+//  CMakeLists.txt sets to 1, 2, 4, and 8): the frame size, every channel of every
+//  board coming through in the right place, each board's own status word, and the
+//  channel settings that the boards share.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include <ADS1299Manager.h>
+
+static ADS1299Manager ADS;
+
+int main(void)
+{
+    const int nBoards = ADS1299::MAX_N_BOARDS;
+    const int nChan = ADS1299::MAX_N_CHAN;
+    char name[40];
+    snprintf(name, sizeof(name), "test_daisy_chain (%d boards)", nBoards);
+
+    ADS1299Sim &chip = ADS1299Sim::chip();
+    hostReset();
+    chip.powerUp(nBoards);
+    ADS.initializeBoards(OPENBCI_V2, nBoards);
+    CHECK(ADS.nBoards == nBoards);
+    CHECK(ADS.isDaisy == (nBoards > 1));
+    CHECK(ADS.getFrameBytes() == nBoards*ADS_FRAME_BYTES_PER_BOARD);
+    CHECK(nChan == 8*nBoards);
+    CHECK(sizeof(ADS.channelData) == nChan*sizeof(long));
+
+    //every channel can be addressed, and lands on its board's shared register
+    for (int chan=1; chan <= nChan; chan++) ADS.activateChannel(chan, ADS_GAIN24, ADSINPUT_NORMAL);
+    for (int i=0; i < 8; i++) CHECK((chip.getRegister(CH1SET+i, nBoards-1) & 0x80) == 0);
+    ADS.activateChannel(nChan, ADS_GAIN02, ADSINPUT_SHORTED);
+    CHECK(chip.getRegister(CH8SET, nBoards-1) == (ADS_GAIN02 | ADSINPUT_SHORTED | 0x08));  //SRB2 on, for V2
+    CHECK(chip.getRegister(CH8SET, 0) == chip.getRegister(CH8SET, nBoards-1));
+    CHECK(ADS.getChannelGain(nChan) == 2.0);
+    CHECK(ADS.getChannelGain(8) == 2.0);   //same register
+    ADS.activateChannel(nChan, ADS_GAIN24, ADSINPUT_NORMAL);
+    ADS.activateChannel(nChan+1, ADS_GAIN02, ADSINPUT_SHORTED);   //no such channel: nothing changes
+    CHECK(ADS.getChannelGain(nChan) == 24.0);
+
+    //stream the test pattern through the DRDY ring
+    ADS.setSampleRate(ADS_RATE_500HZ);
+    chip.setTestPattern(true);
+    chip.resetCounters();
+    ADS.setInterruptMode(true);
+    ADS.start();
+    int nBad = 0, nBadStatus = 0;
+    for (int i=0; i < 100; i++) {
+        unsigned long start = millis();
+        while (!ADS.isDataAvailable() && ((millis() - start) < 100)) ;
+        long n = ADS.popChannelData();
+        for (int chan=0; chan < nChan; chan++) {
+            if (ADS.channelData[chan] != ADS1299Sim::patternValue(n, chan)) nBad++;
+        }
+        for (int b=0; b < nBoards; b++) {
+            if ((ADS.stat[b] & 0xF00000L) != 0xC00000L) nBadStatus++;   //each board's own status word
+        }
+    }
+    ADS.stop();
+    CHECK(nBad == 0);
+    CHECK(nBadStatus == 0);
+    CHECK(chip.framesLost == 0);
+    CHECK(ADS.getRingOverruns() == 0);
+
+    //turning off the last channel turns off channel 8 of every board
+    chip.setTestPattern(false);
+    for (int chan=0; chan < nChan; chan++) chip.setSignal(chan, 10.0e-6, 0.0, 0.0);
+    ADS.deactivateChannel(nChan);
+    CHECK(chip.getRegister(CH8SET, 0) & 0x80);
+    ADS.start();
+    unsigned long start = millis();
+    while (!ADS.isDataAvailable() && ((millis() - start) < 100)) ;
+    ADS.popChannelData();
+    ADS.stop();
+    for (int b=0; b < nBoards; b++) {
+        CHECK(ADS.channelData[b*8 + 7] == 0);
+        CHECK(ADS.channelData[b*8 + 6] != 0);
+    }
+
+    return hostTestResult(name);
+}
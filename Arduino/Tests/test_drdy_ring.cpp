@@ -0,0 +1,104 @@
+//
+//  test_drdy_ring.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  Interrupt-driven acquisition: the DRDY interrupt fills the sample ring, loop()
+//  drains it, and when loop() falls behind the ring overruns and the gap shows up in
+//  the sample numbers and in getRingOverruns().  On a board with no interrupt for
+//  DRDY, start() falls back to polling.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include <ADS1299Manager.h>
+
+static ADS1299Manager ADS;
+
+static boolean waitForData(void)
+{
+    for (int i=0; i < 10000; i++) {
+        if (ADS.isDataAvailable()) return true;
+        hostAdvance(10000);
+    }
+    return false;
+}
+
+int main(void)
+{
+    ADS1299Sim &chip = ADS1299Sim::chip();
+    hostReset();
+    chip.powerUp(1);
+    ADS.initialize(OPENBCI_V2, false);
+    for (int chan=1; chan <= 8; chan++) ADS.activateChannel(chan, ADS_GAIN24, ADSINPUT_NORMAL);
+    ADS.setSampleRate(ADS_RATE_1kHZ);
+    chip.setTestPattern(true);
+
+    //keeping up: every conversion comes through, in order, with the right values
+    chip.resetCounters();
+    ADS.setInterruptMode(true);
+    ADS.start();
+    CHECK(ADS.isInterruptMode());
+    long offset = 0;   //sample numbers carry on across start(), conversions don't
+    int nBad = 0, nOutOfOrder = 0;
+    long prev = 0;
+    for (int i=0; i < 200; i++) {
+        if (!waitForData()) { CHECK(false); break; }
+        long n = ADS.popChannelData();
+        if (i == 0) offset = n - 1;
+        if ((i > 0) && (n != prev+1)) nOutOfOrder++;
+        prev = n;
+        for (int chan=0; chan < 8; chan++) {
+            if (ADS.channelData[chan] != ADS1299Sim::patternValue(n - offset, chan)) nBad++;
+        }
+    }
+    CHECK(nBad == 0);
+    CHECK(nOutOfOrder == 0);
+    CHECK(ADS.getRingOverruns() == 0);
+    CHECK(chip.framesLost == 0);
+    CHECK(chip.framesTorn == 0);
+    CHECK(hostInterruptCount(PIN_DRDY) == chip.conversions);
+
+    //falling behind: the ring fills, and everything after that is counted as an overrun
+    while (ADS.isDataAvailable()) prev = ADS.popChannelData();
+    unsigned long convBefore = chip.conversions;
+    hostAdvance(20 * 1000000ULL);   //20 samples at 1 kHz without looking at the ring
+    unsigned long stalled = chip.conversions - convBefore;
+    CHECK(stalled >= 19);
+    CHECK(ADS.getRingPeakDepth() == ADS_SAMPLE_RING_LEN-1);
+    unsigned long overruns = ADS.getRingOverruns();
+    CHECK(overruns == stalled - (ADS_SAMPLE_RING_LEN-1));
+    for (int i=0; i < ADS_SAMPLE_RING_LEN-1; i++) {
+        long n = ADS.popChannelData();
+        CHECK(n == prev+1);
+        prev = n;
+    }
+    CHECK(waitForData());
+    long n = ADS.popChannelData();
+    CHECK(n == prev + 1 + (long)overruns);   //the gap, in the sample numbers
+    CHECK(chip.framesLost == overruns);      //those frames were left in the chip to be replaced
+    for (int chan=0; chan < 8; chan++) CHECK(ADS.channelData[chan] == ADS1299Sim::patternValue(n - offset, chan));
+    ADS.stop();
+    CHECK(!ADS.isDataAvailable());
+
+    //a board with no interrupt on the DRDY pin: start() polls instead
+    hostPinInterrupts = false;
+    chip.resetCounters();
+    ADS.setInterruptMode(true);
+    ADS.start();
+    CHECK(!ADS.isInterruptMode());
+    nBad = 0;
+    for (int i=0; i < 50; i++) {
+        if (!waitForData()) { CHECK(false); break; }
+        ADS.updateChannelData();
+        long conv = chip.conversions;
+        for (int chan=0; chan < 8; chan++) {
+            if (ADS.channelData[chan] != ADS1299Sim::patternValue(conv, chan)) nBad++;
+        }
+    }
+    ADS.stop();
+    CHECK(nBad == 0);
+    CHECK(chip.framesRead == 50);
+
+    return hostTestResult("test_drdy_ring");
+}
@@ -0,0 +1,269 @@
+//
+//  test_filter_presets.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  The StreamRawData sketch's filter presets (../Sketches/StreamRawData/FilterCoefficients.h)
+//  run through Biquad_cascade_fixed:
+//     the tables are what Biquad_multiChan_fixed::calcCoefficientsQ30() makes from the
+//        designs, and every preset at every sample rate is within 2.5% of its design (it
+//        prints the worst difference in |H|, and which stages run as Q14)
+//     the Q30 stages do the arithmetic right: against the same coefficients in double
+//        precision, they're as close as rounding the output to whole counts allows
+//     the presets that Q14 couldn't do (the 7-13 Hz bandpass at 8 and 16 kHz, and the
+//        highpasses at 1 kHz and up) have the gain they should, measured with sines
+//     switching presets mid-stream, with the glide, all at once, and after a reset: it
+//        prints the energy of the transient (see transientEnergy) next to that of the
+//        filtered signal.  The glide has to keep it small, and smaller than the other two
+//        over all of the switches together.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include "HostSignals.h"
+#include <Biquad_cascade_fixed.h>
+#include <ADS1299Manager.h>   //for the ADS_RATE codes, which the tables go by
+#include "../Sketches/StreamRawData/FilterCoefficients.h"
+
+static const double rates_Hz[N_RATE_CODES] = { 16000.0, 8000.0, 4000.0, 2000.0, 1000.0, 500.0, 250.0 };
+
+static boolean sameCoeff(const BiquadCoeffQ30 &a, const BiquadCoeffQ30 &b)
+{
+    return (a.a0 == b.a0) && (a.a1 == b.a1) && (a.a2 == b.a2) && (a.nb1 == b.nb1) && (a.nb2 == b.nb2);
+}
+
+//Direct Form I in double precision, with the Q30 coefficients.  If 'rounded', the output is
+//rounded down to whole counts, with the part that was dropped added back in next time, the
+//way Biquad_multiChan_fixed::roundOff() does it, but with no other rounding.
+struct ReferenceDF1 {
+    double a0, a1, a2, nb1, nb2;
+    double x1, x2, y1, y2, frac;
+    boolean rounded;
+    ReferenceDF1(const BiquadCoeffQ30 &c, boolean r) {
+        const double scale = 1.0 / (double)(1L << BQ_Q30_FRAC_BITS);
+        a0 = c.a0 * scale; a1 = c.a1 * scale; a2 = c.a2 * scale;
+        nb1 = c.nb1 * scale; nb2 = c.nb2 * scale;
+        x1 = x2 = y1 = y2 = frac = 0.0;
+        rounded = r;
+    }
+    double process(double in) {
+        double out = a0*in + a1*x1 + a2*x2 + nb1*y1 + nb2*y2;
+        if (rounded) {
+            out += frac;
+            frac = out - floor(out);
+            out = floor(out);
+        }
+        x2 = x1; x1 = in; y2 = y1; y1 = out;
+        return out;
+    }
+};
+
+//the gain of a band preset at f_Hz, measured with a sine through the cascade
+static double measureGain(int preset, int rateCode, double f_Hz)
+{
+    double fs = rates_Hz[rateCode];
+    Biquad_cascade_fixed cascade(1, 2);
+    cascade.setStage_P(0, &bandPreset_coeff_P[preset][rateCode][0]);
+    cascade.setStage_P(1, &bandPreset_coeff_P[preset][rateCode][1]);
+    const double amp = 1.0e6;
+    long nSettle = (long)(fs * 10.0 / f_Hz) + (long)(fs * 4.0), nMeasure = (long)(fs * 20.0 / f_Hz);
+    double sumIn2 = 0.0, sumOut2 = 0.0;
+    for (long i=0; i < nSettle + nMeasure; i++) {
+        double in = amp * sin(2.0 * M_PI * f_Hz * i / fs);
+        long val = lround(in);
+        cascade.process(&val);
+        if (i >= nSettle) { sumIn2 += in * in; sumOut2 += (double)val * val; }
+    }
+    return sqrt(sumOut2 / sumIn2);
+}
+
+//the designed gain of a band preset at f_Hz
+static double designGain(int preset, double fs, double f_Hz)
+{
+    double gain = 1.0;
+    for (int s=0; s < 2; s++) {
+        double c[5];
+        if (s == 0) Biquad_multiChan::calcCoefficients(bq_type_highpass, bandPresetDesign_P[preset].hp_Hz / fs, bandPresetDesign_P[preset].hp_Q, 0.0, c);
+        else if (bandPresetDesign_P[preset].lp_Hz > 0.0) Biquad_multiChan::calcCoefficients(bq_type_lowpass, bandPresetDesign_P[preset].lp_Hz / fs, BANDPASS_Q, 0.0, c);
+        else continue;
+        double w = 2.0 * M_PI * f_Hz / fs;
+        double nr = c[0] + c[1]*cos(w) + c[2]*cos(2*w), ni = -c[1]*sin(w) - c[2]*sin(2*w);
+        double dr = 1.0 + c[3]*cos(w) + c[4]*cos(2*w), di = -c[3]*sin(w) - c[4]*sin(2*w);
+        gain *= sqrt((nr*nr + ni*ni) / (dr*dr + di*di));
+    }
+    return gain;
+}
+
+//The transient when the band preset goes from 'from' to 'to' at 250 Hz.  With no transient
+//at all, the output would move smoothly from what the old filter gives to what the new one
+//gives: old*(1-k) + new*k, where k goes from 0 to 1 over the glide (or all at once).  The
+//transient is what's left over, and its energy is given relative to the filtered signal's,
+//over the 4 sec after the switch.  how: 0 = glide, 1 = all at once, 2 = all at once after a reset
+static double transientEnergy(const HostRecording &data, int from, int to, int how)
+{
+    const int N = (int)data[0].size(), rateCode = ADS_RATE_250HZ;
+    const int nSwitch = 40 * 250, nAfter = 4 * 250;
+    Biquad_cascade_fixed switched(N, 4), oldFilter(N, 4), newFilter(N, 4);
+    for (int s=0; s < 2; s++) {
+        switched.setStage_P(s, &bandPreset_coeff_P[from][rateCode][s]);
+        oldFilter.setStage_P(s, &bandPreset_coeff_P[from][rateCode][s]);
+        newFilter.setStage_P(s, &bandPreset_coeff_P[to][rateCode][s]);
+    }
+    for (int s=2; s < 4; s++) {
+        switched.setStage_P(s, &notchPreset_coeff_P[NOTCH_PRESET_DEFAULT][rateCode]);
+        oldFilter.setStage_P(s, &notchPreset_coeff_P[NOTCH_PRESET_DEFAULT][rateCode]);
+        newFilter.setStage_P(s, &notchPreset_coeff_P[NOTCH_PRESET_DEFAULT][rateCode]);
+    }
+    double sumErr2 = 0.0, sumOut2 = 0.0;
+    std::vector<long> a(N), b(N), c(N);
+    for (int i=0; i < nSwitch + nAfter; i++) {
+        if (i == nSwitch) {
+            if (how == 2) for (int chan=0; chan < N; chan++) switched.resetChannel(chan);
+            for (int s=0; s < 2; s++) switched.setStage_P(s, &bandPreset_coeff_P[to][rateCode][s], how == 0);
+        }
+        for (int chan=0; chan < N; chan++) a[chan] = b[chan] = c[chan] = data[i][chan];
+        switched.process(&a[0]);
+        oldFilter.process(&b[0]);
+        newFilter.process(&c[0]);
+        if (i < nSwitch) continue;
+        double k = (how == 0) ? min(1.0, (double)(i - nSwitch + 1) / BQ_GLIDE_SAMPLES) : 1.0;
+        for (int chan=0; chan < N; chan++) {
+            double err = a[chan] - ((1.0 - k) * b[chan] + k * c[chan]);
+            sumErr2 += err * err;
+            sumOut2 += (double)c[chan] * c[chan];
+        }
+    }
+    return sumErr2 / sumOut2;
+}
+
+int main(void)
+{
+    //the tables are what calcCoefficientsQ30() makes from the designs
+    int nQ14 = 0, nQ30 = 0;
+    printf("%-20s", "preset");
+    for (int r=0; r < N_RATE_CODES; r++) printf(" %9.0f", rates_Hz[r]);
+    printf("   (worst error in |H|, * for Q30)\n");
+    for (int p=0; p < N_BAND_PRESETS + N_NOTCH_PRESETS; p++) {
+        boolean isBand = (p < N_BAND_PRESETS);
+        int preset = isBand ? p : p - N_BAND_PRESETS;
+        char name[32];
+        if (!isBand) snprintf(name, sizeof(name), "notch %.0f Hz", notchPresetDesign_Hz_P[preset]);
+        else if (bandPresetDesign_P[preset].lp_Hz > 0.0) snprintf(name, sizeof(name), "bandpass %.0f-%.0f Hz", bandPresetDesign_P[preset].hp_Hz, bandPresetDesign_P[preset].lp_Hz);
+        else snprintf(name, sizeof(name), "highpass %.1f Hz", bandPresetDesign_P[preset].hp_Hz);
+        printf("%-20s", name);
+        for (int r=0; r < N_RATE_CODES; r++) {
+            double fs = rates_Hz[r], worst = 0.0;
+            boolean anyQ30 = false;
+            for (int s=0; s < (isBand ? 2 : 1); s++) {
+                int type; double f_Hz, Q;
+                const BiquadCoeffQ30 *table;
+                if (isBand) {
+                    type = (s == 0) ? bq_type_highpass : bq_type_lowpass;
+                    f_Hz = (s == 0) ? bandPresetDesign_P[preset].hp_Hz : bandPresetDesign_P[preset].lp_Hz;
+                    Q = (s == 0) ? bandPresetDesign_P[preset].hp_Q : BANDPASS_Q;
+                    table = &bandPreset_coeff_P[preset][r][s];
+                } else {
+                    type = bq_type_notch; f_Hz = notchPresetDesign_Hz_P[preset]; Q = NOTCH_PRESET_Q;
+                    table = &notchPreset_coeff_P[preset][r];
+                }
+                if (f_Hz <= 0.0) {
+                    //no filter: it passes straight through
+                    CHECK((table->a0 == (1L << BQ_Q30_FRAC_BITS)) && (table->a1 == 0) && (table->a2 == 0) && (table->nb1 == 0) && (table->nb2 == 0));
+                    continue;
+                }
+                BiquadCoeffQ30 made;
+                Biquad_multiChan_fixed::calcCoefficientsQ30(type, f_Hz / fs, Q, 0.0, &made);
+                CHECK(sameCoeff(made, *table));
+                worst = max(worst, Biquad_multiChan_fixed::calcResponseError(type, f_Hz / fs, Q, 0.0, table));
+                if (!Biquad_multiChan_fixed::isQ14(table)) anyQ30 = true;
+                if (Biquad_multiChan_fixed::isQ14(table)) nQ14++; else nQ30++;
+            }
+            printf(" %8.4f%s", worst, anyQ30 ? "*" : " ");
+            CHECK(worst < 0.025);
+        }
+        printf("\n");
+    }
+    printf("%d stages run as Q14, %d as Q30\n", nQ14, nQ30);
+    CHECK(nQ14 > 0);
+    CHECK(nQ30 > 0);
+
+    //the Q30 arithmetic, against double precision: the 0.5 Hz highpass at 2 kHz, and the
+    //13 Hz lowpass at 16 kHz, on EEG with its electrode offsets
+    {
+        const BiquadCoeffQ30 *cases[2] = { &bandPreset_coeff_P[1][ADS_RATE_2kHZ][0], &bandPreset_coeff_P[4][ADS_RATE_16kHZ][1] };
+        for (int k=0; k < 2; k++) {
+            CHECK(!Biquad_multiChan_fixed::isQ14(cases[k]));
+            Biquad_cascade_fixed cascade(1, 1);
+            cascade.setStage(0, cases[k], false);
+            CHECK(!cascade.isStageQ14(0));
+            ReferenceDF1 exact(*cases[k], false), rounded(*cases[k], true);
+            HostRecording data = makeSyntheticEEG(1, 40000, 2000.0, 7 + k);
+            double sumErr = 0.0, sumErr2 = 0.0, sumRounding2 = 0.0;
+            for (size_t i=0; i < data.size(); i++) {
+                long val = data[i][0];
+                double exactOut = exact.process((double)val);
+                double roundedOut = rounded.process((double)val);
+                cascade.process(&val);
+                if (i < data.size() / 4) continue;
+                sumErr += val - exactOut;
+                sumErr2 += (val - exactOut) * (val - exactOut);
+                sumRounding2 += (roundedOut - exactOut) * (roundedOut - exactOut);
+            }
+            double nCounted = data.size() - data.size() / 4;
+            double rmsErr = sqrt(sumErr2 / nCounted), meanErr = sumErr / nCounted, rmsRounding = sqrt(sumRounding2 / nCounted);
+            printf("Q30 %s: %.2f counts rms from double precision (%.2f from rounding the output alone), mean %.3f\n",
+                k ? "lowpass 13 Hz at 16 kHz" : "highpass 0.5 Hz at 2 kHz", rmsErr, rmsRounding, meanErr);
+            //Rounding the output to whole counts is most of it (poles this close to DC make more
+            //of it).  The Q30 arithmetic itself adds next to nothing, and no offset.
+            CHECK(rmsErr < 1.1 * rmsRounding + 0.5);
+            CHECK(fabs(meanErr) < 0.5);
+        }
+    }
+
+    //the gain, measured, where Q14 used to be far off
+    {
+        struct GainCase { int preset; int rateCode; double f_Hz; };
+        const GainCase cases[] = {
+            { 4, ADS_RATE_16kHZ, 10.0 }, { 4, ADS_RATE_8kHZ, 10.0 }, { 4, ADS_RATE_16kHZ, 40.0 },
+            { 1, ADS_RATE_16kHZ, 0.5 }, { 1, ADS_RATE_2kHZ, 0.5 }, { 1, ADS_RATE_1kHZ, 0.5 },
+            { 1, ADS_RATE_1kHZ, 5.0 }, { 2, ADS_RATE_4kHZ, 1.0 }, { 3, ADS_RATE_8kHZ, 20.0 },
+        };
+        const int nCases = sizeof(cases)/sizeof(cases[0]);
+        printf("%-20s %8s %8s %10s %10s\n", "preset", "rate", "f (Hz)", "gain", "designed");
+        for (int c=0; c < nCases; c++) {
+            const GainCase &k = cases[c];
+            double measured = measureGain(k.preset, k.rateCode, k.f_Hz);
+            double designed = designGain(k.preset, rates_Hz[k.rateCode], k.f_Hz);
+            printf("band %-15d %8.0f %8.1f %10.4f %10.4f\n", k.preset, rates_Hz[k.rateCode], k.f_Hz, measured, designed);
+            CHECK_NEAR(measured, designed, 0.01);
+        }
+    }
+
+    //switching presets mid-stream
+    {
+        HostRecording data = makeSyntheticEEG(8, 44 * 250, 250.0, 3);
+        struct SwitchCase { int from; int to; };
+        const SwitchCase cases[] = { { 1, 2 }, { 1, 3 }, { 3, 4 }, { 4, 5 }, { 0, 1 } };
+        const int nCases = sizeof(cases)/sizeof(cases[0]);
+        printf("%-10s %14s %14s %14s\n", "switch", "glide", "all at once", "reset");
+        double total[3] = { 0.0, 0.0, 0.0 };
+        for (int c=0; c < nCases; c++) {
+            double e[3];
+            for (int how=0; how < 3; how++) {
+                e[how] = transientEnergy(data, cases[c].from, cases[c].to, how);
+                total[how] += e[how];
+            }
+            printf("%d -> %-5d %11.1f dB %11.1f dB %11.1f dB\n", cases[c].from, cases[c].to,
+                10.0*log10(e[0]), 10.0*log10(e[1]), 10.0*log10(e[2]));
+            //a reset starts the highpass over on the electrode offset, which is far worse.  The
+            //glide is usually better than switching all at once, but not always (between the two
+            //narrow bandpasses, the filters along the way are a long way from either one).
+            CHECK(e[0] < 0.03);
+            CHECK(e[0] < 1.0e-4 * e[2]);
+        }
+        printf("all together %9.1f dB %11.1f dB %11.1f dB\n", 10.0*log10(total[0]), 10.0*log10(total[1]), 10.0*log10(total[2]));
+        CHECK(total[0] < 0.5 * total[1]);
+    }
+
+    return hostTestResult("test_filter_presets");
+}
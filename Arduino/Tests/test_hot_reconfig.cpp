@@ -0,0 +1,162 @@
+//
+//  test_hot_reconfig.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  Hot reconfiguration (setHotReconfig) against the simulated chip, in polling mode and
+//  with the DRDY interrupt, at a few sample rates.  For each type of change, it streams,
+//  makes the change between two samples, and streams some more.  The gap in the data is
+//  read off the simulated chip's log of which conversions were read, and it has to match
+//  what the Manager marked on the first sample after the change (and which channels it
+//  says were touched).  Nothing may be sent while the chip is in RDATAC, and no frame may
+//  be torn.  It prints the gap for each type of change.  Last, with the DRDY interrupt and
+//  no samples coming, commit() has to give up after a couple of sample periods, and still
+//  mark the change.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include <ADS1299Manager.h>
+
+static ADS1299Manager ADS;
+
+#define N_BEFORE (40)
+#define N_AFTER (40)
+
+//one sample, from the ring or from the chip.  Returns false if none comes.
+static boolean readSample(boolean interrupt)
+{
+    for (int i=0; i < 100000; i++) {
+        if (ADS.isDataAvailable()) {
+            if (interrupt) ADS.popChannelData();
+            else ADS.updateChannelData();
+            return true;
+        }
+        hostAdvance(2000);
+    }
+    return false;
+}
+
+typedef void (*Change)(void);
+static void changeGain(void) { ADS.activateChannel(3, ADS_GAIN12, ADSINPUT_NORMAL); }
+static void changeOff(void) { ADS.deactivateChannel(5); }
+static void changeLeadOff(void) { ADS.changeChannelLeadOffDetection(2, ON, PCHAN); }
+static void changeTestSignal(void) { ADS.configureInternalTestSignal(ADSTESTSIG_AMP_2X, ADSTESTSIG_PULSE_FAST); }
+static void changeAll(void)
+{
+    ADS1299ChannelConfig config[8];
+    for (int i=0; i < 8; i++) {
+        config[i].flags = ADS_CHANCFG_ACTIVE | ADS_CHANCFG_LOFF_N;
+        config[i].gainCode = ADS_GAIN08;
+        config[i].inputCode = ADSINPUT_SHORTED;
+    }
+    ADS.configureChannels(config, 8, true);
+}
+
+struct ChangeType {
+    const char *name;
+    Change change;
+    byte channels;          //which channels it should be marked as touching
+};
+
+int main(void)
+{
+    ADS1299Sim &chip = ADS1299Sim::chip();
+    hostReset();
+    chip.powerUp(1);
+    ADS.initialize(OPENBCI_V2, false);
+    ADS.setHotReconfig(true);
+
+    const ChangeType changes[] = {
+        { "gain of one channel", changeGain, 0b00000100 },
+        { "channel off (and its bias)", changeOff, 0xFF },
+        { "lead-off of one channel", changeLeadOff, 0x00 },
+        { "test signal", changeTestSignal, 0xFF },
+        { "all channels at once", changeAll, 0xFF },
+    };
+    const int nChanges = sizeof(changes)/sizeof(changes[0]);
+    const int rates[] = { ADS_RATE_250HZ, ADS_RATE_2kHZ, ADS_RATE_8kHZ };   //(at 16 kHz, the Uno can't read the frames in time anyway)
+
+    printf("%-10s %-7s %-28s %12s %12s\n", "mode", "rate", "change", "gap (smp)", "marked");
+    for (int interrupt = 0; interrupt < 2; interrupt++) {
+        for (int r=0; r < 3; r++) {
+            for (int c=0; c < nChanges; c++) {
+                //the same starting point each time
+                ADS.initialize(OPENBCI_V2, false);
+                ADS.setHotReconfig(true);
+                for (int chan=1; chan <= 8; chan++) ADS.activateChannel(chan, ADS_GAIN24, ADSINPUT_NORMAL);
+                ADS.setSampleRate(rates[r]);
+                ADS.setInterruptMode(interrupt == 1);
+                chip.setLogReads(true);
+                chip.resetCounters();
+                chip.readLog.clear();
+
+                ADS.start();
+                int nMarked = 0, marked = -1;
+                byte markedChannels = 0;
+                size_t markedIndex = 0;
+                boolean ok = true;
+                for (int i=0; (i < N_BEFORE + N_AFTER) && ok; i++) {
+                    if (i == N_BEFORE) changes[c].change();
+                    ok = readSample(interrupt == 1);
+                    if (ADS.getDiscontinuity() >= 0) {
+                        nMarked++;
+                        marked = ADS.getDiscontinuity();
+                        markedChannels = ADS.getDiscontinuityChannels();
+                        markedIndex = i;
+                    }
+                }
+                ADS.stop();
+                CHECK(ok);
+
+                //the gap, from the conversions that were read
+                int gap = 0;
+                size_t gapIndex = 0;
+                for (size_t i=1; i < chip.readLog.size(); i++) {
+                    int skipped = (int)(chip.readLog[i] - chip.readLog[i-1]) - 1;
+                    if (skipped > gap) { gap = skipped; gapIndex = i; }
+                }
+                printf("%-10s %-7.0f %-28s %12d %12d\n", interrupt ? "interrupt" : "polling", ADS.getSampleRate_Hz(),
+                    changes[c].name, gap, marked);
+
+                CHECK(nMarked == 1);
+                CHECK(marked == gap);
+                CHECK(markedChannels == changes[c].channels);
+                if (gap > 0) CHECK(markedIndex == gapIndex);
+                CHECK(chip.ignoredCommands == 0);
+                CHECK(chip.framesTorn == 0);
+                CHECK(ADS.verifyRegisters() == 0);   //the changes all got there
+                if (rates[r] == ADS_RATE_250HZ) CHECK(gap == 0);   //plenty of time at 250 Hz
+            }
+        }
+    }
+
+    //no samples coming: commit() sends the change anyway, soon, and it's still marked
+    ADS.initialize(OPENBCI_V2, false);
+    ADS.setHotReconfig(true);
+    for (int chan=1; chan <= 8; chan++) ADS.activateChannel(chan, ADS_GAIN24, ADSINPUT_NORMAL);
+    ADS.setSampleRate(ADS_RATE_250HZ);
+    ADS.setInterruptMode(true);
+    chip.resetCounters();
+    ADS.start();
+    CHECK(readSample(true));
+    ADS.STOP();   //the conversions stop, but the Manager still thinks it's running
+    hostAdvance(10000000);
+    while (ADS.isDataAvailable()) ADS.popChannelData();
+    unsigned long start_us = micros();
+    changeGain();
+    unsigned long waited_us = micros() - start_us;
+    printf("with no samples coming, commit() gave up after %lu us\n", waited_us);
+    CHECK(waited_us < (ADS_HOT_COMMIT_TIMEOUT_PERIODS + 1) * 4000UL);
+    CHECK(chip.ignoredCommands == 0);
+    ADS.START();
+    CHECK(readSample(true));
+    CHECK(ADS.getDiscontinuity() >= 0);
+    CHECK(ADS.getDiscontinuityChannels() == 0b00000100);
+    ADS.stop();
+    CHECK((ADS.readRegister(CH3SET) & 0b01110000) == ADS_GAIN12);
+    CHECK(ADS.verifyRegisters() == 0);
+    ADS.setInterruptMode(false);
+
+    return hostTestResult("test_hot_reconfig");
+}
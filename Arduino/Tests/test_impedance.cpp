@@ -0,0 +1,79 @@
+//
+//  test_impedance.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  Electrode impedance through the simulated chip: AC lead-off at 7.8 Hz and 6 nA, gain 24,
+//  and ADS1299Impedance plus ADS1299Manager::getImpedanceCode turning the tone into ohms,
+//  as writeChannelDataAsImpedance does.  At 250, 500, and 1000 Hz, with an electrode offset
+//  of 0, 20 mV, and 100 mV (which the lock-in has to take out before the Goertzel filter,
+//  or it swamps the tone), it checks that:
+//     * 10k and 50k (P side only), and 10k + 10k (both sides), read back within 3%
+//     * 10 MOhm, whose tone is too big for the lock-in's states, is ADS_IMPEDANCE_OVER_RANGE
+//       instead of whatever the clipped states happen to say
+//     * a channel without the lead-off current is ADS_IMPEDANCE_NOT_MEASURED
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include "HostStream.h"
+#include <ADS1299Manager.h>
+
+static ADS1299Manager ADS;
+
+#define N_CHAN (8)
+
+int main(void)
+{
+    ADS1299Sim &chip = ADS1299Sim::chip();
+    const byte rates[] = { ADS_RATE_250HZ, ADS_RATE_500HZ, ADS_RATE_1kHZ };
+    const double offsets_V[] = { 0.0, 20.0e-3, 100.0e-3 };
+    //the electrodes on each channel (P, N), and which sides get the lead-off current
+    const double ohmsP[N_CHAN] = { 10.0e3, 50.0e3, 10.0e3, 10.0e6, 10.0e3, 10.0e3, 10.0e3, 10.0e3 };
+    const double ohmsN[N_CHAN] = { 10.0e3, 10.0e3, 10.0e3, 10.0e3, 10.0e3, 10.0e3, 10.0e3, 10.0e3 };
+    const int sides[N_CHAN] = { PCHAN, PCHAN, BOTHCHAN, PCHAN, -1, -1, -1, -1 };
+    const double expected_ohms[N_CHAN] = { 10.0e3, 50.0e3, 20.0e3, -1, -1, -1, -1, -1 };   //-1: over range or not measured
+
+    for (int r=0; r < 3; r++) {
+        for (int o=0; o < 3; o++) {
+            hostReset();
+            chip.powerUp(1);
+            ADS.initialize(OPENBCI_V2, false);
+            ADS.setSampleRate(rates[r]);
+            ADS.configureLeadOffDetection(LOFF_MAG_6NA, LOFF_FREQ_7p8HZ);
+            for (int chan=0; chan < N_CHAN; chan++) {
+                ADS.activateChannel(chan+1, ADS_GAIN24, ADSINPUT_NORMAL);
+                if (sides[chan] >= 0) ADS.changeChannelLeadOffDetection(chan+1, ON, sides[chan]);
+                chip.setSignal(chan, offsets_V[o] * ((chan % 2) ? -1.0 : 1.0), 0.0, 0.0);
+                chip.setElectrodes(chan, ohmsP[chan], ohmsN[chan]);
+            }
+            chip.setNoise(0.5e-6);
+
+            ADS1299Impedance impedance(N_CHAN);
+            CHECK(impedance.setup(ADS.getSampleRate_Hz(), ADS.getLeadOffFrequency_Hz(), 2.0));
+            unsigned int codes[N_CHAN];
+            int nBlocks = 0;
+            hostStream(ADS, 2.1, [&](long sampleNumber) {
+                if (!impedance.process(ADS.channelData)) return;
+                nBlocks++;
+                for (int chan=0; chan < N_CHAN; chan++) {
+                    codes[chan] = ADS.getImpedanceCode(chan, impedance.getAmplitude(chan), impedance.getDriveFrequency_Hz());
+                }
+            });
+            CHECK(nBlocks >= 3);
+
+            printf("%4.0f Hz, offset %3.0f mV:", ADS.getSampleRate_Hz(), offsets_V[o] * 1.0e3);
+            for (int chan=0; chan < 4; chan++) printf("  %5u", codes[chan]);
+            printf("  (x100 ohms)\n");
+            for (int chan=0; chan < N_CHAN; chan++) {
+                if (expected_ohms[chan] > 0.0) CHECK_NEAR(codes[chan] * 100.0, expected_ohms[chan], 0.03 * expected_ohms[chan]);
+            }
+            CHECK(codes[3] == ADS_IMPEDANCE_OVER_RANGE);
+            CHECK(impedance.isOverRange(3));
+            for (int chan=0; chan < 3; chan++) CHECK(!impedance.isOverRange(chan));
+            for (int chan=4; chan < N_CHAN; chan++) CHECK(codes[chan] == ADS_IMPEDANCE_NOT_MEASURED);
+        }
+    }
+
+    return hostTestResult("test_impedance");
+}
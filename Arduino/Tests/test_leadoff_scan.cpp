@@ -0,0 +1,194 @@
+//
+//  test_leadoff_scan.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  ADS1299LeadOffScan with the real ADS1299Manager, against the simulated chip, at 250 Hz
+//  with 7.8 Hz AC lead-off.  Channels 3 and 6 are turned off, and each of the others has a
+//  different electrode on its P side.  Four runs: without hot reconfiguration, with it,
+//  and with it while streaming packed binary (and then COBS) with the scan's packets on.
+//  Each checks that:
+//     * the scan goes around the channels that are on (1, 2, 4, 5, 7, 8, 1, ...), skipping
+//       the ones that are off
+//     * the chip has the lead-off current on just the channel under test
+//     * the stream has no gaps: the chip loses no frames, no sample arrives more than a
+//       sample period after the one before, and no sample is marked as having samples
+//       lost before it.  With hot reconfiguration, the only marks are the moves (which
+//       say 0 samples lost), one per move.
+//     * each move is one register write (ADS1299Sim::registerWrites), and changes just
+//       the one register
+//     * each channel's impedance reads back within 3%, and the channels that are off stay
+//       ADS_IMPEDANCE_NOT_MEASURED
+//  With the packets on, the PC has to get every sample, in order, with no bad packets,
+//  and a lead-off scan packet (PCKT_START_LEADOFF_SCAN) for each channel in the order
+//  that it was scanned, right before the sample that it names, which is the first one
+//  with the new setting.  An impedance packet goes out at the end of each dwell.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include "HostStream.h"
+#include "PacketParser.h"
+#include <ADS1299Manager.h>
+#include <ADS1299LeadOffScan.h>
+#include <set>
+
+static ADS1299Manager ADS;
+
+#define N_CHAN (8)
+
+int main(void)
+{
+    ADS1299Sim &chip = ADS1299Sim::chip();
+    const int expectedOrder[] = { 1, 2, 4, 5, 7, 8, 1, 2 };
+    const int nExpected = sizeof(expectedOrder) / sizeof(expectedOrder[0]);
+    const char *runNames[4] = { "without hot reconfiguration", "with hot reconfiguration",
+        "with hot reconfiguration, packed binary", "with hot reconfiguration, COBS" };
+
+    for (int run=0; run < 4; run++) {
+        boolean hot = (run >= 1);
+        boolean sendPackets = (run >= 2);
+        boolean cobs = (run == 3);
+        hostReset();
+        chip.powerUp(1);
+        ADS.initialize(OPENBCI_V2, false);
+        ADS.setHotReconfig(hot);
+        ADS.setCOBSFraming(cobs);
+        ADS.setSampleRate(ADS_RATE_250HZ);
+        ADS.configureLeadOffDetection(LOFF_MAG_6NA, LOFF_FREQ_7p8HZ);
+        for (int chan=0; chan < N_CHAN; chan++) {
+            if ((chan == 2) || (chan == 5)) ADS.deactivateChannel(chan+1);
+            else ADS.activateChannel(chan+1, ADS_GAIN24, ADSINPUT_NORMAL);
+            chip.setSignal(chan, 10.0e-3, 0.0, 0.0);
+            chip.setElectrodes(chan, 10.0e3 * (chan+1), 5.0e3);
+        }
+        chip.setNoise(0.5e-6);
+
+        ADS1299Impedance impedance(N_CHAN);
+        CHECK(impedance.setup(ADS.getSampleRate_Hz(), ADS.getLeadOffFrequency_Hz(), 2.0));
+        ADS1299LeadOffScan scan(&ADS, &impedance);
+        CHECK(scan.start(N_CHAN, PCHAN, 1.0));
+        chip.resetCounters();
+        Serial.clearSent();
+
+        std::vector<int> order;
+        order.push_back(scan.getChannelUnderTest());
+        std::vector<unsigned long> stepWrites;         //WREGs from each move through the next sample
+        boolean moved = false;
+        unsigned long writesBeforeMove = 0;
+        byte regsAtMove[CONFIG4+1];
+        for (int reg=0; reg <= CONFIG4; reg++) regsAtMove[reg] = chip.getRegister(reg);
+        int nWrongRegister = 0, nOtherRegisters = 0, nMarked = 0, nMarkedLost = 0;
+        std::set<long> markedSamples;
+        uint64_t lastSample_ns = 0, maxGap_ns = 0;
+        long nSamples = hostStream(ADS, 8.5, [&](long sampleNumber) {
+            uint64_t now = hostNanos();
+            if (sampleNumber > 1) maxGap_ns = max(maxGap_ns, now - lastSample_ns);
+            lastSample_ns = now;
+            if (ADS.getDiscontinuity() >= 0) {
+                nMarked++;
+                markedSamples.insert(sampleNumber);
+                if (ADS.getDiscontinuity() > 0) nMarkedLost++;
+            }
+
+            //with hot reconfiguration, the last move went out just before this sample was read
+            if (moved) stepWrites.push_back(chip.registerWrites - writesBeforeMove);
+            moved = false;
+
+            //as in the sketch: the scan first, then the data
+            unsigned long writesBefore = chip.registerWrites;
+            if (scan.update(sampleNumber, sendPackets)) {
+                order.push_back(scan.getChannelUnderTest());
+                moved = true;
+                writesBeforeMove = writesBefore;
+                //since the last move, only LOFF_SENSP changed
+                for (int reg=0; reg <= CONFIG4; reg++) {
+                    if ((reg != LOFF_SENSP) && (chip.getRegister(reg) != regsAtMove[reg])) nOtherRegisters++;
+                    regsAtMove[reg] = chip.getRegister(reg);
+                }
+            }
+            if (chip.getRegister(LOFF_SENSP) != (1 << (scan.getChannelUnderTest()-1))) nWrongRegister++;
+            if (cobs) ADS.writeChannelDataAsCOBS(N_CHAN, sampleNumber);
+            else if (sendPackets) ADS.writeChannelDataAsPackedBinary(N_CHAN, sampleNumber);
+        });
+        double period_ns = 1.0e9 / ADS.getSampleRate_Hz();
+
+        printf("%s, channels scanned:", runNames[run]);
+        for (size_t i=0; i < order.size(); i++) printf(" %d", order[i]);
+        printf("\n");
+        printf("   %d samples marked, longest gap %.2f sample periods, WREGs per move:", nMarked, maxGap_ns / period_ns);
+        for (size_t i=0; i < stepWrites.size(); i++) printf(" %lu", stepWrites[i]);
+        printf("\n");
+        CHECK((int)order.size() >= nExpected);
+        for (int i=0; (i < nExpected) && (i < (int)order.size()); i++) CHECK(order[i] == expectedOrder[i]);
+        CHECK(chip.getRegister(LOFF_SENSN) == 0);
+        //the scan moves on before the register is written (with hot reconfiguration, that's
+        //at the next sample boundary), so at most one sample per move sees the old one
+        CHECK(nWrongRegister <= (int)order.size());
+
+        //no gaps
+        CHECK(chip.framesLost == 0);
+        CHECK(chip.ignoredCommands == 0);
+        CHECK(maxGap_ns < 1.5 * period_ns);
+        CHECK(nMarkedLost == 0);
+
+        //the least traffic: each move is the one register, in one WREG
+        int nMoves = (int)order.size() - 1;
+        CHECK(nMarked == (hot ? nMoves : 0));
+        CHECK((int)stepWrites.size() == nMoves);
+        for (size_t i=0; i < stepWrites.size(); i++) CHECK(stepWrites[i] == 1);
+        CHECK(nOtherRegisters == 0);
+
+        for (int chan=0; chan < N_CHAN; chan++) {
+            unsigned int code = scan.getImpedanceCode(chan);
+            if ((chan == 2) || (chan == 5)) {
+                CHECK(code == ADS_IMPEDANCE_NOT_MEASURED);
+            } else {
+                CHECK_NEAR(code * 100.0, 10.0e3 * (chan+1), 0.03 * 10.0e3 * (chan+1));
+            }
+        }
+
+        //what the PC got
+        PacketParser parser(cobs);
+        parser.parse(Serial.sent(), Serial.sentBytes());
+        if (!sendPackets) {
+            CHECK(Serial.sentBytes() == 0);
+        } else {
+            CHECK(parser.badPackets == 0);
+            CHECK((long)parser.samples.size() == nSamples);
+            int nOutOfOrder = 0;
+            for (size_t i=0; i < parser.samples.size(); i++) if (parser.samples[i].sampleNumber != (long)i+1) nOutOfOrder++;
+            CHECK(nOutOfOrder == 0);
+
+            std::vector<int> scanOrder;
+            int nImpedance = 0, nWrongPlace = 0, nUnmarked = 0;
+            for (size_t i=0; i < parser.packets.size(); i++) {
+                const ParsedPacket &packet = parser.packets[i];
+                if (packet.format == PCKT_START_IMPEDANCE) nImpedance++;
+                if (packet.format != PCKT_START_LEADOFF_SCAN) continue;
+                if (packet.payload.size() != 6) { CHECK(false); continue; }
+                long sampleNumber = parseInt32(&packet.payload[0]);
+                scanOrder.push_back(packet.payload[4]);
+                CHECK(packet.payload[5] == PCHAN);
+                if (packet.nSamplesBefore != (size_t)(sampleNumber - 1)) nWrongPlace++;
+                //after the first, each is the sample marked by the hot reconfiguration
+                if ((scanOrder.size() > 1) && (markedSamples.count(sampleNumber) == 0)) nUnmarked++;
+            }
+            printf("   scan packets for channels:");
+            for (size_t i=0; i < scanOrder.size(); i++) printf(" %d", scanOrder[i]);
+            printf(", %d impedance packets\n", nImpedance);
+            //one for each channel that was scanned, except one that the stream ended before
+            CHECK((scanOrder.size() == order.size()) || (scanOrder.size() + 1 == order.size()));
+            for (size_t i=0; i < scanOrder.size(); i++) CHECK(scanOrder[i] == order[i]);
+            CHECK(nWrongPlace == 0);
+            CHECK(nUnmarked == 0);
+            CHECK(nImpedance == nMoves);
+        }
+
+        scan.stop();
+        CHECK(!scan.isScanning());
+        CHECK(chip.getRegister(LOFF_SENSP) == 0);
+    }
+
+    return hostTestResult("test_leadoff_scan");
+}
@@ -0,0 +1,160 @@
+//
+//  test_line_noise.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  LineNoiseCanceller against the two Q=4 notches that it can replace in StreamRawData
+//  (LINE_NOISE_CANCELLER, which is off by default, as the notches take out more of the
+//  fundamental):
+//     the reference: sinQ14() over the whole cycle, against sin()
+//     the attenuation: 8 channels of EEG at 250 Hz with mains interference whose frequency
+//        drifts +/-0.2 Hz (49.8 to 50.2 Hz, and 59.8 to 60.2 Hz), back and forth over 20 s
+//        and over 60 s, with and without 2nd and 3rd harmonics.  What's left of the
+//        interference is F(EEG + mains) - F(EEG), for each filter F, once it has settled.
+//     the EEG next to it: a tone 3 Hz below the mains, which the canceller should leave alone
+//  It prints the attenuation, in dB, of each.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include <LineNoiseCanceller.h>
+#include <Biquad_cascade_fixed.h>
+#include <vector>
+#include <random>
+#include <math.h>
+
+#define FS_HZ (250.0)
+#define N_CHAN (8)
+#define N_SAMPLES (30000)     //two minutes
+#define SETTLE_SAMPLES (5000) //20 seconds
+#define COUNTS_PER_UV (24.0 / 4.5 * 8388607.0 * 1.0e-6)
+
+typedef std::vector<long> Signal;   //[sample*N_CHAN + chan]
+
+//background EEG (1/f) with an alpha rhythm, no DC (as if it had been through the highpass)
+static Signal makeEEG(unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> gauss(0.0, 1.0);
+    Signal out(N_SAMPLES * N_CHAN);
+    for (int chan=0; chan < N_CHAN; chan++) {
+        double state[3] = { 0.0, 0.0, 0.0 };
+        const double pole[3] = { 0.98, 0.9, 0.5 };
+        const double weight_uV[3] = { 3.0, 3.0, 2.0 };
+        for (int i=0; i < N_SAMPLES; i++) {
+            double uV = 0.0;
+            for (int k=0; k < 3; k++) {
+                state[k] = pole[k] * state[k] + sqrt(1.0 - pole[k]*pole[k]) * gauss(rng);
+                uV += weight_uV[k] * state[k];
+            }
+            uV += 10.0 * sin(2.0*M_PI*10.0*i/FS_HZ + chan) + 0.5 * gauss(rng);
+            out[i*N_CHAN + chan] = lround(uV * COUNTS_PER_UV);
+        }
+    }
+    return out;
+}
+
+//mains at f0_Hz +/- 0.2 Hz, the drift a sine with the given period, 20 to 34 uV depending on
+//the channel, and 20% of 2nd and 15% of 3rd harmonic if asked for
+static Signal makeMains(double f0_Hz, double driftPeriod_sec, bool harmonics)
+{
+    Signal out(N_SAMPLES * N_CHAN);
+    double phase = 0.0;
+    for (int i=0; i < N_SAMPLES; i++) {
+        double f_Hz = f0_Hz + 0.2 * sin(2.0*M_PI*i / (FS_HZ * driftPeriod_sec));
+        phase += 2.0*M_PI*f_Hz / FS_HZ;
+        for (int chan=0; chan < N_CHAN; chan++) {
+            double p = phase + 0.4*chan;
+            double uV = (20.0 + 2.0*chan) * (sin(p) + (harmonics ? (0.20*sin(2.0*p + 1.0) + 0.15*sin(3.0*p + 2.0)) : 0.0));
+            out[i*N_CHAN + chan] = lround(uV * COUNTS_PER_UV);
+        }
+    }
+    return out;
+}
+
+static Signal add(const Signal &a, const Signal &b)
+{
+    Signal out(a.size());
+    for (size_t i=0; i < a.size(); i++) out[i] = a[i] + b[i];
+    return out;
+}
+
+//a filter, run over a whole signal from a fresh start
+struct Filter {
+    int kind;        //0 is the canceller, 1 the two notches
+    int Nharmonics;
+    Signal run(Signal data, double f0_Hz) const {
+        if (kind == 0) {
+            LineNoiseCanceller lnc(N_CHAN, Nharmonics);
+            lnc.setFrequency(f0_Hz / FS_HZ);
+            for (int i=0; i < N_SAMPLES; i++) lnc.process(&data[i*N_CHAN]);
+        } else {
+            Biquad_cascade_fixed notches(N_CHAN, 2);
+            for (int s=0; s < 2; s++) notches.setStage(s, bq_type_notch, f0_Hz / FS_HZ, 4.0, 0.0);
+            for (int i=0; i < N_SAMPLES; i++) notches.process(&data[i*N_CHAN]);
+        }
+        return data;
+    }
+};
+
+//power of (a - b) over power of ref, in dB, after the filters have settled
+static double ratio_dB(const Signal &a, const Signal &b, const Signal &ref)
+{
+    double num = 0.0, den = 0.0;
+    for (size_t i = SETTLE_SAMPLES * N_CHAN; i < a.size(); i++) {
+        double d = (double)(a[i] - (b.empty() ? 0 : b[i]));
+        num += d * d;
+        den += (double)ref[i] * (double)ref[i];
+    }
+    return 10.0 * log10(num / den);
+}
+
+int main(void)
+{
+    //the reference sine: good to 1.4e-4 (-77 dB), the whole way around
+    double worst = 0.0;
+    for (long p=0; p < 65536; p++) {
+        worst = max(worst, fabs(LineNoiseCanceller::sinQ14((uint16_t)p) / 16384.0 - sin(2.0*M_PI*p / 65536.0)));
+    }
+    printf("sinQ14: worst error %.2e (%.1f dB)\n", worst, 20.0 * log10(worst));
+    CHECK(worst < 1.4e-4);
+
+    const Filter lnc1 = { 0, 1 }, lnc3 = { 0, 3 }, notch = { 1, 0 };
+    const Signal eeg = makeEEG(1);
+    printf("%-8s %-8s %-10s %10s %10s %10s\n", "mains", "drift", "harmonics", "LNC x1 dB", "LNC x3 dB", "notch dB");
+    const double f0s[2] = { 50.0, 60.0 };
+    const double periods[2] = { 20.0, 60.0 };
+    for (int f=0; f < 2; f++) {
+        const Signal eegOut[3] = { lnc1.run(eeg, f0s[f]), lnc3.run(eeg, f0s[f]), notch.run(eeg, f0s[f]) };
+        for (int d=0; d < 2; d++) {
+            for (int h=0; h < 2; h++) {
+                const Signal mains = makeMains(f0s[f], periods[d], h != 0);
+                const Signal both = add(eeg, mains);
+                double dB[3];
+                dB[0] = ratio_dB(lnc1.run(both, f0s[f]), eegOut[0], mains);
+                dB[1] = ratio_dB(lnc3.run(both, f0s[f]), eegOut[1], mains);
+                dB[2] = ratio_dB(notch.run(both, f0s[f]), eegOut[2], mains);
+                printf("%-8.0f %-8.0f %-10s %10.1f %10.1f %10.1f\n", f0s[f], periods[d], h ? "2nd, 3rd" : "none", dB[0], dB[1], dB[2]);
+
+                //the canceller follows the drift, and takes the harmonics out when it's asked to
+                if (!h) CHECK(dB[0] < -20.0);  //(with the harmonics, they're 12 dB down, and x1 leaves them)
+                CHECK(dB[1] < -20.0);
+                if (h) CHECK(dB[1] < dB[2]);   //the notches don't touch the harmonics
+            }
+        }
+
+        //a tone 3 Hz below the mains goes through the canceller, and not through the notches
+        Signal tone(N_SAMPLES * N_CHAN);
+        for (int i=0; i < N_SAMPLES; i++) {
+            for (int chan=0; chan < N_CHAN; chan++) tone[i*N_CHAN + chan] = lround(20.0 * COUNTS_PER_UV * sin(2.0*M_PI*(f0s[f] - 3.0)*i / FS_HZ));
+        }
+        Signal none;
+        double toneLNC = ratio_dB(lnc1.run(tone, f0s[f]), none, tone);
+        double toneNotch = ratio_dB(notch.run(tone, f0s[f]), none, tone);
+        printf("tone at %.0f Hz: LNC x1 %.2f dB, notch %.2f dB\n", f0s[f] - 3.0, toneLNC, toneNotch);
+        CHECK(fabs(toneLNC) < 0.1);
+        CHECK(toneNotch < -3.0);
+    }
+
+    return hostTestResult("test_line_noise");
+}
@@ -0,0 +1,91 @@
+//
+//  test_manager_basics.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  ADS1299Manager against the simulated chip: it finds the chip, its shadow registers
+//  agree with the chip's, the samples come through in polling mode with their signs
+//  intact, and the SPI policy's Lock really keeps interrupts out.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include <ADS1299Manager.h>
+
+static ADS1299Manager ADS;
+
+static void waitForData(void)
+{
+    unsigned long start = millis();
+    while (!ADS.isDataAvailable() && ((millis() - start) < 100)) ;
+}
+
+int main(void)
+{
+    ADS1299Sim &chip = ADS1299Sim::chip();
+    hostReset();
+    chip.powerUp(1);
+    ADS.initialize(OPENBCI_V2, false);
+
+    //it's there, and stopped
+    CHECK(ADS.getDeviceID() == ADS_SIM_DEVICE_ID);
+    CHECK(!chip.isRDATAC());
+    CHECK(chip.ignoredCommands == 0);           //nothing was sent while it was in RDATAC
+    CHECK(chip.getRegister(LOFF_FLIP) == 0xFF); //V2 senses the negative inputs
+
+    //configure every channel, then compare the shadow copy with the chip
+    for (int chan=1; chan <= 8; chan++) ADS.activateChannel(chan, ADS_GAIN24, ADSINPUT_NORMAL);
+    ADS.setSampleRate(ADS_RATE_500HZ);
+    for (byte reg=CONFIG1; reg <= CONFIG4; reg++) {
+        if ((reg == LOFF_STATP) || (reg == LOFF_STATN)) continue;
+        if (ADS.readRegister(reg) != chip.getRegister(reg)) printf("register 0x%02X: shadow 0x%02X, chip 0x%02X\n", reg, ADS.readRegister(reg), chip.getRegister(reg));
+        CHECK(ADS.readRegister(reg) == chip.getRegister(reg));
+    }
+    CHECK(ADS.verifyRegisters() == 0);
+    CHECK_NEAR(chip.getSampleRate_Hz(), 500.0, 1e-9);
+
+    //stream the test pattern, which says which conversion each value came from
+    chip.setTestPattern(true);
+    chip.setLogReads(true);
+    chip.resetCounters();
+    ADS.start();
+    int nBad = 0;
+    for (int i=0; i < 500; i++) {
+        waitForData();
+        ADS.updateChannelData();
+        long conv = chip.readLog.back();
+        for (int chan=0; chan < 8; chan++) {
+            if (ADS.channelData[chan] != ADS1299Sim::patternValue(conv, chan)) nBad++;
+        }
+    }
+    ADS.stop();
+    CHECK(nBad == 0);
+    CHECK(chip.framesLost == 0);
+    CHECK(chip.framesTorn == 0);
+    CHECK(chip.ignoredCommands == 0);
+    CHECK(chip.framesRead == 500);
+
+    //a real signal: 100 uV DC on channel 3 at gain 24, and the sign survives
+    chip.setTestPattern(false);
+    chip.setSignal(2, -100.0e-6, 0.0, 0.0);
+    ADS.start();
+    waitForData();
+    ADS.updateChannelData();
+    ADS.stop();
+    CHECK_NEAR(ADS.channelData[2], -100.0e-6 * 24.0 / 4.5 * 8388607.0, 1.0);
+    CHECK(ADS.channelData[0] == 0);
+
+    //CRC-16/CCITT's check value
+    CHECK(ADS.computeCRC16((const byte *)"123456789", 9) == 0x29B1);
+
+    //the Lock turns interrupts off, and puts them back the way they were
+    {
+        ADS1299::Lock lock;
+        CHECK(hostDisableInterrupts() == false);
+        hostRestoreInterrupts(false);
+    }
+    CHECK(hostDisableInterrupts() == true);
+    hostRestoreInterrupts(true);
+
+    return hostTestResult("test_manager_basics");
+}
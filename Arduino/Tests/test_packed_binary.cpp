@@ -0,0 +1,132 @@
+//
+//  test_packed_binary.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  The packed (3 bytes per sample) format against the original 4-byte one.  Every
+//  value has to come back out of the PC's parser as it went in (clamped to 24 bits,
+//  for the packed format), and then both are streamed from the simulated chip to see
+//  how many bytes per second each one needs, and whether the link keeps up.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostStream.h"
+#include "PacketParser.h"
+#include <random>
+
+static ADS1299Manager ADS;
+
+#define FORMAT_BINARY (0)
+#define FORMAT_PACKED (1)
+
+static void writeSample(int format, int N, long sampleNumber)
+{
+    if (format == FORMAT_BINARY) ADS.writeChannelDataAsBinary(N, sampleNumber);
+    else ADS.writeChannelDataAsPackedBinary(N, sampleNumber);
+}
+
+static long clamp24(long value)
+{
+    return constrain(value, -8388608L, 8388607L);
+}
+
+int main(int argc, char **argv)
+{
+    ADS1299Sim &chip = ADS1299Sim::chip();
+    hostReset();
+    chip.powerUp(2);
+    ADS.initializeBoards(OPENBCI_V2, 2);
+    for (int chan=1; chan <= 16; chan++) ADS.activateChannel(chan, ADS_GAIN24, ADSINPUT_NORMAL);
+
+    //round trip: random values, plus the edges of the 24-bit range and a few past them
+    //(the filters can overshoot)
+    const long edges[] = { 0, 1, -1, 8388607L, -8388608L, 8388608L, -8388609L, 100000000L, -100000000L, 255, 256, -256 };
+    const int nEdges = sizeof(edges)/sizeof(edges[0]);
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<long> uniform24(-8388608L, 8388607L);
+    for (int format = FORMAT_BINARY; format <= FORMAT_PACKED; format++) {
+        for (int N = 1; N <= 16; N++) {
+            std::vector<std::vector<long> > sent;
+            Serial.clearSent();
+            for (long s = 0; s < 50; s++) {
+                std::vector<long> values(N);
+                for (int chan=0; chan < N; chan++) {
+                    values[chan] = (s < nEdges) ? edges[(s + chan) % nEdges] : uniform24(rng);
+                    ADS.channelData[chan] = values[chan];
+                }
+                writeSample(format, N, 1000 + s);
+                sent.push_back(values);
+            }
+            ADS.flushTX();
+
+            PacketParser parser;
+            parser.parse(Serial.sent(), Serial.sentBytes());
+            CHECK(parser.badPackets == 0);
+            CHECK(parser.samples.size() == sent.size());
+            int perPacket = (format == FORMAT_BINARY) ? ADS.getBinaryPacketBytes(N, false) : ADS.getPackedBinaryPacketBytes(N);
+            CHECK(Serial.sentBytes() == sent.size() * perPacket);
+            int nBad = 0;
+            for (size_t s=0; (s < sent.size()) && (s < parser.samples.size()); s++) {
+                const ParsedSample &got = parser.samples[s];
+                if (got.format != ((format == FORMAT_BINARY) ? PCKT_START : PCKT_START_PACKED)) nBad++;
+                if (got.sampleNumber != 1000 + (long)s) nBad++;
+                if ((int)got.values.size() != N) { nBad++; continue; }
+                for (int chan=0; chan < N; chan++) {
+                    long expected = (format == FORMAT_BINARY) ? sent[s][chan] : clamp24(sent[s][chan]);
+                    if (got.values[chan] != expected) nBad++;
+                }
+            }
+            CHECK(nBad == 0);
+        }
+    }
+
+    //the packet number is a plain 4-byte number in both, so it survives going negative
+    Serial.clearSent();
+    ADS.writeChannelDataAsPackedBinary(8, -2L);
+    ADS.flushTX();
+    {
+        PacketParser parser;
+        parser.parse(Serial.sent(), Serial.sentBytes());
+        CHECK((parser.samples.size() == 1) && (parser.samples[0].sampleNumber == -2L));
+    }
+
+    //bytes per second, streaming EEG-like data from the simulated chip
+    printf("%-7s %-6s %-7s %8s %12s %10s %10s %12s\n", "format", "chans", "rate", "baud", "bytes/sample", "bytes/sec", "fits?", "samples lost");
+    chip.setNoise(5.0e-6);
+    for (int chan=0; chan < 16; chan++) chip.setSignal(chan, 1.0e-3 * chan, 50.0e-6, 10.0);
+    const long bauds[] = { 115200, 153600, 230400 };
+    for (int rate = ADS_RATE_250HZ; rate >= ADS_RATE_500HZ; rate--) {
+        ADS.setSampleRate(rate);
+        for (int N = 8; N <= 16; N += 8) {
+            for (int b=0; b < 3; b++) {
+                for (int format = FORMAT_BINARY; format <= FORMAT_PACKED; format++) {
+                    Serial.begin(bauds[b]);
+                    Serial.clearSent();
+                    chip.resetCounters();
+                    uint64_t start_ns = hostNanos();
+                    long nSamples = hostStream(ADS, 2.0, [&](long sampleNumber) { writeSample(format, N, sampleNumber); });
+                    double seconds = (double)(hostNanos() - start_ns) * 1.0e-9;
+                    double bytesPerSample = (double)Serial.sentBytes() / nSamples;
+                    int perPacket = (format == FORMAT_BINARY) ? ADS.getBinaryPacketBytes(N, false) : ADS.getPackedBinaryPacketBytes(N);
+                    boolean fits = ADS.isStreamSustainable(bauds[b], perPacket);
+                    printf("%-7s %-6d %-7.0f %8ld %12.1f %10.0f %10s %12lu\n", (format == FORMAT_BINARY) ? "binary" : "packed",
+                        N, ADS.getSampleRate_Hz(), bauds[b], bytesPerSample, Serial.sentBytes() / seconds, fits ? "yes" : "no", chip.framesLost);
+                    CHECK(bytesPerSample == perPacket);
+                    //when the link is fast enough, nothing is lost, and when it isn't, something is
+                    if (fits) CHECK(chip.framesLost == 0);
+                    else CHECK(chip.framesLost > 0);
+                }
+            }
+        }
+    }
+
+    //the case this was for: 16 channels at 250 Hz needs 17750 bytes/sec in the old
+    //format and 13750 in the new, so the new one fits a 153600 baud link and the old doesn't
+    ADS.setSampleRate(ADS_RATE_250HZ);
+    CHECK(!ADS.isStreamSustainable(153600, ADS.getBinaryPacketBytes(16, false)));
+    CHECK(ADS.isStreamSustainable(153600, ADS.getPackedBinaryPacketBytes(16)));
+    CHECK(ADS.getPackedBinaryPacketBytes(8) == 31);
+    CHECK(ADS.getBinaryPacketBytes(8, false) == 39);
+
+    return hostTestResult("test_packed_binary");
+}
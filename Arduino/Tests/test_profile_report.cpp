@@ -0,0 +1,149 @@
+//
+//  test_profile_report.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  The timing report ('P' in StreamRawData), both ways that it goes out:
+//     while streaming binary:  one status packet per stage, one after each sample, as in
+//                              the sketch's sendStageProfile(), with each stage packed by
+//                              ADS1299Profiler::packStage().  Streaming packed binary and
+//                              COBS, it checks that the PC's parser gets every sample, in
+//                              order, with no bad packets, and that each stage decodes to
+//                              the count, min, mean, max, and histogram of the times that
+//                              were put in (simulated: 120 usec to read, 700 to filter).
+//     stopped:                 printStage()'s text, with the same numbers
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include "HostStream.h"
+#include "PacketParser.h"
+#include <ADS1299Manager.h>
+#include <ADS1299Profiler.h>
+#include <string>
+
+static ADS1299Manager ADS;
+
+#define N_CHAN (8)
+#define CMD_PROFILE_REPORT (0x82)   //as in StreamRawData.ino
+#define CMD_STATUS_OK (0)
+#define STAGE_READ (0)
+#define STAGE_FILTER (1)
+#define STAGE_TOTAL (2)
+#define N_STAGES (3)
+#define READ_US (120)
+#define FILTER_US (700)
+#define REPORT_AT_SAMPLE (500)      //when 'P' is pressed
+
+static ADS1299Profiler<N_STAGES> stageProfile;
+static int profileReportNext = -1;
+
+//as in the sketch, minus the DRDY interrupt's stage
+static void sendStageProfile(void)
+{
+    byte reply[3 + ADS_PROFILE_PACKED_BYTES];
+    reply[0] = CMD_PROFILE_REPORT;
+    reply[1] = CMD_STATUS_OK;
+    reply[2] = (byte)profileReportNext;
+    stageProfile.packStage(profileReportNext, reply+3);
+    ADS.writeStatusPacket(reply, sizeof(reply));
+    if (++profileReportNext >= N_STAGES) {
+        stageProfile.reset();
+        profileReportNext = -1;
+    }
+}
+
+//the histogram bin that a time lands in (see ADS1299Profiler.h)
+static int binOf(unsigned int dt_us)
+{
+    int bin = 0;
+    for (unsigned int v = dt_us >> 3; (v != 0) && (bin < ADS_PROFILE_N_BINS-1); v >>= 1) bin++;
+    return bin;
+}
+
+int main(void)
+{
+    ADS1299Sim &chip = ADS1299Sim::chip();
+    const unsigned int expected_us[N_STAGES] = { READ_US, FILTER_US, READ_US + FILTER_US };
+
+    for (int cobs=0; cobs < 2; cobs++) {
+        hostReset();
+        chip.powerUp(1);
+        ADS.initialize(OPENBCI_V2, false);
+        ADS.setCOBSFraming(cobs != 0);
+        stageProfile.reset();
+        profileReportNext = -1;
+        Serial.clearSent();
+
+        long nSamples = hostStream(ADS, 4.0, [&](long sampleNumber) {
+            stageProfile.begin();
+            hostAdvance(READ_US * 1000ULL);
+            stageProfile.lap(STAGE_READ);
+            hostAdvance(FILTER_US * 1000ULL);
+            stageProfile.lap(STAGE_FILTER);
+            stageProfile.finish(STAGE_TOTAL);
+            if (cobs) ADS.writeChannelDataAsCOBS(N_CHAN, sampleNumber);
+            else ADS.writeChannelDataAsPackedBinary(N_CHAN, sampleNumber);
+            if (sampleNumber == REPORT_AT_SAMPLE) profileReportNext = 0;
+            if (profileReportNext >= 0) sendStageProfile();
+        });
+        CHECK(nSamples > REPORT_AT_SAMPLE + N_STAGES);
+
+        //the data got through, all of it
+        PacketParser parser(cobs != 0);
+        parser.parse(Serial.sent(), Serial.sentBytes());
+        CHECK(parser.badPackets == 0);
+        CHECK((long)parser.samples.size() == nSamples);
+        int nOutOfOrder = 0;
+        for (size_t i=0; i < parser.samples.size(); i++) if (parser.samples[i].sampleNumber != (long)i+1) nOutOfOrder++;
+        CHECK(nOutOfOrder == 0);
+
+        //and so did the report, a stage after each sample
+        CHECK(parser.packets.size() == N_STAGES);
+        for (size_t Ipacket=0; Ipacket < parser.packets.size(); Ipacket++) {
+            const ParsedPacket &packet = parser.packets[Ipacket];
+            CHECK(packet.format == PCKT_START_STATUS);
+            CHECK(packet.nSamplesBefore == REPORT_AT_SAMPLE + Ipacket);
+            if (packet.payload.size() != 3 + ADS_PROFILE_PACKED_BYTES) { CHECK(false); continue; }
+            const byte *p = &packet.payload[0];
+            CHECK(p[0] == CMD_PROFILE_REPORT);
+            CHECK(p[1] == CMD_STATUS_OK);
+            int stage = p[2];
+            CHECK(stage == (int)Ipacket);
+            unsigned long count = 0, total_us = 0;
+            for (int i=0; i < 4; i++) count |= (unsigned long)p[3+i] << (8*i);
+            for (int i=0; i < 4; i++) total_us |= (unsigned long)p[7+i] << (8*i);
+            unsigned int min_us = (p[11] << 8) | p[12];
+            unsigned int max_us = (p[13] << 8) | p[14];
+            double mean_us = (double)total_us / count;
+            printf("%s, stage %d: n = %lu, min = %u, mean = %.1f, max = %u usec\n", cobs ? "COBS" : "packed", stage, count, min_us, mean_us, max_us);
+
+            //the stages keep counting until the last one has gone out
+            CHECK(count == (unsigned long)(REPORT_AT_SAMPLE + Ipacket));
+            CHECK_NEAR(min_us, expected_us[stage], 8.0);   //give or take the cost of the micros() calls
+            CHECK_NEAR(max_us, expected_us[stage], 8.0);
+            CHECK_NEAR(mean_us, expected_us[stage], 8.0);
+            unsigned long histTotal = 0;
+            for (int Ibin=0; Ibin < ADS_PROFILE_N_BINS; Ibin++) {
+                unsigned int n = (p[15+2*Ibin] << 8) | p[15+2*Ibin+1];
+                histTotal += n;
+                if (Ibin == binOf(expected_us[stage])) CHECK(n == count);
+            }
+            CHECK(histTotal == count);
+        }
+
+        //the report started the timing over
+        CHECK(stageProfile.count[STAGE_READ] == (unsigned long)(nSamples - REPORT_AT_SAMPLE - N_STAGES + 1));
+    }
+
+    //stopped, it's text
+    Serial.clearSent();
+    stageProfile.printStage(F("filter"), STAGE_FILTER, 4000.0);
+    std::string text((const char *)Serial.sent(), Serial.sentBytes());
+    printf("%s", text.c_str());
+    CHECK(text.find("filter: n = ") == 0);
+    CHECK(text.find("max = 70") != std::string::npos);
+    CHECK(text.find("usec>= 512:") != std::string::npos);
+
+    return hostTestResult("test_profile_report");
+}
@@ -0,0 +1,99 @@
+//
+//  test_register_traffic.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  How much SPI traffic it takes to turn on all 8 channels, counted by the simulated chip
+//  (ADS1299Sim::registerWrites and spiBytes), three ways that end with the same registers:
+//     per register:  each register that changes is sent by itself with writeRegister(), the
+//                    way that every change went out before the shadow registers and the
+//                    transactions
+//     per channel:   activateChannel() for each channel.  Each call is its own transaction,
+//                    so it's one WREGS per channel.
+//     one commit:    the same 8 calls inside beginConfig()/commit(), which is one WREGS
+//  With the ADS stopped, a WREGS is 2 opcode bytes plus the registers, so the counts are
+//  exact, and they leave no room for a register being read back (the shadow copy answers
+//  instead).  The batched path has to be the smallest, in WREGs and in bytes.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+#include <ADS1299Manager.h>
+
+static ADS1299Manager ADS;
+
+#define N_CHAN (8)
+
+static void freshChip(void)
+{
+    ADS1299Sim &chip = ADS1299Sim::chip();
+    hostReset();
+    chip.powerUp(1);
+    ADS.initialize(OPENBCI_V2, false);
+    chip.resetCounters();
+}
+
+static void activateAll(void)
+{
+    for (int chan=1; chan <= N_CHAN; chan++) ADS.activateChannel(chan, ADS_GAIN24, ADSINPUT_NORMAL);
+}
+
+int main(void)
+{
+    ADS1299Sim &chip = ADS1299Sim::chip();
+    byte before[CONFIG4+1], target[CONFIG4+1];
+    unsigned long writes[3], bytes[3];
+
+    //one commit, which also tells us where the registers should end up
+    freshChip();
+    for (int reg=0; reg <= CONFIG4; reg++) before[reg] = chip.getRegister(reg);
+    ADS.beginConfig();
+    activateAll();
+    CHECK(chip.registerWrites == 0);   //nothing goes out until the commit
+    ADS.commit();
+    writes[2] = chip.registerWrites; bytes[2] = chip.spiBytes;
+    for (int reg=0; reg <= CONFIG4; reg++) target[reg] = chip.getRegister(reg);
+    int first = -1, last = -1, nChanged = 0;
+    for (int reg=0; reg <= CONFIG4; reg++) {
+        if (target[reg] == before[reg]) continue;
+        if (first < 0) first = reg;
+        last = reg;
+        nChanged++;
+    }
+    CHECK(nChanged > 0);
+
+    //per channel
+    freshChip();
+    activateAll();
+    writes[1] = chip.registerWrites; bytes[1] = chip.spiBytes;
+    for (int reg=0; reg <= CONFIG4; reg++) CHECK(chip.getRegister(reg) == target[reg]);
+
+    //per register
+    freshChip();
+    for (int reg=0; reg <= CONFIG4; reg++) {
+        if (target[reg] != before[reg]) ADS.writeRegister(reg, target[reg]);
+    }
+    writes[0] = chip.registerWrites; bytes[0] = chip.spiBytes;
+    for (int reg=0; reg <= CONFIG4; reg++) CHECK(chip.getRegister(reg) == target[reg]);
+
+    const char *names[3] = { "per register", "per channel", "one commit" };
+    printf("%d registers change, 0x%02X to 0x%02X\n", nChanged, first, last);
+    for (int i=0; i < 3; i++) printf("%-14s %3lu WREG %4lu SPI bytes\n", names[i], writes[i], bytes[i]);
+
+    //per register: one WREG (2 opcode bytes and the value) for each register that changed
+    CHECK(writes[0] == (unsigned long)nChanged);
+    CHECK(bytes[0] == 3UL * nChanged);
+    //per channel: one WREGS per channel
+    CHECK(writes[1] == N_CHAN);
+    //one commit: a single WREGS across the whole range that changed
+    CHECK(writes[2] == 1);
+    CHECK(bytes[2] == 2UL + (last - first + 1));
+
+    //and that's the least traffic of the three
+    CHECK(writes[2] < writes[1]);
+    CHECK(writes[2] < writes[0]);
+    CHECK(bytes[2] < bytes[1]);
+    CHECK(bytes[2] < bytes[0]);
+
+    return hostTestResult("test_register_traffic");
+}
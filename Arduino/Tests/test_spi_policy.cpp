@@ -0,0 +1,180 @@
+//
+//  test_spi_policy.cpp
+//  Part of the host build of the OpenBCI Arduino libraries (see README.txt)
+//
+//  The SPI policies for the boards that the host can't be (see ADS1299_SPI.h), built
+//  against stand-ins for what they touch.  CMakeLists.txt builds it once for each:
+//     DUE:    ADS1299_SPI_DUE, whose PIO registers drive a simulated SPI device in
+//             mode 1 (it changes MISO on the rising edge of SCK and samples MOSI on the
+//             falling edge).  Every byte has to go out and come back in, MSB first, in
+//             8 clocks that leave SCK low.  begin(FREQ) has to set the clock divider so
+//             that SCK is no faster than FREQ, but no slower than it needs to be.
+//     PIC32:  ADS1299_SPI_DSPI, on host/DSPI.h.  begin(FREQ) has to set mode 1 and FREQ.
+//  and, for both, that a Lock turns the interrupts off and puts them back as they were,
+//  nested or not, and whether DRDY gets an interrupt.
+//
+//  Created by Chip Audette, June 2014
+//
+
+#include "HostTest.h"
+
+#if defined(ADS_TEST_BOARD_DUE)
+
+#define __SAM3X8E__
+#define F_CPU (84000000L)
+
+//the interrupt mask
+static uint32_t primask = 0;   //0 is "interrupts on"
+static uint32_t __get_PRIMASK(void) { return primask; }
+static void __set_PRIMASK(uint32_t mask) { primask = mask; }
+static void __disable_irq(void) { primask = 1; }
+
+//PIO B and D, as far as the policy uses them: SCK is PB27, MOSI is PD7, MISO is PD8
+#define SCK_BIT (0x08000000UL)
+#define MOSI_BIT (0x80UL)
+#define MISO_BIT (0x100UL)
+static uint32_t pioB = 0, pioD = 0;
+
+//the device on the other end
+static byte deviceOut = 0, deviceIn = 0;
+static int deviceBit = 0, nClocks = 0;
+static void sckEdge(boolean rising)
+{
+    if (rising) {
+        if (deviceOut & (0x80 >> deviceBit)) pioD |= MISO_BIT; else pioD &= ~MISO_BIT;
+        nClocks++;
+    } else {
+        deviceIn = (deviceIn << 1) | ((pioD & MOSI_BIT) ? 1 : 0);
+        deviceBit = (deviceBit + 1) % 8;
+    }
+}
+
+//a set or clear register: writing a 1 sets or clears that pin
+class SamWriteReg {
+public:
+    SamWriteReg(uint32_t &_pins, boolean _set) : pins(_pins), set(_set) {}
+    void operator=(uint32_t mask) {
+        uint32_t old = pins;
+        pins = set ? (pins | mask) : (pins & ~mask);
+        if ((&pins == &pioB) && ((old ^ pins) & SCK_BIT)) sckEdge((pins & SCK_BIT) != 0);
+    }
+private:
+    uint32_t &pins;
+    boolean set;
+};
+#define REG_PIOB_SODR (SamWriteReg(pioB, true))
+#define REG_PIOB_CODR (SamWriteReg(pioB, false))
+#define REG_PIOD_SODR (SamWriteReg(pioD, true))
+#define REG_PIOD_CODR (SamWriteReg(pioD, false))
+#define REG_PIOD_PDSR (pioD)
+
+#elif defined(ADS_TEST_BOARD_PIC32)
+
+#define __PIC32MX__
+
+#endif
+
+#include <ADS1299_SPI.h>
+
+typedef ADS1299_SPI_Board SPI;
+
+static void dummyISR(void) {}
+
+int main(void)
+{
+    hostReset();
+
+#if defined(ADS_TEST_BOARD_DUE)
+    const char *name = "test_spi_policy (DUE)";
+    SPI::begin(4);
+    CHECK((pioB & SCK_BIT) == 0);
+
+    //every byte both ways, against a device that sends something else
+    int nWrongOut = 0, nWrongIn = 0;
+    for (int i=0; i < 256; i++) {
+        deviceOut = (byte)(i * 37 + 11);
+        nClocks = 0;
+        byte in = SPI::transfer((byte)i);
+        if (deviceIn != (byte)i) nWrongOut++;
+        if (in != deviceOut) nWrongIn++;
+        CHECK(nClocks == 8);
+        CHECK((pioB & SCK_BIT) == 0);
+    }
+    CHECK(nWrongOut == 0);
+    CHECK(nWrongIn == 0);
+    byte buf[4];
+    deviceOut = 0xC3;
+    SPI::readBlock(buf, 4);
+    CHECK((buf[0] == 0xC3) && (buf[3] == 0xC3));
+    CHECK(deviceIn == 0x00);
+
+    //the clock divider.  Each half of the SCK period has to last at least F_CPU/(2*FREQ),
+    //and no more than one spin of the wait loop longer than that.
+    uint32_t lastDivider = 0xFFFFFFFFUL;
+    for (int FREQ=1; FREQ <= 20; FREQ++) {
+        SPI::begin(FREQ);
+        uint32_t divider = SPI::clockDivider();
+        double halfBit = ADS_DUE_HALF_BIT_CYCLES + (double)divider * ADS_DUE_SPIN_CYCLES;
+        double wanted = (double)F_CPU / (2.0e6 * FREQ);
+        printf("FREQ = %2d MHz: clock divider %3lu, SCK = %5.2f MHz\n", FREQ, (unsigned long)divider, F_CPU / (2.0e6 * halfBit));
+        CHECK(halfBit >= wanted);
+        if (divider > 0) CHECK(halfBit < wanted + ADS_DUE_SPIN_CYCLES);
+        CHECK(divider <= lastDivider);
+        lastDivider = divider;
+    }
+    CHECK(lastDivider == 0);   //20 MHz is as fast as it goes
+
+    //the lock
+    CHECK(primask == 0);
+    {
+        SPI::Lock lock;
+        CHECK(primask != 0);
+        {
+            SPI::Lock inner;
+            CHECK(primask != 0);
+        }
+        CHECK(primask != 0);   //still off, until the outer one is done
+    }
+    CHECK(primask == 0);
+    CHECK(SPI::attachDRDY(dummyISR));
+
+#elif defined(ADS_TEST_BOARD_PIC32)
+    const char *name = "test_spi_policy (PIC32)";
+    SPI::begin(4);
+    DSPI0 &port = SPI::port();
+    CHECK(port.csPin == ADS_PIN_CS);
+    CHECK(port.mode == DSPI_MODE1);
+    CHECK(port.speed == 4000000UL);
+    CHECK(port.csLevel == HIGH);
+    SPI::begin(1);
+    CHECK(port.speed == 1000000UL);
+
+    SPI::select();
+    CHECK(port.csLevel == LOW);
+    CHECK(SPI::transfer(0x5A) == 0xA5);
+    CHECK(port.lastByte == 0x5A);
+    byte buf[4];
+    SPI::readBlock(buf, 4);
+    CHECK((buf[0] == 0xFF) && (buf[3] == 0xFF));
+    CHECK(port.lastByte == 0x00);
+    CHECK(port.nBytes == 5);
+    SPI::deselect();
+    CHECK(port.csLevel == HIGH);
+
+    //the lock
+    CHECK(hostPic32Status & 1);
+    {
+        SPI::Lock lock;
+        CHECK((hostPic32Status & 1) == 0);
+        {
+            SPI::Lock inner;
+            CHECK((hostPic32Status & 1) == 0);
+        }
+        CHECK((hostPic32Status & 1) == 0);
+    }
+    CHECK(hostPic32Status & 1);
+    CHECK(!SPI::attachDRDY(dummyISR));   //so the Manager polls
+#endif
+
+    return hostTestResult(name);
+}
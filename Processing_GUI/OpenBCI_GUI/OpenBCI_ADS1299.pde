@@ -25,6 +25,27 @@ final String command_startText = "x";
 final String command_startBinary = "b";
 final String command_startBinary_wAux = "n";
 final String command_startBinary_4chan = "v";
+final String command_startBinary_packed = "c";
+final String command_startBinary_delta = "d";
+final String command_startBinary_batch = "m";
+final String command_startBinary_cobs = "k";
+final String command_startBandPower = "j";
+final String command_startImpedance = "z";
+final String command_toggleImpedanceWithData = "l";
+final String command_toggleLeadOffScan = ".";
+
+//binary commands (see serialEvent in StreamRawData.ino)
+final byte CMD_FRAME_START = (byte)0xF0;
+final byte CMD_CONFIGURE_CHANNELS = 0x01;
+final byte CMD_SET_FILTER_PRESET = 0x02;
+final byte CMD_STATUS_OK = 0;
+final int CMD_PROFILE_REPORT = 0x82;  //not a command: a stage of the Arduino's timing report ('P')
+final int PROFILE_N_BINS = 12;        //ADS_PROFILE_N_BINS
+final byte ADS_CHANCFG_ACTIVE = 0x01;
+final byte ADS_CHANCFG_LOFF_P = 0x02;
+final byte ADS_CHANCFG_LOFF_N = 0x04;
+final byte ADS_GAIN24 = 0x60;
+final byte ADSINPUT_NORMAL = 0x00;
 final String command_activateFilters = "F";
 final String command_deactivateFilters = "g";
 final String[] command_deactivate_channel = {"1", "2", "3", "4", "5", "6", "7", "8"};
@@ -41,6 +62,12 @@ class OpenBCI_ADS1299 {
   //final static int DATAMODE_TXT = 0;
   final static int DATAMODE_BIN = 1;
   final static int DATAMODE_BIN_WAUX = 2;
+  final static int DATAMODE_BIN_PACKED = 3;  //3 bytes per sample instead of 4
+  final static int DATAMODE_BIN_DELTA = 5;  //packed keyframes, then the change from sample to sample
+  final static int DATAMODE_BIN_BATCH = 6;  //several packed samples in each packet
+  final static int DATAMODE_BIN_COBS = 7;   //packed samples plus CRC, framed with COBS
+  final static int DATAMODE_BANDPOWER = 8;  //no samples, just the band power of each channel a few times a second
+  final static int DATAMODE_IMPEDANCE = 9;  //no samples, just the electrode impedance of each channel (needs AC lead-off)
   //final static int DATAMODE_BIN_4CHAN = 4;
   
   final static int STATE_NOCOM = 0;
@@ -53,9 +80,19 @@ class OpenBCI_ADS1299 {
   int known_packet_length_bytes = 0;
   
   final static byte BYTE_START = (byte)0xA0;
+  final static byte BYTE_START_PACKED = (byte)0xA1;
+  final static byte BYTE_START_DELTA = (byte)0xA2;
+  final static byte BYTE_START_BATCH = (byte)0xA3;
+  final static byte BYTE_START_STATUS = (byte)0xA4;  //reply to a binary command
+  final static byte BYTE_START_MARKER = (byte)0xA5;  //the Arduino changed its settings just before this sample
+  final static byte BYTE_START_BANDPOWER = (byte)0xA6;  //band power of each channel, once per block of samples
+  final static byte BYTE_START_IMPEDANCE = (byte)0xA7;  //electrode impedance of each channel, once per block of samples
+  final static byte BYTE_START_LEADOFF_SCAN = (byte)0xA8;  //the Arduino's impedance scan moved to another channel before this sample
+  final static int IMPEDANCE_OVER_RANGE = 0xFFFE;  //6.55 MOhm or more
+  final static int IMPEDANCE_NOT_MEASURED = 0xFFFF;  //no lead-off current on that channel
   final static byte BYTE_END = (byte)0xC0;
   
-  int prefered_datamode = DATAMODE_BIN;
+  int prefered_datamode = DATAMODE_BIN_PACKED;
 
   
   Serial serial_openBCI = null;
@@ -84,9 +121,9 @@ class OpenBCI_ADS1299 {
     
     //choose data mode
     //println("OpenBCI_ADS1299: prefered_datamode = " + prefered_datamode + ", nValuesPerPacket%8 = " + (nValuesPerPacket % 8));
-    if (prefered_datamode == DATAMODE_BIN) {
+    if ((prefered_datamode == DATAMODE_BIN) || (prefered_datamode == DATAMODE_BIN_PACKED)) {
       if ((nValuesPerPacket % 8) != 0) {
-        //must be requesting the aux data, so change the referred data mode
+        //must be requesting the aux data, so change the referred data mode (the packed mode has no aux)
         prefered_datamode = DATAMODE_BIN_WAUX;
         println("OpenBCI_ADS1299: nValuesPerPacket = " + nValuesPerPacket + " so setting prefered_datamode to " + prefered_datamode);
       }
@@ -160,6 +197,30 @@ class OpenBCI_ADS1299 {
         serial_openBCI.write(command_startBinary_wAux + "\n");
         println("OpenBCI_ADS1299: startDataTransfer: starting binary transfer (with Aux)");
         break;
+      case DATAMODE_BIN_PACKED:
+        serial_openBCI.write(command_startBinary_packed + "\n");
+        println("OpenBCI_ADS1299: startDataTransfer: starting packed binary transfer");
+        break;
+      case DATAMODE_BIN_DELTA:
+        serial_openBCI.write(command_startBinary_delta + "\n");
+        println("OpenBCI_ADS1299: startDataTransfer: starting delta-compressed binary transfer");
+        break;
+      case DATAMODE_BIN_BATCH:
+        serial_openBCI.write(command_startBinary_batch + "\n");
+        println("OpenBCI_ADS1299: startDataTransfer: starting batched binary transfer");
+        break;
+      case DATAMODE_BIN_COBS:
+        serial_openBCI.write(command_startBinary_cobs + "\n");
+        println("OpenBCI_ADS1299: startDataTransfer: starting COBS-framed binary transfer");
+        break;
+      case DATAMODE_BANDPOWER:
+        serial_openBCI.write(command_startBandPower + "\n");
+        println("OpenBCI_ADS1299: startDataTransfer: starting band power transfer");
+        break;
+      case DATAMODE_IMPEDANCE:
+        serial_openBCI.write(command_startImpedance + "\n");
+        println("OpenBCI_ADS1299: startDataTransfer: starting impedance transfer");
+        break;
     }
     return 0;
   }
@@ -188,7 +249,11 @@ class OpenBCI_ADS1299 {
       }
     }
     
-    interpretBinaryStream(inByte);  //new 2014-02-02 WEA
+    if (dataMode == DATAMODE_BIN_COBS) {
+      interpretCOBSStream(inByte);
+    } else {
+      interpretBinaryStream(inByte);  //new 2014-02-02 WEA
+    }
     return int(inByte);
   }
 
@@ -206,8 +271,87 @@ class OpenBCI_ADS1299 {
   Channel N data  : 4 bytes
   [Optional] Aux Value : 4 bytes
   End Indcator:    0xC0
+  
+  The packed format is the same, except that it starts with 0xA1, the length
+  is 4 bytes framenumber + 3 bytes per channel, there is no Aux value, and each
+  channel is a 24-bit two's complement value sent most significant byte first.
+  
+  The delta format starts with 0xA2.  The length is just the number of payload
+  bytes.  The payload is the low byte of the framenumber followed by each
+  channel's change since the previous packet, zigzag-encoded as a varint (7 bits
+  per byte, low bits first, high bit set on all but the last byte).  The changes
+  only mean something relative to the last packed (0xA1) packet and the delta
+  packets after it, so after any error we wait for the next packed packet.
+  
+  A discontinuity marker starts with 0xA5, then the payload length (6), the
+  4-byte framenumber of the first sample after the Arduino changed its settings,
+  1 byte for the number of samples lost, and a bit for each channel changed.
+  
+  A status packet starts with 0xA4, then the payload length, and then a payload
+  of the command it answers, the status code, and a bit for each active channel.
+  While a binary format is streaming, the channel on/off and lead-off keys are
+  answered this way too, with 0x80 or 0x81 as the command.  So is the timing
+  report ('P'), one packet per stage, with 0x82 as the command, then the status
+  code, the stage, the count (4 bytes, little endian), the total usec (4 bytes,
+  little endian), the min and max usec (2 bytes each, big endian), and the
+  histogram (2 bytes per bin, big endian).
+  
+  The batch format starts with 0xA3, then 1 byte for the number of channels N,
+  1 byte for the number of samples K, the 4-byte framenumber of the first
+  sample, and then K samples of N packed (3-byte) channels each.  The parser
+  splits it back into K separate data packets.
+  
+  A band power packet starts with 0xA6, then the payload length, and then a
+  payload of the 4-byte framenumber of the last sample in the block, the block
+  length (2 bytes, big endian), 1 byte for the number of channels N, 1 byte for
+  the number of bands, and then each channel's bands (2 bytes each, big endian)
+  in hundredths of a dB re 1 count^2.  It carries no samples.
+  
+  An impedance packet starts with 0xA7, then the payload length, and then a
+  payload of the 4-byte framenumber of the last sample in the block, the block
+  length (2 bytes, big endian), 1 byte for the number of channels N, and then
+  each channel's electrode impedance (2 bytes, big endian) in steps of 100 ohms,
+  or IMPEDANCE_OVER_RANGE, or IMPEDANCE_NOT_MEASURED.  These can come mixed in
+  with the data packets ('l' on the Arduino) or by themselves ('z').  The
+  impedance scan ('.') sends them too, once per channel that it finishes.
+  
+  A lead-off scan packet starts with 0xA8, then the payload length (6), the
+  4-byte framenumber of the first sample with the lead-off current on the new
+  channel, 1 byte for that channel (1-8, and 9-16 too with a daisy chain), and
+  1 byte for the side (1 = P, 2 = N).  That channel has the lead-off tone in its
+  data from then until the next lead-off scan packet.
   ********************************************************************* */
   int nDataValuesInPacket = 0;
+  int nBytesPerValue = 4;
+  boolean isDeltaPacket = false;
+  boolean isBatchPacket = false;
+  boolean isStatusPacket = false;
+  boolean isMarkerPacket = false;
+  boolean isBandPowerPacket = false;
+  boolean isNewBandPowerAvailable = false;
+  int bandPowerSampleIndex = -1;   //the last sample of the block that the band powers came from
+  int bandPowerBlockLen = 0;       //samples in that block
+  float[][] bandPower_dB = new float[0][0];  //[channel][band], dB re 1 count^2
+  boolean isImpedancePacket = false;
+  int impedanceUpdate_millis = -1;  //when the last impedance packet came in
+  float[] impedance_ohm = new float[0];  //[channel], from the Arduino's lock-in.  -1 where it isn't measured.
+  boolean isLeadOffScanPacket = false;
+  int leadOffScanChannel = 0;      //1-8, the channel the Arduino's impedance scan is on (0 if it isn't scanning)
+  int leadOffScanSampleIndex = -1; //the first sample with the lead-off current on that channel
+  int leadOffScanUpdate_millis = -1;
+  int discontinuityCounter = 0;    //how many discontinuity markers have arrived
+  int lastDiscontinuitySampleIndex = -1;
+  int lastCommandStatus = -1;      //from the most recent status packet
+  int lastActiveChannelMask = 0;   //from the most recent status packet
+  int nSamplesInBatch = 0;
+  byte[] batchPayload = new byte[0];
+  DataPacket_ADS1299[] batchPackets = new DataPacket_ADS1299[0];  //the unpacked samples, waiting to be copied out
+  int nBatchPacketsAvailable = 0;
+  int batchPacketReadInd = 0;
+  int deltaPayloadLength = 0;
+  byte[] deltaPayload = new byte[255];
+  int[] deltaRefValues = new int[0];  //the values from the previous packed or delta packet
+  boolean haveDeltaRef = false;
   int localByteCounter=0;
   int localChannelCounter=0;
   int PACKET_readstate = 0;
@@ -218,14 +362,52 @@ class OpenBCI_ADS1299 {
     switch (PACKET_readstate) {
       case 0:  
          //look for header byte  
-         if (actbyte == byte(0xA0)) {          // look for start indicator
+         if (actbyte == BYTE_START) {          // look for start indicator
           //println("OpenBCI_ADS1299: interpretBinaryStream: found 0xA0");
+          nBytesPerValue = 4; isDeltaPacket = false; isBatchPacket = false; isStatusPacket = false; isMarkerPacket = false; isBandPowerPacket = false; isImpedancePacket = false; isLeadOffScanPacket = false;
           PACKET_readstate++;
-         } 
+         } else if (actbyte == BYTE_START_PACKED) {
+          nBytesPerValue = 3; isDeltaPacket = false; isBatchPacket = false; isStatusPacket = false; isMarkerPacket = false; isBandPowerPacket = false; isImpedancePacket = false; isLeadOffScanPacket = false;
+          PACKET_readstate++;
+         } else if (actbyte == BYTE_START_DELTA) {
+          isDeltaPacket = true; isBatchPacket = false; isStatusPacket = false; isMarkerPacket = false; isBandPowerPacket = false; isImpedancePacket = false; isLeadOffScanPacket = false;
+          PACKET_readstate++;
+         } else if (actbyte == BYTE_START_BATCH) {
+          nBytesPerValue = 3; isDeltaPacket = false; isBatchPacket = true; isStatusPacket = false; isMarkerPacket = false; isBandPowerPacket = false; isImpedancePacket = false; isLeadOffScanPacket = false;
+          PACKET_readstate++;
+         } else if (actbyte == BYTE_START_STATUS) {
+          isDeltaPacket = false; isBatchPacket = false; isStatusPacket = true; isMarkerPacket = false; isBandPowerPacket = false; isImpedancePacket = false; isLeadOffScanPacket = false;
+          PACKET_readstate++;
+         } else if (actbyte == BYTE_START_MARKER) {
+          isDeltaPacket = false; isBatchPacket = false; isStatusPacket = false; isMarkerPacket = true; isBandPowerPacket = false; isImpedancePacket = false; isLeadOffScanPacket = false;
+          PACKET_readstate++;
+         } else if (actbyte == BYTE_START_BANDPOWER) {
+          isDeltaPacket = false; isBatchPacket = false; isStatusPacket = false; isMarkerPacket = false; isBandPowerPacket = true; isImpedancePacket = false; isLeadOffScanPacket = false;
+          PACKET_readstate++;
+         } else if (actbyte == BYTE_START_IMPEDANCE) {
+          isDeltaPacket = false; isBatchPacket = false; isStatusPacket = false; isMarkerPacket = false; isBandPowerPacket = false; isImpedancePacket = true; isLeadOffScanPacket = false;
+          PACKET_readstate++;
+         } else if (actbyte == BYTE_START_LEADOFF_SCAN) {
+          isDeltaPacket = false; isBatchPacket = false; isStatusPacket = false; isMarkerPacket = false; isBandPowerPacket = false; isImpedancePacket = false; isLeadOffScanPacket = true;
+          PACKET_readstate++;
+         }
          break;
       case 1:
          //look for byte that gives length of the payload  
-         nDataValuesInPacket = ((int)actbyte) / 4 - 1;   // get number of channels
+         if (isDeltaPacket || isStatusPacket || isMarkerPacket || isBandPowerPacket || isImpedancePacket || isLeadOffScanPacket) {
+           deltaPayloadLength = (0xFF & actbyte);
+           localByteCounter = 0;
+           PACKET_readstate = (deltaPayloadLength > 0) ? 5 : 0;  //go collect the payload
+           break;
+         }
+         if (isBatchPacket) {
+           nDataValuesInPacket = (0xFF & actbyte);  // the batch format gives the number of channels directly
+         } else if (nBytesPerValue == 3) {
+           nDataValuesInPacket = ((0xFF & actbyte) - 4) / 3;   // get number of channels
+           if ((((0xFF & actbyte) - 4) % 3) != 0) nDataValuesInPacket = -1;  //not a whole number of samples
+         } else {
+           nDataValuesInPacket = ((int)actbyte) / 4 - 1;   // get number of channels
+         }
          //println("OpenBCI_ADS1299: interpretBinaryStream: nDataValuesInPacket = " + nDataValuesInPacket);
          //if (nDataValuesInPacket != num_channels) { //old check, too restrictive
          if ((nDataValuesInPacket < 0) || (nDataValuesInPacket > dataPacket.values.length)) {
@@ -234,7 +416,7 @@ class OpenBCI_ADS1299 {
           PACKET_readstate=0;
          } else { 
           localByteCounter=0; //prepare for next usage of localByteCounter
-          PACKET_readstate++;
+          PACKET_readstate = isBatchPacket ? 6 : 2;  //batches give the number of samples next
          }
          break;
       case 2: 
@@ -250,15 +432,19 @@ class OpenBCI_ADS1299 {
           prevSampleIndex = dataPacket.sampleIndex;
           localByteCounter=0;//prepare for next usage of localByteCounter
           localChannelCounter=0; //prepare for next usage of localChannelCounter
-          PACKET_readstate++;
+          PACKET_readstate = isBatchPacket ? 7 : 3;  //batches are collected all at once
         } 
         break;
       case 3: 
         // get channel values 
         localByteBuffer[localByteCounter] = actbyte;
         localByteCounter++;
-        if (localByteCounter==4) {
-          dataPacket.values[localChannelCounter] = interpretAsInt32(localByteBuffer);
+        if (localByteCounter==nBytesPerValue) {
+          if (nBytesPerValue == 3) {
+            dataPacket.values[localChannelCounter] = interpretAsInt24(localByteBuffer);
+          } else {
+            dataPacket.values[localChannelCounter] = interpretAsInt32(localByteBuffer);
+          }
           localChannelCounter++;
           if (localChannelCounter==nDataValuesInPacket) {  
             // all channels arrived !
@@ -275,19 +461,372 @@ class OpenBCI_ADS1299 {
         //look for end byte
         if (actbyte == byte(0xC0)) {    // if correct end delimiter found:
           //println("OpenBCI_ADS1299: interpretBinaryStream: found end byte. Setting isNewDataPacketAvailable to TRUE");
-          isNewDataPacketAvailable = true; //original place for this.  but why not put it in the previous case block
+          if (isStatusPacket) {
+            interpretStatusPayload();
+          } else if (isMarkerPacket) {
+            interpretMarkerPayload();
+          } else if (isBandPowerPacket) {
+            isNewBandPowerAvailable = interpretBandPowerPayload();
+          } else if (isImpedancePacket) {
+            interpretImpedancePayload();
+          } else if (isLeadOffScanPacket) {
+            interpretLeadOffScanPayload();
+          } else if (isDeltaPacket) {
+            isNewDataPacketAvailable = interpretDeltaPayload();
+          } else if (isBatchPacket) {
+            isNewDataPacketAvailable = interpretBatchPayload();
+          } else {
+            isNewDataPacketAvailable = true; //original place for this.  but why not put it in the previous case block
+            if (nBytesPerValue == 3) {
+              //a packed packet is also a keyframe for the delta format
+              deltaRefValues = new int[nDataValuesInPacket];
+              for (int Ichan=0; Ichan < nDataValuesInPacket; Ichan++) deltaRefValues[Ichan] = dataPacket.values[Ichan];
+              haveDeltaRef = true;
+            }
+          }
         } else {
+          haveDeltaRef = false;
           serialErrorCounter++;
           println("OpenBCI_ADS1299: interpretBinaryStream: expecteding end-of-packet byte is missing.  Discarding packet. (" + serialErrorCounter + ")");
         }
         PACKET_readstate=0;  // either way, look for next packet
         break;
+      case 5:
+        //collect the payload of a delta (or status) packet
+        deltaPayload[localByteCounter] = actbyte;
+        localByteCounter++;
+        if (localByteCounter == deltaPayloadLength) PACKET_readstate = 4;  //look for end byte
+        break;
+      case 6:
+        //get the number of samples in a batch packet
+        nSamplesInBatch = (0xFF & actbyte);
+        if (nSamplesInBatch == 0) {
+          PACKET_readstate = 0;  //nothing to read
+        } else {
+          if (batchPayload.length < 3*nDataValuesInPacket*nSamplesInBatch) batchPayload = new byte[3*nDataValuesInPacket*nSamplesInBatch];
+          PACKET_readstate = 2;  //get the sample number
+        }
+        break;
+      case 7:
+        //collect the samples of a batch packet
+        batchPayload[localByteCounter] = actbyte;
+        localByteCounter++;
+        if (localByteCounter == 3*nDataValuesInPacket*nSamplesInBatch) PACKET_readstate = 4;  //look for end byte
+        break;
       default: 
           //println("OpenBCI_ADS1299: Unknown byte: " + actbyte + " .  Continuing...");
           println("OpenBCI_ADS1299: interpretBinaryStream: Unknown byte.  Continuing...");
           PACKET_readstate=0;  // look for next packet
     }
   } // end of interpretBinaryStream
+  
+  /* COBS-framed packets (see writeChannelDataAsCOBS in ADS1299Manager.cpp)
+  
+  Every packet ends with a 0x00 byte, and there are no other zeros in the
+  stream, so after any error we're back in sync at the very next packet.
+  Once the Consistent Overhead Byte Stuffing is undone, the packet is:
+  
+  Start byte     : 1 byte (BYTE_START_PACKED for the data)
+  Framenumber    : 4 bytes (little endian)
+  Channel 1 data : 3 bytes (big endian)
+  ...
+  Channel N data : 3 bytes
+  CRC            : 2 bytes (CRC-16/CCITT of everything above, high byte first)
+  
+  The status, marker, impedance, and lead-off scan packets come the same way:
+  their start byte, then the same payload as in the other framing, then the CRC.
+  ********************************************************************* */
+  byte[] cobsBuffer = new byte[256];
+  byte[] cobsDecoded = new byte[256];
+  int cobsByteCounter = 0;
+  void interpretCOBSStream(byte actbyte)
+  {
+    if (actbyte != 0) {
+      //still inside the packet
+      if (cobsByteCounter < cobsBuffer.length) cobsBuffer[cobsByteCounter] = actbyte;
+      cobsByteCounter++;
+      return;
+    }
+    
+    //that was the end of the packet
+    int nBytes = cobsByteCounter;
+    cobsByteCounter = 0;  //prepare for the next one
+    if (nBytes == 0) return;  //nothing there
+    if (nBytes > cobsBuffer.length) {
+      serialErrorCounter++;
+      println("OpenBCI_ADS1299: interpretCOBSStream: packet is too long.  Discarding packet. (" + serialErrorCounter + ")");
+      return;
+    }
+    
+    //undo the byte stuffing
+    int nDecoded = 0;
+    int Ibyte = 0;
+    while (Ibyte < nBytes) {
+      int code = 0xFF & cobsBuffer[Ibyte];
+      if (Ibyte + code > nBytes) {
+        serialErrorCounter++;
+        println("OpenBCI_ADS1299: interpretCOBSStream: bad COBS code.  Discarding packet. (" + serialErrorCounter + ")");
+        return;
+      }
+      for (int j=1; j < code; j++) cobsDecoded[nDecoded++] = cobsBuffer[Ibyte+j];
+      Ibyte += code;
+      if ((code < 0xFF) && (Ibyte < nBytes)) cobsDecoded[nDecoded++] = 0;  //this is where a zero was
+    }
+    
+    //check the CRC
+    if (nDecoded < 3) {
+      serialErrorCounter++;
+      println("OpenBCI_ADS1299: interpretCOBSStream: packet is too short.  Discarding packet. (" + serialErrorCounter + ")");
+      return;
+    }
+    int crc = 0xFFFF;
+    for (int i=0; i < nDecoded-2; i++) crc = crc16_update(crc,cobsDecoded[i]);
+    if (crc != (((0xFF & cobsDecoded[nDecoded-2]) << 8) | (0xFF & cobsDecoded[nDecoded-1]))) {
+      serialErrorCounter++;
+      println("OpenBCI_ADS1299: interpretCOBSStream: CRC does not match.  Discarding packet. (" + serialErrorCounter + ")");
+      return;
+    }
+    
+    //it's good.  If it isn't data, hand the payload to the same code as the other framing.
+    byte startByte = cobsDecoded[0];
+    if (startByte != BYTE_START_PACKED) {
+      deltaPayloadLength = nDecoded - 1 - 2;
+      for (int i=0; i < deltaPayloadLength; i++) deltaPayload[i] = cobsDecoded[1+i];
+      if (startByte == BYTE_START_STATUS) {
+        interpretStatusPayload();
+      } else if (startByte == BYTE_START_MARKER) {
+        interpretMarkerPayload();
+      } else if (startByte == BYTE_START_IMPEDANCE) {
+        interpretImpedancePayload();
+      } else if (startByte == BYTE_START_LEADOFF_SCAN) {
+        interpretLeadOffScanPayload();
+      }
+      return;
+    }
+    int nValues = (nDecoded - 1 - 4 - 2) / 3;
+    if ((nValues < 0) || ((nDecoded - 1 - 4 - 2) % 3 != 0) || (nValues > dataPacket.values.length)) {
+      serialErrorCounter++;
+      println("OpenBCI_ADS1299: interpretCOBSStream: packet is the wrong size (" + nDecoded + " bytes).  Discarding packet. (" + serialErrorCounter + ")");
+      return;
+    }
+    for (int i=0; i < 4; i++) localByteBuffer[i] = cobsDecoded[1+i];
+    dataPacket.sampleIndex = interpretAsInt32(localByteBuffer);
+    if ((dataPacket.sampleIndex-prevSampleIndex) != 1) {
+      serialErrorCounter++;
+      println("OpenBCI_ADS1299: interpretCOBSStream: apparent sampleIndex jump from Serial data: " + prevSampleIndex + " to  " + dataPacket.sampleIndex + ".  Keeping packet. (" + serialErrorCounter + ")");
+    }
+    prevSampleIndex = dataPacket.sampleIndex;
+    for (int Ichan=0; Ichan < nValues; Ichan++) {
+      for (int i=0; i < 3; i++) localByteBuffer[i] = cobsDecoded[1 + 4 + 3*Ichan + i];
+      dataPacket.values[Ichan] = interpretAsInt24(localByteBuffer);
+    }
+    isNewDataPacketAvailable = true;
+  }
+  
+  //CRC-16/CCITT (polynomial 0x1021), same as on the Arduino
+  int crc16_update(int crc, byte data) {
+    crc ^= (0xFF & data) << 8;
+    for (int i=0; i < 8; i++) {
+      if ((crc & 0x8000) != 0) {
+        crc = ((crc << 1) ^ 0x1021) & 0xFFFF;
+      } else {
+        crc = (crc << 1) & 0xFFFF;
+      }
+    }
+    return crc;
+  }
+  
+  //the reply to a binary command
+  void interpretStatusPayload() {
+    if (deltaPayloadLength < 3) return;
+    lastCommandStatus = 0xFF & deltaPayload[1];
+    if (((0xFF & deltaPayload[0]) == CMD_PROFILE_REPORT) && (lastCommandStatus == CMD_STATUS_OK)) {
+      interpretProfilePayload();
+      return;
+    }
+    //a byte of the mask for each board, channel 1 in bit 0 of the first one
+    int nMaskBytes = min(deltaPayloadLength - 2, 4);
+    lastActiveChannelMask = 0;
+    for (int i=0; i < nMaskBytes; i++) lastActiveChannelMask |= (0xFF & deltaPayload[2+i]) << (8*i);
+    if (lastCommandStatus != CMD_STATUS_OK) {
+      println("OpenBCI_ADS1299: interpretStatusPayload: command " + (0xFF & deltaPayload[0]) + " failed with status " + lastCommandStatus);
+    } else {
+      println("OpenBCI_ADS1299: interpretStatusPayload: command " + (0xFF & deltaPayload[0]) + " OK.  Active channel mask = " + binary(lastActiveChannelMask,8*nMaskBytes));
+    }
+  }
+  
+  //a stage of the Arduino's timing report (see sendStageProfile in StreamRawData.ino)
+  void interpretProfilePayload() {
+    if (deltaPayloadLength < 3 + 12 + 2*PROFILE_N_BINS) return;
+    for (int i=0; i < 4; i++) localByteBuffer[i] = deltaPayload[3+i];
+    long count = 0xFFFFFFFFL & interpretAsInt32(localByteBuffer);
+    for (int i=0; i < 4; i++) localByteBuffer[i] = deltaPayload[7+i];
+    long total_us = 0xFFFFFFFFL & interpretAsInt32(localByteBuffer);
+    int min_us = ((0xFF & deltaPayload[11]) << 8) | (0xFF & deltaPayload[12]);
+    int max_us = ((0xFF & deltaPayload[13]) << 8) | (0xFF & deltaPayload[14]);
+    String line = "OpenBCI_ADS1299: stage " + (0xFF & deltaPayload[2]) + ": n = " + count;
+    if (count > 0) line += ", min = " + min_us + ", mean = " + nf((float)total_us / (float)count,0,1) + ", max = " + max_us + " usec";
+    line += ", usec>=";
+    for (int Ibin=0; Ibin < PROFILE_N_BINS; Ibin++) {
+      int n = ((0xFF & deltaPayload[15+2*Ibin]) << 8) | (0xFF & deltaPayload[15+2*Ibin+1]);
+      if (n > 0) line += " " + ((Ibin == 0) ? 0 : (4 << Ibin)) + ":" + n;
+    }
+    println(line);
+  }
+  
+  //the Arduino changed its settings just before this sample
+  void interpretMarkerPayload() {
+    if (deltaPayloadLength < 6) return;
+    for (int i=0; i < 4; i++) localByteBuffer[i] = deltaPayload[i];
+    lastDiscontinuitySampleIndex = interpretAsInt32(localByteBuffer);
+    discontinuityCounter++;
+    println("OpenBCI_ADS1299: interpretMarkerPayload: settings changed before sample " + lastDiscontinuitySampleIndex + ", " + (0xFF & deltaPayload[4]) + " samples lost, channels changed = " + binary(0xFF & deltaPayload[5],8));
+  }
+  
+  //the band power of each channel, from the Arduino's estimator (see ADS1299BandPower.h).
+  //goertzelBandPower() in math.pde does the same math on the PC, for checking it.
+  boolean interpretBandPowerPayload() {
+    if (deltaPayloadLength < 8) return false;
+    int nChan = 0xFF & deltaPayload[6];
+    int nBands = 0xFF & deltaPayload[7];
+    if (deltaPayloadLength != 8 + 2*nChan*nBands) {
+      serialErrorCounter++;
+      println("OpenBCI_ADS1299: interpretBandPowerPayload: packet is the wrong size.  Discarding packet. (" + serialErrorCounter + ")");
+      return false;
+    }
+    for (int i=0; i < 4; i++) localByteBuffer[i] = deltaPayload[i];
+    bandPowerSampleIndex = interpretAsInt32(localByteBuffer);
+    bandPowerBlockLen = ((0xFF & deltaPayload[4]) << 8) | (0xFF & deltaPayload[5]);
+    if ((bandPower_dB.length != nChan) || ((nChan > 0) && (bandPower_dB[0].length != nBands))) bandPower_dB = new float[nChan][nBands];
+    int Ibyte = 8;
+    for (int Ichan=0; Ichan < nChan; Ichan++) {
+      for (int Iband=0; Iband < nBands; Iband++) {
+        bandPower_dB[Ichan][Iband] = 0.01f * (((0xFF & deltaPayload[Ibyte]) << 8) | (0xFF & deltaPayload[Ibyte+1]));
+        Ibyte += 2;
+      }
+    }
+    return true;
+  }
+  
+  //the electrode impedance of each channel, from the Arduino's lock-in (see ADS1299Impedance.h)
+  void interpretImpedancePayload() {
+    if (deltaPayloadLength < 7) return;
+    int nChan = 0xFF & deltaPayload[6];
+    if (deltaPayloadLength != 7 + 2*nChan) {
+      serialErrorCounter++;
+      println("OpenBCI_ADS1299: interpretImpedancePayload: packet is the wrong size.  Discarding packet. (" + serialErrorCounter + ")");
+      return;
+    }
+    if (impedance_ohm.length != nChan) impedance_ohm = new float[nChan];
+    for (int Ichan=0; Ichan < nChan; Ichan++) {
+      int code = ((0xFF & deltaPayload[7+2*Ichan]) << 8) | (0xFF & deltaPayload[7+2*Ichan+1]);
+      if (code == IMPEDANCE_NOT_MEASURED) {
+        impedance_ohm[Ichan] = -1.0f;
+      } else {
+        impedance_ohm[Ichan] = 100.0f * code;  //over range shows up as 6.55 MOhm
+      }
+    }
+    impedanceUpdate_millis = millis();
+  }
+  
+  //the Arduino's impedance scan has moved the lead-off current to another channel
+  void interpretLeadOffScanPayload() {
+    if (deltaPayloadLength < 6) return;
+    for (int i=0; i < 4; i++) localByteBuffer[i] = deltaPayload[i];
+    leadOffScanSampleIndex = interpretAsInt32(localByteBuffer);
+    leadOffScanChannel = 0xFF & deltaPayload[4];
+    leadOffScanUpdate_millis = millis();
+  }
+  
+  //which channel (1-8) has the lead-off tone in it at this sample, or 0 if none does
+  int getLeadOffScanChannel(int sampleIndex) {
+    if (!isLeadOffScanning() || (sampleIndex < leadOffScanSampleIndex)) return 0;
+    return leadOffScanChannel;
+  }
+  
+  //has the impedance scan moved lately?  It moves once per dwell (a few seconds at most).
+  boolean isLeadOffScanning() {
+    return (leadOffScanUpdate_millis >= 0) && ((millis() - leadOffScanUpdate_millis) < 10000);
+  }
+  
+  //has the Arduino sent its own impedance measurement lately?  The scan only sends them
+  //once per dwell, so give it longer.
+  boolean isImpedanceFromArduino() {
+    int timeout_millis = isLeadOffScanning() ? 10000 : 2000;
+    return (impedanceUpdate_millis >= 0) && ((millis() - impedanceUpdate_millis) < timeout_millis);
+  }
+  
+  //ask the Arduino to start or stop its background impedance scan
+  public void toggleLeadOffScan() {
+    if (serial_openBCI != null) serial_openBCI.write(command_toggleLeadOffScan + "\n");
+  }
+  
+  //ask the Arduino to send its impedance measurements along with the data, or to stop
+  public void toggleImpedanceWithData() {
+    if (serial_openBCI != null) serial_openBCI.write(command_toggleImpedanceWithData + "\n");
+  }
+  
+  //split a batch packet into separate data packets, ready for copyDataPacketTo()
+  boolean interpretBatchPayload() {
+    if (batchPackets.length < nSamplesInBatch) {
+      batchPackets = new DataPacket_ADS1299[nSamplesInBatch];
+      for (int Isamp=0; Isamp < nSamplesInBatch; Isamp++) batchPackets[Isamp] = new DataPacket_ADS1299(dataPacket.values.length);
+    }
+    
+    int Ibyte = 0;
+    for (int Isamp=0; Isamp < nSamplesInBatch; Isamp++) {
+      dataPacket.copyTo(batchPackets[Isamp]);  //keeps any values beyond the N that were sent
+      batchPackets[Isamp].sampleIndex = dataPacket.sampleIndex + Isamp;
+      for (int Ichan=0; Ichan < nDataValuesInPacket; Ichan++) {
+        localByteBuffer[0] = batchPayload[Ibyte++];
+        localByteBuffer[1] = batchPayload[Ibyte++];
+        localByteBuffer[2] = batchPayload[Ibyte++];
+        batchPackets[Isamp].values[Ichan] = interpretAsInt24(localByteBuffer);
+      }
+    }
+    prevSampleIndex = dataPacket.sampleIndex + nSamplesInBatch - 1;
+    nBatchPacketsAvailable = nSamplesInBatch;
+    batchPacketReadInd = 0;
+    return true;
+  }
+  
+  //rebuild the channel values from a delta packet.  Returns false if we can't.
+  boolean interpretDeltaPayload() {
+    if (!haveDeltaRef) return false;  //still waiting for a keyframe
+    
+    //make sure that this packet follows right after the previous one
+    int sampleIndex = prevSampleIndex + 1;
+    if ((0xFF & deltaPayload[0]) != (sampleIndex & 0xFF)) {
+      serialErrorCounter++;
+      println("OpenBCI_ADS1299: interpretDeltaPayload: missed a packet.  Waiting for next keyframe. (" + serialErrorCounter + ")");
+      haveDeltaRef = false;
+      return false;
+    }
+    
+    //decode each channel
+    int Ichan = 0, shift = 0, zigzag = 0;
+    for (int Ibyte = 1; Ibyte < deltaPayloadLength; Ibyte++) {
+      zigzag |= (0x7F & deltaPayload[Ibyte]) << shift;
+      shift += 7;
+      if ((deltaPayload[Ibyte] & 0x80) == 0) {
+        //that was the last byte of this channel
+        if (Ichan >= deltaRefValues.length) break;
+        deltaRefValues[Ichan] += (zigzag >>> 1) ^ (-(zigzag & 1));
+        Ichan++; shift = 0; zigzag = 0;
+      }
+    }
+    if ((Ichan != deltaRefValues.length) || (Ichan > dataPacket.values.length) || (shift != 0)) {
+      serialErrorCounter++;
+      println("OpenBCI_ADS1299: interpretDeltaPayload: packet has the wrong number of channels.  Waiting for next keyframe. (" + serialErrorCounter + ")");
+      haveDeltaRef = false;
+      return false;
+    }
+    
+    for (Ichan = 0; Ichan < deltaRefValues.length; Ichan++) dataPacket.values[Ichan] = deltaRefValues[Ichan];
+    dataPacket.sampleIndex = sampleIndex;
+    prevSampleIndex = sampleIndex;
+    return true;
+  }
 
 
   //activate or deactivate an EEG channel...channel counting is zero through nchan-1
@@ -303,6 +842,55 @@ class OpenBCI_ADS1299 {
     }
   }
   
+  //set up all of the channels in one go, with a single binary command.  The Arduino applies
+  //it as one reconfiguration, so the data stream only pauses once.  The arrays are
+  //zero-referenced channels; only the first 8 are used, as the daisy-chained boards share them.
+  public void configureChannels(boolean[] active, boolean[] leadOffP, boolean[] leadOffN, boolean biasAuto) {
+    if (serial_openBCI == null) return;
+    int nChan = min(active.length, command_activate_channel.length);
+    byte[] payload = new byte[3 + 3*nChan];
+    payload[0] = CMD_CONFIGURE_CHANNELS;
+    payload[1] = (byte)(biasAuto ? 1 : 0);
+    payload[2] = (byte)nChan;
+    for (int Ichan=0; Ichan < nChan; Ichan++) {
+      byte flags = 0;
+      if (active[Ichan]) flags |= ADS_CHANCFG_ACTIVE;
+      if ((leadOffP != null) && leadOffP[Ichan]) flags |= ADS_CHANCFG_LOFF_P;
+      if ((leadOffN != null) && leadOffN[Ichan]) flags |= ADS_CHANCFG_LOFF_N;
+      payload[3+3*Ichan] = flags;
+      payload[3+3*Ichan+1] = ADS_GAIN24;
+      payload[3+3*Ichan+2] = ADSINPUT_NORMAL;
+    }
+    sendCommandFrame(payload);
+    isBiasAuto = biasAuto;
+  }
+  
+  //pick the filters that the Arduino runs on the data before sending it (only used once
+  //it's told to filter, with 'f').  These are indices into the preset bank in the sketch's
+  //FilterCoefficients.h.  The Arduino glides over to the new filters, so this can be sent
+  //while streaming without a glitch in the data.
+  public void setFilterPreset(int bandPreset, int notchPreset) {
+    if (serial_openBCI == null) return;
+    byte[] payload = new byte[3];
+    payload[0] = CMD_SET_FILTER_PRESET;
+    payload[1] = (byte)bandPreset;
+    payload[2] = (byte)notchPreset;
+    sendCommandFrame(payload);
+  }
+  
+  //wrap a binary command in its frame (start byte, length, payload, CRC) and send it
+  private void sendCommandFrame(byte[] payload) {
+    int crc = 0xFFFF;
+    for (int i=0; i < payload.length; i++) crc = crc16_update(crc,payload[i]);
+    byte[] frame = new byte[2 + payload.length + 2];
+    frame[0] = CMD_FRAME_START;
+    frame[1] = (byte)payload.length;
+    for (int i=0; i < payload.length; i++) frame[2+i] = payload[i];
+    frame[frame.length-2] = (byte)(crc >> 8);
+    frame[frame.length-1] = (byte)crc;
+    serial_openBCI.write(frame);
+  }
+  
   //deactivate an EEG channel...channel counting is zero through nchan-1
   public void deactivateChannel(int Ichan) {
     if (serial_openBCI != null) {
@@ -368,9 +956,27 @@ class OpenBCI_ADS1299 {
       );
   }
   
+  int interpretAsInt24(byte[] byteArray) {
+    //big endian, as it comes out of the ADS1299
+    int newInt = ( 
+      ((0xFF & byteArray[0]) << 16) |
+      ((0xFF & byteArray[1]) << 8) | 
+      (0xFF & byteArray[2])
+      );
+    if ((newInt & 0x00800000) > 0) newInt |= 0xFF000000;  //sign extend
+    return newInt;
+  }
+  
 
   
   int copyDataPacketTo(DataPacket_ADS1299 target) {
+    if (batchPacketReadInd < nBatchPacketsAvailable) {
+      //hand out the samples from a batch packet one at a time
+      batchPackets[batchPacketReadInd].copyTo(target);
+      batchPacketReadInd++;
+      isNewDataPacketAvailable = (batchPacketReadInd < nBatchPacketsAvailable);
+      return 0;
+    }
     isNewDataPacketAvailable = false;
     dataPacket.copyTo(target);
     return 0;
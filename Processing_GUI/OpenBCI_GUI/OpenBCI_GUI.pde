@@ -248,7 +248,13 @@ void setup() {
   //for (int Ichan=0; Ichan<OpenBCI_Nchannels;Ichan++) {  //what will happen here for the 16-channel board???
   //  if (Ichan < nchan_active_at_startup) { activateChannel(Ichan); } else { deactivateChannel(Ichan);  }
   //}
-  for (int Ichan=nchan_active_at_startup; Ichan<OpenBCI_Nchannels;Ichan++) deactivateChannel(Ichan);  //deactivate unused channels
+  //deactivate unused channels...all in one command, so the data only pauses once
+  boolean[] startupActive = new boolean[OpenBCI_Nchannels];
+  for (int Ichan=0; Ichan<OpenBCI_Nchannels;Ichan++) startupActive[Ichan] = (Ichan < nchan_active_at_startup);
+  if (openBCI != null) openBCI.configureChannels(startupActive,null,null,openBCI.isBiasAuto);
+  for (int Ichan=nchan_active_at_startup; Ichan<OpenBCI_Nchannels;Ichan++) {
+    if (Ichan < gui.chanButtons.length) gui.chanButtons[Ichan].setIsActive(true); //a deactivated channel is a dark-colored ACTIVE button
+  }
   
   // initialize the minim and audioOut objects...specific to OpenBCI_GUI_Simpler
   //minim = new Minim( this );
@@ -472,6 +478,13 @@ void processNewData() {
 
   //compute the electrode impedance. Do it in a very simple way [rms to amplitude, then uVolt to Volt, then Volt/Amp to Ohm]
   for (int Ichan=0;Ichan < nchan; Ichan++) data_elec_imp_ohm[Ichan] = (sqrt(2.0)*eegProcessing.data_std_uV[Ichan]*1.0e-6) / openBCI.leadOffDrive_amps;     
+  
+  //but if the Arduino is measuring it (with its lock-in on the lead-off signal), use that instead
+  if (openBCI.isImpedanceFromArduino()) {
+    for (int Ichan=0;Ichan < min(nchan,openBCI.impedance_ohm.length); Ichan++) {
+      if (openBCI.impedance_ohm[Ichan] >= 0.0f) data_elec_imp_ohm[Ichan] = openBCI.impedance_ohm[Ichan];
+    }
+  }
       
   //add your own processing steps here!
   //for (int Ichan=0;Ichan < nchan; Ichan++) { 
@@ -492,7 +505,7 @@ void serialEvent(Serial port) {
     boolean echoBytes = !openBCI.isStateNormal(); 
     openBCI.read(echoBytes);
     openBCI_byteCount++;
-    if (openBCI.isNewDataPacketAvailable) {
+    while (openBCI.isNewDataPacketAvailable) {  //a batch packet holds several
       //copy packet into buffer of data packets
       curDataPacketInd = (curDataPacketInd+1) % dataPacketBuff.length; //this is also used to let the rest of the code that it may be time to do something
       openBCI.copyDataPacketTo(dataPacketBuff[curDataPacketInd]);  //resets isNewDataPacketAvailable to false
@@ -92,33 +92,42 @@ float filterWEA_1stOrderIIR(float[] filty, float learn_fac, float filt_state) {
   return prev;
 }
 
+//Filter the data in place, starting from rest.  filt_a[0] is assumed to be 1.0.
+//This is the transposed direct form II, so each new point only needs one pass over
+//the coefficients and nothing gets shifted.  The 5-coefficient filters that we use all
+//the time (like butter(2,...) bandpass and notch) get their own loop, with the state in
+//local variables.
 void filterIIR(double[] filt_b, double[] filt_a, float[] data) {
   int Nback = filt_b.length;
-  double[] prev_y = new double[Nback];
-  double[] prev_x = new double[Nback];
+  if (Nback == 5) {
+    filterIIR_order4(filt_b, filt_a, data);
+    return;
+  }
+  double[] z = new double[Nback];  //the last one stays zero
   
   //step through data points
-  for (int i = 0; i < data.length; i++) {   
-    //shift the previous outputs
-    for (int j = Nback-1; j > 0; j--) {
-      prev_y[j] = prev_y[j-1];
-      prev_x[j] = prev_x[j-1];
-    }
-    
-    //add in the new point
-    prev_x[0] = data[i];
-    
-    //compute the new data point
-    double out = 0;
-    for (int j = 0; j < Nback; j++) {
-      out += filt_b[j]*prev_x[j];
-      if (j > 0) {
-        out -= filt_a[j]*prev_y[j];
-      }
+  for (int i = 0; i < data.length; i++) {
+    double in = data[i];
+    double out = filt_b[0]*in + z[0];
+    for (int j = 1; j < Nback; j++) {
+      z[j-1] = filt_b[j]*in - filt_a[j]*out + z[j];
     }
-    
-    //save output value
-    prev_y[0] = out;
+    data[i] = (float)out;
+  }
+}
+
+//same as above, for 5 coefficients (such as a 2nd-order bandpass or notch)
+void filterIIR_order4(double[] filt_b, double[] filt_a, float[] data) {
+  final double b0 = filt_b[0], b1 = filt_b[1], b2 = filt_b[2], b3 = filt_b[3], b4 = filt_b[4];
+  final double a1 = filt_a[1], a2 = filt_a[2], a3 = filt_a[3], a4 = filt_a[4];
+  double z0 = 0, z1 = 0, z2 = 0, z3 = 0;
+  for (int i = 0; i < data.length; i++) {
+    double in = data[i];
+    double out = b0*in + z0;
+    z0 = b1*in - a1*out + z1;
+    z1 = b2*in - a2*out + z2;
+    z2 = b3*in - a3*out + z3;
+    z3 = b4*in - a4*out;
     data[i] = (float)out;
   }
 }
@@ -149,3 +158,46 @@ void rereferenceTheMontage(float[][] data) {
 }
   
 
+
+//Band power of one block of samples, worked out the way the Arduino does it for its band
+//power packets (see ADS1299BandPower.h): a Goertzel filter at each DFT bin (k*fs/N) from
+//each band's lower edge up to its upper edge, then 2*|X|^2/N^2 added up over the bins.
+//That's the mean square of the part of the signal in each band.  edges_Hz has one more
+//entry than there are bands.  Here it's all floating point, so it's the answer that the
+//Arduino's integer version should match.
+float[] goertzelBandPower(float[] block, float fs_Hz, float[] edges_Hz) {
+  int N = block.length;
+  float[] power = new float[edges_Hz.length-1];
+  for (int Iband=0; Iband < power.length; Iband++) {
+    for (int k=max(1,ceil(edges_Hz[Iband]*N/fs_Hz)); (k*fs_Hz/N < edges_Hz[Iband+1]) && (2*k < N); k++) {
+      double w = 2.0*Math.PI*k/N;
+      double c = 2.0*Math.cos(w), s1 = 0, s2 = 0;
+      for (int i=0; i < N; i++) {
+        double s0 = block[i] + c*s1 - s2;
+        s2 = s1; s1 = s0;
+      }
+      double re = s1 - Math.cos(w)*s2, im = Math.sin(w)*s2;
+      power[Iband] += (float)(2.0*(re*re + im*im)/((double)N*N));
+    }
+  }
+  return power;
+}
+
+//The same thing from the whole spectrum of the block (a plain DFT, so that any block
+//length works), to check goertzelBandPower() and the Arduino against.
+float[] dftBandPower(float[] block, float fs_Hz, float[] edges_Hz) {
+  int N = block.length;
+  float[] power = new float[edges_Hz.length-1];
+  for (int k=1; 2*k < N; k++) {
+    double re = 0, im = 0;
+    for (int i=0; i < N; i++) {
+      re += block[i]*Math.cos(2.0*Math.PI*k*i/N);
+      im -= block[i]*Math.sin(2.0*Math.PI*k*i/N);
+    }
+    float f_Hz = k*fs_Hz/N;
+    for (int Iband=0; Iband < power.length; Iband++) {
+      if ((f_Hz >= edges_Hz[Iband]) && (f_Hz < edges_Hz[Iband+1])) power[Iband] += (float)(2.0*(re*re + im*im)/((double)N*N));
+    }
+  }
+  return power;
+}